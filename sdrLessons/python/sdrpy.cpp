@@ -0,0 +1,515 @@
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include <algorithm>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/complex.h>
+
+#include "capture_file.h"
+#include "qpsk_demod.h"
+#include "resampler.h"
+#include "psd.h"
+#include "ddc.h"
+#include "iq_analytics.h"
+#include "simd_ops.h"
+#include "work_pool.h"
+
+namespace py = pybind11;
+
+/*
+ * sdrpy - ядра sdr_dsp для скриптов tests/scripts (plot_pcm.py и др.):
+ *
+ *   cap = sdrpy.Capture("data2.bin")      # .pcm или .iqz
+ *   iq = cap.iq[440:1330]                 # int16 (n, 2), вид на mmap без копии
+ *   y = sdrpy.Fir(taps).process(iq)       # complex64
+ *   syms, pos = sdrpy.QpskDemod(10).process(y)
+ *   sdrpy.iq_report(syms)["evm_rms"]
+ *
+ * Вход - complex64 или int16 I/Q (масштаб 1/2048, как *_process_iq16),
+ * C-порядок: берётся указатель буфера numpy, без копии. Другие типы
+ * приводятся к complex64 (это копия). Выход - numpy массив поверх
+ * std::vector результата (владелец - capsule), тоже без копии.
+ *
+ * На время обработки GIL отпускается: разные объекты (каналы, куски
+ * записи) можно гонять в потоках Python параллельно. Один объект -
+ * один поток, состояние фильтров не защищено.
+ */
+
+typedef py::array_t<std::complex<float>, py::array::c_style> cf_array;
+typedef py::array_t<int16_t, py::array::c_style> iq16_array;
+
+static const cf_t *cf_data(const cf_array &x)
+{
+    return reinterpret_cast<const cf_t *>(x.data());
+}
+
+/* Пары I/Q: (n, 2) или плоский массив чётной длины */
+static size_t iq16_len(const iq16_array &x)
+{
+    if (x.size() % 2)
+        throw py::value_error("int16 I/Q needs an even number of values");
+    return (size_t)x.size() / 2;
+}
+
+/* Отдать вектор numpy без копии: массив владеет перемещённым вектором */
+template <typename T>
+static py::array_t<T> to_numpy(std::vector<T> &&v)
+{
+    std::vector<T> *p = new std::vector<T>(std::move(v));
+    py::capsule owner(p, [](void *q) { delete static_cast<std::vector<T> *>(q); });
+    return py::array_t<T>((py::ssize_t)p->size(), p->data(), owner);
+}
+
+static py::array_t<std::complex<float>> to_numpy_cf(std::vector<cf_t> &&v)
+{
+    return to_numpy<std::complex<float>>(std::move(v));
+}
+
+static void check(int err, const char *what)
+{
+    if (err < 0)
+        throw py::value_error(std::string(what) + ": " + strerror(-err));
+}
+
+/*
+ * Приведение к complex64 для перегрузок с конверсией. Целые сюда не
+ * пускаются: numpy "безопасно" приводит их поэлементно, и пары I/Q
+ * int16 стали бы 2n отдельных сэмплов без масштаба 1/2048.
+ */
+static cf_array cf_convert(const py::array &x)
+{
+    std::string kind = py::str(x.dtype().attr("kind"));
+    if (kind == "i" || kind == "u" || kind == "b")
+        throw py::type_error("integer input must be int16 I/Q: (n, 2) or flat pairs");
+    auto y = py::array_t<std::complex<float>, py::array::c_style | py::array::forcecast>::ensure(x);
+    if (!y)
+        throw py::type_error("expected complex or float samples");
+    return cf_array(y);
+}
+
+/* Результат перегрузки как py::object (void -> None) */
+template <typename F, typename C, typename A>
+static py::object call_obj(F &f, C &c, const A &x)
+{
+    if constexpr (std::is_void<decltype(f(c, x))>::value) {
+        f(c, x);
+        return py::none();
+    } else {
+        return py::object(f(c, x));
+    }
+}
+
+/*
+ * Метод process для complex64 и int16: сначала без приведения типов,
+ * последним - с приведением. int16 с шагом (cap.iq[::4]) копируется в
+ * непрерывный int16, остальное - к complex64 (cf_convert).
+ */
+template <typename C, typename Fc, typename Fi>
+static void def_process(py::class_<C> &cls, const char *doc, Fc fc, Fi fi)
+{
+    cls.def("process", fc, py::arg("x").noconvert(), doc);
+    cls.def("process", fi, py::arg("x").noconvert());
+    cls.def("process", [fc, fi](C &c, const py::array &x) mutable {
+        if (py::isinstance<py::array_t<int16_t>>(x))
+            return call_obj(fi, c, iq16_array::ensure(x));
+        return call_obj(fc, c, cf_convert(x));
+    }, py::arg("x"));
+}
+
+/* ---- запись ---- */
+
+struct py_capture {
+    struct capture_file cf;
+    bool open = false;
+
+    py_capture() = default;
+    py_capture(const py_capture &) = delete;
+    ~py_capture()
+    {
+        // виды iq держат объект живым, закрываем последним
+        if (open)
+            capture_close(&cf);
+    }
+};
+
+/* ---- FIR ---- */
+
+/* Комплексный сигнал, вещественные коэффициенты; удвоенная линия задержки */
+struct py_fir {
+    size_t ntaps;
+    std::vector<float> h2;      // в обратном порядке, продублированы для I/Q
+    std::vector<float> hist;
+    size_t pos;
+};
+
+static void fir_reset(struct py_fir *f)
+{
+    std::fill(f->hist.begin(), f->hist.end(), 0.0f);
+    f->pos = 0;
+}
+
+static void fir_process(struct py_fir *f, const cf_t *x, size_t n, cf_t *y)
+{
+    const size_t nt = f->ntaps;
+    for (size_t k = 0; k < n; k++) {
+        f->hist[2 * f->pos] = f->hist[2 * (f->pos + nt)] = x[k].real();
+        f->hist[2 * f->pos + 1] = f->hist[2 * (f->pos + nt) + 1] = x[k].imag();
+        if (++f->pos == nt)
+            f->pos = 0;
+        float re, im;
+        simd_dot_cf_rf2(&f->hist[2 * f->pos], f->h2.data(), 2 * nt, &re, &im);
+        y[k] = cf_t(re, im);
+    }
+}
+
+/* int16 -> cf_t кусками, fn(tmp, chunk) на каждый */
+template <typename F>
+static void iq16_chunks(const int16_t *iq, size_t n, F fn)
+{
+    cf_t tmp[1024];
+    while (n > 0) {
+        size_t chunk = n < 1024 ? n : 1024;
+        for (size_t k = 0; k < chunk; k++)
+            tmp[k] = cf_t(iq[2 * k] / 2048.0f, iq[2 * k + 1] / 2048.0f);
+        fn(tmp, chunk);
+        iq += 2 * chunk;
+        n -= chunk;
+    }
+}
+
+/* ---- EVM/MER ---- */
+
+#define REPORT_CHUNK    (1u << 20)
+
+static struct iq_stats stats_parallel(const cf_t *x, size_t n, size_t threads)
+{
+    struct iq_stats total;
+    iq_stats_reset(&total);
+    if (threads <= 1 || n <= REPORT_CHUNK) {
+        iq_stats_add(&total, x, n);
+        return total;
+    }
+
+    struct work_pool pool;
+    work_pool_init(&pool, threads);
+    std::vector<struct iq_stats> accs(work_pool_size(&pool));
+    for (size_t k = 0; k < accs.size(); k++)
+        iq_stats_reset(&accs[k]);
+    for (size_t from = 0; from < n; from += REPORT_CHUNK) {
+        size_t len = n - from < REPORT_CHUNK ? n - from : REPORT_CHUNK;
+        work_pool_submit(&pool, [&accs, x, from, len] {
+            iq_stats_add(&accs[work_pool_thread_index()], x + from, len);
+        });
+    }
+    work_pool_wait(&pool);
+    work_pool_destroy(&pool);
+    for (size_t k = 0; k < accs.size(); k++)
+        iq_stats_merge(&total, &accs[k]);
+    return total;
+}
+
+static py::dict report_dict(const struct iq_stats *s)
+{
+    struct iq_report r;
+    iq_stats_report(s, &r);
+    py::dict d;
+    d["n"] = s->n;
+    d["power"] = r.power;
+    d["dc_i"] = r.dc_i;
+    d["dc_q"] = r.dc_q;
+    d["evm_rms"] = r.evm_rms;
+    d["mer_db"] = r.mer_db;
+    d["snr_m2m4_db"] = r.snr_m2m4_db;
+    d["gain_imb_db"] = r.gain_imb_db;
+    d["phase_imb_deg"] = r.phase_imb_deg;
+    return d;
+}
+
+PYBIND11_MODULE(sdrpy, m)
+{
+    m.doc() = "sdr_dsp kernels and capture reader (zero-copy numpy, GIL released)";
+
+    py::class_<py_capture>(m, "Capture", "Recorded int16 I/Q (.pcm or .iqz), memory mapped")
+        .def(py::init([](const std::string &path) {
+                 py_capture *c = new py_capture;
+                 {
+                     py::gil_scoped_release nogil;
+                     c->open = capture_open(&c->cf, path.c_str()) == 0;
+                 }
+                 if (!c->open) {
+                     delete c;
+                     throw py::value_error("Unable to open capture " + path);
+                 }
+                 return c;
+             }),
+             py::arg("path"))
+        .def_property_readonly("n_samples", [](const py_capture &c) { return c.cf.n_samples; })
+        .def_property_readonly("compressed", [](const py_capture &c) { return c.cf.compressed; })
+        .def_property_readonly("fs", [](const py_capture &c) {
+            return c.cf.compressed ? c.cf.hdr.fs_hz : 0.0;
+        })
+        .def("__len__", [](const py_capture &c) { return c.cf.n_samples; })
+        .def_property_readonly("iq", [](py::object self) {
+            // вид на отображение, держит Capture живым; только чтение
+            const py_capture &c = self.cast<const py_capture &>();
+            py::array_t<int16_t> a({(py::ssize_t)c.cf.n_samples, (py::ssize_t)2},
+                                   {(py::ssize_t)(2 * sizeof(int16_t)), (py::ssize_t)sizeof(int16_t)},
+                                   c.cf.data, self);
+            py::detail::array_proxy(a.ptr())->flags &= ~py::detail::npy_api::NPY_ARRAY_WRITEABLE_;
+            return a;
+        }, "int16 (n, 2) view of the whole capture, no copy")
+        .def("samples", [](const py_capture &c, size_t start, size_t n) {
+            if (start > c.cf.n_samples)
+                start = c.cf.n_samples;
+            if (n > c.cf.n_samples - start)
+                n = c.cf.n_samples - start;
+            std::vector<cf_t> y(n);
+            {
+                py::gil_scoped_release nogil;
+                const int16_t *iq = capture_samples(&c.cf, start);
+                for (size_t k = 0; k < n; k++)
+                    y[k] = cf_t(iq[2 * k] / 2048.0f, iq[2 * k + 1] / 2048.0f);
+            }
+            return to_numpy_cf(std::move(y));
+        }, py::arg("start"), py::arg("n"), "complex64 samples, scale 1/2048");
+
+    py::class_<py_fir> fir(m, "Fir", "Streaming FIR, complex signal, real taps (np.convolve(x, h)[:len(x)])");
+    fir.def(py::init([](py::array_t<double, py::array::c_style | py::array::forcecast> taps) {
+                   if (taps.size() == 0)
+                       throw py::value_error("empty taps");
+                   py_fir *f = new py_fir;
+                   f->ntaps = (size_t)taps.size();
+                   f->h2.resize(2 * f->ntaps);
+                   for (size_t k = 0; k < f->ntaps; k++)
+                       f->h2[2 * k] = f->h2[2 * k + 1] = (float)taps.data()[f->ntaps - 1 - k];
+                   f->hist.assign(4 * f->ntaps, 0.0f);
+                   f->pos = 0;
+                   return f;
+               }),
+               py::arg("taps"))
+        .def("reset", &fir_reset);
+    def_process(fir, "filter x, state carries over to the next call",
+                [](py_fir &f, const cf_array &x) {
+                    std::vector<cf_t> y((size_t)x.size());
+                    {
+                        py::gil_scoped_release nogil;
+                        fir_process(&f, cf_data(x), y.size(), y.data());
+                    }
+                    return to_numpy_cf(std::move(y));
+                },
+                [](py_fir &f, const iq16_array &x) {
+                    size_t n = iq16_len(x);
+                    std::vector<cf_t> y(n);
+                    {
+                        py::gil_scoped_release nogil;
+                        cf_t *out = y.data();
+                        iq16_chunks(x.data(), n, [&](const cf_t *t, size_t len) {
+                            fir_process(&f, t, len, out);
+                            out += len;
+                        });
+                    }
+                    return to_numpy_cf(std::move(y));
+                });
+
+    // MF + Гарднер + Костас (qpsk_demod.h) - то же, что gardner_timing_recovery в plot_pcm.py
+    py::class_<struct qpsk_demod> dm(m, "QpskDemod", "Matched filter -> AGC -> Gardner timing -> Costas loop");
+    dm.def(py::init([](unsigned sps, const std::string &pulse, float rolloff, unsigned rrc_span,
+                       float timing_bw, float costas_bw) {
+               struct qpsk_demod_cfg cfg;
+               qpsk_demod_default_cfg(&cfg, sps);
+               if (pulse == "rrc")
+                   cfg.pulse = QPSK_PULSE_RRC;
+               else if (pulse == "rect")
+                   cfg.pulse = QPSK_PULSE_RECT;
+               else
+                   throw py::value_error("pulse must be 'rect' or 'rrc'");
+               if (rolloff > 0.0f)
+                   cfg.rolloff = rolloff;
+               if (rrc_span)
+                   cfg.rrc_span = rrc_span;
+               if (timing_bw > 0.0f)
+                   cfg.timing_bw = timing_bw;
+               if (costas_bw > 0.0f)
+                   cfg.costas_bw = costas_bw;
+               struct qpsk_demod *d = new struct qpsk_demod;
+               int err = qpsk_demod_init(d, &cfg);
+               if (err < 0) {
+                   delete d;
+                   check(err, "qpsk_demod_init");
+               }
+               return d;
+           }),
+           py::arg("sps"), py::arg("pulse") = "rect", py::arg("rolloff") = 0.0f, py::arg("rrc_span") = 0,
+           py::arg("timing_bw") = 0.0f, py::arg("costas_bw") = 0.0f)
+        .def("reset", &qpsk_demod_reset, py::arg("start") = 0)
+        .def_property_readonly("delay", &qpsk_demod_delay)
+        .def_property_readonly("phase", [](const struct qpsk_demod &d) { return d.phase; })
+        .def_property_readonly("freq", [](const struct qpsk_demod &d) { return d.freq; });
+    def_process(dm, "symbols (complex64) and their positions in input samples (float64)",
+                [](struct qpsk_demod &d, const cf_array &x) {
+                    std::vector<cf_t> syms;
+                    std::vector<double> pos;
+                    {
+                        py::gil_scoped_release nogil;
+                        qpsk_demod_process(&d, cf_data(x), (size_t)x.size(), syms, &pos);
+                    }
+                    return py::make_tuple(to_numpy_cf(std::move(syms)), to_numpy(std::move(pos)));
+                },
+                [](struct qpsk_demod &d, const iq16_array &x) {
+                    size_t n = iq16_len(x);
+                    std::vector<cf_t> syms;
+                    std::vector<double> pos;
+                    {
+                        py::gil_scoped_release nogil;
+                        qpsk_demod_process_iq16(&d, x.data(), n, syms, &pos);
+                    }
+                    return py::make_tuple(to_numpy_cf(std::move(syms)), to_numpy(std::move(pos)));
+                });
+
+    py::class_<struct resampler> rs(m, "Resampler", "Polyphase resampler, fs_out = fs_in * L / M or any ratio");
+    rs.def(py::init([](unsigned L, unsigned M, unsigned taps) {
+               struct resampler *r = new struct resampler;
+               int err = resampler_init_rational(r, L, M, taps);
+               if (err < 0) {
+                   delete r;
+                   check(err, "resampler_init_rational");
+               }
+               return r;
+           }),
+           py::arg("L"), py::arg("M"), py::arg("taps_per_phase") = 16)
+        .def_static("fractional", [](double ratio, unsigned taps, unsigned nphases) {
+            struct resampler *r = new struct resampler;
+            int err = resampler_init_fractional(r, ratio, taps, nphases);
+            if (err < 0) {
+                delete r;
+                check(err, "resampler_init_fractional");
+            }
+            return r;
+        }, py::arg("ratio"), py::arg("taps_per_phase") = 16, py::arg("nphases") = 64,
+           py::return_value_policy::take_ownership)
+        .def("reset", &resampler_reset)
+        .def_property_readonly("delay", &resampler_delay);
+    def_process(rs, "resampled complex64, state carries over to the next call",
+                [](struct resampler &r, const cf_array &x) {
+                    std::vector<cf_t> y;
+                    {
+                        py::gil_scoped_release nogil;
+                        resampler_process(&r, cf_data(x), (size_t)x.size(), y);
+                    }
+                    return to_numpy_cf(std::move(y));
+                },
+                [](struct resampler &r, const iq16_array &x) {
+                    size_t n = iq16_len(x);
+                    std::vector<cf_t> y;
+                    {
+                        py::gil_scoped_release nogil;
+                        iq16_chunks(x.data(), n, [&](const cf_t *t, size_t len) {
+                            resampler_process(&r, t, len, y);
+                        });
+                    }
+                    return to_numpy_cf(std::move(y));
+                });
+
+    py::class_<struct psd> ps(m, "Psd", "Streaming Welch PSD, dB re unit tone, fftshifted");
+    ps.def(py::init([](size_t nfft, py::object overlap, const std::string &window) {
+               struct psd_cfg cfg;
+               psd_default_cfg(&cfg);
+               cfg.nfft = nfft;
+               cfg.overlap = overlap.is_none() ? nfft / 2 : overlap.cast<size_t>();
+               if (window == "hann")
+                   cfg.window = PSD_WIN_HANN;
+               else if (window == "blackman_harris")
+                   cfg.window = PSD_WIN_BLACKMAN_HARRIS;
+               else
+                   throw py::value_error("window must be 'hann' or 'blackman_harris'");
+               struct psd *p = new struct psd;
+               int err = psd_init(p, &cfg);
+               if (err < 0) {
+                   delete p;
+                   check(err, "psd_init");
+               }
+               return p;
+           }),
+           py::arg("nfft") = 1024, py::arg("overlap") = py::none(), py::arg("window") = "blackman_harris")
+        .def("reset", &psd_reset)
+        .def_property_readonly("frames", [](const struct psd &p) { return p.frames; })
+        .def("result", [](struct psd &p) {
+            std::vector<float> db(p.cfg.nfft);
+            {
+                py::gil_scoped_release nogil;
+                psd_flush(&p);
+                psd_result_db(&p, db.data());
+            }
+            return to_numpy(std::move(db));
+        }, "float32 PSD in dB, index nfft / 2 is DC");
+    def_process(ps, "accumulate x into the average",
+                [](struct psd &p, const cf_array &x) {
+                    py::gil_scoped_release nogil;
+                    psd_process(&p, cf_data(x), (size_t)x.size());
+                },
+                [](struct psd &p, const iq16_array &x) {
+                    size_t n = iq16_len(x);
+                    py::gil_scoped_release nogil;
+                    psd_process_iq16(&p, x.data(), n);
+                });
+
+    py::class_<struct ddc> dc(m, "Ddc", "NCO -> CIC -> half-band -> CIC compensation");
+    dc.def(py::init([](double fs, double freq, unsigned cic_decim, unsigned hb_stages) {
+               struct ddc_cfg cfg;
+               ddc_default_cfg(&cfg, fs);
+               cfg.freq = freq;
+               cfg.cic_decim = cic_decim;
+               cfg.hb_stages = hb_stages;
+               if (cic_decim == 1)
+                   cfg.cfir_taps = 0;
+               struct ddc *d = new struct ddc;
+               int err = ddc_init(d, &cfg);
+               if (err < 0) {
+                   delete d;
+                   check(err, "ddc_init");
+               }
+               return d;
+           }),
+           py::arg("fs"), py::arg("freq"), py::arg("cic_decim") = 8, py::arg("hb_stages") = 2)
+        .def("reset", &ddc_reset)
+        .def("set_freq", &ddc_set_freq, py::arg("freq"))
+        .def_property_readonly("decim", &ddc_decim);
+    def_process(dc, "complex64 at fs / decim",
+                [](struct ddc &d, const cf_array &x) {
+                    std::vector<cf_t> y;
+                    {
+                        py::gil_scoped_release nogil;
+                        ddc_process(&d, cf_data(x), (size_t)x.size(), y);
+                    }
+                    return to_numpy_cf(std::move(y));
+                },
+                [](struct ddc &d, const iq16_array &x) {
+                    size_t n = iq16_len(x);
+                    std::vector<cf_t> y;
+                    {
+                        py::gil_scoped_release nogil;
+                        ddc_process_iq16(&d, x.data(), n, y);
+                    }
+                    return to_numpy_cf(std::move(y));
+                });
+
+    auto report = [](const cf_array &x, size_t threads) {
+        struct iq_stats s;
+        {
+            py::gil_scoped_release nogil;
+            s = stats_parallel(cf_data(x), (size_t)x.size(), threads);
+        }
+        return report_dict(&s);
+    };
+    m.def("iq_report", report, py::arg("x").noconvert(), py::arg("threads") = 1,
+          "EVM/MER, SNR (M2M4), DC and I/Q imbalance of x (iq_analytics.h)");
+    m.def("iq_report", [report](const py::array &x, size_t threads) {
+        return report(cf_convert(x), threads);
+    }, py::arg("x"), py::arg("threads") = 1);
+}
@@ -0,0 +1,210 @@
+#include "bert.h"
+
+#include <errno.h>
+
+static inline uint64_t low_mask(unsigned w)
+{
+    return w >= 64 ? ~0ull : (1ull << w) - 1;
+}
+
+/*
+ * Следующие w <= m бит трёхчлена x^n + x^m + 1 по истории h (бит 0 -
+ * самый новый): b[k] = b[k-n] ^ b[k-m], в результате первый - старший.
+ */
+static inline uint64_t lfsr_step(uint64_t h, unsigned n, unsigned m, unsigned w)
+{
+    return ((h >> (n - w)) ^ (h >> (m - w))) & low_mask(w);
+}
+
+int prbs_init(struct prbs *p, unsigned order)
+{
+    switch (order) {
+    case 7:  p->m = 6;  break;
+    case 15: p->m = 14; break;
+    case 23: p->m = 18; break;
+    case 31: p->m = 28; break;
+    default:
+        return -EINVAL;
+    }
+    p->n = order;
+    p->h = low_mask(order);
+    return 0;
+}
+
+uint64_t prbs_next64(struct prbs *p)
+{
+    uint64_t out = 0;
+    for (unsigned got = 0; got < 64;) {
+        unsigned w = 64 - got < p->m ? 64 - got : p->m;
+        uint64_t v = lfsr_step(p->h, p->n, p->m, w);
+        p->h = (p->h << w) | v;
+        out = (out << w) | v;
+        got += w;
+    }
+    return out;
+}
+
+int bert_tx_init(struct bert_tx *t, unsigned order, unsigned sps, int16_t amplitude)
+{
+    if (sps == 0 || prbs_init(&t->gen, order) < 0)
+        return -EINVAL;
+    t->sps = sps;
+    t->amp = amplitude;
+    t->word = 0;
+    t->word_bits = 0;
+    t->cur_i = t->cur_q = 0;
+    t->phase = 0;
+    return 0;
+}
+
+void bert_tx_fill(struct bert_tx *t, int16_t *iq, size_t n)
+{
+    size_t k = 0;
+    while (k < n) {
+        if (t->phase == 0) {
+            if (t->word_bits == 0) {
+                t->word = prbs_next64(&t->gen);
+                t->word_bits = 64;
+            }
+            t->cur_i = (t->word >> 63) ? t->amp : (int16_t)-t->amp;
+            t->cur_q = ((t->word >> 62) & 1) ? t->amp : (int16_t)-t->amp;
+            t->word <<= 2;
+            t->word_bits -= 2;
+        }
+        size_t run = t->sps - t->phase;
+        if (run > n - k)
+            run = n - k;
+        for (size_t j = 0; j < run; j++) {
+            iq[2 * (k + j)] = t->cur_i;
+            iq[2 * (k + j) + 1] = t->cur_q;
+        }
+        k += run;
+        t->phase = (unsigned)((t->phase + run) % t->sps);
+    }
+}
+
+void bert_tx_fill_cb(int16_t *iq, size_t n, long long index, void *user)
+{
+    (void)index;
+    bert_tx_fill((struct bert_tx *)user, iq, n);
+}
+
+void bert_rx_default_cfg(struct bert_rx_cfg *cfg, unsigned order)
+{
+    cfg->order = order;
+    cfg->sync_bits = 4 * order + 64;
+    cfg->hunt_bits = 1 << 14;
+    cfg->loss_window = 1 << 12;
+    cfg->loss_ber = 0.2f;
+}
+
+int bert_rx_init(struct bert_rx *r, const struct bert_rx_cfg *cfg)
+{
+    if (prbs_init(&r->ref, cfg->order) < 0 || cfg->loss_window < 64 || cfg->sync_bits < cfg->order)
+        return -EINVAL;
+    r->cfg = *cfg;
+    bert_rx_reset(r);
+    return 0;
+}
+
+void bert_rx_reset(struct bert_rx *r)
+{
+    r->state = BERT_HUNT;
+    r->rot = 0;
+    r->word = 0;
+    r->word_bits = 0;
+    r->hist = 0;
+    r->hist_bits = 0;
+    r->run = r->hunt = 0;
+    r->win_bits = r->win_errors = 0;
+    r->bits = r->errors = 0;
+    r->locks = r->losses = 0;
+    r->iv_bits = r->iv_errors = 0;
+}
+
+/* HUNT: самосинхронная проверка слова кусками по m бит */
+static void hunt_word(struct bert_rx *r, uint64_t word)
+{
+    unsigned n = r->ref.n, m = r->ref.m;
+    for (unsigned done = 0; done < 64;) {
+        unsigned w = 64 - done < m ? 64 - done : m;
+        uint64_t v = (word >> (64 - done - w)) & low_mask(w);
+        if (r->hist_bits >= n) {
+            if (__builtin_popcountll(v ^ lfsr_step(r->hist, n, m, w)) == 0)
+                r->run += w;
+            else
+                r->run = 0;
+        }
+        r->hist = (r->hist << w) | v;
+        r->hist_bits = r->hist_bits + w < 64 ? r->hist_bits + w : 64;
+        done += w;
+    }
+
+    if (r->run >= r->cfg.sync_bits) {
+        r->ref.h = r->hist;
+        r->state = BERT_LOCK;
+        r->win_bits = r->win_errors = 0;
+        r->locks++;
+        return;
+    }
+    r->hunt += 64;
+    if (r->hunt >= r->cfg.hunt_bits) {
+        // скорее всего Костас встал с поворотом
+        r->rot = (r->rot + 1) & 3;
+        r->hunt = 0;
+        r->run = 0;
+        r->hist_bits = 0;
+    }
+}
+
+static void lock_word(struct bert_rx *r, uint64_t word)
+{
+    r->win_errors += __builtin_popcountll(word ^ prbs_next64(&r->ref));
+    r->win_bits += 64;
+    r->hist = word;
+    if (r->win_bits < r->cfg.loss_window)
+        return;
+
+    if (r->win_errors > r->cfg.loss_ber * r->win_bits) {
+        r->state = BERT_HUNT;
+        r->losses++;
+        r->run = r->hunt = 0;
+        r->hist_bits = 64;
+    } else {
+        r->bits += r->win_bits;
+        r->errors += r->win_errors;
+        r->iv_bits += r->win_bits;
+        r->iv_errors += r->win_errors;
+    }
+    r->win_bits = r->win_errors = 0;
+}
+
+void bert_rx_process(struct bert_rx *r, const cf_t *syms, size_t n)
+{
+    for (size_t k = 0; k < n; k++) {
+        float i = syms[k].real(), q = syms[k].imag();
+        // поворот на rot * 90 град: (i, q) -> (-q, i)
+        for (unsigned j = 0; j < r->rot; j++) {
+            float t = i;
+            i = -q;
+            q = t;
+        }
+        r->word = (r->word << 2) | ((uint64_t)(i > 0.0f) << 1) | (uint64_t)(q > 0.0f);
+        r->word_bits += 2;
+        if (r->word_bits < 64)
+            continue;
+        if (r->state == BERT_LOCK)
+            lock_word(r, r->word);
+        else
+            hunt_word(r, r->word);
+        r->word = 0;
+        r->word_bits = 0;
+    }
+}
+
+void bert_rx_interval(struct bert_rx *r, uint64_t *bits, uint64_t *errors)
+{
+    *bits = r->iv_bits;
+    *errors = r->iv_errors;
+    r->iv_bits = r->iv_errors = 0;
+}
@@ -0,0 +1,108 @@
+#ifndef BERT_H
+#define BERT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "dsp_types.h"
+
+/*
+ * Измеритель BER на PRBS (как max_len_seq в pyhon_qpsk/1.py, но
+ * бесконечный поток): PRBS-7/15/23/31 по ITU-T O.150, x^n + x^m + 1,
+ * без инверсии.
+ *
+ * Генератор словный: для трёхчлена следующие m бит зависят только от
+ * уже выданных, поэтому за шаг выдаются min(m, 64) бит парой сдвигов и
+ * XOR (PRBS-31 - 64 бита за три шага).
+ *
+ * TX: биты -> QPSK (I = 2*b0 - 1, Q = 2*b1 - 1, как qpsk_soft_bits),
+ * прямоугольный импульс на sps сэмплов - то, что ждёт qpsk_demod по
+ * умолчанию. bert_tx_fill_cb - готовый sdr_tx_fill_cb для sdr_stream.
+ *
+ * RX: символы после qpsk_demod. Поиск (HUNT): самосинхронная проверка
+ * r[k] ^ r[k-n] ^ r[k-m] по словам, sync_bits бит подряд без ошибок -
+ * опорный генератор загружается принятыми битами (LOCK). Дальше ошибки -
+ * popcount(опора ^ принятое) на 64 бита. Неоднозначность фазы QPSK после
+ * Костаса: если за hunt_bits нет захвата - следующий поворот на 90 град.
+ * Захват теряется, если в окне loss_window бит ошибок больше loss_ber;
+ * такое окно в статистику не идёт, счёт начинается с нового захвата.
+ */
+
+#define PRBS_MAX_ORDER  31
+
+struct prbs {
+    unsigned n, m;          // x^n + x^m + 1
+    uint64_t h;             // последние биты, бит 0 - самый новый
+};
+
+/* order: 7, 15, 23 или 31; начальное состояние - все единицы */
+int prbs_init(struct prbs *p, unsigned order);
+
+/* Следующие 64 бита, первый по времени - старший */
+uint64_t prbs_next64(struct prbs *p);
+
+struct bert_tx {
+    struct prbs gen;
+    unsigned sps;
+    int16_t amp;
+    uint64_t word;          // ещё не отданные биты, старшие - первые
+    unsigned word_bits;
+    int16_t cur_i, cur_q;   // текущий символ
+    unsigned phase;         // сэмпл внутри символа
+};
+
+int bert_tx_init(struct bert_tx *t, unsigned order, unsigned sps, int16_t amplitude);
+
+/* n сэмплов int16 I/Q продолжения потока */
+void bert_tx_fill(struct bert_tx *t, int16_t *iq, size_t n);
+
+/* sdr_tx_fill_cb для sdr_stream_start: user - struct bert_tx * */
+void bert_tx_fill_cb(int16_t *iq, size_t n, long long index, void *user);
+
+enum bert_state {
+    BERT_HUNT = 0,
+    BERT_LOCK,
+};
+
+struct bert_rx_cfg {
+    unsigned order;
+    unsigned sync_bits;     // безошибочных бит для захвата
+    unsigned hunt_bits;     // бит на один поворот фазы при поиске
+    unsigned loss_window;   // бит в окне проверки захвата (кратно 64)
+    float loss_ber;
+};
+
+void bert_rx_default_cfg(struct bert_rx_cfg *cfg, unsigned order);
+
+struct bert_rx {
+    struct bert_rx_cfg cfg;
+    struct prbs ref;            // опора в LOCK
+    int state;                  // enum bert_state
+    unsigned rot;               // поворот символов, * 90 град
+
+    uint64_t word;              // набираемое слово из символов
+    unsigned word_bits;
+    uint64_t hist;              // принятые биты, бит 0 - самый новый
+    unsigned hist_bits;
+    uint64_t run;               // бит подряд без ошибок (HUNT)
+    uint64_t hunt;              // бит с последнего поворота
+
+    uint64_t win_bits, win_errors;      // текущее окно в LOCK
+
+    /* итоги (только подтверждённые окна) */
+    uint64_t bits, errors;
+    uint64_t locks, losses;
+    /* с последнего bert_rx_interval() */
+    uint64_t iv_bits, iv_errors;
+};
+
+int bert_rx_init(struct bert_rx *r, const struct bert_rx_cfg *cfg);
+void bert_rx_reset(struct bert_rx *r);
+
+/* Жёсткие решения по символам QPSK */
+void bert_rx_process(struct bert_rx *r, const cf_t *syms, size_t n);
+
+/* Биты и ошибки с прошлого вызова (BER во времени); счётчики интервала обнуляются */
+void bert_rx_interval(struct bert_rx *r, uint64_t *bits, uint64_t *errors);
+
+#endif // BERT_H
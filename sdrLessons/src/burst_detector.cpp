@@ -0,0 +1,269 @@
+#include "burst_detector.h"
+
+#include <math.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+
+enum {
+    BURST_IDLE = 0,
+    BURST_PENDING,      // энергия есть, ждём проверку преамбулы
+    BURST_ACTIVE,
+    BURST_REJECTED,     // энергия есть, но преамбула не найдена
+};
+
+int burst_detector_init(struct burst_detector *det, const struct burst_detector_cfg *cfg)
+{
+    if (!det || !cfg || cfg->window == 0)
+        return -EINVAL;
+    if (cfg->off_db > cfg->on_db)
+        return -EINVAL;
+    if (cfg->preamble && cfg->preamble_len == 0)
+        return -EINVAL;
+
+    det->cfg = *cfg;
+    det->on_ratio = powf(10.0f, cfg->on_db / 10.0f);
+    det->off_ratio = powf(10.0f, cfg->off_db / 10.0f);
+
+    det->pre.clear();
+    det->pre_energy = 0.0f;
+    if (cfg->preamble) {
+        det->pre.resize(2 * cfg->preamble_len);
+        for (size_t k = 0; k < 2 * cfg->preamble_len; k++) {
+            det->pre[k] = cfg->preamble[k];
+            det->pre_energy += det->pre[k] * det->pre[k];
+        }
+        if (det->pre_energy <= 0.0f)
+            return -EINVAL;
+    }
+
+    det->latency = 2 * cfg->window + cfg->preamble_len + cfg->hangover;
+    burst_detector_reset(det);
+    return 0;
+}
+
+void burst_detector_reset(struct burst_detector *det)
+{
+    det->pwr_ring.assign(det->cfg.window, 0);
+    det->pwr_pos = 0;
+    det->pwr_sum = 0;
+    det->noise = det->cfg.noise_floor;
+
+    det->state = BURST_IDLE;
+    det->n = 0;
+    det->on_index = 0;
+    det->below_cnt = 0;
+    memset(&det->cur, 0, sizeof(det->cur));
+
+    det->hist.assign(2 * det->cfg.window, 0.0f);
+    det->hist_pos = 0;
+    det->pending.clear();
+    det->pending.reserve(2 * (2 * det->cfg.window + det->cfg.preamble_len));
+
+    det->delay.assign(2 * det->latency, 0);
+    det->delay_pos = 0;
+    det->open.clear();
+}
+
+bool burst_detector_active(const struct burst_detector *det)
+{
+    return det->state == BURST_ACTIVE;
+}
+
+/* Поиск преамбулы в det->pending, возвращает лучший сдвиг или -1 */
+static long long squelch_search(struct burst_detector *det, float *best_corr)
+{
+    const size_t L = det->cfg.preamble_len;
+    const size_t N = det->pending.size() / 2;
+    const float *x = det->pending.data();
+    const float *p = det->pre.data();
+
+    *best_corr = 0.0f;
+    if (N < L)
+        return -1;
+
+    /* энергия окна x[lag .. lag+L) считается скользящей суммой */
+    float ex = 0.0f;
+    for (size_t m = 0; m < L; m++)
+        ex += x[2 * m] * x[2 * m] + x[2 * m + 1] * x[2 * m + 1];
+
+    long long best_lag = -1;
+    float best = 0.0f;
+    for (size_t lag = 0; lag + L <= N; lag++) {
+        float cr = 0.0f, ci = 0.0f;
+        const float *xl = x + 2 * lag;
+        for (size_t m = 0; m < L; m++) {
+            /* x * conj(p) */
+            cr += xl[2 * m] * p[2 * m] + xl[2 * m + 1] * p[2 * m + 1];
+            ci += xl[2 * m + 1] * p[2 * m] - xl[2 * m] * p[2 * m + 1];
+        }
+        float norm = ex * det->pre_energy;
+        float c2 = norm > 0.0f ? (cr * cr + ci * ci) / norm : 0.0f;
+        if (c2 > best) {
+            best = c2;
+            best_lag = (long long)lag;
+        }
+        if (lag + L < N) {
+            const float *out = x + 2 * lag;
+            const float *in = x + 2 * (lag + L);
+            ex += in[0] * in[0] + in[1] * in[1] - out[0] * out[0] - out[1] * out[1];
+        }
+    }
+    *best_corr = sqrtf(best);
+    return best_lag;
+}
+
+static void open_segment(struct burst_detector *det, long long start, float corr)
+{
+    det->cur.start = start;
+    det->cur.end = LLONG_MAX;
+    det->cur.corr = corr;
+    det->open.push_back(det->cur);
+    det->state = BURST_ACTIVE;
+}
+
+/* Проверка преамбулы; переводит PENDING в ACTIVE или REJECTED */
+static void squelch_decide(struct burst_detector *det)
+{
+    float corr;
+    long long lag = squelch_search(det, &corr);
+    long long start_est = det->on_index - (long long)det->cfg.window + 1;
+
+    if (lag >= 0 && corr >= det->cfg.preamble_thresh)
+        open_segment(det, start_est + lag, corr);
+    else
+        det->state = BURST_REJECTED;
+    det->pending.clear();
+}
+
+static void close_segment(struct burst_detector *det, long long end,
+                          std::vector<struct burst_segment> *segments)
+{
+    if (det->state == BURST_PENDING)
+        squelch_decide(det);
+
+    if (det->state == BURST_ACTIVE) {
+        det->cur.end = end > det->cur.start ? end : det->cur.start + 1;
+        det->open.back().end = det->cur.end;
+        det->open.back().peak_db = det->cur.peak_db;
+        if (segments)
+            segments->push_back(det->cur);
+    }
+    det->state = BURST_IDLE;
+    det->below_cnt = 0;
+}
+
+size_t burst_detector_process(struct burst_detector *det, const int16_t *iq, size_t n,
+                              std::vector<int16_t> *active_iq,
+                              std::vector<struct burst_segment> *segments)
+{
+    const size_t W = det->cfg.window;
+    const size_t need = 2 * W + det->cfg.preamble_len;
+    const bool squelch = !det->pre.empty();
+    size_t forwarded = 0;
+
+    for (size_t s = 0; s < n; s++) {
+        const int16_t si = iq[2 * s];
+        const int16_t sq = iq[2 * s + 1];
+        const long long k = det->n++;
+
+        /* скользящее среднее мощности */
+        uint32_t p = (uint32_t)((int32_t)si * si + (int32_t)sq * sq);
+        det->pwr_sum += p;
+        det->pwr_sum -= det->pwr_ring[det->pwr_pos];
+        det->pwr_ring[det->pwr_pos] = p;
+        if (++det->pwr_pos == W)
+            det->pwr_pos = 0;
+
+        if (squelch) {
+            det->hist[2 * det->hist_pos] = si;
+            det->hist[2 * det->hist_pos + 1] = sq;
+            if (++det->hist_pos == W)
+                det->hist_pos = 0;
+        }
+
+        if (k + 1 >= (long long)W) {
+            float avg = (float)det->pwr_sum / (float)W;
+            if (det->noise <= 0.0f)
+                det->noise = avg > 1.0f ? avg : 1.0f;
+
+            switch (det->state) {
+            case BURST_IDLE:
+                if (avg > det->noise * det->on_ratio) {
+                    det->on_index = k;
+                    det->below_cnt = 0;
+                    det->cur.peak_db = 10.0f * log10f(avg / det->noise);
+                    if (squelch) {
+                        /* окно, на котором сработал порог, - начало поиска */
+                        det->pending.clear();
+                        for (size_t m = 0; m < W; m++) {
+                            size_t h = (det->hist_pos + m) % W;
+                            det->pending.push_back(det->hist[2 * h]);
+                            det->pending.push_back(det->hist[2 * h + 1]);
+                        }
+                        det->state = BURST_PENDING;
+                    } else {
+                        open_segment(det, k - (long long)W + 1, 1.0f);
+                    }
+                } else if (det->cfg.noise_alpha > 0.0f) {
+                    det->noise += det->cfg.noise_alpha * (avg - det->noise);
+                    if (det->noise < 1.0f)
+                        det->noise = 1.0f;
+                }
+                break;
+
+            default:
+                if (det->state == BURST_PENDING) {
+                    det->pending.push_back(si);
+                    det->pending.push_back(sq);
+                    if (det->pending.size() >= 2 * need)
+                        squelch_decide(det);
+                }
+
+                float db = 10.0f * log10f(avg / det->noise);
+                if (db > det->cur.peak_db) {
+                    det->cur.peak_db = db;
+                    if (det->state == BURST_ACTIVE)
+                        det->open.back().peak_db = db;
+                }
+
+                if (avg < det->noise * det->off_ratio) {
+                    /* среднее отстаёт от конца пакета на длину окна */
+                    if (++det->below_cnt >= (long long)det->cfg.hangover + 1)
+                        close_segment(det, k - (long long)(det->cfg.hangover + W) + 1, segments);
+                } else {
+                    det->below_cnt = 0;
+                }
+                break;
+            }
+        }
+
+        /* гейт: сэмпл с индексом k - latency выходит из линии задержки */
+        if (!active_iq)
+            continue;
+        const long long j = k - (long long)det->latency;
+        int16_t oi = det->delay[2 * det->delay_pos];
+        int16_t oq = det->delay[2 * det->delay_pos + 1];
+        det->delay[2 * det->delay_pos] = si;
+        det->delay[2 * det->delay_pos + 1] = sq;
+        if (++det->delay_pos == det->latency)
+            det->delay_pos = 0;
+        if (j < 0)
+            continue;
+
+        while (!det->open.empty() && det->open.front().end <= j)
+            det->open.erase(det->open.begin());
+        if (!det->open.empty() && det->open.front().start <= j) {
+            active_iq->push_back(oi);
+            active_iq->push_back(oq);
+            forwarded++;
+        }
+    }
+
+    /* без гейта список open не нужен */
+    if (!active_iq) {
+        while (!det->open.empty() && det->open.front().end != LLONG_MAX)
+            det->open.erase(det->open.begin());
+    }
+    return forwarded;
+}
@@ -0,0 +1,91 @@
+#ifndef BURST_DETECTOR_H
+#define BURST_DETECTOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+/*
+ * Потоковый детектор пакетов (burst) для RX.
+ *
+ * Мощность считается скользящим средним по окну cfg.window сэмплов,
+ * включение/выключение - с гистерезисом относительно шумового пола.
+ * Опционально начало пакета подтверждается корреляцией с преамбулой
+ * (squelch): пакеты без преамбулы отбрасываются.
+ *
+ * Все индексы - абсолютные номера сэмплов с момента burst_detector_init().
+ */
+
+/* Участок активности: [start, end) */
+struct burst_segment {
+    long long start;
+    long long end;
+    float peak_db;      // пиковая средняя мощность над шумом, дБ
+    float corr;         // нормированная корреляция с преамбулой (1.0 без squelch)
+};
+
+struct burst_detector_cfg {
+    size_t window;          // окно скользящего среднего мощности, сэмплы
+    float on_db;            // порог включения над шумом, дБ
+    float off_db;           // порог выключения над шумом, дБ (off_db < on_db)
+    size_t hangover;        // сэмплов ниже off_db до закрытия пакета
+    float noise_alpha;      // скорость трекинга шумового пола в паузах (0 - не трекать)
+    float noise_floor;      // начальный шумовой пол (I^2+Q^2), 0 - по первому окну
+
+    /* Преамбула для squelch, interleaved I/Q int16. NULL - squelch выключен */
+    const int16_t *preamble;
+    size_t preamble_len;    // длина преамбулы в сэмплах (парах I/Q)
+    float preamble_thresh;  // порог нормированной корреляции, 0..1
+};
+
+struct burst_detector {
+    struct burst_detector_cfg cfg;
+
+    /* скользящее среднее мощности */
+    std::vector<uint32_t> pwr_ring;
+    size_t pwr_pos;
+    uint64_t pwr_sum;
+    float noise;
+    float on_ratio, off_ratio;
+
+    /* состояние автомата */
+    int state;
+    long long n;            // номер следующего входного сэмпла
+    long long on_index;     // где сработал порог включения
+    long long below_cnt;
+    struct burst_segment cur;
+
+    /* история для squelch: последние window сэмплов + ожидающий пакет */
+    std::vector<float> hist;        // interleaved I/Q
+    size_t hist_pos;
+    std::vector<float> pending;     // interleaved I/Q, начиная с on_index - window + 1
+    std::vector<float> pre;         // преамбула, float
+    float pre_energy;
+
+    /* линия задержки для гейтинга выходных сэмплов */
+    size_t latency;
+    std::vector<int16_t> delay;     // interleaved I/Q
+    size_t delay_pos;
+    std::vector<struct burst_segment> open; // подтверждённые, ещё не выданные целиком
+};
+
+int burst_detector_init(struct burst_detector *det, const struct burst_detector_cfg *cfg);
+void burst_detector_reset(struct burst_detector *det);
+
+/*
+ * Обработать блок из n сэмплов (interleaved I/Q int16).
+ *
+ * segments (может быть NULL) - сюда добавляются закрывшиеся пакеты.
+ * active_iq (может быть NULL) - сюда добавляются только сэмплы внутри
+ * подтверждённых пакетов, с задержкой det->latency сэмплов относительно входа.
+ *
+ * Возвращает число добавленных в active_iq сэмплов.
+ */
+size_t burst_detector_process(struct burst_detector *det, const int16_t *iq, size_t n,
+                              std::vector<int16_t> *active_iq,
+                              std::vector<struct burst_segment> *segments);
+
+/* true, если сейчас идёт подтверждённый пакет */
+bool burst_detector_active(const struct burst_detector *det);
+
+#endif // BURST_DETECTOR_H
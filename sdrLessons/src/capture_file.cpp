@@ -0,0 +1,440 @@
+#include "capture_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <atomic>
+
+#include "iq_codec.h"
+#include "work_pool.h"
+
+#define IQC_BLOCK_HDR   12      // заголовок блока iq_codec: mode, shift, pred, 0, n, len
+
+static int map_file(struct capture_file *cf, const char *path)
+{
+    struct stat st;
+
+    memset(cf, 0, sizeof(*cf));
+    cf->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (cf->fd < 0) {
+        fprintf(stderr, "Unable to open %s: %s\n", path, strerror(errno));
+        return -errno;
+    }
+    if (fstat(cf->fd, &st) < 0) {
+        int ret = -errno;
+        close(cf->fd);
+        return ret;
+    }
+
+    cf->map_len = st.st_size;
+    cf->n_samples = st.st_size / (2 * sizeof(int16_t));
+    if (cf->map_len == 0)
+        return 0;
+
+    void *p = mmap(NULL, cf->map_len, PROT_READ, MAP_SHARED, cf->fd, 0);
+    if (p == MAP_FAILED) {
+        int ret = -errno;
+        close(cf->fd);
+        cf->fd = -1;
+        return ret;
+    }
+    // файл читается в основном последовательно
+    madvise(p, cf->map_len, MADV_SEQUENTIAL);
+    cf->data = static_cast<const int16_t *>(p);
+    return 0;
+}
+
+/* Незакрытая запись (обрыв): индекс по заголовкам блоков */
+static int scan_blocks(struct capture_file *cf)
+{
+    std::vector<struct capture_index_entry> idx;
+    uint64_t off = sizeof(struct capture_iqz_hdr), first = 0;
+    while (off + IQC_BLOCK_HDR <= cf->file_len) {
+        const uint8_t *b = cf->file + off;
+        uint32_t len;
+        memcpy(&len, b + 8, 4);
+        long n = iqc_block_samples(b, cf->file_len - off);
+        if (n <= 0 || (uint64_t)n > cf->hdr.block_samples || len < IQC_BLOCK_HDR || len > cf->file_len - off)
+            break;
+        idx.push_back({off, first, len, (uint32_t)n});
+        off += len;
+        first += n;
+    }
+    cf->n_blocks = idx.size();
+    cf->index = static_cast<struct capture_index_entry *>(malloc((idx.size() + 1) * sizeof(idx[0])));
+    if (!cf->index)
+        return -ENOMEM;
+    memcpy(cf->index, idx.data(), idx.size() * sizeof(idx[0]));
+    cf->n_samples = first;
+    return 0;
+}
+
+static int open_iqz(struct capture_file *cf)
+{
+    cf->compressed = true;
+    cf->file = reinterpret_cast<const uint8_t *>(cf->data);
+    cf->file_len = cf->map_len;
+    cf->data = NULL;
+    memcpy(&cf->hdr, cf->file, sizeof(cf->hdr));
+    if (cf->hdr.version != CAPTURE_IQZ_VERSION || cf->hdr.block_samples == 0)
+        return -EINVAL;
+    // блоки читаются вразброс
+    madvise(const_cast<uint8_t *>(cf->file), cf->file_len, MADV_RANDOM);
+
+    if (cf->hdr.index_offset == 0)
+        return scan_blocks(cf);
+
+    if (cf->hdr.n_blocks > cf->file_len / sizeof(struct capture_index_entry))
+        return -EINVAL;
+    size_t idx_len = cf->hdr.n_blocks * sizeof(struct capture_index_entry);
+    if (cf->hdr.index_offset > cf->file_len || idx_len > cf->file_len - cf->hdr.index_offset)
+        return -EINVAL;
+    cf->n_blocks = cf->hdr.n_blocks;
+    cf->index = static_cast<struct capture_index_entry *>(malloc(idx_len + sizeof(struct capture_index_entry)));
+    if (!cf->index)
+        return -ENOMEM;
+    memcpy(cf->index, cf->file + cf->hdr.index_offset, idx_len);
+    cf->n_samples = cf->hdr.n_samples;
+    // блоки подряд и целиком внутри n_samples: capture_open пишет по first
+    uint64_t first = 0;
+    for (size_t b = 0; b < cf->n_blocks; b++) {
+        const struct capture_index_entry *e = &cf->index[b];
+        if (e->offset > cf->file_len || e->len > cf->file_len - e->offset || e->n > cf->hdr.block_samples ||
+            e->first != first || e->n > cf->n_samples - first)
+            return -EINVAL;
+        first += e->n;
+    }
+    if (first != cf->n_samples)
+        return -EINVAL;
+    return 0;
+}
+
+int capture_open_index(struct capture_file *cf, const char *path)
+{
+    int ret = map_file(cf, path);
+    if (ret < 0)
+        return ret;
+
+    if (cf->map_len >= sizeof(struct capture_iqz_hdr) &&
+        *reinterpret_cast<const uint32_t *>(cf->data) == CAPTURE_IQZ_MAGIC) {
+        ret = open_iqz(cf);
+        if (ret < 0) {
+            fprintf(stderr, "Unable to open %s: bad compressed capture\n", path);
+            capture_close(cf);
+            return ret;
+        }
+        if (cf->hdr.index_offset == 0)
+            printf("* %s: not closed, recovered %zu blocks\n", path, cf->n_blocks);
+    }
+    return 0;
+}
+
+int capture_open(struct capture_file *cf, const char *path)
+{
+    int ret = capture_open_index(cf, path);
+    if (ret < 0 || !cf->compressed || cf->n_samples == 0)
+        return ret;
+
+    // распаковка целиком: анонимное отображение вместо файла
+    size_t len = cf->n_samples * 2 * sizeof(int16_t);
+    void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        ret = -errno;
+        capture_close(cf);
+        return ret;
+    }
+    int16_t *dst = static_cast<int16_t *>(p);
+
+    struct work_pool pool;
+    work_pool_init(&pool, 0);
+    std::atomic<int> err(0);
+    for (size_t b = 0; b < cf->n_blocks; b++) {
+        work_pool_submit(&pool, [cf, b, dst, &err] {
+            long r = capture_read_block(cf, b, dst + 2 * cf->index[b].first);
+            if (r < 0)
+                err.store((int)r);
+        });
+    }
+    work_pool_wait(&pool);
+    work_pool_destroy(&pool);
+
+    if (err.load() < 0) {
+        fprintf(stderr, "Unable to decode %s: corrupted block\n", path);
+        munmap(p, len);
+        capture_close(cf);
+        return -EINVAL;
+    }
+    cf->data = dst;
+    cf->map_len = len;
+    return 0;
+}
+
+void capture_close(struct capture_file *cf)
+{
+    if (cf->compressed && cf->file)
+        munmap(const_cast<uint8_t *>(cf->file), cf->file_len);
+    if (cf->data)
+        munmap(const_cast<int16_t *>(cf->data), cf->map_len);
+    if (cf->fd >= 0)
+        close(cf->fd);
+    free(cf->index);
+    free(cf->cache);
+    memset(cf, 0, sizeof(*cf));
+    cf->fd = -1;
+}
+
+long capture_read_block(const struct capture_file *cf, size_t b, int16_t *out)
+{
+    if (b >= cf->n_blocks)
+        return -EINVAL;
+    const struct capture_index_entry *e = &cf->index[b];
+    // не больше, чем обещает индекс: out рассчитан ровно на e->n
+    long n = iqc_decode(cf->file + e->offset, e->len, out, e->n);
+    if (n >= 0 && (uint32_t)n != e->n)
+        return -EINVAL;
+    return n;
+}
+
+/* Блок, содержащий сэмпл index (блоки идут подряд) */
+static size_t find_block(const struct capture_file *cf, size_t index)
+{
+    size_t lo = 0, hi = cf->n_blocks;
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+        if (cf->index[mid].first <= index)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+long capture_read(struct capture_file *cf, size_t start, size_t n, int16_t *out)
+{
+    if (start >= cf->n_samples)
+        return 0;
+    if (n > cf->n_samples - start)
+        n = cf->n_samples - start;
+    if (!cf->compressed || cf->data) {
+        memcpy(out, capture_samples(cf, start), n * 2 * sizeof(int16_t));
+        return (long)n;
+    }
+
+    if (!cf->cache) {
+        cf->cache = static_cast<int16_t *>(malloc(cf->hdr.block_samples * 2 * sizeof(int16_t)));
+        if (!cf->cache)
+            return -ENOMEM;
+        cf->cache_block = (size_t)-1;
+    }
+    size_t done = 0;
+    size_t b = find_block(cf, start);
+    while (done < n && b < cf->n_blocks) {
+        const struct capture_index_entry *e = &cf->index[b];
+        if (cf->cache_block != b) {
+            long r = capture_read_block(cf, b, cf->cache);
+            if (r < 0) {
+                cf->cache_block = (size_t)-1;
+                return r;
+            }
+            cf->cache_block = b;
+        }
+        size_t from = start + done - e->first;
+        size_t take = e->n - from < n - done ? e->n - from : n - done;
+        memcpy(out + 2 * done, cf->cache + 2 * from, take * 2 * sizeof(int16_t));
+        done += take;
+        b++;
+    }
+    return (long)done;
+}
+
+/* ---------- запись ---------- */
+
+void capture_writer_default_cfg(struct capture_writer_cfg *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->block_samples = 65536;
+    cfg->level = 1;
+    cfg->max_jobs = 64;
+}
+
+static bool write_full(int fd, const void *buf, size_t len, off_t off)
+{
+    const char *p = static_cast<const char *>(buf);
+    while (len > 0) {
+        ssize_t r = pwrite(fd, p, len, off);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return false;
+        p += r;
+        len -= r;
+        off += r;
+    }
+    return true;
+}
+
+/* Записать готовые блоки с головы очереди; в файл пишет один поток за раз */
+static void flush_ready(struct capture_writer *w, std::unique_lock<std::mutex> &guard)
+{
+    if (w->flushing)
+        return;
+    w->flushing = true;
+    while (!w->jobs.empty() && w->jobs.front()->done) {
+        struct capture_job *job = w->jobs.front();
+        w->jobs.pop_front();
+        uint64_t off = w->offset;
+        w->offset += job->len;
+        w->index.push_back({off, w->hdr.n_samples, (uint32_t)job->len, (uint32_t)job->n});
+        w->hdr.n_samples += job->n;
+        w->raw_bytes += job->n * 2 * sizeof(int16_t);
+
+        guard.unlock();
+        int ret = write_full(w->fd, job->out.data(), job->len, off) ? 0 : -errno;
+        guard.lock();
+        if (ret < 0 && w->error == 0)
+            w->error = ret;
+        w->spare.push_back(job);
+    }
+    w->flushing = false;
+    w->cv.notify_all();
+}
+
+static struct capture_job *get_job(struct capture_writer *w)
+{
+    struct capture_job *job;
+    {
+        std::lock_guard<std::mutex> guard(w->lock);
+        if (!w->spare.empty()) {
+            job = w->spare.back();
+            w->spare.pop_back();
+            job->n = 0;
+            return job;
+        }
+    }
+    job = new capture_job();
+    job->iq.resize(w->cfg.block_samples * 2);
+    job->out.resize(iqc_bound(w->cfg.block_samples));
+    job->n = 0;
+    return job;
+}
+
+static void submit_job(struct capture_writer *w, struct capture_job *job)
+{
+    std::unique_lock<std::mutex> guard(w->lock);
+    // ограничение памяти: ждём, пока пул и диск разберут очередь
+    w->cv.wait(guard, [w] { return w->jobs.size() < w->cfg.max_jobs; });
+    job->done = false;
+    w->jobs.push_back(job);
+    guard.unlock();
+
+    work_pool_submit(w->pool, [w, job] {
+        job->len = iqc_encode(job->iq.data(), job->n, job->out.data(), w->cfg.level);
+        std::unique_lock<std::mutex> g(w->lock);
+        job->done = true;
+        flush_ready(w, g);
+    });
+}
+
+int capture_writer_open(struct capture_writer *w, const char *path, const struct capture_writer_cfg *cfg)
+{
+    w->cfg = *cfg;
+    if (w->cfg.block_samples == 0 || w->cfg.max_jobs == 0)
+        return -EINVAL;
+    w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (w->fd < 0) {
+        fprintf(stderr, "Unable to create %s: %s\n", path, strerror(errno));
+        return -errno;
+    }
+
+    memset(&w->hdr, 0, sizeof(w->hdr));
+    w->hdr.magic = CAPTURE_IQZ_MAGIC;
+    w->hdr.version = CAPTURE_IQZ_VERSION;
+    w->hdr.block_samples = (uint32_t)w->cfg.block_samples;
+    w->hdr.level = (uint32_t)w->cfg.level;
+    w->hdr.fs_hz = w->cfg.fs_hz;
+    if (!write_full(w->fd, &w->hdr, sizeof(w->hdr), 0)) {
+        int ret = -errno;
+        close(w->fd);
+        return ret;
+    }
+    w->offset = sizeof(w->hdr);
+    w->raw_bytes = 0;
+    w->error = 0;
+    w->flushing = false;
+    w->jobs.clear();
+    w->spare.clear();
+    w->index.clear();
+
+    w->own_pool = cfg->pool == NULL;
+    w->pool = cfg->pool;
+    if (w->own_pool) {
+        w->pool = new work_pool();
+        work_pool_init(w->pool, cfg->threads);
+    }
+    w->fill = get_job(w);
+    return 0;
+}
+
+int capture_writer_write(struct capture_writer *w, const int16_t *iq, size_t n)
+{
+    const size_t bs = w->cfg.block_samples;
+    while (n > 0) {
+        struct capture_job *job = w->fill;
+        size_t take = bs - job->n < n ? bs - job->n : n;
+        memcpy(job->iq.data() + 2 * job->n, iq, take * 2 * sizeof(int16_t));
+        job->n += take;
+        iq += 2 * take;
+        n -= take;
+        if (job->n == bs) {
+            submit_job(w, job);
+            w->fill = get_job(w);
+        }
+    }
+    std::lock_guard<std::mutex> guard(w->lock);
+    return w->error;
+}
+
+int capture_writer_close(struct capture_writer *w)
+{
+    if (w->fill->n > 0) {
+        submit_job(w, w->fill);
+    } else {
+        // spare пополняют и потоки пула (flush_ready)
+        std::lock_guard<std::mutex> guard(w->lock);
+        w->spare.push_back(w->fill);
+    }
+    w->fill = NULL;
+
+    {
+        std::unique_lock<std::mutex> guard(w->lock);
+        w->cv.wait(guard, [w] { return w->jobs.empty() && !w->flushing; });
+    }
+    if (w->own_pool) {
+        work_pool_destroy(w->pool);
+        delete w->pool;
+    }
+    w->pool = NULL;
+
+    int ret = w->error;
+    size_t idx_len = w->index.size() * sizeof(struct capture_index_entry);
+    w->hdr.n_blocks = w->index.size();
+    w->hdr.index_offset = w->offset;
+    if (ret == 0 && (!write_full(w->fd, w->index.data(), idx_len, w->offset) ||
+                     !write_full(w->fd, &w->hdr, sizeof(w->hdr), 0)))
+        ret = -errno;
+    if (close(w->fd) < 0 && ret == 0)
+        ret = -errno;
+    w->fd = -1;
+
+    for (struct capture_job *job : w->spare)
+        delete job;
+    w->spare.clear();
+    w->index.clear();
+    return ret;
+}
@@ -0,0 +1,133 @@
+#ifndef CAPTURE_FILE_H
+#define CAPTURE_FILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+struct work_pool;
+
+/*
+ * Чтение записанных I/Q: int16, I/Q чередуются (как пишет soapy_pluto и
+ * читает plot_pcm.py::read_iq_data). Файл отображается в память (mmap),
+ * сэмплы доступны напрямую без копирования.
+ *
+ * Сжатые записи (.iqz, см. iq_codec.h): заголовок, независимо сжатые блоки
+ * по block_samples сэмплов и индекс блоков в конце файла. capture_open()
+ * распаковывает такую запись целиком (параллельно), capture_open_index()
+ * читает только индекс - сэмплы берутся через capture_read() с
+ * распаковкой нужных блоков.
+ */
+
+#define CAPTURE_IQZ_MAGIC       0x315a5149u     // "IQZ1"
+#define CAPTURE_IQZ_VERSION     1
+
+struct capture_iqz_hdr {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t n_samples;
+    uint64_t n_blocks;
+    uint64_t index_offset;      // 0 - запись не закрыта, индекс строится по блокам
+    uint32_t block_samples;
+    uint32_t level;
+    double fs_hz;               // 0 - неизвестна
+    uint8_t reserved[16];
+};
+
+struct capture_index_entry {
+    uint64_t offset;            // от начала файла
+    uint64_t first;             // номер первого сэмпла блока
+    uint32_t len;               // байт
+    uint32_t n;                 // сэмплов
+};
+
+struct capture_file {
+    int fd;
+    const int16_t *data;    // interleaved I/Q; NULL после capture_open_index()
+    size_t n_samples;       // пар I/Q
+    size_t map_len;
+
+    // только для .iqz
+    bool compressed;
+    const uint8_t *file;            // отображение сжатого файла
+    size_t file_len;
+    struct capture_iqz_hdr hdr;
+    struct capture_index_entry *index;
+    size_t n_blocks;
+    int16_t *cache;                 // последний распакованный блок capture_read()
+    size_t cache_block;
+};
+
+int capture_open(struct capture_file *cf, const char *path);
+int capture_open_index(struct capture_file *cf, const char *path);
+void capture_close(struct capture_file *cf);
+
+/* Указатель на сэмпл index (пара I/Q) */
+static inline const int16_t *capture_samples(const struct capture_file *cf, size_t index)
+{
+    return cf->data + 2 * index;
+}
+
+/*
+ * Скопировать n сэмплов начиная со start в out. Возвращает число
+ * скопированных (меньше n в конце записи) или отрицательный errno.
+ * Для .iqz держит кэш одного блока - один читатель на capture_file.
+ */
+long capture_read(struct capture_file *cf, size_t start, size_t n, int16_t *out);
+
+/* Распаковать блок b индекса в out (не меньше hdr.block_samples сэмплов); потокобезопасно */
+long capture_read_block(const struct capture_file *cf, size_t b, int16_t *out);
+
+/*
+ * Запись .iqz: сэмплы копятся в блоки, блоки сжимаются задачами work_pool,
+ * в файл идут в исходном порядке из потока пула, закончившего сжатие
+ * первым в очереди. capture_writer_write() только копирует и ставит задачи;
+ * ждёт, лишь если в работе больше max_jobs блоков (диск/CPU не успевают).
+ */
+struct capture_writer_cfg {
+    size_t block_samples;
+    int level;                  // см. iqc_encode()
+    double fs_hz;
+    size_t threads;             // 0 - по числу ядер (если pool == NULL)
+    struct work_pool *pool;     // общий пул или NULL - свой
+    size_t max_jobs;
+};
+
+void capture_writer_default_cfg(struct capture_writer_cfg *cfg);
+
+struct capture_job {
+    std::vector<int16_t> iq;
+    std::vector<uint8_t> out;
+    size_t n, len;
+    bool done;
+};
+
+struct capture_writer {
+    struct capture_writer_cfg cfg;
+    int fd;
+    struct capture_iqz_hdr hdr;
+    struct work_pool *pool;
+    bool own_pool;
+
+    struct capture_job *fill;                   // заполняемый блок
+    std::mutex lock;
+    std::condition_variable cv;
+    std::deque<struct capture_job *> jobs;      // в порядке файла
+    std::vector<struct capture_job *> spare;
+    bool flushing;                              // какой-то поток пишет в файл
+    std::vector<struct capture_index_entry> index;
+    uint64_t offset;
+    uint64_t raw_bytes;
+    int error;
+};
+
+int capture_writer_open(struct capture_writer *w, const char *path, const struct capture_writer_cfg *cfg);
+int capture_writer_write(struct capture_writer *w, const int16_t *iq, size_t n);
+/* Дописать последний блок и индекс; 0 или первая ошибка записи */
+int capture_writer_close(struct capture_writer *w);
+
+#endif // CAPTURE_FILE_H
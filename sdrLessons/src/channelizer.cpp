@@ -0,0 +1,179 @@
+#include "channelizer.h"
+#include "simd_ops.h"
+
+#include <math.h>
+#include <string.h>
+#include <errno.h>
+
+#include <algorithm>
+
+void channelizer_default_cfg(struct channelizer_cfg *cfg, unsigned nchan)
+{
+    cfg->nchan = nchan;
+    cfg->oversample = 2;
+    cfg->taps = 12;
+    cfg->batch = 16;
+}
+
+static double bessel_i0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12)
+            break;
+    }
+    return sum;
+}
+
+int channelizer_init(struct channelizer *ch, const struct channelizer_cfg *cfg)
+{
+    const unsigned M = cfg->nchan;
+    if (M < 2 || (M & (M - 1)) || (cfg->oversample != 1 && cfg->oversample != 2) || cfg->taps == 0 ||
+        cfg->batch == 0)
+        return -EINVAL;
+    ch->cfg = *cfg;
+    ch->decim = M / cfg->oversample;
+    ch->len = (size_t)cfg->taps * M;
+    int ret = fft_plan_init(&ch->plan, M, true);
+    if (ret < 0)
+        return ret;
+
+    // прототип: sinc с окном Кайзера, срез fs / (2M), сумма 1 (тон в центре канала - с той же амплитудой)
+    const size_t L = ch->len;
+    const double beta = 8.0;
+    const double c = (L - 1) / 2.0;
+    const double cutoff = 0.5 / M;
+    std::vector<double> h(L);
+    double sum = 0.0;
+    for (size_t k = 0; k < L; k++) {
+        double t = (double)k - c;
+        double sinc = t == 0.0 ? 2.0 * cutoff : sin(2.0 * M_PI * cutoff * t) / (M_PI * t);
+        double w = t / c;
+        h[k] = sinc * bessel_i0(beta * sqrt(fmax(0.0, 1.0 - w * w))) / bessel_i0(beta);
+        sum += h[k];
+    }
+    ch->h2.resize(2 * L);
+    for (size_t j = 0; j < L; j++) {
+        float v = (float)(h[L - 1 - j] / sum);
+        ch->h2[2 * j] = v;
+        ch->h2[2 * j + 1] = v;
+    }
+    ch->hist.resize(4 * L);
+    ch->acc.resize(2 * (size_t)M);
+    ch->work.resize(cfg->batch * M);
+    channelizer_reset(ch);
+    return 0;
+}
+
+void channelizer_reset(struct channelizer *ch)
+{
+    std::fill(ch->hist.begin(), ch->hist.end(), 0.0f);
+    ch->hpos = 0;
+    ch->fill = 0;
+    ch->m = 0;
+    ch->nwork = 0;
+}
+
+/* Окно -> nchan точек перед БПФ: v[r] = sum_p h[r + pM] x[mD - r - pM] */
+static void fold(struct channelizer *ch, cf_t *v)
+{
+    const unsigned M = ch->cfg.nchan;
+    const size_t M2 = 2 * (size_t)M;
+    const float *win = &ch->hist[2 * ch->hpos];     // старейший .. новейший
+    const float *h2 = ch->h2.data();
+    float *w = ch->acc.data();
+
+    memset(w, 0, M2 * sizeof(float));
+    for (unsigned p = 0; p < ch->cfg.taps; p++)
+        simd_mac_f32(w, h2 + p * M2, win + p * M2, M2);
+    // z[j] с j = M - 1 - r (mod M) - отсюда обратный порядок
+    for (unsigned r = 0; r < M; r++)
+        v[r] = cf_t(w[2 * (M - 1 - r)], w[2 * (M - 1 - r) + 1]);
+}
+
+/* Обратное БПФ накопленной пачки и раздача по каналам */
+static void flush_work(struct channelizer *ch, std::vector<cf_t> *out)
+{
+    const unsigned M = ch->cfg.nchan;
+    if (ch->nwork == 0)
+        return;
+    fft_execute_batch(&ch->plan, ch->work.data(), ch->work.data(), ch->nwork);
+    long long m0 = ch->m - (long long)ch->nwork;
+    for (unsigned c = 0; c < M; c++) {
+        std::vector<cf_t> &o = out[c];
+        size_t base = o.size();
+        o.resize(base + ch->nwork);
+        for (size_t b = 0; b < ch->nwork; b++) {
+            cf_t y = ch->work[b * M + c];
+            // D = M / 2: множитель exp(-j pi c m) = (-1)^(c m)
+            if (ch->cfg.oversample == 2 && (c & (m0 + b) & 1))
+                y = -y;
+            o[base + b] = y;
+        }
+    }
+    ch->nwork = 0;
+}
+
+size_t channelizer_process(struct channelizer *ch, const cf_t *x, size_t n, std::vector<cf_t> *out)
+{
+    const size_t L = ch->len;
+    const unsigned M = ch->cfg.nchan;
+    size_t produced = 0;
+
+    for (size_t k = 0; k < n; k++) {
+        float re = x[k].real(), im = x[k].imag();
+        ch->hist[2 * ch->hpos] = re;
+        ch->hist[2 * ch->hpos + 1] = im;
+        ch->hist[2 * (ch->hpos + L)] = re;
+        ch->hist[2 * (ch->hpos + L) + 1] = im;
+        if (++ch->hpos == L)
+            ch->hpos = 0;
+        if (++ch->fill < ch->decim)
+            continue;
+        ch->fill = 0;
+        fold(ch, &ch->work[ch->nwork * M]);
+        ch->nwork++;
+        ch->m++;
+        produced++;
+        if (ch->nwork == ch->cfg.batch)
+            flush_work(ch, out);
+    }
+    flush_work(ch, out);
+    return produced;
+}
+
+size_t channelizer_process_iq16(struct channelizer *ch, const int16_t *iq, size_t n, std::vector<cf_t> *out)
+{
+    cf_t tmp[1024];
+    size_t produced = 0;
+
+    while (n > 0) {
+        size_t chunk = n < 1024 ? n : 1024;
+        for (size_t k = 0; k < chunk; k++)
+            tmp[k] = cf_t(iq[2 * k] / 2048.0f, iq[2 * k + 1] / 2048.0f);
+        produced += channelizer_process(ch, tmp, chunk, out);
+        iq += 2 * chunk;
+        n -= chunk;
+    }
+    return produced;
+}
+
+double channelizer_chan_offset(const struct channelizer *ch, unsigned c, double fs)
+{
+    const unsigned M = ch->cfg.nchan;
+    int k = c < M / 2 ? (int)c : (int)c - (int)M;
+    return k * fs / M;
+}
+
+void channelizer_dispatch(struct work_pool *pool, const std::vector<cf_t> *out, const unsigned *chans,
+                          size_t count, channel_fn fn, void *user)
+{
+    for (size_t k = 0; k < count; k++) {
+        unsigned c = chans[k];
+        const std::vector<cf_t> *y = &out[c];
+        work_pool_submit(pool, [fn, c, y, user]() { fn(c, y->data(), y->size(), user); });
+    }
+    work_pool_wait(pool);
+}
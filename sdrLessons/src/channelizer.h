@@ -0,0 +1,78 @@
+#ifndef CHANNELIZER_H
+#define CHANNELIZER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "dsp_types.h"
+#include "fft.h"
+#include "work_pool.h"
+
+/*
+ * Полифазный банк фильтров (PFB): один широкий поток -> nchan равноотстоящих
+ * узких каналов, канал c - на частоте c * fs / nchan (c >= nchan / 2 -
+ * отрицательные частоты, как np.fft.fftfreq), выход с шагом decim = nchan / oversample.
+ *
+ * На каждый выходной отсчёт: окно последних taps * nchan сэмплов умножается
+ * на прототип ФНЧ (Кайзер, срез fs / (2 * nchan)), складывается по фазам в
+ * nchan точек и идёт в одно обратное БПФ (пачкой через fft_execute_batch).
+ * Цена на входной сэмпл - taps * oversample умножений и log2(nchan) от БПФ,
+ * а не nchan отдельных DDC.
+ *
+ * oversample = 1 - критическая дискретизация (края каналов заворачиваются
+ * в соседние), oversample = 2 - выход на 2 * fs / nchan, края чистые.
+ */
+
+struct channelizer_cfg {
+    unsigned nchan;         // степень двойки
+    unsigned oversample;    // 1 или 2
+    unsigned taps;          // коэффициентов прототипа на ветвь
+    size_t batch;           // выходных векторов на одно БПФ пачкой
+};
+
+void channelizer_default_cfg(struct channelizer_cfg *cfg, unsigned nchan);
+
+struct channelizer {
+    struct channelizer_cfg cfg;
+    unsigned decim;
+    size_t len;                 // taps * nchan
+    std::vector<float> h2;      // прототип в обратном порядке, продублирован для I/Q
+    struct fft_plan plan;       // обратное
+
+    std::vector<float> hist;    // interleaved I/Q, удвоенная линия задержки
+    size_t hpos;
+    unsigned fill;              // сэмплов с последнего выхода
+    long long m;                // номер следующего выходного отсчёта
+    std::vector<float> acc;     // свёртка по фазам, 2 * nchan
+
+    std::vector<cf_t> work;     // batch * nchan
+    size_t nwork;
+};
+
+int channelizer_init(struct channelizer *ch, const struct channelizer_cfg *cfg);
+void channelizer_reset(struct channelizer *ch);
+
+/*
+ * n входных сэмплов; выход канала c добавляется в out[c] (out - nchan
+ * векторов). Возвращает число новых отсчётов на канал.
+ */
+size_t channelizer_process(struct channelizer *ch, const cf_t *x, size_t n, std::vector<cf_t> *out);
+
+/* int16 I/Q, масштаб 1/2048 */
+size_t channelizer_process_iq16(struct channelizer *ch, const int16_t *iq, size_t n, std::vector<cf_t> *out);
+
+/* Сдвиг центра канала c от LO, Гц */
+double channelizer_chan_offset(const struct channelizer *ch, unsigned c, double fs);
+
+/* Обработчик канала: выход канала chan за блок, вызывается в потоке пула */
+typedef void (*channel_fn)(unsigned chan, const cf_t *y, size_t n, void *user);
+
+/*
+ * Раздать выход каналов chans[0..count) по потокам пула (fn на каждый канал)
+ * и дождаться всех. Каналы независимы: у каждого своё состояние в user.
+ */
+void channelizer_dispatch(struct work_pool *pool, const std::vector<cf_t> *out, const unsigned *chans,
+                          size_t count, channel_fn fn, void *user);
+
+#endif // CHANNELIZER_H
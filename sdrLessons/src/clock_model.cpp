@@ -0,0 +1,198 @@
+#include "clock_model.h"
+
+#include <math.h>
+#include <errno.h>
+#include <algorithm>
+
+void clock_model_default_cfg(struct clock_model_cfg *cfg, double fs_hz)
+{
+    cfg->fs_hz = fs_hz;
+    cfg->window = 512;          // ~25 с при 50 мс
+    cfg->min_points = 8;
+    cfg->period_ms = 50.0;
+    cfg->max_ppm = 200.0;
+    cfg->reject = 4.0;
+    cfg->latency_ns = 0;
+}
+
+int clock_model_init(struct clock_model *cm, const struct clock_model_cfg *cfg)
+{
+    if (cfg->fs_hz <= 0.0 || cfg->window < 2 || cfg->min_points < 2 || cfg->min_points > cfg->window)
+        return -EINVAL;
+    cm->cfg = *cfg;
+    cm->x.assign(cfg->window, 0.0);
+    cm->y.assign(cfg->window, 0.0);
+    cm->r.assign(cfg->window, 0.0);
+    cm->tmp.assign(cfg->window, 0.0);
+    cm->seq.store(0);
+    cm->a.store(0.0);
+    cm->b.store(0.0);
+    clock_model_reset(cm);
+    return 0;
+}
+
+void clock_model_reset(struct clock_model *cm)
+{
+    cm->seq.fetch_add(1, std::memory_order_acq_rel);
+    cm->valid.store(false, std::memory_order_relaxed);
+    cm->seq.fetch_add(1, std::memory_order_release);
+
+    cm->have_ref = false;
+    cm->ref_index = 0;
+    cm->ref_ns = 0;
+    cm->count = cm->pos = 0;
+    cm->cand_valid = false;
+    cm->interval_start = 0;
+    cm->ppm = cm->jitter_ns = 0.0;
+    cm->inliers = 0;
+    cm->fits = cm->rejected = 0;
+}
+
+static double median(double *v, size_t n)
+{
+    std::nth_element(v, v + n / 2, v + n);
+    return v[n / 2];
+}
+
+/* МНК по точкам с mask != 0 (mask == NULL - все), x центрируется */
+static bool lsq(const struct clock_model *cm, const double *mask, double *a, double *b)
+{
+    double n = 0.0, sx = 0.0, sy = 0.0;
+    for (size_t k = 0; k < cm->count; k++) {
+        if (mask && mask[k] == 0.0)
+            continue;
+        n += 1.0;
+        sx += cm->x[k];
+        sy += cm->y[k];
+    }
+    if (n < 2.0)
+        return false;
+    double mx = sx / n, my = sy / n, sxx = 0.0, sxy = 0.0;
+    for (size_t k = 0; k < cm->count; k++) {
+        if (mask && mask[k] == 0.0)
+            continue;
+        double dx = cm->x[k] - mx;
+        sxx += dx * dx;
+        sxy += dx * (cm->y[k] - my);
+    }
+    if (sxx <= 0.0)
+        return false;
+    *b = sxy / sxx;
+    *a = my - *b * mx;
+    return true;
+}
+
+static void fit(struct clock_model *cm)
+{
+    size_t n = cm->count;
+    double a, b;
+    if (!lsq(cm, NULL, &a, &b))
+        return;
+
+    for (size_t k = 0; k < n; k++)
+        cm->r[k] = cm->y[k] - a - b * cm->x[k];
+    std::copy(cm->r.begin(), cm->r.begin() + n, cm->tmp.begin());
+    double med = median(cm->tmp.data(), n);
+    for (size_t k = 0; k < n; k++)
+        cm->tmp[k] = fabs(cm->r[k] - med);
+    double sigma = 1.4826 * median(cm->tmp.data(), n);
+    double thr = cm->cfg.reject * sigma + 1000.0;      // не меньше 1 мкс
+
+    // r[] -> маска годных точек
+    size_t good = 0;
+    for (size_t k = 0; k < n; k++) {
+        bool ok = fabs(cm->r[k] - med) <= thr;
+        cm->r[k] = ok ? 1.0 : 0.0;
+        good += ok;
+    }
+    if (good < cm->cfg.min_points || !lsq(cm, cm->r.data(), &a, &b))
+        return;
+
+    // нижняя огибающая
+    double low = INFINITY;
+    for (size_t k = 0; k < n; k++)
+        if (cm->r[k] != 0.0)
+            low = fmin(low, cm->y[k] - a - b * cm->x[k]);
+    a += low;
+
+    double ppm = (b * cm->cfg.fs_hz * 1e-9 - 1.0) * 1e6;
+    cm->fits++;
+    if (fabs(ppm) > cm->cfg.max_ppm) {
+        cm->rejected++;
+        return;
+    }
+    cm->ppm = ppm;
+    cm->jitter_ns = sigma;
+    cm->inliers = good;
+
+    cm->seq.fetch_add(1, std::memory_order_acq_rel);
+    cm->a.store(a, std::memory_order_relaxed);
+    cm->b.store(b, std::memory_order_relaxed);
+    cm->valid.store(true, std::memory_order_relaxed);
+    cm->seq.fetch_add(1, std::memory_order_release);
+}
+
+void clock_model_update(struct clock_model *cm, long long index_end, int64_t host_ns)
+{
+    if (!cm->have_ref) {
+        // параметры модели считаются относительно первого наблюдения
+        cm->have_ref = true;
+        cm->ref_index = index_end;
+        cm->ref_ns = host_ns;
+        cm->interval_start = host_ns;
+    }
+    double x = (double)(index_end - cm->ref_index);
+    double y = (double)(host_ns - cm->ref_ns);
+    double d = y - x * 1e9 / cm->cfg.fs_hz;         // задержка против номинала
+
+    if (host_ns - cm->interval_start >= (int64_t)(cm->cfg.period_ms * 1e6) && cm->cand_valid) {
+        cm->x[cm->pos] = cm->cand_x;
+        cm->y[cm->pos] = cm->cand_y;
+        cm->pos = (cm->pos + 1) % cm->cfg.window;
+        if (cm->count < cm->cfg.window)
+            cm->count++;
+        cm->cand_valid = false;
+        cm->interval_start = host_ns;
+        if (cm->count >= cm->cfg.min_points)
+            fit(cm);
+    }
+    if (!cm->cand_valid || d < cm->cand_d) {
+        cm->cand_valid = true;
+        cm->cand_x = x;
+        cm->cand_y = y;
+        cm->cand_d = d;
+    }
+}
+
+/* Согласованный снимок модели */
+static bool snapshot(const struct clock_model *cm, double *a, double *b)
+{
+    for (;;) {
+        uint32_t s0 = cm->seq.load(std::memory_order_acquire);
+        if (s0 & 1)
+            continue;
+        bool valid = cm->valid.load(std::memory_order_relaxed);
+        *a = cm->a.load(std::memory_order_relaxed);
+        *b = cm->b.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (cm->seq.load(std::memory_order_relaxed) == s0)
+            return valid;
+    }
+}
+
+int64_t clock_model_host_ns(const struct clock_model *cm, long long index)
+{
+    double a, b;
+    if (!snapshot(cm, &a, &b))
+        return 0;
+    return cm->ref_ns + llround(a + b * (double)(index - cm->ref_index)) - cm->cfg.latency_ns;
+}
+
+long long clock_model_index(const struct clock_model *cm, int64_t host_ns)
+{
+    double a, b;
+    if (!snapshot(cm, &a, &b))
+        return -1;
+    double t = (double)(host_ns + cm->cfg.latency_ns - cm->ref_ns);
+    return cm->ref_index + llround((t - a) / b);
+}
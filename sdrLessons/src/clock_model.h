@@ -0,0 +1,88 @@
+#ifndef CLOCK_MODEL_H
+#define CLOCK_MODEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <atomic>
+
+/*
+ * Модель "номер сэмпла -> CLOCK_MONOTONIC" для прямого libiio (метки
+ * времени есть только у Soapy, timestamp_every=1920).
+ *
+ *   t(i) = t_ref + a + b * (i - i_ref) - latency_ns
+ *
+ * Наблюдение - блок: сэмпл index_end (следующий за блоком) готов к
+ * host_ns. Задержка доставки всегда положительна и с хвостом (планировщик,
+ * USB/сеть), поэтому:
+ *   - за каждые period_ms остаётся одно наблюдение - самое раннее
+ *     относительно номинальной fs (нижняя огибающая);
+ *   - окно из window таких точек; МНК, отброс выбросов по медиане/MAD
+ *     (reject * sigma), повторный МНК по оставшимся, сдвиг прямой под
+ *     самую раннюю из них;
+ *   - уход больше max_ppm от номинала - подгонка не принимается.
+ * Окно скользит - модель следит за дрейфом кварца и подстройкой часов
+ * хоста. Пропуск сэмплов (переполнение DMA) сдвигает прямую, модель
+ * догоняет за пол-окна.
+ *
+ * latency_ns - постоянная часть задержки АЦП -> DMA, снаружи не видна,
+ * задаётся калибровкой (петля TX -> RX, sdr_autotune). Для TX наблюдение -
+ * освобождение блока DMA, ЦАП позже: latency_ns отрицательная.
+ *
+ * Обновляет один поток (RX или TX), читать можно из любых: параметры
+ * публикуются под seqlock, оценка стоит несколько умножений.
+ */
+
+struct clock_model_cfg {
+    double fs_hz;               // номинальная частота дискретизации
+    size_t window;              // точек в подгонке
+    size_t min_points;          // до этого модели нет
+    double period_ms;           // одна точка на интервал
+    double max_ppm;
+    double reject;              // порог выброса в sigma (1.4826 * MAD)
+    int64_t latency_ns;
+};
+
+void clock_model_default_cfg(struct clock_model_cfg *cfg, double fs_hz);
+
+struct clock_model {
+    struct clock_model_cfg cfg;
+
+    /* точки окна относительно первого наблюдения */
+    bool have_ref;
+    long long ref_index;
+    int64_t ref_ns;
+    std::vector<double> x, y;           // кольцо на window точек
+    size_t count, pos;
+    std::vector<double> r, tmp;
+
+    /* лучшее наблюдение текущего интервала */
+    bool cand_valid;
+    double cand_x, cand_y, cand_d;
+    int64_t interval_start;
+
+    /* опубликованная модель: seq нечётный - пишется */
+    std::atomic<uint32_t> seq;
+    std::atomic<bool> valid;
+    std::atomic<double> a, b;           // нс и нс/сэмпл
+
+    /* диагностика (поток обновления) */
+    double ppm;                         // уход от номинала
+    double jitter_ns;                   // разброс точек окна (sigma)
+    size_t inliers;
+    uint64_t fits, rejected;
+};
+
+int clock_model_init(struct clock_model *cm, const struct clock_model_cfg *cfg);
+void clock_model_reset(struct clock_model *cm);
+
+/* Наблюдение: сэмпл index_end готов к host_ns (CLOCK_MONOTONIC) */
+void clock_model_update(struct clock_model *cm, long long index_end, int64_t host_ns);
+
+/* CLOCK_MONOTONIC сэмпла index; 0 - модели ещё нет */
+int64_t clock_model_host_ns(const struct clock_model *cm, long long index);
+
+/* Номер сэмпла в момент host_ns (планирование TX); -1 - модели ещё нет */
+long long clock_model_index(const struct clock_model *cm, int64_t host_ns);
+
+#endif // CLOCK_MODEL_H
@@ -0,0 +1,297 @@
+#include "ddc.h"
+#include "simd_ops.h"
+
+#include <math.h>
+#include <string.h>
+#include <errno.h>
+
+#include <algorithm>
+
+#define NCO_TAB         256
+#define CHUNK           4096
+#define TWO_POW_64      18446744073709551616.0
+
+void ddc_default_cfg(struct ddc_cfg *cfg, double fs)
+{
+    cfg->fs = fs;
+    cfg->freq = 0.0;
+    cfg->cic_decim = 8;
+    cfg->cic_order = 5;
+    cfg->hb_stages = 2;
+    cfg->cfir_taps = 21;
+}
+
+static double bessel_i0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12)
+            break;
+    }
+    return sum;
+}
+
+static double kaiser(size_t k, size_t n, double beta)
+{
+    double c = (n - 1) / 2.0;
+    double w = ((double)k - c) / c;
+    return bessel_i0(beta * sqrt(fmax(0.0, 1.0 - w * w))) / bessel_i0(beta);
+}
+
+static void fir_init(struct ddc_fir *f, const std::vector<double> &h)
+{
+    f->ntaps = (unsigned)h.size();
+    f->h2.resize(2 * h.size());
+    for (size_t m = 0; m < h.size(); m++) {
+        f->h2[2 * m] = (float)h[h.size() - 1 - m];
+        f->h2[2 * m + 1] = (float)h[h.size() - 1 - m];
+    }
+    f->hist.assign(4 * h.size(), 0.0f);
+    f->pos = 0;
+}
+
+static inline cf_t fir_push(struct ddc_fir *f, cf_t x)
+{
+    const size_t n = f->ntaps;
+    f->hist[2 * f->pos] = f->hist[2 * (f->pos + n)] = x.real();
+    f->hist[2 * f->pos + 1] = f->hist[2 * (f->pos + n) + 1] = x.imag();
+    if (++f->pos == n)
+        f->pos = 0;
+    float re, im;
+    simd_dot_cf_rf2(&f->hist[2 * f->pos], f->h2.data(), 2 * n, &re, &im);
+    return cf_t(re, im);
+}
+
+/*
+ * Полуполосный ФНЧ на 4m + 3 коэффициента для ступени, после которой до
+ * выхода остаётся ещё rest ступеней: полоса +-0.4 fs_out не трогается,
+ * переход сужается к последней ступени.
+ */
+static void halfband_init(struct ddc_halfband *hb, unsigned rest)
+{
+    const double A = 90.0;
+    const double beta = 0.1102 * (A - 8.7);
+    double fp = 0.4 / (double)(2u << rest);
+    double tb = 0.5 - 2.0 * fp;
+    size_t n = (size_t)ceil((A - 8.0) / (2.285 * 2.0 * M_PI * tb)) + 1;
+    size_t m = n / 4 > 1 ? n / 4 : 1;      // 4m + 3 >= n
+    n = 4 * m + 3;
+
+    const double c = (n - 1) / 2.0;
+    std::vector<double> even(2 * m + 2);
+    double sum = 0.0;
+    for (size_t j = 0; j < even.size(); j++) {
+        double t = 2.0 * j - c;     // нечётное: 0.5 sinc(t / 2) ненулевой
+        even[j] = sin(M_PI * t / 2.0) / (M_PI * t) * kaiser(2 * j, n, beta);
+        sum += even[j];
+    }
+    for (size_t j = 0; j < even.size(); j++)
+        even[j] *= 0.5 / sum;       // с центром 0.5 - единичное усиление
+    fir_init(&hb->even, even);
+    hb->odd.assign(m + 1, cf_t(0.0f, 0.0f));
+    hb->odd_pos = 0;
+    hb->odd_next = false;
+}
+
+static void halfband_process(struct ddc_halfband *hb, const cf_t *x, size_t n, std::vector<cf_t> &out)
+{
+    for (size_t k = 0; k < n; k++) {
+        if (hb->odd_next) {
+            hb->odd[hb->odd_pos] = x[k];
+            if (++hb->odd_pos == hb->odd.size())
+                hb->odd_pos = 0;
+        } else {
+            // в odd_pos - самый старый нечётный, как раз центр
+            out.push_back(fir_push(&hb->even, x[k]) + 0.5f * hb->odd[hb->odd_pos]);
+        }
+        hb->odd_next = !hb->odd_next;
+    }
+}
+
+static double cic_response(double f, unsigned R, unsigned N)
+{
+    if (f == 0.0)
+        return 1.0;
+    return pow(fabs(sin(M_PI * f * R) / (R * sin(M_PI * f))), N);
+}
+
+/* Компенсация спада CIC в полосе 0.45 fs_out: частотная выборка + окно Кайзера */
+static void cfir_design(std::vector<double> &h, unsigned ntaps, unsigned R, unsigned N, unsigned decim)
+{
+    const int K = 512;
+    const int half = (int)ntaps / 2;
+    h.resize(ntaps);
+    double sum = 0.0;
+    for (int t = -half; t <= half; t++) {
+        double acc = 0.0;
+        for (int k = 0; k <= K / 2; k++) {
+            double f = (double)k / K;                       // доли fs_out
+            double d = 1.0 / cic_response(fmin(f, 0.45) / decim, R, N);
+            double w = (k == 0 || k == K / 2) ? 1.0 : 2.0;
+            acc += w * d * cos(2.0 * M_PI * k * t / K);
+        }
+        h[t + half] = acc / K * kaiser(t + half, ntaps, 5.0);
+        sum += h[t + half];
+    }
+    for (size_t k = 0; k < h.size(); k++)
+        h[k] /= sum;
+}
+
+int ddc_init(struct ddc *d, const struct ddc_cfg *cfg)
+{
+    if (cfg->fs <= 0.0 || cfg->cic_decim == 0 || cfg->cic_order == 0 || cfg->cic_order > 8 ||
+        cfg->hb_stages > 8 || (cfg->cfir_taps && !(cfg->cfir_taps & 1)))
+        return -EINVAL;
+    d->cfg = *cfg;
+
+    const unsigned R = cfg->cic_decim, N = cfg->cic_order;
+    int growth = (int)ceil(N * log2((double)R));
+    int bits = std::min(24, 59 - growth);
+    if (bits < 8)
+        return -EINVAL;
+    d->cic_scale = ldexp(1.0, bits);
+    d->cic_gain = (float)(1.0 / (pow((double)R, N) * d->cic_scale));
+
+    d->hb.resize(cfg->hb_stages);
+    for (unsigned s = 0; s < cfg->hb_stages; s++)
+        halfband_init(&d->hb[s], cfg->hb_stages - 1 - s);
+    if (cfg->cfir_taps) {
+        std::vector<double> h;
+        cfir_design(h, cfg->cfir_taps, R, N, ddc_decim(d));
+        fir_init(&d->cfir, h);
+    }
+
+    d->tab.resize(NCO_TAB);
+    d->mix.resize(CHUNK);
+    ddc_set_freq(d, cfg->freq);
+    ddc_reset(d);
+    return 0;
+}
+
+void ddc_reset(struct ddc *d)
+{
+    d->phase = 0;
+    memset(d->integ, 0, sizeof(d->integ));
+    memset(d->comb, 0, sizeof(d->comb));
+    d->cic_count = 0;
+    for (size_t s = 0; s < d->hb.size(); s++)
+        halfband_init(&d->hb[s], (unsigned)(d->hb.size() - 1 - s));
+    if (d->cfg.cfir_taps) {
+        std::fill(d->cfir.hist.begin(), d->cfir.hist.end(), 0.0f);
+        d->cfir.pos = 0;
+    }
+}
+
+void ddc_set_freq(struct ddc *d, double freq)
+{
+    d->cfg.freq = freq;
+    // сигнал на +freq переносится в 0: поворот на -freq
+    double cyc = -freq / d->cfg.fs;
+    cyc -= floor(cyc);
+    double s = cyc * TWO_POW_64;
+    d->step = s >= TWO_POW_64 ? 0 : (uint64_t)s;
+    for (unsigned k = 0; k < NCO_TAB; k++) {
+        double ph = (double)(uint64_t)(d->step * k) * (2.0 * M_PI / TWO_POW_64);
+        d->tab[k] = cf_t((float)cos(ph), (float)sin(ph));
+    }
+}
+
+unsigned ddc_decim(const struct ddc *d)
+{
+    return d->cfg.cic_decim << d->cfg.hb_stages;
+}
+
+/* x * exp(j * phase), фаза идёт дальше */
+static void nco_mix(struct ddc *d, const cf_t *x, size_t n, cf_t *y)
+{
+    for (size_t k0 = 0; k0 < n; k0 += NCO_TAB) {
+        size_t len = n - k0 < NCO_TAB ? n - k0 : NCO_TAB;
+        double ph = (double)d->phase * (2.0 * M_PI / TWO_POW_64);
+        const float br = (float)cos(ph), bi = (float)sin(ph);
+        const float *t = reinterpret_cast<const float *>(d->tab.data());
+        const float *in = reinterpret_cast<const float *>(x + k0);
+        float *out = reinterpret_cast<float *>(y + k0);
+        for (size_t k = 0; k < len; k++) {
+            float rr = br * t[2 * k] - bi * t[2 * k + 1];
+            float ri = br * t[2 * k + 1] + bi * t[2 * k];
+            float xr = in[2 * k], xi = in[2 * k + 1];
+            out[2 * k] = xr * rr - xi * ri;
+            out[2 * k + 1] = xr * ri + xi * rr;
+        }
+        d->phase += d->step * len;
+    }
+}
+
+static void cic_process(struct ddc *d, const cf_t *x, size_t n, std::vector<cf_t> &out)
+{
+    const unsigned R = d->cfg.cic_decim, N = d->cfg.cic_order;
+    const double scale = d->cic_scale;
+    for (size_t k = 0; k < n; k++) {
+        uint64_t vi = (uint64_t)llrint(x[k].real() * scale);
+        uint64_t vq = (uint64_t)llrint(x[k].imag() * scale);
+        for (unsigned s = 0; s < N; s++) {
+            vi = d->integ[s][0] += vi;
+            vq = d->integ[s][1] += vq;
+        }
+        if (++d->cic_count < R)
+            continue;
+        d->cic_count = 0;
+        for (unsigned s = 0; s < N; s++) {
+            uint64_t ti = vi - d->comb[s][0], tq = vq - d->comb[s][1];
+            d->comb[s][0] = vi;
+            d->comb[s][1] = vq;
+            vi = ti;
+            vq = tq;
+        }
+        out.push_back(cf_t((float)(int64_t)vi * d->cic_gain, (float)(int64_t)vq * d->cic_gain));
+    }
+}
+
+size_t ddc_process(struct ddc *d, const cf_t *x, size_t n, std::vector<cf_t> &out)
+{
+    size_t produced = 0;
+    while (n > 0) {
+        size_t len = n < CHUNK ? n : CHUNK;
+        nco_mix(d, x, len, d->mix.data());
+
+        std::vector<cf_t> *cur = &d->stage_a, *next = &d->stage_b;
+        cur->clear();
+        if (d->cfg.cic_decim > 1)
+            cic_process(d, d->mix.data(), len, *cur);
+        else
+            cur->assign(d->mix.begin(), d->mix.begin() + len);
+        for (size_t s = 0; s < d->hb.size(); s++) {
+            next->clear();
+            halfband_process(&d->hb[s], cur->data(), cur->size(), *next);
+            std::swap(cur, next);
+        }
+        if (d->cfg.cfir_taps) {
+            for (size_t k = 0; k < cur->size(); k++)
+                out.push_back(fir_push(&d->cfir, (*cur)[k]));
+        } else {
+            out.insert(out.end(), cur->begin(), cur->end());
+        }
+        produced += cur->size();
+        x += len;
+        n -= len;
+    }
+    return produced;
+}
+
+size_t ddc_process_iq16(struct ddc *d, const int16_t *iq, size_t n, std::vector<cf_t> &out)
+{
+    cf_t tmp[1024];
+    size_t produced = 0;
+
+    while (n > 0) {
+        size_t chunk = n < 1024 ? n : 1024;
+        for (size_t k = 0; k < chunk; k++)
+            tmp[k] = cf_t(iq[2 * k] / 2048.0f, iq[2 * k + 1] / 2048.0f);
+        produced += ddc_process(d, tmp, chunk, out);
+        iq += 2 * chunk;
+        n -= chunk;
+    }
+    return produced;
+}
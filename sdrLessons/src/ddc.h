@@ -0,0 +1,84 @@
+#ifndef DDC_H
+#define DDC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "dsp_types.h"
+
+/*
+ * Цифровой понижающий преобразователь (DDC) для узкого сигнала внутри
+ * rf_bandwidth: NCO -> CIC (децимация cic_decim) -> hb_stages полуполосных
+ * ФНЧ (по 2) -> компенсирующий FIR спада CIC. Децимация всего -
+ * cic_decim * 2^hb_stages, всё дальше по цепочке работает на fs_out.
+ *
+ * NCO: фазовый аккумулятор 64 бит, поворот = таблица exp(-j w k) на кусок
+ * в 256 сэмплов, умноженная на точную фазу начала куска - фаза непрерывна
+ * между блоками и при ddc_set_freq(), ошибка не копится.
+ * CIC: целочисленные интеграторы/гребни (uint64, переполнение по модулю
+ * не мешает), без умножений. Полуполосные ФНЧ считают только ненулевые
+ * коэффициенты (чётная ветвь - simd_dot_cf_rf2, нечётная - центр 0.5).
+ *
+ * Полоса пропускания - +-0.4 fs_out, подавление наложений ~90 dB
+ * (CIC 5-го порядка по умолчанию, полуполосные - Кайзер на 90 dB).
+ */
+
+struct ddc_cfg {
+    double fs;              // входная частота дискретизации
+    double freq;            // сдвиг сигнала от LO, Гц: он переносится в 0
+    unsigned cic_decim;     // 1 - без CIC
+    unsigned cic_order;
+    unsigned hb_stages;
+    unsigned cfir_taps;     // нечётное; 0 - без компенсации
+};
+
+void ddc_default_cfg(struct ddc_cfg *cfg, double fs);
+
+/* FIR с удвоенной линией задержки */
+struct ddc_fir {
+    unsigned ntaps;
+    std::vector<float> h2;      // в обратном порядке, продублированы для I/Q
+    std::vector<float> hist;    // interleaved I/Q, 2 * ntaps сэмплов
+    size_t pos;
+};
+
+struct ddc_halfband {
+    struct ddc_fir even;        // ненулевые коэффициенты
+    std::vector<cf_t> odd;      // задержка нечётной ветви до центра
+    size_t odd_pos;
+    bool odd_next;              // следующий сэмпл - нечётный
+};
+
+struct ddc {
+    struct ddc_cfg cfg;
+
+    uint64_t phase, step;
+    std::vector<cf_t> tab;      // exp(-j * step * k), k < 256
+
+    double cic_scale;           // вход -> целые
+    float cic_gain;             // 1 / (R^N * scale)
+    uint64_t integ[8][2], comb[8][2];
+    unsigned cic_count;
+
+    std::vector<struct ddc_halfband> hb;
+    struct ddc_fir cfir;
+
+    std::vector<cf_t> mix, stage_a, stage_b;
+};
+
+int ddc_init(struct ddc *d, const struct ddc_cfg *cfg);
+void ddc_reset(struct ddc *d);
+
+/* Новая частота NCO без разрыва фазы */
+void ddc_set_freq(struct ddc *d, double freq);
+
+unsigned ddc_decim(const struct ddc *d);
+
+/* Выход (fs / ddc_decim) добавляется в out. Возвращает число новых сэмплов */
+size_t ddc_process(struct ddc *d, const cf_t *x, size_t n, std::vector<cf_t> &out);
+
+/* int16 I/Q, масштаб 1/2048 */
+size_t ddc_process_iq16(struct ddc *d, const int16_t *iq, size_t n, std::vector<cf_t> &out);
+
+#endif // DDC_H
@@ -0,0 +1,233 @@
+#include "demapper.h"
+
+#include <math.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+
+#include "iq_analytics.h"
+#include "simd_ops.h"
+
+#define CHUNK       256
+#define NOISE_MIN   1e-4f       // EVM 1% - дальше LLR всё равно в насыщении
+
+/* Уровень по оси 16QAM: знак и внутренний (1) / внешний (3) */
+static inline float qam16_level(unsigned sign, unsigned inner)
+{
+    return (sign ? 1.0f : -1.0f) * (inner ? 1.0f : 3.0f);
+}
+
+int demapper_init(struct demapper *d, int mod)
+{
+    *d = demapper();
+    d->mod = mod;
+    d->bps = (unsigned)mod;
+    d->llr_scale = DEMAP_LLR_SCALE;
+
+    switch (mod) {
+    case DEMAP_BPSK:
+        d->points[0] = cf_t(-1.0f, 0.0f);
+        d->points[1] = cf_t(1.0f, 0.0f);
+        break;
+    case DEMAP_QPSK:
+        for (unsigned l = 0; l < 4; l++)
+            d->points[l] = cf_t((l & 2) ? 1.0f : -1.0f, (l & 1) ? 1.0f : -1.0f) * (float)M_SQRT1_2;
+        break;
+    case DEMAP_8PSK:
+        // метка - код Грея номера точки на окружности
+        for (unsigned k = 0; k < 8; k++) {
+            unsigned l = k ^ (k >> 1);
+            d->points[l] = cf_t(cosf(k * (float)M_PI / 4.0f), sinf(k * (float)M_PI / 4.0f));
+        }
+        break;
+    case DEMAP_16QAM:
+        for (unsigned l = 0; l < 16; l++)
+            d->points[l] = cf_t(qam16_level((l >> 3) & 1, (l >> 2) & 1),
+                                qam16_level((l >> 1) & 1, l & 1)) / sqrtf(10.0f);
+        break;
+    default:
+        return -EINVAL;
+    }
+    demapper_set_noise(d, 1.0f, 0.1f);
+    return 0;
+}
+
+int demap_mod_parse(const char *name)
+{
+    if (strcasecmp(name, "bpsk") == 0)
+        return DEMAP_BPSK;
+    if (strcasecmp(name, "qpsk") == 0)
+        return DEMAP_QPSK;
+    if (strcasecmp(name, "8psk") == 0)
+        return DEMAP_8PSK;
+    if (strcasecmp(name, "16qam") == 0)
+        return DEMAP_16QAM;
+    return -EINVAL;
+}
+
+void demapper_set_noise(struct demapper *d, float gain, float noise_var)
+{
+    d->gain = gain;
+    d->noise_var = noise_var > NOISE_MIN ? noise_var : NOISE_MIN;
+}
+
+void demapper_set_evm(struct demapper *d, const struct iq_report *r)
+{
+    // power = ref * (1 + EVM^2), EVM - относительно мощности точки
+    double e2 = r->evm_rms * r->evm_rms;
+    double ref = r->power / (1.0 + e2);
+    demapper_set_noise(d, ref > 0.0 ? (float)(1.0 / sqrt(ref)) : 1.0f, (float)e2);
+}
+
+unsigned demap_nearest(const struct demapper *d, cf_t y)
+{
+    unsigned best = 0;
+    float dmin = INFINITY;
+    for (unsigned l = 0; l < (1u << d->bps); l++) {
+        float dist = std::norm(y - d->points[l]);
+        if (dist < dmin) {
+            dmin = dist;
+            best = l;
+        }
+    }
+    return best;
+}
+
+float demapper_estimate(struct demapper *d, const cf_t *syms, size_t n)
+{
+    if (n == 0)
+        return 0.0f;
+    double p = 0.0;
+    for (size_t k = 0; k < n; k++)
+        p += std::norm(syms[k]);
+    if (p <= 0.0)
+        return 0.0f;
+
+    // решения при грубом масштабе, затем масштаб МНК: g = sum Re(y* s) / sum |y|^2
+    float g = (float)sqrt(n / p);
+    double cross = 0.0;
+    for (size_t k = 0; k < n; k++) {
+        cf_t s = d->points[demap_nearest(d, syms[k] * g)];
+        cross += syms[k].real() * s.real() + syms[k].imag() * s.imag();
+    }
+    if (cross > 0.0)
+        g = (float)(cross / p);
+
+    double err = 0.0;
+    for (size_t k = 0; k < n; k++) {
+        cf_t y = syms[k] * g;
+        err += std::norm(y - d->points[demap_nearest(d, y)]);
+    }
+    float n0 = (float)(err / n);
+    demapper_set_noise(d, g, n0);
+    return sqrtf(n0);
+}
+
+size_t demapper_map(const struct demapper *d, const uint8_t *bits, size_t nbits, cf_t *syms)
+{
+    size_t n = nbits / d->bps;
+    for (size_t k = 0; k < n; k++) {
+        unsigned l = 0;
+        for (unsigned b = 0; b < d->bps; b++)
+            l = (l << 1) | (bits[k * d->bps + b] & 1);
+        syms[k] = d->points[l];
+    }
+    return n;
+}
+
+/*
+ * LLR куска в float, без общего множителя; множитель - в *scale.
+ * Для BPSK/QPSK/16QAM - замкнутые формулы max-log по осям, 8PSK - перебор точек.
+ */
+static void llr_chunk(const struct demapper *d, const cf_t *syms, size_t n, float *out, float *scale)
+{
+    const float *x = reinterpret_cast<const float *>(syms);
+    const float g = d->gain, n0 = d->noise_var;
+
+    switch (d->mod) {
+    case DEMAP_BPSK:
+        // (|y + 1|^2 - |y - 1|^2) / N0 = 4 Re(y) / N0
+        for (size_t k = 0; k < n; k++)
+            out[k] = x[2 * k];
+        *scale = 4.0f * g / n0;
+        break;
+    case DEMAP_QPSK:
+        // по осям как BPSK с амплитудой 1/sqrt(2)
+        memcpy(out, x, 2 * n * sizeof(float));
+        *scale = 4.0f * (float)M_SQRT1_2 * g / n0;
+        break;
+    case DEMAP_16QAM: {
+        // ось в единицах A = 1/sqrt(10): b0 - x при |x| <= 2, иначе 2(x - sgn x); b1 - 2 - |x|
+        const float ga = g * sqrtf(10.0f);
+        for (size_t k = 0; k < 2 * n; k++) {
+            float v = x[k] * ga;
+            float a = fabsf(v);
+            float outer = 2.0f * (v - copysignf(1.0f, v));
+            out[2 * k] = a <= 2.0f ? v : outer;
+            out[2 * k + 1] = 2.0f - a;
+        }
+        // порядок: I0 I1 Q0 Q1 - совпадает с чередованием I/Q во входе
+        *scale = 4.0f / (10.0f * n0);
+        break;
+    }
+    default: {
+        const unsigned npts = 1u << d->bps;
+        for (size_t k = 0; k < n; k++) {
+            cf_t y = syms[k] * g;
+            float dist[16];
+            for (unsigned l = 0; l < npts; l++)
+                dist[l] = std::norm(y - d->points[l]);
+            for (unsigned b = 0; b < d->bps; b++) {
+                unsigned mask = 1u << (d->bps - 1 - b);
+                float d0 = INFINITY, d1 = INFINITY;
+                for (unsigned l = 0; l < npts; l++) {
+                    if (l & mask)
+                        d1 = fminf(d1, dist[l]);
+                    else
+                        d0 = fminf(d0, dist[l]);
+                }
+                out[k * d->bps + b] = d0 - d1;
+            }
+        }
+        *scale = 1.0f / n0;
+        break;
+    }
+    }
+}
+
+void demap_soft(const struct demapper *d, const cf_t *syms, size_t n, int8_t *llr)
+{
+    float tmp[CHUNK * 4];
+    float scale;
+
+    if (d->mod == DEMAP_QPSK) {
+        // без промежуточного буфера: LLR пропорциональны I и Q
+        llr_chunk(d, syms, 0, tmp, &scale);
+        simd_f32_to_i8_sat(reinterpret_cast<const float *>(syms), 2 * n, scale * d->llr_scale, llr);
+        return;
+    }
+    while (n > 0) {
+        size_t m = n < CHUNK ? n : CHUNK;
+        llr_chunk(d, syms, m, tmp, &scale);
+        simd_f32_to_i8_sat(tmp, m * d->bps, scale * d->llr_scale, llr);
+        syms += m;
+        llr += m * d->bps;
+        n -= m;
+    }
+}
+
+void demap_hard(const struct demapper *d, const cf_t *syms, size_t n, uint8_t *bits)
+{
+    float tmp[CHUNK * 4];
+    float scale;
+
+    while (n > 0) {
+        size_t m = n < CHUNK ? n : CHUNK;
+        llr_chunk(d, syms, m, tmp, &scale);
+        for (size_t k = 0; k < m * d->bps; k++)
+            bits[k] = tmp[k] > 0.0f;
+        syms += m;
+        bits += m * d->bps;
+        n -= m;
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef DEMAPPER_H
+#define DEMAPPER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "dsp_types.h"
+
+struct iq_report;
+
+/*
+ * Демаппер символов в биты: жёсткие решения и мягкие int8 LLR (max-log)
+ * для BPSK/QPSK/8PSK/16QAM после синхронизации (qpsk_demod, Костас).
+ *
+ * Созвездия с единичной средней энергией, код Грея. Биты символа идут
+ * подряд, b0 - старший бит метки: QPSK - b0 по I, b1 по Q (как
+ * qpsk_soft_bits); 16QAM - b0 знак I, b1 внутренний уровень I, b2, b3 - то же по Q.
+ *
+ * LLR = ln P(b = 1) / P(b = 0) (знак как у fec.h: > 0 - скорее 1), в int8
+ * умножается на llr_scale и ограничивается +-127 - выход сразу идёт в
+ * fec_viterbi_decode. Шум N0 (на единичную энергию символа) и масштаб
+ * входа берутся из оценки EVM: demapper_set_evm() по iq_report или
+ * demapper_estimate() по решениям для любого созвездия.
+ */
+
+enum demap_mod {
+    DEMAP_BPSK = 1,         // значение - бит на символ
+    DEMAP_QPSK = 2,
+    DEMAP_8PSK = 3,
+    DEMAP_16QAM = 4,
+};
+
+#define DEMAP_LLR_SCALE     8.0f    // LLR 16 -> 127
+
+struct demapper {
+    int mod;
+    unsigned bps;               // бит на символ
+    cf_t points[16];            // по метке (b0 - старший бит)
+    float gain;                 // вход -> единичная энергия
+    float noise_var;            // N0
+    float llr_scale;
+};
+
+int demapper_init(struct demapper *d, int mod);
+
+/* Строка "bpsk", "qpsk", "8psk", "16qam" -> enum demap_mod, -EINVAL если нет */
+int demap_mod_parse(const char *name);
+
+void demapper_set_noise(struct demapper *d, float gain, float noise_var);
+
+/* По iq_stats_report (оценка EVM для QPSK) */
+void demapper_set_evm(struct demapper *d, const struct iq_report *r);
+
+/* EVM по ближайшим точкам созвездия: выставляет gain и noise_var, возвращает EVM (доля) */
+float demapper_estimate(struct demapper *d, const cf_t *syms, size_t n);
+
+/* Метка ближайшей точки созвездия (вход уже в единичной энергии, без gain) */
+unsigned demap_nearest(const struct demapper *d, cf_t y);
+
+/* Биты -> символы (nbits кратно bps). Возвращает число символов */
+size_t demapper_map(const struct demapper *d, const uint8_t *bits, size_t nbits, cf_t *syms);
+
+/* n символов -> n * bps мягких решений / жёстких бит 0/1 */
+void demap_soft(const struct demapper *d, const cf_t *syms, size_t n, int8_t *llr);
+void demap_hard(const struct demapper *d, const cf_t *syms, size_t n, uint8_t *bits);
+
+#endif // DEMAPPER_H
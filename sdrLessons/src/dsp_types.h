@@ -0,0 +1,9 @@
+#ifndef DSP_TYPES_H
+#define DSP_TYPES_H
+
+#include <complex>
+
+/* комплексный отсчёт для DSP блоков (I + jQ) */
+typedef std::complex<float> cf_t;
+
+#endif // DSP_TYPES_H
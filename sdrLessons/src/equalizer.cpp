@@ -0,0 +1,117 @@
+#include "equalizer.h"
+
+#include <math.h>
+#include <errno.h>
+
+#include "simd_ops.h"
+
+void equalizer_default_cfg(struct equalizer_cfg *cfg, unsigned sps)
+{
+    cfg->sps = sps;
+    cfg->ntaps = 7 * sps + 1;   // 7 символов: эхо в кабеле/между антеннами - единицы символов
+    cfg->mod = DEMAP_QPSK;
+    cfg->mu_cma = 2e-3f;
+    cfg->mu_dd = 2e-3f;
+    cfg->dd_enter = 0.08f;      // для QPSK: EVM ~28%, решения уже в основном верные
+    cfg->dd_leave = 0.2f;
+    cfg->mse_alpha = 0.01f;
+}
+
+int equalizer_init(struct equalizer *eq, const struct equalizer_cfg *cfg)
+{
+    if (cfg->sps < 1 || cfg->ntaps < cfg->sps)
+        return -EINVAL;
+    if (demapper_init(&eq->dm, cfg->mod) < 0)
+        return -EINVAL;
+    eq->cfg = *cfg;
+
+    double p2 = 0.0, p4 = 0.0;
+    for (unsigned l = 0; l < (1u << eq->dm.bps); l++) {
+        double p = std::norm(eq->dm.points[l]);
+        p2 += p;
+        p4 += p * p;
+    }
+    eq->r2 = (float)(p4 / p2);
+
+    // треть длины до центра: эхо многолучёвости - после основного луча
+    eq->center = cfg->ntaps / 3 / cfg->sps * cfg->sps;
+    eq->taps.resize(cfg->ntaps);
+    eq->hist.resize(2 * cfg->ntaps);
+    equalizer_reset(eq);
+    return 0;
+}
+
+void equalizer_reset(struct equalizer *eq)
+{
+    eq->taps.assign(eq->cfg.ntaps, cf_t(0.0f, 0.0f));
+    eq->taps[eq->center] = cf_t(1.0f, 0.0f);
+    eq->hist.assign(2 * eq->cfg.ntaps, cf_t(0.0f, 0.0f));
+    eq->pos = 0;
+    eq->phase = 0;
+    eq->mode = EQ_MODE_CMA;
+    eq->mse = eq->cfg.dd_leave;
+    eq->n_syms = 0;
+    eq->n_switches = 0;
+}
+
+size_t equalizer_delay(const struct equalizer *eq)
+{
+    return eq->center / eq->cfg.sps;
+}
+
+size_t equalizer_process(struct equalizer *eq, const cf_t *x, size_t n, std::vector<cf_t> &out)
+{
+    const size_t L = eq->cfg.ntaps;
+    const float alpha = eq->cfg.mse_alpha;
+    float *taps = reinterpret_cast<float *>(eq->taps.data());
+    size_t produced = 0;
+
+    for (size_t s = 0; s < n; s++) {
+        eq->pos = eq->pos == 0 ? L - 1 : eq->pos - 1;
+        eq->hist[eq->pos] = x[s];
+        eq->hist[eq->pos + L] = x[s];
+        if (++eq->phase < eq->cfg.sps)
+            continue;
+        eq->phase = 0;
+
+        const float *w = reinterpret_cast<const float *>(&eq->hist[eq->pos]);
+        float re, im;
+        simd_dot_cf_cf(w, taps, L, &re, &im);
+        cf_t y(re, im);
+        cf_t d = eq->dm.points[demap_nearest(&eq->dm, y)];
+        eq->mse += alpha * (std::norm(d - y) - eq->mse);
+
+        cf_t e;
+        float mu;
+        if (eq->mode == EQ_MODE_CMA) {
+            e = y * (eq->r2 - std::norm(y));
+            mu = eq->cfg.mu_cma;
+            if (eq->mse < eq->cfg.dd_enter) {
+                eq->mode = EQ_MODE_DD;
+                eq->n_switches++;
+            }
+        } else {
+            e = d - y;
+            mu = eq->cfg.mu_dd;
+            if (eq->mse > eq->cfg.dd_leave) {
+                eq->mode = EQ_MODE_CMA;
+                eq->n_switches++;
+            }
+        }
+        simd_axpy_conj_cf(taps, w, L, mu * e.real(), mu * e.imag());
+
+        // разнос (вход без AGC, слишком большой шаг) - начать захват заново
+        if (!(eq->mse < 1e3f)) {
+            unsigned long long syms = eq->n_syms, sw = eq->n_switches;
+            equalizer_reset(eq);
+            eq->n_syms = syms;
+            eq->n_switches = sw;
+            taps = reinterpret_cast<float *>(eq->taps.data());
+        }
+
+        out.push_back(y);
+        eq->n_syms++;
+        produced++;
+    }
+    return produced;
+}
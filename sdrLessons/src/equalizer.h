@@ -0,0 +1,76 @@
+#ifndef EQUALIZER_H
+#define EQUALIZER_H
+
+#include <stddef.h>
+#include <vector>
+
+#include "dsp_types.h"
+#include "demapper.h"
+
+/*
+ * Адаптивный эквалайзер против МСИ (многолучёвость кабеля/антенн в петле
+ * single_adalm_rxtx_costas.cpp, остаток после грубого фильтра np.ones(10)).
+ *
+ * Дробный шаг: вход - sps отсчётов на символ (2 - T/2, как half-выход
+ * qpsk_demod; 1 - обычный эквалайзер по символам), выход - символ на
+ * каждый sps-й отсчёт, y = sum w[k] * x[n - k].
+ *
+ * Захват вслепую по CMA (ошибка y (R2 - |y|^2)), затем, когда СКО
+ * решений падает ниже dd_enter, - LMS по решениям (d - y), обратно в CMA
+ * при росте выше dd_leave. Вход - в единичной энергии созвездия (после
+ * AGC), фаза - грубо снята Костасом. Состояние (линия задержки,
+ * коэффициенты, режим) переносится между блоками.
+ */
+
+enum equalizer_mode {
+    EQ_MODE_CMA = 0,
+    EQ_MODE_DD,
+};
+
+struct equalizer_cfg {
+    unsigned ntaps;         // длина в отсчётах входа
+    unsigned sps;           // 1 или 2
+    int mod;                // созвездие решений, enum demap_mod
+    float mu_cma;
+    float mu_dd;
+    float dd_enter;         // СКО решений (|d - y|^2), ниже - переход в DD
+    float dd_leave;         // выше - обратно в CMA
+    float mse_alpha;        // сглаживание СКО
+};
+
+void equalizer_default_cfg(struct equalizer_cfg *cfg, unsigned sps);
+
+struct equalizer {
+    struct equalizer_cfg cfg;
+    struct demapper dm;
+    float r2;               // модуль CMA: E|s|^4 / E|s|^2
+    size_t center;          // начальный единичный отвод, кратен sps
+
+    std::vector<cf_t> taps;
+    /* линия задержки удвоенной длины, окно hist[pos .. pos + ntaps) - от новых к старым */
+    std::vector<cf_t> hist;
+    size_t pos;
+    unsigned phase;         // номер отсчёта внутри символа
+
+    int mode;               // enum equalizer_mode
+    float mse;
+    unsigned long long n_syms;
+    unsigned long long n_switches;
+};
+
+int equalizer_init(struct equalizer *eq, const struct equalizer_cfg *cfg);
+
+/* Коэффициенты - единичный отвод в center, режим CMA */
+void equalizer_reset(struct equalizer *eq);
+
+/* Задержка выхода относительно входа в символах */
+size_t equalizer_delay(const struct equalizer *eq);
+
+/*
+ * Обработать n отсчётов входа. Первый отсчёт после reset - начало символа
+ * (для half-выхода qpsk_demod: середина, затем сам символ). Символы
+ * добавляются в out, возвращает их число.
+ */
+size_t equalizer_process(struct equalizer *eq, const cf_t *x, size_t n, std::vector<cf_t> &out);
+
+#endif // EQUALIZER_H
@@ -0,0 +1,262 @@
+#include "fec.h"
+
+#include <string.h>
+#include <errno.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+ * Состояние - последние 6 входных бит, новейший в младшем разряде:
+ * регистр r = (s << 1) | b, следующее состояние r & 63.
+ *
+ * Бабочка: старые состояния j и j + 32 переходят в новые 2j (бит 0) и 2j + 1
+ * (бит 1). Оба полинома содержат старший и младший разряды регистра, поэтому
+ * выходы для j + 32 и для бита 1 инвертированы относительно (j, 0): хватает
+ * одной метрики ветви m_j на бабочку.
+ */
+
+#define RENORM_STEPS    8
+#define METRIC_MIN      (-8192)
+
+static int16_t sign_a[FEC_STATES / 2] __attribute__((aligned(32)));
+static int16_t sign_b[FEC_STATES / 2] __attribute__((aligned(32)));
+
+static inline unsigned parity(unsigned x)
+{
+    return __builtin_parity(x);
+}
+
+static bool init_tables(void)
+{
+    for (unsigned j = 0; j < FEC_STATES / 2; j++) {
+        sign_a[j] = parity((j << 1) & FEC_POLY_A) ? 1 : -1;
+        sign_b[j] = parity((j << 1) & FEC_POLY_B) ? 1 : -1;
+    }
+    return true;
+}
+
+void fec_conv_encode(const uint8_t *bits, size_t nbits, uint8_t *coded)
+{
+    unsigned s = 0;
+    for (size_t k = 0; k < nbits + FEC_K - 1; k++) {
+        unsigned b = k < nbits ? (bits[k] & 1) : 0;
+        unsigned r = (s << 1) | b;
+        coded[2 * k] = (uint8_t)parity(r & FEC_POLY_A);
+        coded[2 * k + 1] = (uint8_t)parity(r & FEC_POLY_B);
+        s = r & (FEC_STATES - 1);
+    }
+}
+
+void fec_viterbi_init(struct fec_viterbi *v)
+{
+    static const bool tables_ready = init_tables();
+    (void)tables_ready;
+    v->decisions.clear();
+    memset(v->metrics, 0, sizeof(v->metrics));
+}
+
+/* Один шаг: old -> nw, возвращает решения (см. fec_viterbi::decisions) */
+static inline uint64_t acs_step(const int16_t *old, int16_t *nw, int s0, int s1)
+{
+#if defined(__AVX2__)
+    const __m256i S0 = _mm256_set1_epi16((int16_t)s0);
+    const __m256i S1 = _mm256_set1_epi16((int16_t)s1);
+    __m256i de[2], dodd[2];
+    for (int q = 0; q < 2; q++) {
+        __m256i lo = _mm256_load_si256(reinterpret_cast<const __m256i *>(old + 16 * q));
+        __m256i hi = _mm256_load_si256(reinterpret_cast<const __m256i *>(old + 32 + 16 * q));
+        __m256i m = _mm256_adds_epi16(
+            _mm256_mullo_epi16(_mm256_load_si256(reinterpret_cast<const __m256i *>(sign_a + 16 * q)), S0),
+            _mm256_mullo_epi16(_mm256_load_si256(reinterpret_cast<const __m256i *>(sign_b + 16 * q)), S1));
+        __m256i a = _mm256_adds_epi16(lo, m), b = _mm256_subs_epi16(hi, m);
+        __m256i c = _mm256_subs_epi16(lo, m), d = _mm256_adds_epi16(hi, m);
+        __m256i ne = _mm256_max_epi16(a, b), no = _mm256_max_epi16(c, d);
+        de[q] = _mm256_cmpgt_epi16(b, a);
+        dodd[q] = _mm256_cmpgt_epi16(d, c);
+        // unpack работает в пределах 128-битных половин - собираем порядок 2j, 2j + 1
+        __m256i A = _mm256_unpacklo_epi16(ne, no), B = _mm256_unpackhi_epi16(ne, no);
+        _mm256_store_si256(reinterpret_cast<__m256i *>(nw + 32 * q), _mm256_permute2x128_si256(A, B, 0x20));
+        _mm256_store_si256(reinterpret_cast<__m256i *>(nw + 32 * q + 16), _mm256_permute2x128_si256(A, B, 0x31));
+    }
+    uint32_t even = (uint32_t)_mm256_movemask_epi8(_mm256_permute4x64_epi64(_mm256_packs_epi16(de[0], de[1]), 0xd8));
+    uint32_t odd = (uint32_t)_mm256_movemask_epi8(_mm256_permute4x64_epi64(_mm256_packs_epi16(dodd[0], dodd[1]), 0xd8));
+    return (uint64_t)even | ((uint64_t)odd << 32);
+#elif defined(__SSE2__)
+    const __m128i S0 = _mm_set1_epi16((int16_t)s0);
+    const __m128i S1 = _mm_set1_epi16((int16_t)s1);
+    __m128i de[4], dodd[4];
+    for (int q = 0; q < 4; q++) {
+        __m128i lo = _mm_load_si128(reinterpret_cast<const __m128i *>(old + 8 * q));
+        __m128i hi = _mm_load_si128(reinterpret_cast<const __m128i *>(old + 32 + 8 * q));
+        __m128i m = _mm_adds_epi16(
+            _mm_mullo_epi16(_mm_load_si128(reinterpret_cast<const __m128i *>(sign_a + 8 * q)), S0),
+            _mm_mullo_epi16(_mm_load_si128(reinterpret_cast<const __m128i *>(sign_b + 8 * q)), S1));
+        __m128i a = _mm_adds_epi16(lo, m), b = _mm_subs_epi16(hi, m);
+        __m128i c = _mm_subs_epi16(lo, m), d = _mm_adds_epi16(hi, m);
+        __m128i ne = _mm_max_epi16(a, b), no = _mm_max_epi16(c, d);
+        de[q] = _mm_cmpgt_epi16(b, a);
+        dodd[q] = _mm_cmpgt_epi16(d, c);
+        _mm_store_si128(reinterpret_cast<__m128i *>(nw + 16 * q), _mm_unpacklo_epi16(ne, no));
+        _mm_store_si128(reinterpret_cast<__m128i *>(nw + 16 * q + 8), _mm_unpackhi_epi16(ne, no));
+    }
+    uint32_t even = (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(de[0], de[1])) |
+                    ((uint32_t)_mm_movemask_epi8(_mm_packs_epi16(de[2], de[3])) << 16);
+    uint32_t odd = (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(dodd[0], dodd[1])) |
+                   ((uint32_t)_mm_movemask_epi8(_mm_packs_epi16(dodd[2], dodd[3])) << 16);
+    return (uint64_t)even | ((uint64_t)odd << 32);
+#else
+    uint64_t dec = 0;
+    for (unsigned j = 0; j < FEC_STATES / 2; j++) {
+        int m = sign_a[j] * s0 + sign_b[j] * s1;
+        int a = old[j] + m, b = old[j + 32] - m;
+        int c = old[j] - m, d = old[j + 32] + m;
+        nw[2 * j] = (int16_t)(b > a ? b : a);
+        nw[2 * j + 1] = (int16_t)(d > c ? d : c);
+        dec |= (uint64_t)(b > a) << j;
+        dec |= (uint64_t)(d > c) << (32 + j);
+    }
+    return dec;
+#endif
+}
+
+/* Вычесть метрику состояния 0, чтобы int16 не переполнялся */
+static inline void renorm(int16_t *m)
+{
+    int16_t ref = m[0];
+    for (unsigned s = 0; s < FEC_STATES; s++) {
+        int v = m[s] - ref;
+        m[s] = (int16_t)(v < -32768 ? -32768 : v);
+    }
+}
+
+long fec_viterbi_decode(struct fec_viterbi *v, const int8_t *soft, size_t nbits, uint8_t *bits)
+{
+    const size_t steps = nbits + FEC_K - 1;
+    if (v->decisions.size() < steps)
+        v->decisions.resize(steps);
+
+    int16_t *old = v->metrics[0], *nw = v->metrics[1];
+    for (unsigned s = 0; s < FEC_STATES; s++)
+        old[s] = METRIC_MIN;
+    old[0] = 0;
+
+    long offset = 0;
+    uint64_t *dec = v->decisions.data();
+    for (size_t t = 0; t < steps; t++) {
+        dec[t] = acs_step(old, nw, soft[2 * t], soft[2 * t + 1]);
+        if ((t + 1) % RENORM_STEPS == 0) {
+            offset += nw[0];
+            renorm(nw);
+        }
+        int16_t *tmp = old;
+        old = nw;
+        nw = tmp;
+    }
+    long metric = offset + old[0];
+
+    // обратный проход от состояния 0 (хвост из нулей)
+    unsigned s = 0;
+    for (size_t t = steps; t-- > 0;) {
+        unsigned b = s & 1, j = s >> 1;
+        unsigned d = (unsigned)(dec[t] >> (b ? 32 + j : j)) & 1;
+        if (t < nbits)
+            bits[t] = (uint8_t)b;
+        s = j | (d << 5);
+    }
+    return metric;
+}
+
+/* ---------- кадр пакета ---------- */
+
+static uint8_t crc8(const uint8_t *p, size_t n)
+{
+    uint8_t crc = 0;
+    for (size_t k = 0; k < n; k++) {
+        crc ^= p[k];
+        for (int b = 0; b < 8; b++)
+            crc = (uint8_t)(crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1);
+    }
+    return crc;
+}
+
+static uint32_t crc32(const uint8_t *p, size_t n)
+{
+    static uint32_t table[256];
+    static bool ready = false;
+    if (!ready) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int b = 0; b < 8; b++)
+                c = c & 1 ? (c >> 1) ^ 0xedb88320u : c >> 1;
+            table[i] = c;
+        }
+        ready = true;
+    }
+    uint32_t crc = 0xffffffffu;
+    for (size_t k = 0; k < n; k++)
+        crc = table[(crc ^ p[k]) & 0xff] ^ (crc >> 8);
+    return crc ^ 0xffffffffu;
+}
+
+static void bytes_to_bits(const uint8_t *p, size_t n, uint8_t *bits)
+{
+    for (size_t k = 0; k < n; k++)
+        for (int b = 0; b < 8; b++)
+            bits[8 * k + b] = (p[k] >> (7 - b)) & 1;
+}
+
+static void bits_to_bytes(const uint8_t *bits, size_t n, uint8_t *p)
+{
+    for (size_t k = 0; k < n; k++) {
+        uint8_t v = 0;
+        for (int b = 0; b < 8; b++)
+            v = (uint8_t)(v << 1 | bits[8 * k + b]);
+        p[k] = v;
+    }
+}
+
+long fec_packet_encode(const uint8_t *data, size_t len, uint8_t *coded)
+{
+    if (len > FEC_PACKET_MAX)
+        return -EINVAL;
+
+    uint8_t hdr[3] = {(uint8_t)(len >> 8), (uint8_t)len, 0};
+    hdr[2] = crc8(hdr, 2);
+    uint8_t bits[8 * (FEC_PACKET_MAX + 4)];
+    bytes_to_bits(hdr, 3, bits);
+    fec_conv_encode(bits, 24, coded);
+
+    uint32_t crc = crc32(data, len);
+    uint8_t tail[4] = {(uint8_t)(crc >> 24), (uint8_t)(crc >> 16), (uint8_t)(crc >> 8), (uint8_t)crc};
+    bytes_to_bits(data, len, bits);
+    bytes_to_bits(tail, 4, bits + 8 * len);
+    fec_conv_encode(bits, 8 * (len + 4), coded + FEC_PACKET_HDR_SOFT);
+    return (long)fec_packet_coded_len(len);
+}
+
+int fec_packet_decode_hdr(struct fec_viterbi *v, const int8_t *soft)
+{
+    uint8_t bits[24], hdr[3];
+    fec_viterbi_decode(v, soft, 24, bits);
+    bits_to_bytes(bits, 3, hdr);
+    size_t len = (size_t)hdr[0] << 8 | hdr[1];
+    if (crc8(hdr, 2) != hdr[2] || len > FEC_PACKET_MAX)
+        return -EBADMSG;
+    return (int)len;
+}
+
+int fec_packet_decode_body(struct fec_viterbi *v, const int8_t *soft, size_t len, uint8_t *data)
+{
+    if (len > FEC_PACKET_MAX)
+        return -EINVAL;
+    uint8_t bits[8 * (FEC_PACKET_MAX + 4)], tail[4];
+    fec_viterbi_decode(v, soft, 8 * (len + 4), bits);
+    bits_to_bytes(bits, len, data);
+    bits_to_bytes(bits + 8 * len, 4, tail);
+    uint32_t crc = (uint32_t)tail[0] << 24 | (uint32_t)tail[1] << 16 | (uint32_t)tail[2] << 8 | tail[3];
+    return crc32(data, len) == crc ? 0 : -EBADMSG;
+}
@@ -0,0 +1,85 @@
+#ifndef FEC_H
+#define FEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+/*
+ * Помехоустойчивое кодирование пакетов: свёрточный код K = 7, R = 1/2,
+ * полиномы 171, 133 (восьм.) - как в 802.11 / CCSDS.
+ *
+ * Биты - байты 0/1 (как в sequences.h). Пакет завершается 6 нулевыми
+ * хвостовыми битами: кодер и декодер начинают и заканчивают в состоянии 0.
+ *
+ * Мягкие решения - int8: > 0 - скорее 1, < 0 - скорее 0, 0 - стёрто
+ * (знак как у символа 2*b - 1, см. sequence_to_bpsk). Пара на каждый
+ * входной бит: выход полинома 171, затем 133.
+ *
+ * Декодер Витерби: 64 состояния, метрики int16, бабочки на SSE2 (8 состояний
+ * в регистре) или AVX2 (16). Решения - по 64 бита на шаг, обратный проход
+ * от состояния 0.
+ */
+
+#define FEC_K           7
+#define FEC_STATES      64
+#define FEC_POLY_A      0171
+#define FEC_POLY_B      0133
+
+/* Число кодовых бит (и мягких решений) для пакета из nbits */
+static inline size_t fec_conv_coded_len(size_t nbits)
+{
+    return 2 * (nbits + FEC_K - 1);
+}
+
+/* Закодировать nbits; в coded пишется fec_conv_coded_len(nbits) бит */
+void fec_conv_encode(const uint8_t *bits, size_t nbits, uint8_t *coded);
+
+struct fec_viterbi {
+    std::vector<uint64_t> decisions;    // шаг t: биты 0..31 - чётные новые состояния, 32..63 - нечётные
+    int16_t metrics[2][FEC_STATES] __attribute__((aligned(32)));
+};
+
+void fec_viterbi_init(struct fec_viterbi *v);
+
+/*
+ * Декодировать пакет: soft - fec_conv_coded_len(nbits) мягких решений,
+ * в bits пишется nbits бит. Возвращает итоговую метрику пути (корреляция
+ * с мягкими решениями, больше - надёжнее).
+ */
+long fec_viterbi_decode(struct fec_viterbi *v, const int8_t *soft, size_t nbits, uint8_t *bits);
+
+/*
+ * Кадр пакета канала чата/TUN поверх кода (байты, старший бит первым):
+ *   заголовок - длина (16 бит) + CRC-8 длины, отдельный блок кода;
+ *   тело - данные + CRC-32 (как zlib), второй блок кода.
+ * Приёмник сначала декодирует заголовок (FEC_PACKET_HDR_SOFT мягких
+ * решений, для QPSK - qpsk_soft_bits) и по длине знает, сколько решений
+ * ждать для тела. Ошибка CRC - -EBADMSG.
+ */
+
+#define FEC_PACKET_MAX      2048                        // байт данных
+#define FEC_PACKET_HDR_SOFT (2 * (24 + FEC_K - 1))      // fec_conv_coded_len(24)
+
+/* Кодовых бит тела для len байт данных */
+static inline size_t fec_packet_body_len(size_t len)
+{
+    return fec_conv_coded_len(8 * (len + 4));
+}
+
+/* Всего кодовых бит кадра */
+static inline size_t fec_packet_coded_len(size_t len)
+{
+    return FEC_PACKET_HDR_SOFT + fec_packet_body_len(len);
+}
+
+/* Закодировать кадр в coded (fec_packet_coded_len(len) бит 0/1). Число бит или -EINVAL */
+long fec_packet_encode(const uint8_t *data, size_t len, uint8_t *coded);
+
+/* Заголовок: длина данных или -EBADMSG */
+int fec_packet_decode_hdr(struct fec_viterbi *v, const int8_t *soft);
+
+/* Тело: soft - fec_packet_body_len(len) решений, в data - len байт. 0 или -EBADMSG */
+int fec_packet_decode_body(struct fec_viterbi *v, const int8_t *soft, size_t len, uint8_t *data);
+
+#endif // FEC_H
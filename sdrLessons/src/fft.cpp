@@ -0,0 +1,110 @@
+#include "fft.h"
+
+#include <math.h>
+#include <errno.h>
+
+size_t fft_next_pow2(size_t n)
+{
+    size_t p = 1;
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+int fft_plan_init(struct fft_plan *plan, size_t n, bool inverse)
+{
+    if (n < 2 || (n & (n - 1)) != 0)
+        return -EINVAL;
+
+    plan->n = n;
+    plan->inverse = inverse;
+    plan->log2n = 0;
+    while ((1u << plan->log2n) < n)
+        plan->log2n++;
+
+    plan->rev.resize(n);
+    for (size_t k = 0; k < n; k++) {
+        uint32_t r = 0;
+        for (unsigned b = 0; b < plan->log2n; b++)
+            r |= ((k >> b) & 1u) << (plan->log2n - 1 - b);
+        plan->rev[k] = r;
+    }
+
+    /* для стадии с половиной длины h повороты лежат в tw[h - 1 .. 2h - 1) */
+    const double sign = inverse ? 1.0 : -1.0;
+    plan->tw.resize(n - 1);
+    for (size_t h = 1; h < n; h <<= 1) {
+        for (size_t k = 0; k < h; k++) {
+            double a = sign * M_PI * (double)k / (double)h;
+            plan->tw[h - 1 + k] = cf_t((float)cos(a), (float)sin(a));
+        }
+    }
+    return 0;
+}
+
+static void bit_reverse(const struct fft_plan *plan, const cf_t *in, cf_t *out)
+{
+    const size_t n = plan->n;
+
+    if (in == out) {
+        for (size_t k = 0; k < n; k++) {
+            size_t r = plan->rev[k];
+            if (r > k) {
+                cf_t t = out[k];
+                out[k] = out[r];
+                out[r] = t;
+            }
+        }
+    } else {
+        for (size_t k = 0; k < n; k++)
+            out[plan->rev[k]] = in[k];
+    }
+}
+
+void fft_execute_batch(const struct fft_plan *plan, const cf_t *in, cf_t *out, size_t count)
+{
+    const size_t n = plan->n;
+    for (size_t c = 0; c < count; c++)
+        bit_reverse(plan, in + c * n, out + c * n);
+
+    /*
+     * Бабочки стадии h занимают блоки по 2h подряд, поэтому стадия идёт одним
+     * проходом по всем БПФ пакета, повороты стадии читаются из кэша.
+     * Работаем с float напрямую: operator* у std::complex медленный без -ffast-math.
+     */
+    float *d = reinterpret_cast<float *>(out);
+    const size_t total = n * count;
+
+    // h = 1: поворот 1
+    for (size_t base = 0; base < total; base += 2) {
+        float *a = d + 2 * base;
+        float ar = a[0], ai = a[1], br = a[2], bi = a[3];
+        a[0] = ar + br;
+        a[1] = ai + bi;
+        a[2] = ar - br;
+        a[3] = ai - bi;
+    }
+    for (size_t h = 2; h < n; h <<= 1) {
+        const float *w = reinterpret_cast<const float *>(&plan->tw[h - 1]);
+        for (size_t base = 0; base < total; base += 2 * h) {
+            float *a = d + 2 * base;
+            float *b = a + 2 * h;
+            for (size_t k = 0; k < h; k++) {
+                float wr = w[2 * k], wi = w[2 * k + 1];
+                float br = b[2 * k], bi = b[2 * k + 1];
+                float tr = br * wr - bi * wi;
+                float ti = br * wi + bi * wr;
+                float ar = a[2 * k], ai = a[2 * k + 1];
+                a[2 * k] = ar + tr;
+                a[2 * k + 1] = ai + ti;
+                b[2 * k] = ar - tr;
+                b[2 * k + 1] = ai - ti;
+            }
+        }
+    }
+}
+
+void fft_execute(const struct fft_plan *plan, const cf_t *in, cf_t *out)
+{
+    fft_execute_batch(plan, in, out, 1);
+}
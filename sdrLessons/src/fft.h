@@ -0,0 +1,34 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "dsp_types.h"
+
+/*
+ * Комплексное БПФ по основанию 2 (in-place, DIT).
+ * Повороты и таблица бит-реверса считаются один раз в fft_plan_init().
+ * Обратное БПФ не нормируется (как в FFTW).
+ */
+struct fft_plan {
+    size_t n;
+    unsigned log2n;
+    bool inverse;
+    std::vector<cf_t> tw;           // повороты, подряд для каждой стадии
+    std::vector<uint32_t> rev;
+};
+
+int fft_plan_init(struct fft_plan *plan, size_t n, bool inverse);
+
+/* in == out допускается */
+void fft_execute(const struct fft_plan *plan, const cf_t *in, cf_t *out);
+
+/* count БПФ подряд (in[c * n .. (c + 1) * n)), стадии - одним проходом по пакету */
+void fft_execute_batch(const struct fft_plan *plan, const cf_t *in, cf_t *out, size_t count);
+
+/* наименьшая степень двойки >= n */
+size_t fft_next_pow2(size_t n);
+
+#endif // FFT_H
@@ -0,0 +1,272 @@
+#include "fft_correlator.h"
+
+#include <math.h>
+#include <string.h>
+#include <errno.h>
+
+int fft_correlator_init(struct fft_correlator *fc, const struct fft_correlator_cfg *cfg)
+{
+    if (!fc || !cfg)
+        return -EINVAL;
+
+    int ret = fft_plan_init(&fc->fwd, cfg->fft_len, false);
+    if (ret < 0)
+        return ret;
+    ret = fft_plan_init(&fc->inv, cfg->fft_len, true);
+    if (ret < 0)
+        return ret;
+
+    fc->cfg = *cfg;
+    fc->tmpl.clear();
+    fc->max_len = 0;
+    fc->step = 0;
+    fc->started = false;
+    fc->fill = 0;
+    fc->buf_start = 0;
+
+    fc->buf.assign(cfg->fft_len, cf_t(0.0f, 0.0f));
+    fc->spec.resize(cfg->fft_len);
+    fc->out.resize(cfg->fft_len);
+    fc->energy_prefix.resize(cfg->fft_len + 1);
+    fc->pwr.resize(cfg->fft_len);
+    fc->pwr_prefix.resize(cfg->fft_len + 1);
+    return 0;
+}
+
+int fft_correlator_add_template(struct fft_correlator *fc, const cf_t *seq, size_t len)
+{
+    if (fc->started || len == 0 || len >= fc->cfg.fft_len / 2)
+        return -EINVAL;
+
+    struct corr_template t;
+    t.len = len;
+    t.energy = 0.0f;
+    t.has_pending = false;
+    t.pending_pwr = 0.0f;
+    t.spec.assign(fc->cfg.fft_len, cf_t(0.0f, 0.0f));
+    for (size_t k = 0; k < len; k++) {
+        t.spec[k] = seq[k];
+        t.energy += std::norm(seq[k]);
+    }
+    if (t.energy <= 0.0f)
+        return -EINVAL;
+
+    fft_execute(&fc->fwd, t.spec.data(), t.spec.data());
+    for (size_t k = 0; k < fc->cfg.fft_len; k++)
+        t.spec[k] = std::conj(t.spec[k]);
+
+    fc->tmpl.push_back(t);
+    if (len > fc->max_len)
+        fc->max_len = len;
+    return (int)fc->tmpl.size() - 1;
+}
+
+int fft_correlator_add_bpsk_template(struct fft_correlator *fc, const float *symbols,
+                                     size_t len, unsigned sps)
+{
+    if (sps == 0)
+        return -EINVAL;
+
+    std::vector<cf_t> seq(len * sps);
+    for (size_t k = 0; k < len; k++)
+        for (unsigned s = 0; s < sps; s++)
+            seq[k * sps + s] = cf_t(symbols[k], 0.0f);
+    return fft_correlator_add_template(fc, seq.data(), seq.size());
+}
+
+/* Первый блок: история из нулей, чтобы выход был с индекса 0 */
+static void correlator_start(struct fft_correlator *fc)
+{
+    fc->step = fc->cfg.fft_len - (fc->max_len - 1);
+    fc->fill = fc->max_len - 1;
+    fc->buf_start = -(long long)(fc->max_len - 1);
+    fc->started = true;
+
+    size_t tail = fc->cfg.cfar_guard < fc->step ? fc->cfg.cfar_guard : fc->step;
+    for (size_t t = 0; t < fc->tmpl.size(); t++) {
+        fc->tmpl[t].tail.assign(tail, 0.0f);
+        fc->tmpl[t].has_pending = false;
+    }
+}
+
+static size_t correlate_block(struct fft_correlator *fc, std::vector<struct corr_peak> *peaks)
+{
+    const size_t N = fc->cfg.fft_len;
+    const float scale = 1.0f / (float)N;
+    size_t found = 0;
+
+    fft_execute(&fc->fwd, fc->buf.data(), fc->spec.data());
+
+    fc->energy_prefix[0] = 0.0;
+    for (size_t k = 0; k < N; k++)
+        fc->energy_prefix[k + 1] = fc->energy_prefix[k] + std::norm(fc->buf[k]);
+
+    for (size_t t = 0; t < fc->tmpl.size(); t++) {
+        struct corr_template &tp = fc->tmpl[t];
+        const size_t vlen = N - tp.len + 1;     // валидные выходы overlap-save
+
+        const float *a = reinterpret_cast<const float *>(fc->spec.data());
+        const float *b = reinterpret_cast<const float *>(tp.spec.data());
+        float *o = reinterpret_cast<float *>(fc->out.data());
+        for (size_t k = 0; k < N; k++) {
+            float ar = a[2 * k], ai = a[2 * k + 1];
+            float br = b[2 * k], bi = b[2 * k + 1];
+            o[2 * k] = ar * br - ai * bi;
+            o[2 * k + 1] = ar * bi + ai * br;
+        }
+        fft_execute(&fc->inv, fc->out.data(), fc->out.data());
+
+        fc->pwr_prefix[0] = 0.0;
+        for (size_t m = 0; m < vlen; m++) {
+            fc->pwr[m] = std::norm(fc->out[m]) * scale * scale;
+            fc->pwr_prefix[m + 1] = fc->pwr_prefix[m] + fc->pwr[m];
+        }
+
+        const size_t G = fc->cfg.cfar_guard;
+        const size_t T = fc->cfg.cfar_train;
+        const size_t TL = tp.tail.size();
+
+        /* пик у конца прошлого блока: правые соседи теперь здесь */
+        if (tp.has_pending) {
+            size_t last = (size_t)(tp.pending.index + (long long)G - fc->buf_start);
+            bool is_max = true;
+            for (size_t j = 0; j <= last && j < vlen && is_max; j++)
+                is_max = fc->pwr[j] <= tp.pending_pwr;
+            if (is_max) {
+                if (peaks)
+                    peaks->push_back(tp.pending);
+                found++;
+            }
+            tp.has_pending = false;
+        }
+
+        for (size_t m = 0; m < fc->step; m++) {
+            const long long index = fc->buf_start + (long long)m;
+            if (index < 0)
+                continue;
+
+            const float p = fc->pwr[m];
+            double ex = fc->energy_prefix[m + tp.len] - fc->energy_prefix[m];
+            if (ex <= 0.0)
+                continue;
+            float corr = sqrtf((float)(p / (ex * tp.energy)));
+            if (corr < fc->cfg.min_corr)
+                continue;
+
+            /* локальный максимум в +-G; левее начала блока - tail */
+            size_t lo = m > G ? m - G : 0;
+            size_t hi = m + G < vlen - 1 ? m + G : vlen - 1;
+            bool is_max = true;
+            for (size_t j = m < G ? TL - (G - m < TL ? G - m : TL) : TL; j < TL && is_max; j++)
+                is_max = tp.tail[j] < p;
+            for (size_t j = lo; j <= hi && is_max; j++) {
+                if (j < m && fc->pwr[j] >= p)
+                    is_max = false;
+                if (j > m && fc->pwr[j] > p)
+                    is_max = false;
+            }
+            if (!is_max)
+                continue;
+
+            /* CA-CFAR: обучающие ячейки слева и справа от защитной зоны */
+            double noise = 0.0;
+            size_t cells = 0;
+            if (m > G) {
+                size_t r = m - G;
+                size_t l = r > T ? r - T : 0;
+                noise += fc->pwr_prefix[r] - fc->pwr_prefix[l];
+                cells += r - l;
+            }
+            if (m + G + 1 < vlen) {
+                size_t l = m + G + 1;
+                size_t r = l + T < vlen ? l + T : vlen;
+                noise += fc->pwr_prefix[r] - fc->pwr_prefix[l];
+                cells += r - l;
+            }
+            float ratio = cells && noise > 0.0 ? (float)(p / (noise / cells)) : INFINITY;
+            if (ratio < fc->cfg.cfar_factor)
+                continue;
+
+            /* параболическая интерполяция по модулю */
+            double frac = 0.0;
+            if (m > 0 && m + 1 < vlen) {
+                double y0 = sqrt(fc->pwr[m - 1]);
+                double y1 = sqrt(p);
+                double y2 = sqrt(fc->pwr[m + 1]);
+                double den = y0 - 2.0 * y1 + y2;
+                if (den < 0.0)
+                    frac = 0.5 * (y0 - y2) / den;
+            }
+
+            struct corr_peak pk;
+            pk.tmpl = (int)t;
+            pk.index = index;
+            pk.frac_index = (double)index + frac;
+            pk.corr = corr > 1.0f ? 1.0f : corr;
+            pk.phase = std::arg(fc->out[m]);
+            pk.cfar_ratio = ratio;
+            if (m + G > vlen - 1) {
+                // не все правые соседи посчитаны - решит следующий блок
+                tp.pending = pk;
+                tp.pending_pwr = p;
+                tp.has_pending = true;
+                continue;
+            }
+            if (peaks)
+                peaks->push_back(pk);
+            found++;
+        }
+
+        for (size_t j = 0; j < TL; j++)
+            tp.tail[j] = fc->pwr[fc->step - TL + j];
+    }
+    return found;
+}
+
+size_t fft_correlator_process(struct fft_correlator *fc, const cf_t *x, size_t n,
+                              std::vector<struct corr_peak> *peaks)
+{
+    if (fc->tmpl.empty())
+        return 0;
+    if (!fc->started)
+        correlator_start(fc);
+
+    const size_t N = fc->cfg.fft_len;
+    const size_t hist = fc->max_len - 1;
+    size_t found = 0;
+
+    while (n > 0) {
+        size_t chunk = N - fc->fill;
+        if (chunk > n)
+            chunk = n;
+        memcpy(&fc->buf[fc->fill], x, chunk * sizeof(cf_t));
+        fc->fill += chunk;
+        x += chunk;
+        n -= chunk;
+
+        if (fc->fill == N) {
+            found += correlate_block(fc, peaks);
+            memmove(&fc->buf[0], &fc->buf[fc->step], hist * sizeof(cf_t));
+            fc->fill = hist;
+            fc->buf_start += (long long)fc->step;
+        }
+    }
+    return found;
+}
+
+size_t fft_correlator_process_iq16(struct fft_correlator *fc, const int16_t *iq, size_t n,
+                                   std::vector<struct corr_peak> *peaks)
+{
+    cf_t tmp[1024];
+    size_t found = 0;
+
+    while (n > 0) {
+        size_t chunk = n < 1024 ? n : 1024;
+        for (size_t k = 0; k < chunk; k++)
+            tmp[k] = cf_t(iq[2 * k], iq[2 * k + 1]);
+        found += fft_correlator_process(fc, tmp, chunk, peaks);
+        iq += 2 * chunk;
+        n -= chunk;
+    }
+    return found;
+}
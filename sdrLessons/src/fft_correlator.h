@@ -0,0 +1,95 @@
+#ifndef FFT_CORRELATOR_H
+#define FFT_CORRELATOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "dsp_types.h"
+#include "fft.h"
+
+/*
+ * Потоковый коррелятор для поиска преамбул / обучающих последовательностей.
+ *
+ * Overlap-save: на каждый блок из step = fft_len - (L_max - 1) новых
+ * сэмплов одно прямое БПФ и по одному обратному на шаблон. Спектры
+ * шаблонов считаются один раз в fft_correlator_add_template().
+ *
+ * Пик засчитывается, если:
+ *  - нормированная корреляция |c| / sqrt(Ex * Er) >= min_corr;
+ *  - |c|^2 больше cfar_factor * (среднее |c|^2 по обучающим ячейкам)
+ *    (CA-CFAR, guard ячеек с каждой стороны не учитываются);
+ *  - это локальный максимум в пределах +-guard.
+ *
+ * Локальный максимум проверяется и через стык блоков: последние guard
+ * выходов блока переносятся в следующий, а пик ближе guard к концу блока
+ * выдаётся только со следующим блоком, когда видны его правые соседи.
+ */
+
+struct fft_correlator_cfg {
+    size_t fft_len;         // степень двойки, > максимальной длины шаблона
+    float min_corr;         // порог нормированной корреляции, 0..1
+    float cfar_factor;      // порог CFAR по мощности
+    size_t cfar_guard;      // защитные ячейки с каждой стороны
+    size_t cfar_train;      // обучающие ячейки с каждой стороны
+};
+
+struct corr_peak {
+    int tmpl;               // номер шаблона
+    long long index;        // абсолютный индекс начала шаблона во входном потоке
+    double frac_index;      // индекс с параболической интерполяцией
+    float corr;             // нормированная корреляция, 0..1
+    float phase;            // фаза корреляции, рад
+    float cfar_ratio;       // |c|^2 / шум CFAR
+};
+
+struct corr_template {
+    size_t len;
+    float energy;
+    std::vector<cf_t> spec;         // conj(FFT(шаблон, дополненный нулями))
+
+    /* стык блоков */
+    std::vector<float> tail;        // |c|^2 на [buf_start - tail.size(), buf_start)
+    bool has_pending;               // пик у конца прошлого блока ждёт правых соседей
+    struct corr_peak pending;
+    float pending_pwr;
+};
+
+struct fft_correlator {
+    struct fft_correlator_cfg cfg;
+    struct fft_plan fwd, inv;
+    std::vector<struct corr_template> tmpl;
+
+    size_t max_len;
+    size_t step;                    // новых сэмплов на блок
+    bool started;
+
+    std::vector<cf_t> buf;          // fft_len: (max_len - 1) истории + step новых
+    size_t fill;                    // сколько сэмплов сейчас в buf
+    long long buf_start;            // абсолютный индекс buf[0]
+
+    /* рабочие массивы */
+    std::vector<cf_t> spec, out;
+    std::vector<double> energy_prefix;
+    std::vector<float> pwr;
+    std::vector<double> pwr_prefix;
+};
+
+int fft_correlator_init(struct fft_correlator *fc, const struct fft_correlator_cfg *cfg);
+
+/* Добавить шаблон; только до первого вызова process. Возвращает номер шаблона или -errno */
+int fft_correlator_add_template(struct fft_correlator *fc, const cf_t *seq, size_t len);
+
+/* Шаблон из символов +-1 с повтором sps раз (прямоугольный импульс, как np.ones(ns) в 1.py) */
+int fft_correlator_add_bpsk_template(struct fft_correlator *fc, const float *symbols,
+                                     size_t len, unsigned sps);
+
+/* Обработать n сэмплов, найденные пики добавляются в peaks. Возвращает число пиков */
+size_t fft_correlator_process(struct fft_correlator *fc, const cf_t *x, size_t n,
+                              std::vector<struct corr_peak> *peaks);
+
+/* То же для interleaved I/Q int16 прямо из iio блока */
+size_t fft_correlator_process_iq16(struct fft_correlator *fc, const int16_t *iq, size_t n,
+                                   std::vector<struct corr_peak> *peaks);
+
+#endif // FFT_CORRELATOR_H
@@ -0,0 +1,177 @@
+#include "iq_analytics.h"
+#include "simd_ops.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+
+void iq_stats_reset(struct iq_stats *s)
+{
+    s->n = 0;
+    for (int k = 0; k < 7; k++)
+        s->m[k] = 0.0;
+}
+
+void iq_stats_merge(struct iq_stats *dst, const struct iq_stats *src)
+{
+    dst->n += src->n;
+    for (int k = 0; k < 7; k++)
+        dst->m[k] += src->m[k];
+}
+
+void iq_stats_add(struct iq_stats *s, const cf_t *x, size_t n)
+{
+    const float *f = reinterpret_cast<const float *>(x);
+
+    // блоками, чтобы float аккумуляторы ядра не теряли точность
+    while (n > 0) {
+        size_t chunk = n < 4096 ? n : 4096;
+        float m[7] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+        simd_iq_moments(f, 2 * chunk, m);
+        for (int k = 0; k < 7; k++)
+            s->m[k] += m[k];
+        s->n += chunk;
+        f += 2 * chunk;
+        n -= chunk;
+    }
+}
+
+void iq_stats_report(const struct iq_stats *s, struct iq_report *r)
+{
+    memset(r, 0, sizeof(*r));
+    if (s->n == 0)
+        return;
+
+    const double n = (double)s->n;
+    const double mi = s->m[0] / n, mq = s->m[1] / n;
+    const double pi = s->m[2] / n, pq = s->m[3] / n;
+    const double p = pi + pq;
+
+    r->power = p;
+    r->dc_i = mi;
+    r->dc_q = mq;
+
+    /*
+     * QPSK: точки (+-a, +-a), a = E(|I| + |Q|) / 2.
+     * E|x - ref|^2 = E|x|^2 - 2a E(|I| + |Q|) + 2a^2 = p - 2a^2
+     * (пока символ не перескочил в чужой квадрант).
+     */
+    const double a = s->m[5] / (2.0 * n);
+    const double ref = 2.0 * a * a;
+    const double err = p - ref;
+    if (ref > 0.0 && err > 0.0) {
+        r->evm_rms = sqrt(err / ref);
+        r->mer_db = 10.0 * log10(ref / err);
+    }
+
+    /* M2M4 для постоянной огибающей: S = sqrt(2 M2^2 - M4), N = M2 - S */
+    const double m4 = s->m[6] / n;
+    const double d = 2.0 * p * p - m4;
+    if (d > 0.0) {
+        double sig = sqrt(d);
+        double noise = p - sig;
+        r->snr_m2m4_db = noise > 0.0 ? 10.0 * log10(sig / noise) : INFINITY;
+    }
+
+    const double vi = pi - mi * mi, vq = pq - mq * mq;
+    const double cov = s->m[4] / n - mi * mq;
+    if (vi > 0.0 && vq > 0.0) {
+        r->gain_imb_db = 10.0 * log10(vi / vq);
+        double c = cov / sqrt(vi * vq);
+        if (c > 1.0) c = 1.0;
+        if (c < -1.0) c = -1.0;
+        r->phase_imb_deg = asin(c) * 180.0 / M_PI;
+    }
+}
+
+void density_hist_init(struct density_hist *d, unsigned w, unsigned h,
+                       float x0, float x1, float y0, float y1)
+{
+    d->w = w;
+    d->h = h;
+    d->x0 = x0;
+    d->x1 = x1;
+    d->y0 = y0;
+    d->y1 = y1;
+    d->bins.assign((size_t)w * h, 0);
+}
+
+void density_hist_merge(struct density_hist *dst, const struct density_hist *src)
+{
+    const size_t n = dst->bins.size();
+    uint32_t *a = dst->bins.data();
+    const uint32_t *b = src->bins.data();
+    for (size_t k = 0; k < n; k++)      // векторизуется компилятором
+        a[k] += b[k];
+}
+
+void density_hist_add_iq(struct density_hist *d, const cf_t *x, size_t n)
+{
+    const float sx = d->w / (d->x1 - d->x0);
+    const float sy = d->h / (d->y1 - d->y0);
+    uint32_t *bins = d->bins.data();
+
+    for (size_t k = 0; k < n; k++) {
+        float fx = (x[k].real() - d->x0) * sx;
+        float fy = (x[k].imag() - d->y0) * sy;
+        // выход за границы (и NaN) не считаем
+        if (!(fx >= 0.0f && fx < (float)d->w && fy >= 0.0f && fy < (float)d->h))
+            continue;
+        bins[(size_t)fy * d->w + (size_t)fx]++;
+    }
+}
+
+void density_hist_add_eye(struct density_hist *d, const cf_t *x, size_t n,
+                          unsigned sps, long long first_index)
+{
+    if (n < 2 || sps == 0)
+        return;
+
+    const unsigned period = 2 * sps;
+    unsigned cps = d->w / period;       // столбцов на интервал между сэмплами
+    if (cps == 0)
+        cps = 1;
+    const float sy = d->h / (d->y1 - d->y0);
+    uint32_t *bins = d->bins.data();
+    unsigned ph = (unsigned)(first_index % period);
+
+    for (size_t k = 0; k + 1 < n; k++) {
+        const float a = x[k].real();
+        const float step = (x[k + 1].real() - a) / cps;
+        const unsigned col0 = ph * cps;
+        for (unsigned j = 0; j < cps && col0 + j < d->w; j++) {
+            float fy = (a + step * j - d->y0) * sy;
+            if (fy >= 0.0f && fy < (float)d->h)
+                bins[(size_t)fy * d->w + col0 + j]++;
+        }
+        if (++ph == period)
+            ph = 0;
+    }
+}
+
+int density_hist_save_npy(const struct density_hist *d, const char *path)
+{
+    char hdr[128];
+    int len = snprintf(hdr, sizeof(hdr), "{'descr': '<u4', 'fortran_order': False, 'shape': (%u, %u), }",
+                       d->h, d->w);
+    // magic(6) + версия(2) + длина(2) + заголовок, всё кратно 64
+    int total = (10 + len + 1 + 63) & ~63;
+    while (10 + len + 1 < total)
+        hdr[len++] = ' ';
+    hdr[len++] = '\n';
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "Unable to open %s for writing\n", path);
+        return -errno;
+    }
+    const unsigned char magic[10] = {0x93, 'N', 'U', 'M', 'P', 'Y', 1, 0,
+                                     (unsigned char)(len & 0xff), (unsigned char)(len >> 8)};
+    fwrite(magic, 1, sizeof(magic), f);
+    fwrite(hdr, 1, len, f);
+    // x86/ARM little-endian, как '<u4'
+    size_t written = fwrite(d->bins.data(), sizeof(uint32_t), d->bins.size(), f);
+    fclose(f);
+    return written == d->bins.size() ? 0 : -EIO;
+}
@@ -0,0 +1,67 @@
+#ifndef IQ_ANALYTICS_H
+#define IQ_ANALYTICS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "dsp_types.h"
+
+/*
+ * Аналитика созвездия и глазковой диаграммы без matplotlib на каждый сэмпл.
+ *
+ * iq_stats - аддитивные моменты (считаются SIMD ядром simd_iq_moments),
+ * куски записи обрабатываются параллельно и складываются iq_stats_merge.
+ * Из них iq_stats_report выводит EVM/MER (решения QPSK по знакам, масштаб
+ * созвездия оценивается по среднему |I| + |Q|), SNR по M2M4, DC и
+ * разбаланс I/Q (для круговых сигналов: сырые сэмплы, QPSK до Костаса).
+ *
+ * density_hist - двумерная гистограмма плотности (созвездие или глаз),
+ * тоже складывается по кускам и сохраняется в .npy для plot_pcm.py.
+ */
+
+struct iq_stats {
+    size_t n;
+    double m[7];        // как в simd_iq_moments
+};
+
+struct iq_report {
+    double power;           // E|x|^2
+    double dc_i, dc_q;
+    double evm_rms;         // доля от амплитуды точки созвездия
+    double mer_db;
+    double snr_m2m4_db;
+    double gain_imb_db;     // 10 log10(var I / var Q)
+    double phase_imb_deg;   // отклонение от квадратуры
+};
+
+void iq_stats_reset(struct iq_stats *s);
+void iq_stats_merge(struct iq_stats *dst, const struct iq_stats *src);
+void iq_stats_add(struct iq_stats *s, const cf_t *x, size_t n);
+void iq_stats_report(const struct iq_stats *s, struct iq_report *r);
+
+struct density_hist {
+    unsigned w, h;              // столбцы (ось X), строки (ось Y)
+    float x0, x1, y0, y1;       // границы осей
+    std::vector<uint32_t> bins; // h строк по w, строка 0 - y0
+};
+
+void density_hist_init(struct density_hist *d, unsigned w, unsigned h,
+                       float x0, float x1, float y0, float y1);
+void density_hist_merge(struct density_hist *dst, const struct density_hist *src);
+
+/* Созвездие: X = I, Y = Q */
+void density_hist_add_iq(struct density_hist *d, const cf_t *x, size_t n);
+
+/*
+ * Глаз: по X - время в пределах двух символов (x0..x1 = 0..2*sps),
+ * по Y - I. Соседние сэмплы соединяются отрезками, как линии plot_eye_diagram.
+ * first_index - номер x[0] в записи (фаза трассы), x[n-1] только конец отрезка.
+ */
+void density_hist_add_eye(struct density_hist *d, const cf_t *x, size_t n,
+                          unsigned sps, long long first_index);
+
+/* uint32 массив (h, w) в формате .npy */
+int density_hist_save_npy(const struct density_hist *d, const char *path);
+
+#endif // IQ_ANALYTICS_H
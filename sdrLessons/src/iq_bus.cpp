@@ -0,0 +1,308 @@
+#include "iq_bus.h"
+#include "rt_thread.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "iq_bus needs lock-free 64-bit atomics");
+
+#define DEAD_CHECK_BLOCKS   1024    // как часто писатель ищет умерших читателей
+
+static size_t align_up(size_t v, size_t a)
+{
+    return (v + a - 1) & ~(a - 1);
+}
+
+static uint32_t *futex_word(struct iq_bus_hdr *h)
+{
+    return reinterpret_cast<uint32_t *>(&h->futex);
+}
+
+static bool pid_dead(int32_t pid)
+{
+    return kill(pid, 0) < 0 && errno == ESRCH;
+}
+
+int iq_bus_create(struct iq_bus *b, const char *name, size_t slots, size_t slot_samples, double fs_hz)
+{
+    if (slots < 4 || (slots & (slots - 1)) != 0 || slot_samples == 0 || strlen(name) >= sizeof(b->name))
+        return -EINVAL;
+
+    size_t slot_off = align_up(sizeof(struct iq_bus_hdr), 64);
+    size_t data_off = align_up(slot_off + slots * sizeof(struct iq_bus_slot), 4096);
+    size_t len = data_off + slots * slot_samples * 2 * sizeof(int16_t);
+
+    // сегмент от упавшего писателя - удаляем, его читатели увидят смерть писателя
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0660);
+    if (fd < 0) {
+        fprintf(stderr, "Unable to create shm %s: %s\n", name, strerror(errno));
+        return -errno;
+    }
+    if (ftruncate(fd, (off_t)len) < 0) {
+        int err = -errno;
+        close(fd);
+        shm_unlink(name);
+        return err;
+    }
+    void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        shm_unlink(name);
+        return -errno;
+    }
+    // RX поток не должен ловить page fault; без RLIMIT_MEMLOCK - как есть
+    mlock(p, len);
+
+    b->writer = true;
+    snprintf(b->name, sizeof(b->name), "%s", name);
+    b->map = static_cast<uint8_t *>(p);
+    b->map_len = len;
+    b->hdr = reinterpret_cast<struct iq_bus_hdr *>(b->map);
+    b->slot = reinterpret_cast<struct iq_bus_slot *>(b->map + slot_off);
+    b->data = reinterpret_cast<int16_t *>(b->map + data_off);
+    b->reader = -1;
+    b->cursor = 0;
+    b->pending_stamp = 0;
+
+    // ftruncate уже обнулил сегмент: все штампы 0, читателей нет
+    struct iq_bus_hdr *h = b->hdr;
+    h->version = IQ_BUS_VERSION;
+    h->slots = (uint32_t)slots;
+    h->max_readers = IQ_BUS_MAX_READERS;
+    h->slot_samples = slot_samples;
+    h->data_offset = data_off;
+    h->fs_hz = fs_hz;
+    h->writer_pid = (int32_t)getpid();
+    h->magic.store(IQ_BUS_MAGIC, std::memory_order_release);
+    return 0;
+}
+
+/* Пометки медленных читателей и освобождение записей умерших процессов */
+static void check_readers(struct iq_bus *b, uint64_t head)
+{
+    struct iq_bus_hdr *h = b->hdr;
+    const uint64_t hi = h->slots * 3 / 4, lo = h->slots / 4;
+    bool dead_check = (head % DEAD_CHECK_BLOCKS) == 0;
+
+    for (unsigned k = 0; k < IQ_BUS_MAX_READERS; k++) {
+        struct iq_bus_reader_rec *r = &h->readers[k];
+        int32_t pid = r->pid.load(std::memory_order_acquire);
+        if (pid <= 0)
+            continue;
+        if (dead_check && pid_dead(pid)) {
+            r->pid.compare_exchange_strong(pid, 0);
+            continue;
+        }
+        uint64_t cur = r->cursor.load(std::memory_order_relaxed);
+        uint64_t lag = head > cur ? head - cur : 0;
+        if (lag > hi && !r->slow.load(std::memory_order_relaxed)) {
+            r->slow.store(1, std::memory_order_relaxed);
+            r->slow_events.fetch_add(1, std::memory_order_relaxed);
+            h->slow_events.fetch_add(1, std::memory_order_relaxed);
+        } else if (lag < lo && r->slow.load(std::memory_order_relaxed)) {
+            r->slow.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void iq_bus_publish(struct iq_bus *b, const int16_t *iq, size_t n, long long index, int64_t host_ns,
+                    int64_t sample_ns)
+{
+    struct iq_bus_hdr *h = b->hdr;
+    uint64_t blk = h->head.load(std::memory_order_relaxed);
+    size_t k = blk & (h->slots - 1);
+    struct iq_bus_slot *s = &b->slot[k];
+    if (n > h->slot_samples)
+        n = h->slot_samples;
+
+    // seqlock: штамп 0 виден раньше новых данных
+    s->stamp.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(b->data + k * h->slot_samples * 2, iq, n * 2 * sizeof(int16_t));
+    s->info.index = index;
+    s->info.n = n;
+    s->info.flags = 0;
+    s->info.host_ns = host_ns;
+    s->info.sample_ns = sample_ns;
+    s->stamp.store(blk + 1, std::memory_order_release);
+    h->head.store(blk + 1, std::memory_order_release);
+
+    h->futex.fetch_add(1, std::memory_order_seq_cst);
+    if (h->waiters.load(std::memory_order_seq_cst) > 0)
+        syscall(SYS_futex, futex_word(h), FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+    check_readers(b, blk + 1);
+}
+
+size_t iq_bus_readers(const struct iq_bus *b)
+{
+    size_t count = 0;
+    for (unsigned k = 0; k < IQ_BUS_MAX_READERS; k++)
+        if (b->hdr->readers[k].pid.load(std::memory_order_relaxed) > 0)
+            count++;
+    return count;
+}
+
+int iq_bus_attach(struct iq_bus *b, const char *name)
+{
+    if (strlen(name) >= sizeof(b->name))
+        return -EINVAL;
+    int fd = shm_open(name, O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) {
+        fprintf(stderr, "Unable to open shm %s: %s\n", name, strerror(errno));
+        return -errno;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(struct iq_bus_hdr)) {
+        close(fd);
+        return -EINVAL;
+    }
+    size_t len = (size_t)st.st_size;
+    void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        return -errno;
+
+    struct iq_bus_hdr *h = static_cast<struct iq_bus_hdr *>(p);
+    uint32_t magic = h->magic.load(std::memory_order_acquire);
+    if (magic != IQ_BUS_MAGIC || h->version != IQ_BUS_VERSION ||
+        h->data_offset + h->slots * h->slot_samples * 2 * sizeof(int16_t) > len) {
+        fprintf(stderr, "%s: not an IQ bus or writer not ready\n", name);
+        munmap(p, len);
+        return -EINVAL;
+    }
+
+    // запись читателя: свободная или от умершего процесса; -1 - заполняется
+    int slot = -1;
+    for (unsigned k = 0; k < IQ_BUS_MAX_READERS && slot < 0; k++) {
+        int32_t pid = h->readers[k].pid.load(std::memory_order_acquire);
+        if ((pid == 0 || (pid > 0 && pid_dead(pid))) &&
+            h->readers[k].pid.compare_exchange_strong(pid, -1))
+            slot = (int)k;
+    }
+    if (slot < 0) {
+        munmap(p, len);
+        return -EBUSY;
+    }
+
+    b->writer = false;
+    snprintf(b->name, sizeof(b->name), "%s", name);
+    b->map = static_cast<uint8_t *>(p);
+    b->map_len = len;
+    b->hdr = h;
+    b->slot = reinterpret_cast<struct iq_bus_slot *>(b->map + align_up(sizeof(struct iq_bus_hdr), 64));
+    b->data = reinterpret_cast<int16_t *>(b->map + h->data_offset);
+    b->reader = slot;
+    b->cursor = h->head.load(std::memory_order_acquire);
+    b->pending_stamp = 0;
+
+    struct iq_bus_reader_rec *r = &h->readers[slot];
+    r->cursor.store(b->cursor, std::memory_order_relaxed);
+    r->lost.store(0, std::memory_order_relaxed);
+    r->slow.store(0, std::memory_order_relaxed);
+    r->slow_events.store(0, std::memory_order_relaxed);
+    r->pid.store((int32_t)getpid(), std::memory_order_release);
+    return 0;
+}
+
+static void skip_to(struct iq_bus *b, uint64_t to)
+{
+    struct iq_bus_reader_rec *r = &b->hdr->readers[b->reader];
+    r->lost.fetch_add(to - b->cursor, std::memory_order_relaxed);
+    b->cursor = to;
+    r->cursor.store(to, std::memory_order_release);
+}
+
+const int16_t *iq_bus_read_begin(struct iq_bus *b, const struct iq_block_info **info)
+{
+    struct iq_bus_hdr *h = b->hdr;
+    for (;;) {
+        uint64_t head = h->head.load(std::memory_order_acquire);
+        if (b->cursor >= head)
+            return NULL;
+        // слот head & mask уже может переписываться: догоняем до середины кольца
+        if (head - b->cursor >= h->slots) {
+            skip_to(b, head - h->slots / 2);
+            continue;
+        }
+        size_t k = b->cursor & (h->slots - 1);
+        uint64_t stamp = b->slot[k].stamp.load(std::memory_order_acquire);
+        if (stamp != b->cursor + 1)
+            continue;       // писатель обогнал после чтения head
+        b->pending_stamp = stamp;
+        *info = &b->slot[k].info;
+        return b->data + k * h->slot_samples * 2;
+    }
+}
+
+int iq_bus_read_end(struct iq_bus *b)
+{
+    struct iq_bus_hdr *h = b->hdr;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t stamp = b->slot[b->cursor & (h->slots - 1)].stamp.load(std::memory_order_relaxed);
+    struct iq_bus_reader_rec *r = &h->readers[b->reader];
+    b->cursor++;
+    r->cursor.store(b->cursor, std::memory_order_release);
+    if (stamp != b->pending_stamp) {
+        r->lost.fetch_add(1, std::memory_order_relaxed);
+        return -ESTALE;
+    }
+    return 0;
+}
+
+int iq_bus_wait(struct iq_bus *b, int timeout_ms)
+{
+    struct iq_bus_hdr *h = b->hdr;
+    for (;;) {
+        if (b->cursor < h->head.load(std::memory_order_acquire))
+            return 1;
+        if (h->closed.load(std::memory_order_acquire))
+            return -EPIPE;
+        if (rt_shutdown_requested())
+            return 0;
+
+        h->waiters.fetch_add(1, std::memory_order_seq_cst);
+        uint32_t val = h->futex.load(std::memory_order_seq_cst);
+        long ret = 0;
+        if (b->cursor >= h->head.load(std::memory_order_seq_cst) && !h->closed.load()) {
+            struct timespec ts;
+            ts.tv_sec = timeout_ms / 1000;
+            ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+            ret = syscall(SYS_futex, futex_word(h), FUTEX_WAIT, val, timeout_ms < 0 ? NULL : &ts, NULL, 0);
+        }
+        h->waiters.fetch_sub(1, std::memory_order_relaxed);
+        if (ret < 0 && errno == ETIMEDOUT) {
+            if (b->cursor < h->head.load(std::memory_order_acquire))
+                return 1;
+            return pid_dead(h->writer_pid) ? -EPIPE : 0;
+        }
+    }
+}
+
+void iq_bus_close(struct iq_bus *b)
+{
+    if (!b->map)
+        return;
+    struct iq_bus_hdr *h = b->hdr;
+    if (b->writer) {
+        h->closed.store(1, std::memory_order_release);
+        h->futex.fetch_add(1, std::memory_order_seq_cst);
+        syscall(SYS_futex, futex_word(h), FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+        munmap(b->map, b->map_len);
+        shm_unlink(b->name);
+    } else {
+        h->readers[b->reader].pid.store(0, std::memory_order_release);
+        munmap(b->map, b->map_len);
+    }
+    b->map = NULL;
+    b->hdr = NULL;
+}
@@ -0,0 +1,117 @@
+#ifndef IQ_BUS_H
+#define IQ_BUS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <atomic>
+
+#include "iq_ring.h"
+
+/*
+ * Шина RX блоков в общей памяти для локальных процессов (демодулятор,
+ * запись, спектр): RX поток публикует блок один раз, любое число
+ * читателей из других процессов видит его без сокетов и без второго
+ * подключения к IIO.
+ *
+ * Сегмент POSIX shm (shm_open, /dev/shm): заголовок, таблица читателей,
+ * slots слотов с iq_block_info и данными. Кольцо широковещательное -
+ * у каждого читателя свой курсор (в таблице, виден писателю).
+ *
+ * Писатель никогда не ждёт: слот перезаписывается независимо от
+ * читателей. Слот защищён seqlock-штампом (номер блока + 1, 0 - пишется),
+ * поэтому читатель работает с данными прямо в сегменте и в конце
+ * проверяет, что их не перезаписали (iq_bus_read_end() -> -ESTALE).
+ * Отставший больше чем на кольцо читатель перескакивает вперёд,
+ * пропуск считается в lost и виден по info->index.
+ *
+ * Медленные читатели: писатель на каждой публикации смотрит отставание
+ * курсоров; больше 3/4 кольца - читатель помечается slow (счётчик
+ * slow_events), меньше 1/4 - пометка снимается. Записи умерших процессов
+ * освобождаются.
+ *
+ * Ожидание - futex на счётчике публикаций в сегменте (межпроцессный,
+ * без FUTEX_PRIVATE); писатель будит, только если кто-то спит.
+ */
+
+#define IQ_BUS_MAGIC        0x53554249u     // "IBUS"
+#define IQ_BUS_VERSION      2
+#define IQ_BUS_MAX_READERS  16
+#define IQ_BUS_DEFAULT_NAME "/sdr_iq_bus"
+
+struct iq_bus_reader_rec {
+    std::atomic<int32_t> pid;           // 0 - свободно
+    std::atomic<uint64_t> cursor;       // следующий блок читателя
+    std::atomic<uint64_t> lost;         // пропущено блоков (перескоки и -ESTALE)
+    std::atomic<uint32_t> slow;
+    std::atomic<uint64_t> slow_events;
+};
+
+struct iq_bus_slot {
+    std::atomic<uint64_t> stamp;        // номер блока + 1; 0 - слот пишется
+    struct iq_block_info info;
+};
+
+struct iq_bus_hdr {
+    std::atomic<uint32_t> magic;        // пишется последним
+    uint32_t version;
+    uint32_t slots;                     // степень двойки
+    uint32_t max_readers;
+    uint64_t slot_samples;
+    uint64_t data_offset;               // от начала сегмента
+    double fs_hz;                       // 0 - неизвестна
+    int32_t writer_pid;
+    std::atomic<uint32_t> closed;
+
+    std::atomic<uint64_t> head;         // опубликовано блоков
+    std::atomic<uint32_t> futex;        // +1 на публикацию
+    std::atomic<uint32_t> waiters;
+    std::atomic<uint64_t> slow_events;
+
+    struct iq_bus_reader_rec readers[IQ_BUS_MAX_READERS];
+};
+
+struct iq_bus {
+    bool writer;
+    char name[64];
+    uint8_t *map;
+    size_t map_len;
+    struct iq_bus_hdr *hdr;
+    struct iq_bus_slot *slot;
+    int16_t *data;
+
+    // читатель
+    int reader;                         // запись в hdr->readers
+    uint64_t cursor;
+    uint64_t pending_stamp;             // штамп слота из iq_bus_read_begin()
+};
+
+/* Писатель: создать сегмент name (старый с тем же именем удаляется) */
+int iq_bus_create(struct iq_bus *b, const char *name, size_t slots, size_t slot_samples, double fs_hz);
+
+/* Опубликовать блок (n обрезается до slot_samples). Не ждёт */
+void iq_bus_publish(struct iq_bus *b, const int16_t *iq, size_t n, long long index, int64_t host_ns,
+                    int64_t sample_ns);
+
+/* Писатель: число подключённых читателей */
+size_t iq_bus_readers(const struct iq_bus *b);
+
+/* Читатель: подключиться к name, чтение начинается со следующего блока */
+int iq_bus_attach(struct iq_bus *b, const char *name);
+
+/* Читатель: следующий блок прямо в сегменте или NULL */
+const int16_t *iq_bus_read_begin(struct iq_bus *b, const struct iq_block_info **info);
+
+/* Читатель: блок обработан. 0 или -ESTALE - его перезаписали за время чтения */
+int iq_bus_read_end(struct iq_bus *b);
+
+/*
+ * Читатель: ждать блок. 1 - есть, 0 - таймаут или rt_shutdown_requested(),
+ * -EPIPE - писатель закрыл шину или умер
+ */
+int iq_bus_wait(struct iq_bus *b, int timeout_ms);
+
+/* Писатель - удаляет сегмент и будит читателей; читатель - освобождает запись */
+void iq_bus_close(struct iq_bus *b);
+
+#endif // IQ_BUS_H
@@ -0,0 +1,513 @@
+#include "iq_codec.h"
+
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+
+#include <vector>
+
+/*
+ * Заголовок блока (12 байт):
+ *   u8 mode, u8 shift, u8 pred, u8 0, u32 n (сэмплов), u32 len (байт вместе с заголовком)
+ * IQC_RANS дальше: u16 freq[IQC_SYMS], u32 длина rANS потока, rANS поток
+ * (начальные состояния I и Q, затем байты перенормировки),
+ * сырые биты (LSB first) до конца блока.
+ */
+
+#define IQC_HDR         12
+#define IQC_SYMS        64
+#define IQC_SCALE_BITS  12
+#define IQC_SCALE       (1u << IQC_SCALE_BITS)
+#define RANS_L          (1u << 23)
+
+static inline void put_u32(uint8_t *p, uint32_t v)
+{
+    memcpy(p, &v, 4);
+}
+
+static inline uint32_t get_u32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static void write_hdr(uint8_t *out, int mode, int shift, int pred, size_t n, size_t len)
+{
+    out[0] = (uint8_t)mode;
+    out[1] = (uint8_t)shift;
+    out[2] = (uint8_t)pred;
+    out[3] = 0;
+    put_u32(out + 4, (uint32_t)n);
+    put_u32(out + 8, (uint32_t)len);
+}
+
+size_t iqc_bound(size_t n)
+{
+    return IQC_HDR + 4 * n;
+}
+
+/* ---------- упаковка 12 бит ---------- */
+
+static size_t pack12(const int16_t *iq, size_t n, int shift, uint8_t *out)
+{
+    uint8_t *p = out + IQC_HDR;
+    for (size_t k = 0; k < 2 * n; k += 2) {
+        uint32_t a = (uint32_t)(iq[k] >> shift) & 0xfff;
+        uint32_t b = (uint32_t)(iq[k + 1] >> shift) & 0xfff;
+        p[0] = (uint8_t)a;
+        p[1] = (uint8_t)((a >> 8) | (b << 4));
+        p[2] = (uint8_t)(b >> 4);
+        p += 3;
+    }
+    size_t len = p - out;
+    write_hdr(out, IQC_PACK12, shift, 0, n, len);
+    return len;
+}
+
+static void unpack12(const uint8_t *p, size_t n, int shift, int16_t *out)
+{
+    for (size_t k = 0; k < 2 * n; k += 2) {
+        uint32_t a = p[0] | ((uint32_t)(p[1] & 0x0f) << 8);
+        uint32_t b = (p[1] >> 4) | ((uint32_t)p[2] << 4);
+        // знаковое расширение 12 -> 32 бит
+        out[k] = (int16_t)((int32_t)(a << 20) >> (20 - shift));
+        out[k + 1] = (int16_t)((int32_t)(b << 20) >> (20 - shift));
+        p += 3;
+    }
+}
+
+/* ---------- остатки предсказания -> токены ---------- */
+
+static inline uint32_t zigzag(int32_t e)
+{
+    return ((uint32_t)e << 1) ^ (uint32_t)(e >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t u)
+{
+    return (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+}
+
+/* u < 16 - токен u; дальше по два токена на длину (старший бит + следующий) */
+static inline unsigned token_of(uint32_t u, unsigned *extra_bits)
+{
+    if (u < 16) {
+        *extra_bits = 0;
+        return u;
+    }
+    unsigned nb = 32 - __builtin_clz(u);
+    *extra_bits = nb - 2;
+    return 16 + 2 * (nb - 5) + ((u >> (nb - 2)) & 1);
+}
+
+template <int PRED>
+static inline int32_t predict(int32_t v1, int32_t v2)
+{
+    return PRED == 2 ? 2 * v1 - v2 : PRED == 1 ? v1 : 0;
+}
+
+/* zigzag остатков предсказания, отдельно по I и Q */
+template <int PRED>
+static void residuals_t(const int16_t *iq, size_t n, int shift, uint32_t *u)
+{
+    int32_t i1 = 0, i2 = 0, q1 = 0, q2 = 0;
+    for (size_t k = 0; k < n; k++) {
+        int32_t i = iq[2 * k] >> shift, q = iq[2 * k + 1] >> shift;
+        u[2 * k] = zigzag(i - predict<PRED>(i1, i2));
+        u[2 * k + 1] = zigzag(q - predict<PRED>(q1, q2));
+        i2 = i1;
+        i1 = i;
+        q2 = q1;
+        q1 = q;
+    }
+}
+
+static void residuals(const int16_t *iq, size_t n, int shift, int pred, uint32_t *u)
+{
+    switch (pred) {
+    case 1:  residuals_t<1>(iq, n, shift, u); break;
+    case 2:  residuals_t<2>(iq, n, shift, u); break;
+    default: residuals_t<0>(iq, n, shift, u); break;
+    }
+}
+
+template <int PRED>
+static void reconstruct_t(const uint32_t *u, size_t n, int shift, int16_t *out)
+{
+    int32_t i1 = 0, i2 = 0, q1 = 0, q2 = 0;
+    for (size_t k = 0; k < n; k++) {
+        int32_t i = unzigzag(u[2 * k]) + predict<PRED>(i1, i2);
+        int32_t q = unzigzag(u[2 * k + 1]) + predict<PRED>(q1, q2);
+        out[2 * k] = (int16_t)(i * (1 << shift));
+        out[2 * k + 1] = (int16_t)(q * (1 << shift));
+        i2 = i1;
+        i1 = i;
+        q2 = q1;
+        q1 = q;
+    }
+}
+
+static void reconstruct(const uint32_t *u, size_t n, int shift, int pred, int16_t *out)
+{
+    switch (pred) {
+    case 1:  reconstruct_t<1>(u, n, shift, out); break;
+    case 2:  reconstruct_t<2>(u, n, shift, out); break;
+    default: reconstruct_t<0>(u, n, shift, out); break;
+    }
+}
+
+/* Предсказатель с наименьшей суммой |остатка| по блоку */
+static int choose_predictor(const int16_t *iq, size_t n, int shift)
+{
+    uint64_t cost[3] = {0, 0, 0};
+    for (int c = 0; c < 2; c++) {
+        int32_t v1 = 0, v2 = 0;
+        for (size_t k = 0; k < n; k++) {
+            int32_t v = iq[2 * k + c] >> shift;
+            cost[0] += abs(v);
+            cost[1] += abs(v - v1);
+            cost[2] += abs(v - 2 * v1 + v2);
+            v2 = v1;
+            v1 = v;
+        }
+    }
+    int best = 0;
+    for (int p = 1; p < 3; p++)
+        if (cost[p] < cost[best])
+            best = p;
+    return best;
+}
+
+/* Частоты к сумме IQC_SCALE, у встреченных символов не меньше 1 */
+static void normalize_freq(const uint32_t *count, size_t total, uint16_t *freq)
+{
+    uint32_t sum = 0;
+    for (int s = 0; s < IQC_SYMS; s++) {
+        uint32_t f = 0;
+        if (count[s]) {
+            f = (uint32_t)((uint64_t)count[s] * IQC_SCALE / total);
+            if (f == 0)
+                f = 1;
+        }
+        freq[s] = (uint16_t)f;
+        sum += f;
+    }
+    // недостачу отдаём самому частому символу, излишек снимаем с самых частых
+    while (sum != IQC_SCALE) {
+        int best = 0;
+        for (int s = 1; s < IQC_SYMS; s++)
+            if (freq[s] > freq[best])
+                best = s;
+        if (sum < IQC_SCALE) {
+            freq[best] += IQC_SCALE - sum;
+            sum = IQC_SCALE;
+        } else {
+            uint32_t d = sum - IQC_SCALE;
+            if (d > freq[best] - 1u)
+                d = freq[best] - 1u;
+            freq[best] -= d;
+            sum -= d;
+        }
+    }
+}
+
+struct bit_writer {
+    uint8_t *p, *end;
+    uint64_t acc;
+    unsigned nbits;
+};
+
+static inline bool bw_put(struct bit_writer *bw, uint32_t v, unsigned n)
+{
+    bw->acc |= (uint64_t)v << bw->nbits;
+    bw->nbits += n;
+    while (bw->nbits >= 8) {
+        if (bw->p == bw->end)
+            return false;
+        *bw->p++ = (uint8_t)bw->acc;
+        bw->acc >>= 8;
+        bw->nbits -= 8;
+    }
+    return true;
+}
+
+/* Кодирование символа без деления: x / freq через обратное (как в rans_byte.h F. Giesen) */
+struct rans_sym {
+    uint32_t x_max;
+    uint32_t rcp_freq;
+    uint32_t bias;
+    uint32_t cmpl_freq;
+    uint32_t rcp_shift;
+};
+
+static void rans_sym_init(struct rans_sym *s, uint32_t start, uint32_t freq)
+{
+    s->x_max = ((RANS_L >> IQC_SCALE_BITS) << 8) * freq;
+    s->cmpl_freq = IQC_SCALE - freq;
+    if (freq < 2) {
+        // freq == 1: x / 1 = x, сдвиг на 32 недопустим - через bias
+        s->rcp_freq = ~0u;
+        s->rcp_shift = 0;
+        s->bias = start + IQC_SCALE - 1;
+    } else {
+        uint32_t shift = 0;
+        while (freq > (1u << shift))
+            shift++;
+        s->rcp_freq = (uint32_t)(((1ull << (shift + 31)) + freq - 1) / freq);
+        s->rcp_shift = shift - 1;
+        s->bias = start;
+    }
+}
+
+static inline void rans_put(uint32_t *x, uint8_t **ptr, const struct rans_sym *sym)
+{
+    uint32_t st = *x;
+    while (st >= sym->x_max) {
+        *--*ptr = (uint8_t)st;
+        st >>= 8;
+    }
+    uint32_t q = (uint32_t)(((uint64_t)st * sym->rcp_freq) >> 32) >> sym->rcp_shift;
+    *x = st + sym->bias + q * sym->cmpl_freq;
+}
+
+/* Возвращает размер или 0, если не поместилось в limit */
+static size_t encode_rans(const int16_t *iq, size_t n, int shift, int pred, uint8_t *out, size_t limit)
+{
+    const size_t nsym = 2 * n;
+    static thread_local std::vector<uint8_t> tokens;
+    static thread_local std::vector<uint32_t> values;
+    static thread_local std::vector<uint8_t> stream;
+    tokens.resize(nsym);
+    values.resize(nsym);
+
+    // остатки I и Q чередуются, как сэмплы
+    residuals(iq, n, shift, pred, values.data());
+    uint32_t count[IQC_SYMS] = {0};
+    for (size_t k = 0; k < nsym; k++) {
+        unsigned eb;
+        unsigned t = token_of(values[k], &eb);
+        tokens[k] = (uint8_t)t;
+        count[t]++;
+    }
+
+    uint16_t freq[IQC_SYMS];
+    uint32_t start[IQC_SYMS + 1];
+    normalize_freq(count, nsym, freq);
+    start[0] = 0;
+    for (int s = 0; s < IQC_SYMS; s++)
+        start[s + 1] = start[s] + freq[s];
+
+    size_t fixed = IQC_HDR + 2 * IQC_SYMS + 4;
+    if (limit < fixed + 8)
+        return 0;
+
+    struct rans_sym syms[IQC_SYMS];
+    for (int s = 0; s < IQC_SYMS; s++)
+        rans_sym_init(&syms[s], start[s], freq[s]);
+
+    // rANS кодирует с конца; пишем в отдельный буфер справа налево.
+    // Два состояния: I - x[0], Q - x[1], декодер считает их независимо
+    stream.resize(nsym * 3 + 16);
+    uint8_t *const s_end = stream.data() + stream.size();
+    uint8_t *ptr = s_end;
+    uint32_t x0 = RANS_L, x1 = RANS_L;
+    for (size_t k = nsym; k > 0; k -= 2) {
+        rans_put(&x1, &ptr, &syms[tokens[k - 1]]);
+        rans_put(&x0, &ptr, &syms[tokens[k - 2]]);
+    }
+    ptr -= 8;
+    put_u32(ptr, x0);
+    put_u32(ptr + 4, x1);
+    size_t rans_len = s_end - ptr;
+    if (fixed + rans_len > limit)
+        return 0;
+
+    uint8_t *p = out + IQC_HDR;
+    for (int s = 0; s < IQC_SYMS; s++) {
+        memcpy(p, &freq[s], 2);
+        p += 2;
+    }
+    put_u32(p, (uint32_t)rans_len);
+    p += 4;
+    memcpy(p, ptr, rans_len);
+    p += rans_len;
+
+    struct bit_writer bw = {p, out + limit, 0, 0};
+    for (size_t k = 0; k < nsym; k++) {
+        unsigned eb;
+        token_of(values[k], &eb);
+        if (eb && !bw_put(&bw, values[k] & ((1u << eb) - 1), eb))
+            return 0;
+    }
+    if (bw.nbits && !bw_put(&bw, 0, 8 - bw.nbits))
+        return 0;
+
+    size_t len = bw.p - out;
+    write_hdr(out, IQC_RANS, shift, pred, n, len);
+    return len;
+}
+
+struct bit_reader {
+    const uint8_t *p, *end;
+    uint64_t acc;
+    unsigned nbits;
+};
+
+static inline unsigned rans_get(uint32_t *x, const uint8_t *lut, const uint16_t *freq, const uint32_t *start)
+{
+    uint32_t st = *x;
+    unsigned t = lut[st & (IQC_SCALE - 1)];
+    *x = freq[t] * (st >> IQC_SCALE_BITS) + (st & (IQC_SCALE - 1)) - start[t];
+    return t;
+}
+
+static inline bool rans_renorm(uint32_t *x, const uint8_t **rp, const uint8_t *rend)
+{
+    while (*x < RANS_L) {
+        if (*rp == rend)
+            return false;
+        *x = (*x << 8) | *(*rp)++;
+    }
+    return true;
+}
+
+/* Токен + сырые биты -> zigzag остаток */
+static inline bool token_value(unsigned t, struct bit_reader *br, uint32_t *u)
+{
+    if (t < 16) {
+        *u = t;
+        return true;
+    }
+    unsigned nb = 5 + (t - 16) / 2;
+    unsigned eb = nb - 2;
+    while (br->nbits < eb) {
+        if (br->p == br->end)
+            return false;
+        br->acc |= (uint64_t)*br->p++ << br->nbits;
+        br->nbits += 8;
+    }
+    *u = (1u << (nb - 1)) | ((t & 1u) << eb) | (uint32_t)(br->acc & ((1u << eb) - 1));
+    br->acc >>= eb;
+    br->nbits -= eb;
+    return true;
+}
+
+static long decode_rans(const uint8_t *in, size_t len, size_t n, int shift, int pred, int16_t *out)
+{
+    const uint8_t *p = in + IQC_HDR;
+    const uint8_t *end = in + len;
+    if (len < IQC_HDR + 2 * IQC_SYMS + 8)
+        return -EINVAL;
+
+    uint16_t freq[IQC_SYMS];
+    uint32_t start[IQC_SYMS];
+    uint8_t lut[IQC_SCALE];
+    uint32_t sum = 0;
+    for (int s = 0; s < IQC_SYMS; s++) {
+        memcpy(&freq[s], p, 2);
+        p += 2;
+        start[s] = sum;
+        if (sum + freq[s] > IQC_SCALE)
+            return -EINVAL;
+        memset(lut + sum, s, freq[s]);
+        sum += freq[s];
+    }
+    if (sum != IQC_SCALE)
+        return -EINVAL;
+    uint32_t rans_len = get_u32(p);
+    p += 4;
+    if (rans_len < 4 || rans_len > (size_t)(end - p))
+        return -EINVAL;
+    if (rans_len < 8)
+        return -EINVAL;
+    const uint8_t *rp = p + 8, *rend = p + rans_len;
+    uint32_t x0 = get_u32(p), x1 = get_u32(p + 4);
+
+    struct bit_reader br = {rend, end, 0, 0};
+    static thread_local std::vector<uint32_t> values;
+    values.resize(2 * n);
+    uint32_t *u = values.data();
+    for (size_t k = 0; k < 2 * n; k += 2) {
+        unsigned ti = rans_get(&x0, lut, freq, start);
+        unsigned tq = rans_get(&x1, lut, freq, start);
+        // перенормировка в порядке, обратном кодеру: сначала I, потом Q
+        if (!rans_renorm(&x0, &rp, rend) || !rans_renorm(&x1, &rp, rend))
+            return -EINVAL;
+        if (!token_value(ti, &br, &u[k]) || !token_value(tq, &br, &u[k + 1]))
+            return -EINVAL;
+    }
+    reconstruct(u, n, shift, pred, out);
+    return (long)n;
+}
+
+size_t iqc_encode(const int16_t *iq, size_t n, uint8_t *out, int level)
+{
+    int32_t lo = 0, hi = 0;
+    uint32_t bits = 0;
+    for (size_t k = 0; k < 2 * n; k++) {
+        int32_t v = iq[k];
+        lo = v < lo ? v : lo;
+        hi = v > hi ? v : hi;
+        bits |= (uint32_t)v;
+    }
+    // TX отсчёты сдвинуты на 4 влево - младшие биты всегда нули
+    int shift = (bits & 0xf) == 0 && bits != 0 ? 4 : 0;
+    bool fits12 = (lo >> shift) >= -2048 && (hi >> shift) <= 2047;
+
+    size_t best = 0;
+    if (fits12)
+        best = pack12(iq, n, shift, out);
+    if (level > 0) {
+        static thread_local std::vector<uint8_t> tmp;
+        tmp.resize(iqc_bound(n));
+        size_t limit = best ? best - 1 : iqc_bound(n);
+        int pred = choose_predictor(iq, n, shift);
+        size_t len = encode_rans(iq, n, shift, pred, tmp.data(), limit);
+        if (len) {
+            memcpy(out, tmp.data(), len);
+            best = len;
+        }
+    }
+    if (!best) {
+        best = IQC_HDR + 4 * n;
+        memcpy(out + IQC_HDR, iq, 4 * n);
+        write_hdr(out, IQC_RAW16, 0, 0, n, best);
+    }
+    return best;
+}
+
+long iqc_block_samples(const uint8_t *in, size_t len)
+{
+    if (len < IQC_HDR || in[0] > IQC_RANS)
+        return -EINVAL;
+    return get_u32(in + 4);
+}
+
+long iqc_decode(const uint8_t *in, size_t len, int16_t *out, size_t n_max)
+{
+    if (len < IQC_HDR)
+        return -EINVAL;
+    int mode = in[0], shift = in[1], pred = in[2];
+    size_t n = get_u32(in + 4);
+    size_t blen = get_u32(in + 8);
+    if (blen > len || n > n_max || shift > 4 || pred > 2)
+        return -EINVAL;
+
+    switch (mode) {
+    case IQC_RAW16:
+        if (blen != IQC_HDR + 4 * n)
+            return -EINVAL;
+        memcpy(out, in + IQC_HDR, 4 * n);
+        return (long)n;
+    case IQC_PACK12:
+        if (blen != IQC_HDR + 3 * n)
+            return -EINVAL;
+        unpack12(in + IQC_HDR, n, shift, out);
+        return (long)n;
+    case IQC_RANS:
+        return decode_rans(in, blen, n, shift, pred, out);
+    default:
+        return -EINVAL;
+    }
+}
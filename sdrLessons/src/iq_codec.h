@@ -0,0 +1,42 @@
+#ifndef IQ_CODEC_H
+#define IQ_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Сжатие блока I/Q без потерь (int16, I/Q чередуются).
+ *
+ * АЦП AD9361 даёт 12 бит: RX - со знаком в младших битах, TX (txdata.pcm) -
+ * сдвинутые на 4 влево. Блок кодируется одним из способов:
+ *  - IQC_RAW16:  как есть (если не влезает в 12 бит);
+ *  - IQC_PACK12: упаковка 2 отсчёта -> 3 байта (-25%);
+ *  - IQC_RANS:   предсказание (нет / разность / LPC 2-го порядка, выбирается
+ *                по блоку) + rANS остатков: остаток -> zigzag -> токен
+ *                (rANS, 64 символа, таблица частот в блоке) + сырые младшие биты.
+ * Блоки независимы (предсказатель стартует с нуля) - произвольный доступ.
+ */
+
+enum iqc_mode {
+    IQC_RAW16 = 0,
+    IQC_PACK12 = 1,
+    IQC_RANS = 2,
+};
+
+/* Максимальный размер сжатого блока из n сэмплов */
+size_t iqc_bound(size_t n);
+
+/*
+ * Сжать n сэмплов в out (не меньше iqc_bound(n)). level 0 - только упаковка
+ * 12 бит, 1 - предсказание + rANS (с откатом на упаковку, если она меньше).
+ * Возвращает размер в байтах.
+ */
+size_t iqc_encode(const int16_t *iq, size_t n, uint8_t *out, int level);
+
+/* Число сэмплов в сжатом блоке (из заголовка) или -EINVAL */
+long iqc_block_samples(const uint8_t *in, size_t len);
+
+/* Распаковать блок в out (n_max сэмплов). Возвращает число сэмплов или -EINVAL */
+long iqc_decode(const uint8_t *in, size_t len, int16_t *out, size_t n_max);
+
+#endif // IQ_CODEC_H
@@ -0,0 +1,120 @@
+#include "iq_correct.h"
+#include "simd_ops.h"
+
+#include <math.h>
+#include <errno.h>
+
+#define CHUNK       1024
+
+void iq_correct_default_cfg(struct iq_correct_cfg *cfg)
+{
+    cfg->fix_dc = true;
+    cfg->fix_iq = true;
+    cfg->dc_tau = 1e5;          // 10 мс на 10 MS/s
+    cfg->iq_tau = 1e6;
+    cfg->max_gain_db = 3.0f;
+    cfg->max_phase_deg = 20.0f;
+}
+
+int iq_correct_init(struct iq_correct *c, const struct iq_correct_cfg *cfg)
+{
+    if (cfg->dc_tau <= 0.0 || cfg->iq_tau <= 0.0)
+        return -EINVAL;
+    c->cfg = *cfg;
+    c->tmp.resize(2 * CHUNK);
+    iq_correct_reset(c);
+    return 0;
+}
+
+void iq_correct_reset(struct iq_correct *c)
+{
+    c->primed = false;
+    c->dc_i = c->dc_q = 0.0;
+    c->cii = c->cqq = c->ciq = 0.0;
+    c->p = 0.0;
+    c->g = 1.0;
+    c->gain_db = c->phase_deg = 0.0;
+    c->iq_valid = false;
+    c->c[0] = 1.0f;
+    c->c[1] = c->c[2] = c->c[3] = 0.0f;
+    c->c[4] = 1.0f;
+    c->c[5] = 0.0f;
+}
+
+/* Моменты блока (суммы I, Q, I^2, Q^2, IQ) -> сглаженные оценки -> c[] */
+static void update(struct iq_correct *c, const double *m, size_t n)
+{
+    if (n == 0)
+        return;
+    double mi = m[0] / n, mq = m[1] / n;
+    double bii = m[2] / n - mi * mi, bqq = m[3] / n - mq * mq, biq = m[4] / n - mi * mq;
+
+    double a_dc = c->primed ? 1.0 - exp(-(double)n / c->cfg.dc_tau) : 1.0;
+    double a_iq = c->primed ? 1.0 - exp(-(double)n / c->cfg.iq_tau) : 1.0;
+    c->primed = true;
+    c->dc_i += a_dc * (mi - c->dc_i);
+    c->dc_q += a_dc * (mq - c->dc_q);
+    c->cii += a_iq * (bii - c->cii);
+    c->cqq += a_iq * (bqq - c->cqq);
+    c->ciq += a_iq * (biq - c->ciq);
+
+    c->iq_valid = false;
+    if (c->cii > 0.0 && c->cqq > 0.0) {
+        double rho = c->ciq / sqrt(c->cii * c->cqq);
+        double orth = c->cqq - c->ciq * c->ciq / c->cii;
+        c->gain_db = 10.0 * log10(c->cii / c->cqq);
+        c->phase_deg = asin(fmax(-1.0, fmin(1.0, rho))) * 180.0 / M_PI;
+        if (orth > 0.0 && fabs(c->gain_db) <= c->cfg.max_gain_db &&
+            fabs(c->phase_deg) <= c->cfg.max_phase_deg) {
+            c->p = c->ciq / c->cii;
+            c->g = sqrt(c->cii / orth);
+            c->iq_valid = true;
+        }
+    }
+
+    double di = c->cfg.fix_dc ? c->dc_i : 0.0, dq = c->cfg.fix_dc ? c->dc_q : 0.0;
+    double p = c->cfg.fix_iq ? c->p : 0.0, g = c->cfg.fix_iq ? c->g : 1.0;
+    c->c[0] = 1.0f;
+    c->c[1] = 0.0f;
+    c->c[2] = (float)-di;
+    c->c[3] = (float)(-g * p);
+    c->c[4] = (float)g;
+    c->c[5] = (float)(g * (p * di - dq));
+}
+
+/* m[0..4] += суммы по x, кусками - float аккумуляторы ядра не теряют точность */
+static void add_moments(const float *x, size_t n, double *m)
+{
+    while (n > 0) {
+        size_t chunk = n < CHUNK ? n : CHUNK;
+        float s[7] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+        simd_iq_moments(x, 2 * chunk, s);
+        for (int k = 0; k < 5; k++)
+            m[k] += s[k];
+        x += 2 * chunk;
+        n -= chunk;
+    }
+}
+
+void iq_correct_process(struct iq_correct *c, cf_t *x, size_t n)
+{
+    double m[5] = {0.0, 0.0, 0.0, 0.0, 0.0};
+    add_moments(reinterpret_cast<const float *>(x), n, m);
+    update(c, m, n);
+    simd_iq_affine(reinterpret_cast<float *>(x), n, c->c);
+}
+
+void iq_correct_process_iq16(struct iq_correct *c, const int16_t *in, int16_t *out, size_t n)
+{
+    double m[5] = {0.0, 0.0, 0.0, 0.0, 0.0};
+    float *t = c->tmp.data();
+    for (size_t k0 = 0; k0 < n; k0 += CHUNK) {
+        size_t len = n - k0 < CHUNK ? n - k0 : CHUNK;
+        const int16_t *p = in + 2 * k0;
+        for (size_t k = 0; k < 2 * len; k++)
+            t[k] = (float)p[k];
+        add_moments(t, len, m);
+    }
+    update(c, m, n);
+    simd_iq_affine_i16(in, out, n, c->c);
+}
@@ -0,0 +1,66 @@
+#ifndef IQ_CORRECT_H
+#define IQ_CORRECT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "dsp_types.h"
+
+/*
+ * Адаптивная коррекция DC (утечка LO, холостой TX p_dat = 10 в примерах)
+ * и разбаланса I/Q на RX блоках, на месте, состояние между блоками.
+ *
+ * Оценка - по моментам блока (simd_iq_moments): среднее сглаживается
+ * с постоянной времени dc_tau, ковариация I/Q внутри блока - с iq_tau
+ * (сэмплов; вес блока 1 - exp(-n / tau), не зависит от длины блоков).
+ * Разбаланс снимается ортогонализацией Грама-Шмидта, как для кругового
+ * сигнала (шум, QPSK, OFDM):
+ *
+ *   I' = I - dc_i
+ *   Q' = g * ((Q - dc_q) - p * (I - dc_i)),  p = cov(I,Q) / var I,
+ *   g = sqrt(var I / (var Q - cov(I,Q)^2 / var I))
+ *
+ * Всё вместе - одно аффинное преобразование 2x2 (simd_iq_affine*).
+ * Оценки больше max_gain_db / max_phase_deg (некруговой сигнал, например
+ * чистый тон в одной ветви) не применяются - остаётся последняя годная.
+ *
+ * Объект работает в единицах входа: поток кормится либо cf_t, либо int16.
+ */
+
+struct iq_correct_cfg {
+    bool fix_dc;
+    bool fix_iq;
+    double dc_tau;          // сэмплов
+    double iq_tau;
+    float max_gain_db;
+    float max_phase_deg;
+};
+
+void iq_correct_default_cfg(struct iq_correct_cfg *cfg);
+
+struct iq_correct {
+    struct iq_correct_cfg cfg;
+    bool primed;                // было хоть одно обновление
+    double dc_i, dc_q;          // сглаженное среднее
+    double cii, cqq, ciq;       // сглаженная ковариация
+    double p, g;                // последние годные коэффициенты разбаланса
+    float c[6];                 // текущее преобразование, см. simd_iq_affine
+
+    /* оценка для отчёта: 10 log10(var I / var Q), отклонение от квадратуры */
+    double gain_db, phase_deg;
+    bool iq_valid;
+
+    std::vector<float> tmp;
+};
+
+int iq_correct_init(struct iq_correct *c, const struct iq_correct_cfg *cfg);
+void iq_correct_reset(struct iq_correct *c);
+
+/* Оценить по блоку и исправить его на месте */
+void iq_correct_process(struct iq_correct *c, cf_t *x, size_t n);
+
+/* int16 I/Q с насыщением; in == out допускается */
+void iq_correct_process_iq16(struct iq_correct *c, const int16_t *in, int16_t *out, size_t n);
+
+#endif // IQ_CORRECT_H
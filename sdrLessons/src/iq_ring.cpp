@@ -0,0 +1,130 @@
+#include "iq_ring.h"
+#include "rt_thread.h"
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+
+int iq_ring_init(struct iq_ring *r, size_t slots, size_t slot_samples, int cpu)
+{
+    if (slots < 2 || (slots & (slots - 1)) != 0 || slot_samples == 0)
+        return -EINVAL;
+
+    r->slots = slots;
+    r->slot_samples = slot_samples;
+    r->data_len = slots * slot_samples * 2 * sizeof(int16_t) + slots * sizeof(struct iq_block_info);
+    uint8_t *mem = static_cast<uint8_t *>(rt_alloc_locked(r->data_len, cpu));
+    if (!mem)
+        return -ENOMEM;
+    r->info = reinterpret_cast<struct iq_block_info *>(mem);
+    r->data = reinterpret_cast<int16_t *>(mem + slots * sizeof(struct iq_block_info));
+
+    r->head.store(0);
+    r->tail.store(0);
+    r->overflows.store(0);
+    r->efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (r->efd < 0) {
+        rt_free_locked(mem, r->data_len);
+        return -errno;
+    }
+    return 0;
+}
+
+void iq_ring_destroy(struct iq_ring *r)
+{
+    if (r->info)
+        rt_free_locked(r->info, r->data_len);
+    if (r->efd >= 0)
+        close(r->efd);
+    r->info = NULL;
+    r->data = NULL;
+    r->efd = -1;
+}
+
+int16_t *iq_ring_write_begin(struct iq_ring *r, struct iq_block_info **info)
+{
+    uint64_t head = r->head.load(std::memory_order_relaxed);
+    uint64_t tail = r->tail.load(std::memory_order_acquire);
+    if (head - tail >= r->slots) {
+        r->overflows.fetch_add(1, std::memory_order_relaxed);
+        return NULL;
+    }
+    size_t slot = head & (r->slots - 1);
+    *info = &r->info[slot];
+    return r->data + slot * r->slot_samples * 2;
+}
+
+void iq_ring_write_commit(struct iq_ring *r)
+{
+    r->head.fetch_add(1, std::memory_order_release);
+    uint64_t one = 1;
+    ssize_t ret = write(r->efd, &one, sizeof(one));
+    (void)ret;
+}
+
+int iq_ring_push(struct iq_ring *r, const int16_t *iq, size_t n, long long index, int64_t host_ns,
+                 int64_t sample_ns)
+{
+    struct iq_block_info *info;
+    int16_t *dst = iq_ring_write_begin(r, &info);
+    if (!dst)
+        return -ENOBUFS;
+    if (n > r->slot_samples)
+        n = r->slot_samples;
+    memcpy(dst, iq, n * 2 * sizeof(int16_t));
+    info->index = index;
+    info->n = n;
+    info->flags = 0;
+    info->host_ns = host_ns;
+    info->sample_ns = sample_ns;
+    iq_ring_write_commit(r);
+    return 0;
+}
+
+const int16_t *iq_ring_read_begin(struct iq_ring *r, const struct iq_block_info **info)
+{
+    uint64_t tail = r->tail.load(std::memory_order_relaxed);
+    uint64_t head = r->head.load(std::memory_order_acquire);
+    if (tail == head)
+        return NULL;
+    size_t slot = tail & (r->slots - 1);
+    *info = &r->info[slot];
+    return r->data + slot * r->slot_samples * 2;
+}
+
+void iq_ring_read_release(struct iq_ring *r)
+{
+    r->tail.fetch_add(1, std::memory_order_release);
+}
+
+int iq_ring_wait(struct iq_ring *r, int timeout_ms)
+{
+    for (;;) {
+        if (r->tail.load(std::memory_order_relaxed) != r->head.load(std::memory_order_acquire))
+            return 1;
+        if (rt_shutdown_requested())
+            return 0;
+
+        struct pollfd pfd[2];
+        int nfds = 1;
+        pfd[0].fd = r->efd;
+        pfd[0].events = POLLIN;
+        if (rt_shutdown_fd() >= 0) {
+            pfd[1].fd = rt_shutdown_fd();
+            pfd[1].events = POLLIN;
+            nfds = 2;
+        }
+        int ret = poll(pfd, nfds, timeout_ms);
+        if (ret < 0 && errno != EINTR)
+            return -errno;
+        if (ret == 0)
+            return 0;
+        if (pfd[0].revents & POLLIN) {
+            uint64_t cnt;
+            ssize_t rd = read(r->efd, &cnt, sizeof(cnt));
+            (void)rd;
+        }
+    }
+}
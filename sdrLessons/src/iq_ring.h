@@ -0,0 +1,57 @@
+#ifndef IQ_RING_H
+#define IQ_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <atomic>
+
+/*
+ * Кольцо блоков I/Q (один писатель, один читатель) между RX потоком и DSP.
+ *
+ * Память выделяется одним куском через rt_alloc_locked() на NUMA узле
+ * писателя. Писатель никогда не ждёт: если кольцо заполнено, блок
+ * отбрасывается и увеличивается счётчик overflows.
+ * Читатель может ждать данные через poll() на iq_ring.efd.
+ */
+
+struct iq_block_info {
+    long long index;        // абсолютный номер первого сэмпла блока
+    size_t n;               // сэмплов (пар I/Q) в блоке
+    uint32_t flags;
+    int64_t host_ns;        // CLOCK_MONOTONIC момента получения блока
+    int64_t sample_ns;      // оценка CLOCK_MONOTONIC первого сэмпла (clock_model.h), 0 - нет
+};
+
+struct iq_ring {
+    size_t slots;           // степень двойки
+    size_t slot_samples;    // ёмкость слота в сэмплах
+    int16_t *data;          // slots * slot_samples * 2
+    size_t data_len;
+    struct iq_block_info *info;
+
+    std::atomic<uint64_t> head;     // пишет писатель
+    std::atomic<uint64_t> tail;     // пишет читатель
+    std::atomic<uint64_t> overflows;
+    int efd;                        // eventfd: блок готов
+};
+
+int iq_ring_init(struct iq_ring *r, size_t slots, size_t slot_samples, int cpu);
+void iq_ring_destroy(struct iq_ring *r);
+
+/* Писатель: слот для записи или NULL, если кольцо заполнено (overflow уже учтён) */
+int16_t *iq_ring_write_begin(struct iq_ring *r, struct iq_block_info **info);
+void iq_ring_write_commit(struct iq_ring *r);
+
+/* Писатель: скопировать блок целиком. 0 или -ENOBUFS */
+int iq_ring_push(struct iq_ring *r, const int16_t *iq, size_t n, long long index, int64_t host_ns,
+                 int64_t sample_ns);
+
+/* Читатель: следующий блок или NULL; после обработки iq_ring_read_release() */
+const int16_t *iq_ring_read_begin(struct iq_ring *r, const struct iq_block_info **info);
+void iq_ring_read_release(struct iq_ring *r);
+
+/* Ждать блок или запрос остановки (rt_shutdown_fd). 1 - есть блок, 0 - таймаут/остановка */
+int iq_ring_wait(struct iq_ring *r, int timeout_ms);
+
+#endif // IQ_RING_H
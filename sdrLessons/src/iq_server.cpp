@@ -0,0 +1,806 @@
+#include "iq_server.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/un.h>
+#include <linux/errqueue.h>
+
+#include <algorithm>
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+
+static int64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void iq_server_default_cfg(struct iq_server_cfg *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->tcp_port = 5555;
+    cfg->udp_port = 5556;
+    cfg->unix_path = "/tmp/sdr_iq.sock";
+    cfg->block_samples = 1 << 13;       // как block_size движка
+    cfg->pool_blocks = 256;            // 8 МиБ, хватает ~15 отстающим клиентам
+    cfg->client_queue = 16;
+    cfg->udp_samples = 1024;            // 4 КиБ + заголовок, без фрагментации на loopback
+    cfg->zerocopy_min = 16384;          // меньше - копия дешевле уведомлений
+    cfg->thread.name = "iq-server";
+    cfg->thread.cpu = -1;
+    cfg->thread.priority = 0;
+}
+
+/* ---------- блоки ---------- */
+
+static void block_unref(struct iq_server *srv, struct iq_srv_block *b)
+{
+    if (b->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+    if (b->pooled) {
+        std::lock_guard<std::mutex> lock(srv->pool_lock);
+        srv->pool_free.push_back(b);
+    } else {
+        delete[] b->iq;
+        delete b;
+    }
+}
+
+static struct iq_srv_block *block_new(size_t n)
+{
+    struct iq_srv_block *b = new iq_srv_block;
+    b->refs.store(1);
+    b->pooled = false;
+    b->iq = new int16_t[2 * n];
+    return b;
+}
+
+int iq_server_publish(struct iq_server *srv, const int16_t *iq, size_t n, long long index,
+                      int64_t host_ns)
+{
+    int ret = 0;
+
+    while (n > 0) {
+        size_t chunk = n < srv->cfg.block_samples ? n : srv->cfg.block_samples;
+        struct iq_srv_block *b = NULL;
+        {
+            std::lock_guard<std::mutex> lock(srv->pool_lock);
+            if (!srv->pool_free.empty()) {
+                b = srv->pool_free.back();
+                srv->pool_free.pop_back();
+            }
+        }
+        if (!b) {
+            srv->pool_drops.fetch_add(1, std::memory_order_relaxed);
+            ret = -ENOBUFS;
+        } else {
+            memcpy(b->iq, iq, chunk * 2 * sizeof(int16_t));
+            b->refs.store(1, std::memory_order_relaxed);
+            b->hdr.magic = IQ_NET_MAGIC;
+            b->hdr.n = (uint32_t)chunk;
+            b->hdr.index = index;
+            b->hdr.host_ns = host_ns;
+            b->hdr.decim = 1;
+            b->hdr.reserved = 0;
+
+            // очередь не меньше пула - места хватает всегда
+            uint64_t head = srv->q_head.load(std::memory_order_relaxed);
+            srv->q[head & (srv->q.size() - 1)] = b;
+            srv->q_head.store(head + 1, std::memory_order_release);
+            srv->published.fetch_add(1, std::memory_order_relaxed);
+        }
+        iq += 2 * chunk;
+        index += chunk;
+        n -= chunk;
+    }
+
+    uint64_t one = 1;
+    ssize_t r = write(srv->efd, &one, sizeof(one));
+    (void)r;
+    return ret;
+}
+
+size_t iq_server_clients(const struct iq_server *srv)
+{
+    return srv->subscribed.load(std::memory_order_relaxed);
+}
+
+/* ---------- клиенты ---------- */
+
+static void update_subscribed(struct iq_server *srv)
+{
+    size_t n = 0;
+    for (size_t k = 0; k < srv->clients.size(); k++)
+        n += srv->clients[k]->decim != 0;
+    srv->subscribed.store(n, std::memory_order_relaxed);
+
+    // прореживатели без подписчиков больше не нужны
+    for (size_t k = 0; k < srv->decims.size();) {
+        bool used = false;
+        for (size_t c = 0; c < srv->clients.size(); c++)
+            used |= srv->clients[c]->decim == srv->decims[k].decim;
+        if (used)
+            k++;
+        else
+            srv->decims.erase(srv->decims.begin() + k);
+    }
+}
+
+/*
+ * Отбросить очередь клиента. Начатый блок (sent > 0) остаётся до конца,
+ * иначе поток TCP/Unix потеряет границу заголовка; keep_front == false -
+ * соединение всё равно закрывается. Блоки в полёте (MSG_ZEROCOPY) не
+ * трогаем - их держит ядро до уведомления.
+ */
+static void client_drop_queue(struct iq_server *srv, struct iq_client *c, bool keep_front)
+{
+    size_t keep = keep_front && c->sent > 0 ? 1 : 0;
+    for (size_t k = keep; k < c->queue.size(); k++)
+        block_unref(srv, c->queue[k]);
+    c->queue.resize(keep);
+    if (!keep)
+        c->sent = 0;
+}
+
+static void client_close(struct iq_server *srv, struct iq_client *c)
+{
+    for (size_t k = 0; k < c->inflight.size(); k++) {
+        // уведомления так и не пришли: страницы могут быть у ядра, в пул нельзя
+        if (c->inflight[k].second->pooled)
+            srv->zc_abandoned++;
+    }
+    if (!c->inflight.empty())
+        fprintf(stderr, "iq_server: fd %d closed with %zu zerocopy blocks unconfirmed\n", c->fd,
+                c->inflight.size());
+    close(c->fd);
+    delete c;
+}
+
+static void client_zc_complete(struct iq_server *srv, struct iq_client *c);
+
+static void client_remove(struct iq_server *srv, struct iq_client *c)
+{
+    printf("* iq_server: client fd %d gone, blocks %llu, dropped %llu\n", c->fd,
+           (unsigned long long)c->blocks, (unsigned long long)c->dropped);
+    client_drop_queue(srv, c, false);
+    srv->clients.erase(std::find(srv->clients.begin(), srv->clients.end(), c));
+    update_subscribed(srv);
+    if (c->kind == IQ_CLIENT_UDP) {
+        delete c;
+        return;
+    }
+
+    epoll_ctl(srv->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    client_zc_complete(srv, c);
+    if (c->inflight.empty()) {
+        close(c->fd);
+        delete c;
+        return;
+    }
+    // сокет живёт до уведомлений, опрашивается из цикла сервера
+    shutdown(c->fd, SHUT_RDWR);
+    c->decim = 0;
+    c->last_seen_ns = monotonic_ns();
+    srv->closing.push_back(c);
+}
+
+/* Закрыть отключённых, по которым пришли все уведомления; force - всех */
+static void reap_closing(struct iq_server *srv, bool force)
+{
+    const int64_t now = monotonic_ns();
+    for (size_t k = 0; k < srv->closing.size();) {
+        struct iq_client *c = srv->closing[k];
+        client_zc_complete(srv, c);
+        if (c->inflight.empty() || force || now - c->last_seen_ns > IQ_ZC_LINGER_S * 1000000000LL) {
+            client_close(srv, c);
+            srv->closing.erase(srv->closing.begin() + k);
+        } else {
+            k++;
+        }
+    }
+}
+
+static void subscribe(struct iq_server *srv, struct iq_client *c, unsigned decim)
+{
+    if (decim == 0)
+        decim = 1;
+    if (decim > IQ_MAX_DECIM)
+        decim = IQ_MAX_DECIM;
+    if (c->decim != decim)
+        client_drop_queue(srv, c, true);        // не смешивать потоки в одной очереди
+    c->decim = decim;
+
+    bool found = decim == 1;
+    for (size_t k = 0; k < srv->decims.size() && !found; k++)
+        found = srv->decims[k].decim == decim;
+    if (!found) {
+        struct iq_decimator d = {decim, 0, 0, 0, -1};
+        srv->decims.push_back(d);
+    }
+    update_subscribed(srv);
+}
+
+/* Разобрать "SUB <decim>" / "UNSUB"; false - отписка */
+static bool parse_request(struct iq_server *srv, struct iq_client *c, const char *line)
+{
+    unsigned decim = 1;
+    if (strncmp(line, "UNSUB", 5) == 0) {
+        c->decim = 0;
+        client_drop_queue(srv, c, true);
+        update_subscribed(srv);
+        return false;
+    }
+    if (strncmp(line, "SUB", 3) == 0) {
+        sscanf(line + 3, "%u", &decim);
+        subscribe(srv, c, decim);
+    }
+    return true;
+}
+
+static void client_set_out(struct iq_server *srv, struct iq_client *c, bool on)
+{
+    if (c->kind == IQ_CLIENT_UDP || c->want_out == on)
+        return;
+    struct epoll_event ev;
+    ev.events = EPOLLIN | (on ? (uint32_t)EPOLLOUT : 0u);
+    ev.data.ptr = c;
+    epoll_ctl(srv->epfd, EPOLL_CTL_MOD, c->fd, &ev);
+    c->want_out = on;
+}
+
+/* TCP/Unix: отправить очередь, пока сокет принимает. false - клиент отвалился */
+static bool client_send_stream(struct iq_server *srv, struct iq_client *c)
+{
+    const size_t hdr_len = sizeof(struct iq_net_hdr);
+
+    while (!c->queue.empty()) {
+        struct iq_srv_block *b = c->queue.front();
+        const size_t payload = b->hdr.n * 2 * sizeof(int16_t);
+        const size_t total = hdr_len + payload;
+
+        struct iovec iov[2];
+        int iovcnt = 0;
+        if (c->sent < hdr_len) {
+            iov[iovcnt].iov_base = reinterpret_cast<char *>(&b->hdr) + c->sent;
+            iov[iovcnt++].iov_len = hdr_len - c->sent;
+            iov[iovcnt].iov_base = b->iq;
+            iov[iovcnt++].iov_len = payload;
+        } else {
+            iov[iovcnt].iov_base = reinterpret_cast<char *>(b->iq) + (c->sent - hdr_len);
+            iov[iovcnt++].iov_len = total - c->sent;
+        }
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+
+        bool zc = c->zerocopy && payload >= srv->cfg.zerocopy_min;
+        ssize_t r = sendmsg(c->fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL | (zc ? MSG_ZEROCOPY : 0));
+        if (r < 0 && zc && errno == ENOBUFS) {
+            // кончился optmem под уведомления - этот блок копией
+            zc = false;
+            r = sendmsg(c->fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+        }
+        if (r < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                client_set_out(srv, c, true);
+                return true;
+            }
+            return false;
+        }
+        if (zc) {
+            // страницы блока заняты ядром до уведомления с этим номером
+            b->refs.fetch_add(1, std::memory_order_relaxed);
+            c->inflight.push_back(std::make_pair(c->zc_next++, b));
+        }
+        c->sent += r;
+        if (c->sent == total) {
+            c->queue.pop_front();
+            block_unref(srv, b);
+            c->sent = 0;
+            c->blocks++;
+        }
+    }
+    client_set_out(srv, c, false);
+    return true;
+}
+
+/* Уведомления MSG_ZEROCOPY: диапазоны [lo, hi] номеров sendmsg */
+static void client_zc_complete(struct iq_server *srv, struct iq_client *c)
+{
+    for (;;) {
+        char control[128];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(c->fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+            return;
+
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            const struct sock_extended_err *ee =
+                reinterpret_cast<const struct sock_extended_err *>(CMSG_DATA(cm));
+            if (ee->ee_errno != 0 || ee->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                continue;
+            uint32_t lo = ee->ee_info, hi = ee->ee_data;
+            for (size_t k = 0; k < c->inflight.size();) {
+                uint32_t id = c->inflight[k].first;
+                if (id - lo <= hi - lo) {
+                    block_unref(srv, c->inflight[k].second);
+                    c->inflight.erase(c->inflight.begin() + k);
+                } else {
+                    k++;
+                }
+            }
+        }
+    }
+}
+
+/* UDP: блок нарезается на датаграммы, sent - в сэмплах */
+static void client_send_udp(struct iq_server *srv, struct iq_client *c)
+{
+    while (!c->queue.empty()) {
+        struct iq_srv_block *b = c->queue.front();
+        while (c->sent < b->hdr.n) {
+            size_t chunk = b->hdr.n - c->sent;
+            if (chunk > srv->cfg.udp_samples)
+                chunk = srv->cfg.udp_samples;
+            struct iq_net_hdr hdr = b->hdr;
+            hdr.n = (uint32_t)chunk;
+            hdr.index += (int64_t)c->sent * b->hdr.decim;
+
+            struct iovec iov[2];
+            iov[0].iov_base = &hdr;
+            iov[0].iov_len = sizeof(hdr);
+            iov[1].iov_base = b->iq + 2 * c->sent;
+            iov[1].iov_len = chunk * 2 * sizeof(int16_t);
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_name = &c->addr;
+            msg.msg_namelen = c->addrlen;
+            msg.msg_iov = iov;
+            msg.msg_iovlen = 2;
+            if (sendmsg(c->fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL) < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    return;
+                // ICMP от пропавшего подписчика и т.п. - датаграмма потеряна, идём дальше
+            }
+            c->sent += chunk;
+        }
+        c->queue.pop_front();
+        block_unref(srv, b);
+        c->sent = 0;
+        c->blocks++;
+    }
+}
+
+/* Поставить блок в очереди клиентов с данным decim; переполнена - отбросить */
+static void deliver(struct iq_server *srv, struct iq_srv_block *b, unsigned decim)
+{
+    for (size_t k = 0; k < srv->clients.size(); k++) {
+        struct iq_client *c = srv->clients[k];
+        if (c->decim != decim)
+            continue;
+        // блоки в полёте (MSG_ZEROCOPY) тоже держат память пула
+        if (c->queue.size() + c->inflight.size() >= srv->cfg.client_queue) {
+            c->dropped++;
+            continue;
+        }
+        b->refs.fetch_add(1, std::memory_order_relaxed);
+        c->queue.push_back(b);
+    }
+}
+
+/* Прореживание средним по decim сэмплам; окно продолжается между блоками */
+static void decimate(struct iq_server *srv, struct iq_decimator *d, const struct iq_srv_block *in)
+{
+    const size_t n = in->hdr.n;
+    size_t out_n = (d->count + n) / d->decim;
+    if (out_n == 0) {
+        for (size_t k = 0; k < n; k++) {
+            if (d->count == 0)
+                d->first = in->hdr.index + k;
+            d->acc_i += in->iq[2 * k];
+            d->acc_q += in->iq[2 * k + 1];
+            d->count++;
+        }
+        return;
+    }
+
+    struct iq_srv_block *b = block_new(out_n);
+    size_t m = 0;
+    b->hdr = in->hdr;
+    b->hdr.decim = d->decim;
+    for (size_t k = 0; k < n; k++) {
+        if (d->count == 0)
+            d->first = in->hdr.index + k;
+        d->acc_i += in->iq[2 * k];
+        d->acc_q += in->iq[2 * k + 1];
+        if (++d->count == d->decim) {
+            if (m == 0)
+                b->hdr.index = d->first;
+            b->iq[2 * m] = (int16_t)(d->acc_i / (int32_t)d->decim);
+            b->iq[2 * m + 1] = (int16_t)(d->acc_q / (int32_t)d->decim);
+            m++;
+            d->acc_i = d->acc_q = 0;
+            d->count = 0;
+        }
+    }
+    b->hdr.n = (uint32_t)m;
+    deliver(srv, b, d->decim);
+    block_unref(srv, b);
+}
+
+/* ---------- сокеты ---------- */
+
+static int listen_inet(int type, int port)
+{
+    int fd = socket(AF_INET6, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -errno;
+    int one = 1, zero = 0;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));   // и IPv4 тоже
+
+    struct sockaddr_in6 addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_any;
+    addr.sin6_port = htons(port);
+    if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0 ||
+        (type == SOCK_STREAM && listen(fd, 16) < 0)) {
+        int ret = -errno;
+        close(fd);
+        return ret;
+    }
+    return fd;
+}
+
+static int listen_unix(const char *path)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -errno;
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path);
+    if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        int ret = -errno;
+        close(fd);
+        return ret;
+    }
+    return fd;
+}
+
+static void epoll_add(struct iq_server *srv, int fd, void *tag)
+{
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = tag;
+    epoll_ctl(srv->epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static void accept_clients(struct iq_server *srv, int lfd, enum iq_client_kind kind)
+{
+    for (;;) {
+        int fd = accept4(lfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;
+
+        struct iq_client *c = new iq_client();
+        c->fd = fd;
+        c->kind = kind;
+        c->addrlen = 0;
+        c->decim = 0;
+        c->want_out = false;
+        c->sent = 0;
+        c->zc_next = 0;
+        c->req_len = 0;
+        c->blocks = c->dropped = 0;
+        c->last_seen_ns = monotonic_ns();
+        int one = 1;
+        c->zerocopy = kind == IQ_CLIENT_TCP &&
+                      setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0;
+        srv->clients.push_back(c);
+        epoll_add(srv, fd, c);
+        printf("* iq_server: client fd %d (%s%s)\n", fd, kind == IQ_CLIENT_TCP ? "tcp" : "unix",
+               c->zerocopy ? ", zerocopy" : "");
+    }
+}
+
+/* TCP/Unix: прочитать запросы. false - соединение закрыто */
+static bool client_read(struct iq_server *srv, struct iq_client *c)
+{
+    for (;;) {
+        ssize_t r = recv(c->fd, c->req + c->req_len, sizeof(c->req) - 1 - c->req_len, MSG_DONTWAIT);
+        if (r == 0)
+            return false;
+        if (r < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        c->req_len += r;
+        c->req[c->req_len] = 0;
+
+        char *nl;
+        while ((nl = strchr(c->req, '\n')) != NULL) {
+            *nl = 0;
+            parse_request(srv, c, c->req);
+            size_t used = nl + 1 - c->req;
+            memmove(c->req, nl + 1, c->req_len - used + 1);
+            c->req_len -= used;
+        }
+        if (c->req_len == sizeof(c->req) - 1)
+            c->req_len = 0;     // мусор без перевода строки
+    }
+}
+
+static void udp_read(struct iq_server *srv)
+{
+    for (;;) {
+        char buf[64];
+        struct sockaddr_storage addr;
+        socklen_t addrlen = sizeof(addr);
+        ssize_t r = recvfrom(srv->udp_fd, buf, sizeof(buf) - 1, MSG_DONTWAIT,
+                             reinterpret_cast<struct sockaddr *>(&addr), &addrlen);
+        if (r < 0)
+            return;
+        buf[r] = 0;
+
+        struct iq_client *c = NULL;
+        for (size_t k = 0; k < srv->clients.size() && !c; k++) {
+            struct iq_client *p = srv->clients[k];
+            if (p->kind == IQ_CLIENT_UDP && p->addrlen == addrlen && memcmp(&p->addr, &addr, addrlen) == 0)
+                c = p;
+        }
+        if (!c) {
+            if (strncmp(buf, "SUB", 3) != 0)
+                continue;
+            c = new iq_client();
+            c->fd = srv->udp_fd;
+            c->kind = IQ_CLIENT_UDP;
+            c->addr = addr;
+            c->addrlen = addrlen;
+            c->decim = 0;
+            c->zerocopy = false;
+            c->want_out = false;
+            c->sent = 0;
+            c->zc_next = 0;
+            c->req_len = 0;
+            c->blocks = c->dropped = 0;
+            srv->clients.push_back(c);
+            printf("* iq_server: udp client\n");
+        }
+        c->last_seen_ns = monotonic_ns();
+        if (!parse_request(srv, c, buf))
+            client_remove(srv, c);
+    }
+}
+
+/* ---------- поток сервера ---------- */
+
+static void *server_thread_fn(void *arg)
+{
+    struct iq_server *srv = static_cast<struct iq_server *>(arg);
+    struct epoll_event evs[32];
+    int timeout = 200;
+
+    rt_thread_apply(&srv->cfg.thread);
+
+    while (!srv->stop.load(std::memory_order_relaxed)) {
+        int n = epoll_wait(srv->epfd, evs, 32, timeout);
+        for (int k = 0; k < n; k++) {
+            void *tag = evs[k].data.ptr;
+            if (tag == &srv->efd) {
+                uint64_t v;
+                ssize_t r = read(srv->efd, &v, sizeof(v));
+                (void)r;
+            } else if (tag == &srv->tcp_fd) {
+                accept_clients(srv, srv->tcp_fd, IQ_CLIENT_TCP);
+            } else if (tag == &srv->unix_fd) {
+                accept_clients(srv, srv->unix_fd, IQ_CLIENT_UNIX);
+            } else if (tag == &srv->udp_fd) {
+                udp_read(srv);
+            } else {
+                struct iq_client *c = static_cast<struct iq_client *>(tag);
+                if (evs[k].events & EPOLLERR)
+                    client_zc_complete(srv, c);
+                if ((evs[k].events & (EPOLLIN | EPOLLHUP)) && !client_read(srv, c)) {
+                    client_remove(srv, c);
+                    // дальнейшие события в evs могут ссылаться на удалённого клиента
+                    break;
+                }
+            }
+        }
+
+        /* новые блоки от источника */
+        uint64_t tail = srv->q_tail.load(std::memory_order_relaxed);
+        uint64_t head = srv->q_head.load(std::memory_order_acquire);
+        for (; tail != head; tail++) {
+            struct iq_srv_block *b = srv->q[tail & (srv->q.size() - 1)];
+            deliver(srv, b, 1);
+            for (size_t d = 0; d < srv->decims.size(); d++)
+                decimate(srv, &srv->decims[d], b);
+            block_unref(srv, b);
+        }
+        srv->q_tail.store(tail, std::memory_order_release);
+
+        /* отправка и просроченные UDP подписки */
+        const int64_t now = monotonic_ns();
+        bool udp_pending = false;
+        for (size_t k = 0; k < srv->clients.size();) {
+            struct iq_client *c = srv->clients[k];
+            if (c->kind == IQ_CLIENT_UDP) {
+                if (now - c->last_seen_ns > IQ_UDP_TIMEOUT_S * 1000000000LL) {
+                    client_remove(srv, c);
+                    continue;
+                }
+                client_send_udp(srv, c);
+                udp_pending |= !c->queue.empty();
+            } else if (!c->queue.empty() && !client_send_stream(srv, c)) {
+                client_remove(srv, c);
+                continue;
+            }
+            k++;
+        }
+        reap_closing(srv, false);
+        // UDP без EPOLLOUT: при заполненном буфере сокета переспрашиваем чаще;
+        // закрывающиеся сокеты вне epoll - их уведомления тоже опросом
+        timeout = udp_pending ? 1 : srv->closing.empty() ? 200 : 10;
+    }
+    return NULL;
+}
+
+int iq_server_start(struct iq_server *srv, const struct iq_server_cfg *cfg)
+{
+    if (cfg->pool_blocks < 2 || (cfg->pool_blocks & (cfg->pool_blocks - 1)) != 0 ||
+        cfg->block_samples == 0 || cfg->udp_samples == 0)
+        return -EINVAL;
+
+    srv->cfg = *cfg;
+    srv->tcp_fd = srv->udp_fd = srv->unix_fd = -1;
+    srv->running = false;
+    srv->stop.store(false);
+    srv->published.store(0);
+    srv->pool_drops.store(0);
+    srv->subscribed.store(0);
+    srv->q.assign(cfg->pool_blocks, NULL);
+    srv->q_head.store(0);
+    srv->q_tail.store(0);
+    srv->zc_abandoned = 0;
+
+    // пул зафиксирован в памяти: publish не ловит page fault
+    size_t block_bytes = cfg->block_samples * 2 * sizeof(int16_t);
+    srv->pool_mem = static_cast<int16_t *>(rt_alloc_locked(cfg->pool_blocks * block_bytes, -1));
+    if (!srv->pool_mem)
+        return -ENOMEM;
+    for (size_t k = 0; k < cfg->pool_blocks; k++) {
+        struct iq_srv_block *b = new iq_srv_block;
+        b->refs.store(0);
+        b->pooled = true;
+        b->iq = srv->pool_mem + k * cfg->block_samples * 2;
+        srv->pool_all.push_back(b);
+        srv->pool_free.push_back(b);
+    }
+
+    srv->epfd = epoll_create1(EPOLL_CLOEXEC);
+    srv->efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (srv->epfd < 0 || srv->efd < 0) {
+        int ret = -errno;
+        iq_server_stop(srv);
+        return ret;
+    }
+    epoll_add(srv, srv->efd, &srv->efd);
+
+    if (cfg->tcp_port > 0) {
+        srv->tcp_fd = listen_inet(SOCK_STREAM, cfg->tcp_port);
+        if (srv->tcp_fd < 0) {
+            fprintf(stderr, "Unable to listen on tcp %d: %s\n", cfg->tcp_port, strerror(-srv->tcp_fd));
+            int ret = srv->tcp_fd;
+            iq_server_stop(srv);
+            return ret;
+        }
+        epoll_add(srv, srv->tcp_fd, &srv->tcp_fd);
+    }
+    if (cfg->udp_port > 0) {
+        srv->udp_fd = listen_inet(SOCK_DGRAM, cfg->udp_port);
+        if (srv->udp_fd < 0) {
+            fprintf(stderr, "Unable to bind udp %d: %s\n", cfg->udp_port, strerror(-srv->udp_fd));
+            int ret = srv->udp_fd;
+            iq_server_stop(srv);
+            return ret;
+        }
+        epoll_add(srv, srv->udp_fd, &srv->udp_fd);
+    }
+    if (cfg->unix_path) {
+        srv->unix_fd = listen_unix(cfg->unix_path);
+        if (srv->unix_fd < 0) {
+            fprintf(stderr, "Unable to listen on %s: %s\n", cfg->unix_path, strerror(-srv->unix_fd));
+            int ret = srv->unix_fd;
+            iq_server_stop(srv);
+            return ret;
+        }
+        epoll_add(srv, srv->unix_fd, &srv->unix_fd);
+    }
+
+    int ret = pthread_create(&srv->tid, NULL, server_thread_fn, srv);
+    if (ret) {
+        iq_server_stop(srv);
+        return -ret;
+    }
+    srv->running = true;
+    printf("* iq_server: tcp %d, udp %d, unix %s\n", cfg->tcp_port, cfg->udp_port,
+           cfg->unix_path ? cfg->unix_path : "-");
+    return 0;
+}
+
+void iq_server_stop(struct iq_server *srv)
+{
+    srv->stop.store(true);
+    if (srv->running) {
+        uint64_t one = 1;
+        ssize_t r = write(srv->efd, &one, sizeof(one));
+        (void)r;
+        pthread_join(srv->tid, NULL);
+        srv->running = false;
+    }
+
+    while (!srv->clients.empty())
+        client_remove(srv, srv->clients.back());
+    // уведомления MSG_ZEROCOPY: пул нельзя освобождать, пока ядро читает блоки
+    for (int k = 0; k < IQ_ZC_LINGER_S * 100 && !srv->closing.empty(); k++) {
+        reap_closing(srv, false);
+        if (!srv->closing.empty())
+            usleep(10000);
+    }
+    reap_closing(srv, true);
+    uint64_t tail = srv->q_tail.load(), head = srv->q_head.load();
+    for (; tail != head; tail++)
+        block_unref(srv, srv->q[tail & (srv->q.size() - 1)]);
+    srv->q_tail.store(tail);
+
+    if (srv->tcp_fd >= 0)
+        close(srv->tcp_fd);
+    if (srv->udp_fd >= 0)
+        close(srv->udp_fd);
+    if (srv->unix_fd >= 0) {
+        close(srv->unix_fd);
+        unlink(srv->cfg.unix_path);
+    }
+    if (srv->epfd >= 0)
+        close(srv->epfd);
+    if (srv->efd >= 0)
+        close(srv->efd);
+    srv->tcp_fd = srv->udp_fd = srv->unix_fd = srv->epfd = srv->efd = -1;
+
+    for (size_t k = 0; k < srv->pool_all.size(); k++)
+        delete srv->pool_all[k];
+    srv->pool_all.clear();
+    srv->pool_free.clear();
+    if (srv->pool_mem && srv->zc_abandoned == 0)
+        rt_free_locked(srv->pool_mem, srv->cfg.pool_blocks * srv->cfg.block_samples * 2 * sizeof(int16_t));
+    else if (srv->pool_mem)
+        fprintf(stderr, "iq_server: %zu blocks still owned by the kernel, pool memory left mapped\n",
+                srv->zc_abandoned);
+    srv->pool_mem = NULL;
+
+    printf("* iq_server: published %llu blocks, pool drops %llu\n",
+           (unsigned long long)srv->published.load(), (unsigned long long)srv->pool_drops.load());
+}
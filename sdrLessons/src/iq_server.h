@@ -0,0 +1,148 @@
+#ifndef IQ_SERVER_H
+#define IQ_SERVER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "rt_thread.h"
+
+/*
+ * Раздача RX блоков по сети: TCP, UDP и Unix сокеты, много подписчиков.
+ *
+ * Источник (поток DSP, читающий iq_ring) зовёт iq_server_publish(): блок
+ * копируется в пул один раз и передаётся потоку сервера. Источник никогда
+ * не ждёт - нет свободного блока в пуле, блок отбрасывается.
+ *
+ * Поток сервера (epoll) раздаёт блоки клиентам по счётчику ссылок, без
+ * копий: TCP - sendmsg(MSG_ZEROCOPY), блок освобождается по уведомлению из
+ * MSG_ERRQUEUE. У каждого клиента своя очередь на client_queue блоков
+ * (вместе с ещё не подтверждёнными ядром);
+ * медленный клиент теряет новые блоки (пропуск виден по index), остальные
+ * и радио от него не зависят. Отключившийся клиент с неподтверждёнными
+ * блоками держит сокет до уведомлений (не дольше IQ_ZC_LINGER_S, потом
+ * блоки брошены, а не возвращены в пул).
+ *
+ * Протокол: клиент шлёт строку "SUB <decim>\n" (UDP - датаграмму "SUB <decim>",
+ * повторять не реже раза в IQ_UDP_TIMEOUT_S секунд; "UNSUB" - отписка).
+ * decim > 1 - прореженный поток (среднее по decim сэмплам), считается один
+ * раз на каждое значение decim, не больше IQ_MAX_DECIM. Смена decim
+ * отбрасывает очередь, кроме начатого блока. Дальше сервер шлёт блоки: iq_net_hdr и n
+ * пар int16 I/Q. По UDP блок режется на датаграммы по udp_samples сэмплов.
+ */
+
+#define IQ_NET_MAGIC        0x42535149u     // "IQSB"
+#define IQ_UDP_TIMEOUT_S    10
+#define IQ_ZC_LINGER_S      5
+#define IQ_MAX_DECIM        65536           // |сумма окна| <= 32768 * decim влезает в int32
+
+struct iq_net_hdr {
+    uint32_t magic;
+    uint32_t n;             // пар I/Q за заголовком
+    int64_t index;          // номер первого сэмпла во входном потоке (до прореживания)
+    int64_t host_ns;        // CLOCK_MONOTONIC блока
+    uint32_t decim;
+    uint32_t reserved;
+};
+
+struct iq_srv_block {
+    std::atomic<int> refs;
+    bool pooled;
+    struct iq_net_hdr hdr;
+    int16_t *iq;
+};
+
+enum iq_client_kind {
+    IQ_CLIENT_TCP,
+    IQ_CLIENT_UNIX,
+    IQ_CLIENT_UDP,
+};
+
+struct iq_client {
+    int fd;                 // UDP: общий сокет сервера
+    enum iq_client_kind kind;
+    struct sockaddr_storage addr;
+    socklen_t addrlen;
+    unsigned decim;         // 0 - ещё не подписан
+    bool zerocopy;
+    bool want_out;          // EPOLLOUT включён
+
+    std::deque<struct iq_srv_block *> queue;
+    size_t sent;            // отправлено байт (UDP - сэмплов) из queue.front()
+    std::deque<std::pair<uint32_t, struct iq_srv_block *> > inflight;  // MSG_ZEROCOPY
+    uint32_t zc_next;
+
+    char req[64];
+    size_t req_len;
+    int64_t last_seen_ns;
+
+    uint64_t blocks, dropped;
+};
+
+struct iq_decimator {
+    unsigned decim;
+    int32_t acc_i, acc_q;
+    unsigned count;
+    long long first;        // index первого сэмпла текущего окна
+};
+
+struct iq_server_cfg {
+    int tcp_port;               // 0 - не слушать
+    int udp_port;
+    const char *unix_path;      // NULL - не слушать
+    size_t block_samples;       // ёмкость блока пула
+    size_t pool_blocks;         // степень двойки
+    size_t client_queue;        // блоков в очереди клиента до отбрасывания
+    size_t udp_samples;         // сэмплов в датаграмме
+    size_t zerocopy_min;        // MSG_ZEROCOPY только для блоков от стольких байт
+    struct rt_thread_cfg thread;
+};
+
+void iq_server_default_cfg(struct iq_server_cfg *cfg);
+
+struct iq_server {
+    struct iq_server_cfg cfg;
+    int tcp_fd, udp_fd, unix_fd;
+    int epfd, efd;
+
+    std::mutex pool_lock;
+    std::vector<struct iq_srv_block *> pool_free;
+    std::vector<struct iq_srv_block *> pool_all;
+    int16_t *pool_mem;
+
+    // источник -> поток сервера (один писатель, один читатель)
+    std::vector<struct iq_srv_block *> q;
+    std::atomic<uint64_t> q_head, q_tail;
+
+    std::vector<struct iq_client *> clients;
+    std::vector<struct iq_client *> closing;    // отключены, ждут уведомлений MSG_ZEROCOPY
+    size_t zc_abandoned;                        // брошено блоков без уведомления
+    std::vector<struct iq_decimator> decims;
+
+    pthread_t tid;
+    bool running;
+    std::atomic<bool> stop;
+
+    std::atomic<uint64_t> published;
+    std::atomic<uint64_t> pool_drops;
+    std::atomic<size_t> subscribed;
+};
+
+int iq_server_start(struct iq_server *srv, const struct iq_server_cfg *cfg);
+void iq_server_stop(struct iq_server *srv);
+
+/* Опубликовать n сэмплов (interleaved I/Q). 0 или -ENOBUFS (блок отброшен) */
+int iq_server_publish(struct iq_server *srv, const int16_t *iq, size_t n, long long index,
+                      int64_t host_ns);
+
+/* Число подписанных клиентов */
+size_t iq_server_clients(const struct iq_server *srv);
+
+#endif // IQ_SERVER_H
@@ -0,0 +1,400 @@
+#include "ofdm.h"
+
+#include <math.h>
+#include <errno.h>
+
+#include "sequences.h"
+
+#define PLATEAU     0.9f        // доля максимума метрики на плато
+#define COH_MIN     0.3f        // связность канала преамбулы ниже - ложное срабатывание
+#define H_ALPHA     0.5f        // вес новой оценки по пилотам
+#define R_MIN       1e-9        // тишина: метрика не считается
+
+void ofdm_default_cfg(struct ofdm_cfg *cfg, unsigned nfft)
+{
+    cfg->nfft = nfft;
+    cfg->ncp = nfft / 8;
+    cfg->n_used = nfft * 13 / 16 & ~1u;     // края полосы - под спад фильтров AD9361
+    cfg->pilot_step = 8;                    // пилоты через 8: задержки до nfft / 8 = ncp
+    cfg->mod = DEMAP_QPSK;
+    cfg->n_syms = 16;
+    cfg->sc_threshold = 0.4f;       // ~3 дБ ОСШ; ложные срабатывания отсекает связность канала
+}
+
+static inline size_t bin(const struct ofdm *o, int k)
+{
+    return (size_t)((k + (int)o->cfg.nfft) % (int)o->cfg.nfft);
+}
+
+int ofdm_init(struct ofdm *o, const struct ofdm_cfg *cfg)
+{
+    if (cfg->nfft < 16 || cfg->ncp >= cfg->nfft || cfg->n_used < 4 || (cfg->n_used & 1) ||
+        cfg->n_used >= cfg->nfft || cfg->pilot_step < 2 || cfg->n_syms == 0)
+        return -EINVAL;
+    if (fft_plan_init(&o->fwd, cfg->nfft, false) < 0 || fft_plan_init(&o->inv, cfg->nfft, true) < 0)
+        return -EINVAL;
+    if (demapper_init(&o->dm, cfg->mod) < 0)
+        return -EINVAL;
+    o->cfg = *cfg;
+
+    const int half = (int)cfg->n_used / 2;
+    o->used.clear();
+    for (int k = -half; k <= half; k++)
+        if (k != 0)
+            o->used.push_back(k);
+    o->data_idx.clear();
+    o->pilot_idx.clear();
+    for (unsigned j = 0; j < cfg->n_used; j++) {
+        if (j % cfg->pilot_step == 0 || j + 1 == cfg->n_used)
+            o->pilot_idx.push_back(j);
+        else
+            o->data_idx.push_back(j);
+    }
+
+    std::vector<uint8_t> pn;
+    max_len_seq(13, pn);
+    o->pre_val.assign(cfg->n_used, cf_t(0.0f, 0.0f));
+    size_t p = 0;
+    for (unsigned j = 0; j < cfg->n_used; j++) {
+        if (o->used[j] & 1)
+            continue;
+        // половина поднесущих с удвоенной мощностью - мощность символа как у данных
+        o->pre_val[j] = cf_t(pn[p] ? 1.0f : -1.0f, pn[p + 1] ? 1.0f : -1.0f);
+        p = (p + 2) % (pn.size() - 1);
+    }
+    const size_t np = o->pilot_idx.size() * cfg->n_syms;
+    o->pilot_pn.resize(np);
+    for (size_t k = 0; k < np; k++)
+        o->pilot_pn[k] = pn[(k + 4096) % pn.size()] ? 1.0f : -1.0f;
+
+    o->sym_len = cfg->nfft + cfg->ncp;
+    o->frame_len = (cfg->n_syms + 1) * o->sym_len;
+    o->bits_per_frame = (size_t)cfg->n_syms * o->data_idx.size() * o->dm.bps;
+    o->fbuf.resize((size_t)(cfg->n_syms + 1) * cfg->nfft);
+    o->h.resize(cfg->n_used);
+    o->hp.resize(cfg->n_used);
+    o->frames = 0;
+    o->misses = 0;
+    ofdm_rx_reset(o, 0);
+    return 0;
+}
+
+void ofdm_rx_reset(struct ofdm *o, long long start)
+{
+    o->buf.clear();
+    o->buf_start = start;
+    o->scan = 0;
+    o->pr_valid = false;
+    o->m_win.clear();
+    o->p_win.clear();
+    o->locked = false;
+}
+
+void ofdm_modulate(struct ofdm *o, const uint8_t *bits, std::vector<cf_t> &out)
+{
+    const unsigned nfft = o->cfg.nfft, ncp = o->cfg.ncp;
+    const size_t nsym = o->cfg.n_syms + 1;
+    const size_t nd = o->data_idx.size(), npil = o->pilot_idx.size();
+    cf_t *f = o->fbuf.data();
+
+    for (size_t k = 0; k < nsym * nfft; k++)
+        f[k] = cf_t(0.0f, 0.0f);
+    for (unsigned j = 0; j < o->cfg.n_used; j++)
+        f[bin(o, o->used[j])] = o->pre_val[j];
+
+    std::vector<cf_t> pts(nd);
+    for (size_t s = 1; s < nsym; s++) {
+        cf_t *fs = f + s * nfft;
+        demapper_map(&o->dm, bits + (s - 1) * nd * o->dm.bps, nd * o->dm.bps, pts.data());
+        for (size_t k = 0; k < nd; k++)
+            fs[bin(o, o->used[o->data_idx[k]])] = pts[k];
+        for (size_t k = 0; k < npil; k++)
+            fs[bin(o, o->used[o->pilot_idx[k]])] = o->pilot_pn[(s - 1) * npil + k];
+    }
+    fft_execute_batch(&o->inv, f, f, nsym);
+
+    const float scale = 1.0f / sqrtf((float)o->cfg.n_used);
+    for (size_t s = 0; s < nsym; s++) {
+        const cf_t *t = f + s * nfft;
+        for (unsigned k = nfft - ncp; k < nfft; k++)
+            out.push_back(t[k] * scale);
+        for (unsigned k = 0; k < nfft; k++)
+            out.push_back(t[k] * scale);
+    }
+}
+
+/*
+ * Канал на всех used по оценкам hk на поднесущих idx[0..m): наклон фазы
+ * phi (рад на поднесущую) снимается, линейная интерполяция по частоте,
+ * за крайними - константа, затем наклон возвращается.
+ */
+static void interp_channel(const struct ofdm *o, const unsigned *idx, const cf_t *hk, size_t m,
+                           float phi, cf_t *h)
+{
+    size_t seg = 0;
+    for (unsigned j = 0; j < o->cfg.n_used; j++) {
+        const int k = o->used[j];
+        while (seg + 1 < m && o->used[idx[seg + 1]] <= k)
+            seg++;
+        const int k0 = o->used[idx[seg]];
+        cf_t g0 = hk[seg] * std::polar(1.0f, -phi * k0);
+        cf_t g;
+        if (k <= k0 || seg + 1 >= m) {
+            g = g0;
+        } else {
+            const int k1 = o->used[idx[seg + 1]];
+            cf_t g1 = hk[seg + 1] * std::polar(1.0f, -phi * k1);
+            float a = (float)(k - k0) / (float)(k1 - k0);
+            g = g0 * (1.0f - a) + g1 * a;
+        }
+        h[j] = g * std::polar(1.0f, phi * k);
+    }
+}
+
+/*
+ * Кадр с окном БПФ преамбулы в buf[w0], сдвиг частоты omega рад/сэмпл.
+ * Возвращает связность оценок канала соседних поднесущих преамбулы
+ * |sum h[k+2] h*[k]| / sum |h[k+2]| |h[k]|: ~1 для настоящей преамбулы,
+ * ~1/sqrt(n_used) для шума.
+ */
+static float demod_frame(struct ofdm *o, size_t w0, float omega, struct ofdm_frame *fr)
+{
+    const unsigned nfft = o->cfg.nfft;
+    const size_t nsym = o->cfg.n_syms + 1;
+    const size_t nd = o->data_idx.size(), npil = o->pilot_idx.size();
+    cf_t *f = o->fbuf.data();
+
+    // снять CFO: фаза от начала окна преамбулы, опора пересчитывается на каждый символ
+    for (size_t s = 0; s < nsym; s++) {
+        const cf_t *x = &o->buf[w0 + s * o->sym_len];
+        cf_t rot = std::polar(1.0f, -omega * (float)(s * o->sym_len));
+        const cf_t step = std::polar(1.0f, -omega);
+        for (unsigned k = 0; k < nfft; k++) {
+            f[s * nfft + k] = x[k] * rot;
+            rot *= step;
+        }
+    }
+    fft_execute_batch(&o->fwd, f, f, nsym);
+
+    /* преамбула: чётные поднесущие */
+    std::vector<unsigned> even;
+    std::vector<cf_t> hk;
+    for (unsigned j = 0; j < o->cfg.n_used; j++) {
+        if (o->used[j] & 1)
+            continue;
+        even.push_back(j);
+        hk.push_back(f[bin(o, o->used[j])] / o->pre_val[j]);
+    }
+    // наклон фазы по соседним чётным (шаг 2 поднесущие) - сдвиг окна внутри CP
+    cf_t acc(0.0f, 0.0f);
+    float mag = 0.0f;
+    for (size_t k = 1; k < even.size(); k++) {
+        if (o->used[even[k]] - o->used[even[k - 1]] == 2) {
+            acc += hk[k] * std::conj(hk[k - 1]);
+            mag += std::abs(hk[k]) * std::abs(hk[k - 1]);
+        }
+    }
+    const float coh = mag > 0.0f ? std::abs(acc) / mag : 0.0f;
+    if (coh < COH_MIN)
+        return coh;
+    const float phi = std::arg(acc) / 2.0f;
+    interp_channel(o, even.data(), hk.data(), even.size(), phi, o->h.data());
+
+    fr->syms.resize(o->cfg.n_syms * nd);
+    fr->csi.resize(o->cfg.n_syms * nd);
+    hk.resize(npil);
+    double csi_sum = 0.0;
+    for (size_t s = 1; s < nsym; s++) {
+        const cf_t *fs = f + s * nfft;
+        // пилоты: общий поворот фазы, затем новая оценка
+        cf_t cpe(0.0f, 0.0f);
+        for (size_t k = 0; k < npil; k++) {
+            hk[k] = fs[bin(o, o->used[o->pilot_idx[k]])] * o->pilot_pn[(s - 1) * npil + k];
+            cpe += hk[k] * std::conj(o->h[o->pilot_idx[k]]);
+        }
+        float a = std::abs(cpe);
+        if (a > 0.0f)
+            cpe /= a;
+        else
+            cpe = cf_t(1.0f, 0.0f);
+        interp_channel(o, o->pilot_idx.data(), hk.data(), npil, phi, o->hp.data());
+        for (unsigned j = 0; j < o->cfg.n_used; j++)
+            o->h[j] = o->h[j] * cpe * (1.0f - H_ALPHA) + o->hp[j] * H_ALPHA;
+
+        cf_t *out = &fr->syms[(s - 1) * nd];
+        float *csi = &fr->csi[(s - 1) * nd];
+        for (size_t k = 0; k < nd; k++) {
+            const unsigned j = o->data_idx[k];
+            float p = std::norm(o->h[j]);
+            out[k] = p > 0.0f ? fs[bin(o, o->used[j])] * std::conj(o->h[j]) / p : cf_t(0.0f, 0.0f);
+            csi[k] = p;
+            csi_sum += p;
+        }
+    }
+    if (csi_sum > 0.0) {
+        float norm = (float)(fr->csi.size() / csi_sum);
+        for (size_t k = 0; k < fr->csi.size(); k++)
+            fr->csi[k] *= norm;
+    }
+    fr->evm = demapper_estimate(&o->dm, fr->syms.data(), fr->syms.size());
+    return coh;
+}
+
+/* Начало окна и CFO по плато метрики в m_win/p_win */
+static void lock_frame(struct ofdm *o)
+{
+    const size_t W = o->m_win.size();
+    size_t best = 0;
+    for (size_t k = 1; k < W; k++)
+        if (o->m_win[k] > o->m_win[best])
+            best = k;
+    size_t first = best, last = best;
+    const float lvl = PLATEAU * o->m_win[best];
+    while (first > 0 && o->m_win[first - 1] >= lvl)
+        first--;
+    while (last + 1 < W && o->m_win[last + 1] >= lvl)
+        last++;
+
+    // середина плато ~ середина CP, окно БПФ - на ncp/4 раньше конца CP
+    const size_t mid = (first + last) / 2;
+    const size_t L = o->cfg.nfft / 2;
+    o->lock_pos = o->buf_start + (long long)(o->win_start + mid + o->cfg.ncp / 4);
+    o->lock_cfo = std::arg(o->p_win[mid]) / (float)L;
+    o->locked = true;
+}
+
+size_t ofdm_rx_process(struct ofdm *o, const cf_t *x, size_t n, std::vector<struct ofdm_frame> &frames)
+{
+    const size_t L = o->cfg.nfft / 2;
+    const size_t W = o->sym_len;
+    size_t produced = 0;
+
+    o->buf.insert(o->buf.end(), x, x + n);
+    const cf_t *r = o->buf.data();
+    const size_t size = o->buf.size();
+
+    for (;;) {
+        if (o->locked) {
+            const size_t w0 = (size_t)(o->lock_pos - o->buf_start);
+            const size_t end = w0 + o->cfg.n_syms * o->sym_len + o->cfg.nfft;
+            if (end > size)
+                break;
+            struct ofdm_frame fr;
+            float coh = demod_frame(o, w0, o->lock_cfo, &fr);
+            o->locked = false;
+            o->m_win.clear();
+            o->p_win.clear();
+            o->pr_valid = false;
+            if (coh < COH_MIN) {
+                // ложное срабатывание: искать дальше с конца окна метрики
+                o->misses++;
+                o->scan = o->win_start + W;
+                continue;
+            }
+            fr.pos = o->lock_pos - o->cfg.ncp;
+            fr.cfo = o->lock_cfo * L / (float)M_PI;
+            frames.push_back(std::move(fr));
+            o->frames++;
+            produced++;
+            o->scan = end;
+            continue;
+        }
+
+        /* поиск: нужен ещё один сэмпл для сдвига сумм на scan + 1 */
+        if (o->scan + 2 * L + 1 > size)
+            break;
+        if (!o->pr_valid) {
+            double pr = 0.0, pi = 0.0, rs = 0.0;
+            for (size_t m = 0; m < L; m++) {
+                cf_t a = r[o->scan + m], b = r[o->scan + m + L];
+                pr += a.real() * b.real() + a.imag() * b.imag();
+                pi += a.real() * b.imag() - a.imag() * b.real();
+                rs += std::norm(b);
+            }
+            o->p_re = pr;
+            o->p_im = pi;
+            o->r_sum = rs;
+            o->pr_valid = true;
+        }
+        while (o->scan + 2 * L + 1 <= size) {
+            const size_t d = o->scan;
+            float m = 0.0f;
+            if (o->r_sum > R_MIN * L)
+                m = (float)((o->p_re * o->p_re + o->p_im * o->p_im) / (o->r_sum * o->r_sum));
+            if (!o->m_win.empty() || m > o->cfg.sc_threshold) {
+                if (o->m_win.empty())
+                    o->win_start = d;
+                o->m_win.push_back(m);
+                o->p_win.push_back(cf_t((float)o->p_re, (float)o->p_im));
+            }
+
+            // P(d + 1) = P(d) + conj(r[d + L]) r[d + 2L] - conj(r[d]) r[d + L]
+            cf_t a = r[d], b = r[d + L], c = r[d + 2 * L];
+            o->p_re += (b.real() * c.real() + b.imag() * c.imag()) - (a.real() * b.real() + a.imag() * b.imag());
+            o->p_im += (b.real() * c.imag() - b.imag() * c.real()) - (a.real() * b.imag() - a.imag() * b.real());
+            o->r_sum += std::norm(c) - std::norm(b);
+            o->scan++;
+            // скользящие суммы периодически пересчитываются заново
+            if ((o->scan & 0xffff) == 0)
+                o->pr_valid = false;
+
+            if (o->m_win.size() == W) {
+                lock_frame(o);
+                break;
+            }
+            if (!o->pr_valid)
+                break;
+        }
+    }
+
+    /* выбросить обработанное, держать всё, что ещё нужно поиску и кадру */
+    size_t keep = o->scan;
+    if (!o->m_win.empty() && o->win_start < keep)
+        keep = o->win_start;
+    if (o->locked && (size_t)(o->lock_pos - o->buf_start) < keep)
+        keep = (size_t)(o->lock_pos - o->buf_start);
+    if (keep >= 4 * o->frame_len) {
+        o->buf.erase(o->buf.begin(), o->buf.begin() + keep);
+        o->buf_start += (long long)keep;
+        o->scan -= keep;
+        o->win_start -= o->m_win.empty() ? 0 : keep;
+    }
+    return produced;
+}
+
+size_t ofdm_rx_process_iq16(struct ofdm *o, const int16_t *iq, size_t n,
+                            std::vector<struct ofdm_frame> &frames)
+{
+    cf_t tmp[1024];
+    size_t produced = 0;
+
+    while (n > 0) {
+        size_t chunk = n < 1024 ? n : 1024;
+        for (size_t k = 0; k < chunk; k++)
+            tmp[k] = cf_t(iq[2 * k] / 2048.0f, iq[2 * k + 1] / 2048.0f);
+        produced += ofdm_rx_process(o, tmp, chunk, frames);
+        iq += 2 * chunk;
+        n -= chunk;
+    }
+    return produced;
+}
+
+void ofdm_frame_llr(struct ofdm *o, const struct ofdm_frame *f, int8_t *llr)
+{
+    const size_t n = f->syms.size();
+    const unsigned bps = o->dm.bps;
+    demapper_estimate(&o->dm, f->syms.data(), n);
+    demap_soft(&o->dm, f->syms.data(), n, llr);
+    // шум после эквалайзера на поднесущей - N0 / |H|^2
+    for (size_t k = 0; k < n; k++) {
+        for (unsigned b = 0; b < bps; b++) {
+            float v = llr[k * bps + b] * f->csi[k];
+            llr[k * bps + b] = (int8_t)(v > 127.0f ? 127 : (v < -127.0f ? -127 : lrintf(v)));
+        }
+    }
+}
+
+void ofdm_frame_bits(struct ofdm *o, const struct ofdm_frame *f, uint8_t *bits)
+{
+    demap_hard(&o->dm, f->syms.data(), f->syms.size(), bits);
+}
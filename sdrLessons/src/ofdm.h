@@ -0,0 +1,115 @@
+#ifndef OFDM_H
+#define OFDM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "dsp_types.h"
+#include "fft.h"
+#include "demapper.h"
+
+/*
+ * OFDM PHY поверх блочного RX/TX (sdr_stream, tx_waveform): вся полоса
+ * занята поднесущими вместо одной несущей QPSK 1 Мсим/с из 1.py.
+ *
+ * Кадр: преамбула Шмидла-Кокса (известные QPSK только на чётных
+ * поднесущих - две одинаковые половины во времени) + n_syms символов
+ * данных, у каждого символа циклический префикс ncp. Заняты n_used
+ * поднесущих вокруг DC (сама DC пустая), каждая pilot_step-я из них и
+ * последняя - пилоты BPSK.
+ *
+ * Приём:
+ *  - метрика Шмидла-Кокса M(d) = |P(d)|^2 / R(d)^2 скользящими суммами,
+ *    по плато M >= 0.9 max - начало символа, по arg P - дробный сдвиг
+ *    частоты (+-1 поднесущая, целый сдвиг не ищется); ложные срабатывания
+ *    отсекаются по связности оценок канала соседних поднесущих преамбулы;
+ *  - окна БПФ всех символов кадра - одним пакетным БПФ;
+ *  - канал по преамбуле, дальше по пилотам каждого символа: общий
+ *    фазовый сдвиг (остаток CFO) + линейная интерполяция по частоте с
+ *    компенсацией наклона фазы (задержки окна).
+ *
+ * Состояние приёмника переносится между блоками: кадр может начинаться
+ * в одном блоке и заканчиваться в следующих.
+ */
+
+struct ofdm_cfg {
+    unsigned nfft;          // степень двойки
+    unsigned ncp;           // циклический префикс, сэмплов
+    unsigned n_used;        // занятых поднесущих, чётное, < nfft
+    unsigned pilot_step;
+    int mod;                // данные, enum demap_mod
+    unsigned n_syms;        // символов данных в кадре
+    float sc_threshold;     // порог метрики Шмидла-Кокса (0..1)
+};
+
+void ofdm_default_cfg(struct ofdm_cfg *cfg, unsigned nfft);
+
+struct ofdm_frame {
+    long long pos;          // абсолютный индекс начала кадра (CP преамбулы)
+    float cfo;              // сдвиг частоты, доли поднесущей
+    float evm;              // по решениям, доля
+    std::vector<cf_t> syms; // n_syms * n_data после эквализации, по символам
+    std::vector<float> csi; // |H|^2 для каждого из syms, среднее 1
+};
+
+struct ofdm {
+    struct ofdm_cfg cfg;
+    struct fft_plan fwd, inv;
+    struct demapper dm;
+
+    std::vector<int> used;          // поднесущие со знаком (-n_used/2 .. n_used/2, без 0)
+    std::vector<unsigned> data_idx; // номера в used
+    std::vector<unsigned> pilot_idx;
+    std::vector<cf_t> pre_val;      // преамбула на used (0 на нечётных)
+    std::vector<float> pilot_pn;    // +-1, по символу и пилоту подряд
+    size_t sym_len;                 // nfft + ncp
+    size_t frame_len;
+    size_t bits_per_frame;
+
+    /* приёмник */
+    std::vector<cf_t> buf;
+    long long buf_start;            // абсолютный индекс buf[0]
+    size_t scan;                    // следующая позиция метрики в buf
+    bool pr_valid;
+    double p_re, p_im, r_sum;       // P(scan), R(scan)
+    std::vector<float> m_win;       // метрика и P после пересечения порога
+    std::vector<cf_t> p_win;
+    size_t win_start;
+    bool locked;                    // кадр найден, ждём его конца в buf
+    long long lock_pos;             // абсолютный индекс окна БПФ преамбулы
+    float lock_cfo;                 // рад/сэмпл
+    long long frames, misses;       // принято / ложных срабатываний
+
+    std::vector<cf_t> fbuf;         // окна БПФ кадра
+    std::vector<cf_t> h, hp;        // канал на used, оценка по пилотам
+};
+
+int ofdm_init(struct ofdm *o, const struct ofdm_cfg *cfg);
+
+/* Сбросить приёмник (поток с абсолютного индекса start) */
+void ofdm_rx_reset(struct ofdm *o, long long start);
+
+/*
+ * Кадр из bits_per_frame бит 0/1: frame_len сэмплов добавляются в out,
+ * средняя мощность 1. Для TX: tx_waveform_from_symbols(..., sps = 1, ...).
+ */
+void ofdm_modulate(struct ofdm *o, const uint8_t *bits, std::vector<cf_t> &out);
+
+/* Обработать n сэмплов, найденные кадры добавляются в frames. Возвращает их число */
+size_t ofdm_rx_process(struct ofdm *o, const cf_t *x, size_t n, std::vector<struct ofdm_frame> &frames);
+
+/* Вариант для int16 I/Q блоков RX */
+size_t ofdm_rx_process_iq16(struct ofdm *o, const int16_t *iq, size_t n,
+                            std::vector<struct ofdm_frame> &frames);
+
+/*
+ * Мягкие решения кадра для fec_viterbi_decode: LLR демаппера (шум - по EVM
+ * кадра), взвешенные |H|^2 поднесущей. llr - bits_per_frame значений.
+ */
+void ofdm_frame_llr(struct ofdm *o, const struct ofdm_frame *f, int8_t *llr);
+
+/* Жёсткие решения кадра, bits_per_frame бит */
+void ofdm_frame_bits(struct ofdm *o, const struct ofdm_frame *f, uint8_t *bits);
+
+#endif // OFDM_H
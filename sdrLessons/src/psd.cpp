@@ -0,0 +1,134 @@
+#include "psd.h"
+
+#include <math.h>
+#include <errno.h>
+
+#include <algorithm>
+
+void psd_default_cfg(struct psd_cfg *cfg)
+{
+    cfg->nfft = 1024;
+    cfg->overlap = 512;
+    cfg->window = PSD_WIN_BLACKMAN_HARRIS;
+    cfg->batch = 16;
+}
+
+int psd_init(struct psd *p, const struct psd_cfg *cfg)
+{
+    if (cfg->nfft < 8 || (cfg->nfft & (cfg->nfft - 1)) || cfg->overlap >= cfg->nfft || cfg->batch == 0)
+        return -EINVAL;
+    p->cfg = *cfg;
+    int ret = fft_plan_init(&p->plan, cfg->nfft, false);
+    if (ret < 0)
+        return ret;
+
+    const size_t n = cfg->nfft;
+    p->win.resize(n);
+    double sum = 0.0;
+    for (size_t k = 0; k < n; k++) {
+        double t = 2.0 * M_PI * k / n;     // периодическое окно
+        double w;
+        if (cfg->window == PSD_WIN_HANN)
+            w = 0.5 - 0.5 * cos(t);
+        else
+            w = 0.35875 - 0.48829 * cos(t) + 0.14128 * cos(2 * t) - 0.01168 * cos(3 * t);
+        p->win[k] = (float)w;
+        sum += w;
+    }
+    p->norm = 1.0 / (sum * sum);
+    p->work.resize(cfg->batch * n);
+    p->acc.resize(n);
+    psd_reset(p);
+    return 0;
+}
+
+void psd_reset(struct psd *p)
+{
+    p->pend.clear();
+    p->pend_pos = 0;
+    std::fill(p->acc.begin(), p->acc.end(), 0.0);
+    p->frames = 0;
+}
+
+/* count кадров с начала pend[pend_pos..] */
+static void run_frames(struct psd *p, size_t count)
+{
+    const size_t n = p->cfg.nfft;
+    const size_t hop = n - p->cfg.overlap;
+    const float *w = p->win.data();
+
+    for (size_t f = 0; f < count; f++) {
+        const cf_t *src = &p->pend[p->pend_pos + f * hop];
+        cf_t *dst = &p->work[f * n];
+        for (size_t k = 0; k < n; k++)
+            dst[k] = src[k] * w[k];
+    }
+    fft_execute_batch(&p->plan, p->work.data(), p->work.data(), count);
+
+    // fftshift сразу при накоплении
+    const size_t half = n / 2;
+    for (size_t f = 0; f < count; f++) {
+        const cf_t *X = &p->work[f * n];
+        for (size_t k = 0; k < n; k++)
+            p->acc[(k + half) & (n - 1)] += std::norm(X[k]);
+    }
+    p->frames += count;
+    p->pend_pos += count * hop;
+}
+
+static size_t frames_ready(const struct psd *p)
+{
+    size_t avail = p->pend.size() - p->pend_pos;
+    if (avail < p->cfg.nfft)
+        return 0;
+    return 1 + (avail - p->cfg.nfft) / (p->cfg.nfft - p->cfg.overlap);
+}
+
+static void compact(struct psd *p)
+{
+    if (p->pend_pos > 0 && p->pend_pos >= p->pend.size() / 2) {
+        p->pend.erase(p->pend.begin(), p->pend.begin() + p->pend_pos);
+        p->pend_pos = 0;
+    }
+}
+
+void psd_process(struct psd *p, const cf_t *x, size_t n)
+{
+    p->pend.insert(p->pend.end(), x, x + n);
+    while (frames_ready(p) >= p->cfg.batch)
+        run_frames(p, p->cfg.batch);
+    compact(p);
+}
+
+void psd_process_iq16(struct psd *p, const int16_t *iq, size_t n)
+{
+    size_t base = p->pend.size();
+    p->pend.resize(base + n);
+    for (size_t k = 0; k < n; k++)
+        p->pend[base + k] = cf_t(iq[2 * k] / 2048.0f, iq[2 * k + 1] / 2048.0f);
+    while (frames_ready(p) >= p->cfg.batch)
+        run_frames(p, p->cfg.batch);
+    compact(p);
+}
+
+void psd_flush(struct psd *p)
+{
+    size_t ready;
+    while ((ready = frames_ready(p)) > 0)
+        run_frames(p, ready < p->cfg.batch ? ready : p->cfg.batch);
+    compact(p);
+}
+
+void psd_result_db(struct psd *p, float *out)
+{
+    psd_flush(p);
+    const size_t n = p->cfg.nfft;
+    if (p->frames == 0) {
+        for (size_t k = 0; k < n; k++)
+            out[k] = -200.0f;
+        return;
+    }
+    const double scale = p->norm / p->frames;
+    for (size_t k = 0; k < n; k++)
+        out[k] = (float)(10.0 * log10(p->acc[k] * scale + 1e-20));
+}
@@ -0,0 +1,63 @@
+#ifndef PSD_H
+#define PSD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "dsp_types.h"
+#include "fft.h"
+
+/*
+ * Потоковый спектр мощности (метод Уэлча): окно nfft сэмплов со сдвигом
+ * nfft - overlap, |X|^2 усредняется по всем кадрам с последнего psd_reset().
+ * Вход - кусками любой длины, хвост между вызовами хранится внутри.
+ * Кадры копятся пачкой и считаются fft_execute_batch().
+ *
+ * Результат - dB относительно тона с амплитудой 1.0 (для iq16 - 2048,
+ * полная шкала АЦП AD9361), порядок как после np.fft.fftshift:
+ * out[nfft / 2] - нулевая частота.
+ */
+
+enum psd_window {
+    PSD_WIN_HANN = 0,
+    PSD_WIN_BLACKMAN_HARRIS,    // 4 члена, боковые -92 dB
+};
+
+struct psd_cfg {
+    size_t nfft;                // степень двойки
+    size_t overlap;             // < nfft
+    int window;
+    size_t batch;               // кадров на один вызов fft_execute_batch
+};
+
+void psd_default_cfg(struct psd_cfg *cfg);
+
+struct psd {
+    struct psd_cfg cfg;
+    struct fft_plan plan;
+    std::vector<float> win;
+    double norm;                // 1 / (sum win)^2
+
+    std::vector<cf_t> pend;     // сэмплы, ещё не ушедшие в кадры
+    size_t pend_pos;
+    std::vector<cf_t> work;     // batch * nfft
+    std::vector<double> acc;    // сумма |X|^2 по кадрам
+    size_t frames;
+};
+
+int psd_init(struct psd *p, const struct psd_cfg *cfg);
+
+/* Обнулить накопление и хвост */
+void psd_reset(struct psd *p);
+
+void psd_process(struct psd *p, const cf_t *x, size_t n);
+void psd_process_iq16(struct psd *p, const int16_t *iq, size_t n);
+
+/* Досчитать неполную пачку (кадры, для которых уже хватает сэмплов) */
+void psd_flush(struct psd *p);
+
+/* nfft значений в dB; без кадров - -200 dB */
+void psd_result_db(struct psd *p, float *out);
+
+#endif // PSD_H
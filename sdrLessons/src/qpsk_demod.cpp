@@ -0,0 +1,218 @@
+#include "qpsk_demod.h"
+
+#include <math.h>
+#include <errno.h>
+
+#include "simd_ops.h"
+
+void qpsk_demod_default_cfg(struct qpsk_demod_cfg *cfg, unsigned sps)
+{
+    cfg->sps = sps;
+    cfg->pulse = QPSK_PULSE_RECT;
+    cfg->rrc_span = 8;
+    cfg->rolloff = 0.35f;
+    cfg->timing_bw = 0.01f;     // как normalized_bandwidth в plot_pcm.py
+    cfg->costas_bw = 0.02f;
+    cfg->agc_rate = 0.01f;
+}
+
+static void rrc_taps(std::vector<float> &taps, unsigned sps, unsigned span, float beta)
+{
+    const int len = (int)(sps * span) | 1;
+    const int mid = len / 2;
+    taps.resize(len);
+
+    double sum = 0.0;
+    for (int k = 0; k < len; k++) {
+        double t = (double)(k - mid) / sps;
+        double h;
+        if (t == 0.0) {
+            h = 1.0 - beta + 4.0 * beta / M_PI;
+        } else if (beta > 0.0f && fabs(fabs(4.0 * beta * t) - 1.0) < 1e-9) {
+            h = beta / sqrt(2.0) * ((1.0 + 2.0 / M_PI) * sin(M_PI / (4.0 * beta)) +
+                                    (1.0 - 2.0 / M_PI) * cos(M_PI / (4.0 * beta)));
+        } else {
+            h = (sin(M_PI * t * (1.0 - beta)) + 4.0 * beta * t * cos(M_PI * t * (1.0 + beta))) /
+                (M_PI * t * (1.0 - 16.0 * beta * beta * t * t));
+        }
+        taps[k] = (float)h;
+        sum += h;
+    }
+    for (int k = 0; k < len; k++)
+        taps[k] = (float)(taps[k] / sum);
+}
+
+/* Коэффициенты ПИ-фильтра петли 2-го порядка (zeta = 1/sqrt(2)) */
+static void loop_gains(float bw, float detector_gain, double *kp, double *ki)
+{
+    const double zeta = sqrt(2.0) / 2.0;
+    double theta = bw / (zeta + 0.25 / zeta);
+    double d = (1.0 + 2.0 * zeta * theta + theta * theta) * detector_gain;
+    *kp = 4.0 * zeta * theta / d;
+    *ki = 4.0 * theta * theta / d;
+}
+
+int qpsk_demod_init(struct qpsk_demod *d, const struct qpsk_demod_cfg *cfg)
+{
+    if (cfg->sps < 2)
+        return -EINVAL;
+
+    d->cfg = *cfg;
+    if (cfg->pulse == QPSK_PULSE_RRC)
+        rrc_taps(d->taps, cfg->sps, cfg->rrc_span, cfg->rolloff);
+    else
+        d->taps.assign(cfg->sps, 1.0f / cfg->sps);
+
+    size_t ring = 4;
+    while (ring < 4 * cfg->sps + 4)
+        ring <<= 1;
+    d->y.resize(ring);
+    d->ymask = ring - 1;
+
+    double kp, ki;
+    loop_gains(cfg->timing_bw, 2.7f, &kp, &ki);     // kp = 2.7, как в plot_pcm.py
+    d->t_kp = kp;
+    d->t_ki = ki;
+    loop_gains(cfg->costas_bw, 1.0f, &kp, &ki);
+    d->c_alpha = (float)kp;
+    d->c_beta = (float)ki;
+    d->half = NULL;
+
+    qpsk_demod_reset(d, 0);
+    return 0;
+}
+
+void qpsk_demod_reset(struct qpsk_demod *d, long long start)
+{
+    const size_t L = d->taps.size();
+
+    d->fhist.assign(2 * L, cf_t(0.0f, 0.0f));
+    d->fpos = 0;
+    for (size_t k = 0; k <= d->ymask; k++)
+        d->y[k] = cf_t(0.0f, 0.0f);
+    d->n = start;
+
+    d->t_next = (double)(start + (long long)L);
+    d->t_integ = 0.0;
+    d->prev_sym = cf_t(0.0f, 0.0f);
+
+    d->gain = 0.0f;         // 0 - оценить по первому символу
+    d->phase = 0.0f;
+    d->freq = 0.0f;
+}
+
+double qpsk_demod_delay(const struct qpsk_demod *d)
+{
+    return (double)(d->taps.size() - 1) / 2.0;
+}
+
+static inline cf_t interp(const struct qpsk_demod *d, double t)
+{
+    long long i = (long long)floor(t);
+    float f = (float)(t - (double)i);
+    return d->y[i & d->ymask] * (1.0f - f) + d->y[(i + 1) & d->ymask] * f;
+}
+
+static inline float sgn(float v)
+{
+    return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+size_t qpsk_demod_process(struct qpsk_demod *d, const cf_t *x, size_t n,
+                          std::vector<cf_t> &syms, std::vector<double> *pos)
+{
+    const size_t L = d->taps.size();
+    const float *taps = d->taps.data();
+    const double sps = d->cfg.sps;
+    const double delay = qpsk_demod_delay(d);
+    size_t produced = 0;
+
+    for (size_t s = 0; s < n; s++) {
+        /* согласованный фильтр, окно fhist[fpos .. fpos + L) - от новых к старым */
+        d->fpos = d->fpos == 0 ? L - 1 : d->fpos - 1;
+        d->fhist[d->fpos] = x[s];
+        d->fhist[d->fpos + L] = x[s];
+        const float *w = reinterpret_cast<const float *>(&d->fhist[d->fpos]);
+        float acc_r = 0.0f, acc_i = 0.0f;
+        for (size_t k = 0; k < L; k++) {
+            acc_r += taps[k] * w[2 * k];
+            acc_i += taps[k] * w[2 * k + 1];
+        }
+        const long long idx = d->n++;
+        d->y[idx & d->ymask] = cf_t(acc_r, acc_i);
+
+        /* строб: нужен отсчёт floor(t) + 1 */
+        while (d->t_next + 1.0 <= (double)idx) {
+            const double t = d->t_next;
+            cf_t sym = interp(d, t);
+            cf_t mid = interp(d, t - sps / 2.0);
+
+            if (d->gain <= 0.0f) {
+                float a = std::abs(sym);
+                d->gain = a > 1e-9f ? 1.0f / a : 1.0f;
+            }
+            sym *= d->gain;
+            mid *= d->gain;
+
+            /* Гарднер: e = Re{(y[k-1] - y[k]) * conj(y[k-1/2])} */
+            cf_t diff = d->prev_sym - sym;
+            float e = diff.real() * mid.real() + diff.imag() * mid.imag();
+            d->prev_sym = sym;
+            d->t_integ += d->t_ki * e;
+            double v = d->t_kp * e + d->t_integ;
+            if (v > 0.5) v = 0.5;
+            if (v < -0.5) v = -0.5;
+            d->t_next = t + sps * (1.0 + v);
+
+            /* AGC по модулю символа (цель |s| = 1) */
+            float a = std::abs(sym);
+            float step = 1.0f + d->cfg.agc_rate * (1.0f - a);
+            if (step < 0.5f) step = 0.5f;
+            if (step > 2.0f) step = 2.0f;
+            d->gain *= step;
+
+            /* Костас для QPSK */
+            cf_t rot(cosf(d->phase), -sinf(d->phase));
+            cf_t out = sym * rot;
+            if (d->half) {
+                d->half->push_back(mid * rot);
+                d->half->push_back(out);
+            }
+            float ec = sgn(out.real()) * out.imag() - sgn(out.imag()) * out.real();
+            d->freq += d->c_beta * ec;
+            d->phase += d->freq + d->c_alpha * ec;
+            if (d->phase > (float)M_PI)
+                d->phase -= 2.0f * (float)M_PI;
+            else if (d->phase < -(float)M_PI)
+                d->phase += 2.0f * (float)M_PI;
+
+            syms.push_back(out);
+            if (pos)
+                pos->push_back(t - delay);
+            produced++;
+        }
+    }
+    return produced;
+}
+
+size_t qpsk_demod_process_iq16(struct qpsk_demod *d, const int16_t *iq, size_t n,
+                               std::vector<cf_t> &syms, std::vector<double> *pos)
+{
+    cf_t tmp[1024];
+    size_t produced = 0;
+
+    while (n > 0) {
+        size_t chunk = n < 1024 ? n : 1024;
+        for (size_t k = 0; k < chunk; k++)
+            tmp[k] = cf_t(iq[2 * k] / 2048.0f, iq[2 * k + 1] / 2048.0f);
+        produced += qpsk_demod_process(d, tmp, chunk, syms, pos);
+        iq += 2 * chunk;
+        n -= chunk;
+    }
+    return produced;
+}
+
+void qpsk_soft_bits(const cf_t *syms, size_t n, float scale, int8_t *soft)
+{
+    simd_f32_to_i8_sat(reinterpret_cast<const float *>(syms), 2 * n, scale, soft);
+}
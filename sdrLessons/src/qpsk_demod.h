@@ -0,0 +1,90 @@
+#ifndef QPSK_DEMOD_H
+#define QPSK_DEMOD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "dsp_types.h"
+
+/*
+ * Потоковый QPSK демодулятор: согласованный фильтр -> AGC ->
+ * синхронизация по времени (Гарднер, как plot_pcm.py::gardner_timing_recovery)
+ * -> петля Костаса 4-го порядка для фазы/частоты.
+ *
+ * Состояние переносится между вызовами, поэтому поток можно подавать
+ * блоками любой длины. Позиции символов - абсолютные (в сэмплах входа).
+ */
+
+enum qpsk_pulse {
+    QPSK_PULSE_RECT = 0,    // прямоугольный импульс длиной sps (np.ones(ns) в 1.py)
+    QPSK_PULSE_RRC,         // корень из приподнятого косинуса
+};
+
+struct qpsk_demod_cfg {
+    unsigned sps;           // отсчётов на символ
+    int pulse;              // enum qpsk_pulse
+    unsigned rrc_span;      // длина RRC в символах
+    float rolloff;
+    float timing_bw;        // нормированная полоса петли Гарднера (BnTs)
+    float costas_bw;        // нормированная полоса петли Костаса
+    float agc_rate;
+};
+
+void qpsk_demod_default_cfg(struct qpsk_demod_cfg *cfg, unsigned sps);
+
+struct qpsk_demod {
+    struct qpsk_demod_cfg cfg;
+    std::vector<float> taps;
+
+    /* фильтр: линия задержки удвоенной длины, чтобы окно было непрерывным */
+    std::vector<cf_t> fhist;
+    size_t fpos;
+
+    /* отфильтрованные отсчёты для интерполяции */
+    std::vector<cf_t> y;
+    size_t ymask;
+    long long n;            // абсолютный номер следующего входного сэмпла
+
+    /* Гарднер */
+    double t_next;          // позиция следующего строба
+    double t_kp, t_ki, t_integ;
+    cf_t prev_sym;
+
+    /* AGC и Костас */
+    float gain;
+    float phase, freq;
+    float c_alpha, c_beta;
+
+    /* если не NULL - сюда пары (середина, символ) с шагом T/2 после AGC и
+       поворота Костаса, вход для дробного эквалайзера (equalizer.h) */
+    std::vector<cf_t> *half;
+};
+
+int qpsk_demod_init(struct qpsk_demod *d, const struct qpsk_demod_cfg *cfg);
+
+/* Начать поток с абсолютного индекса start (для обработки файла кусками) */
+void qpsk_demod_reset(struct qpsk_demod *d, long long start);
+
+/* Групповая задержка фильтра в сэмплах */
+double qpsk_demod_delay(const struct qpsk_demod *d);
+
+/*
+ * Обработать n сэмплов. Символы (после AGC и Костаса) добавляются в syms,
+ * их позиции (в сэмплах, с учётом задержки фильтра) - в pos (может быть NULL).
+ */
+size_t qpsk_demod_process(struct qpsk_demod *d, const cf_t *x, size_t n,
+                          std::vector<cf_t> &syms, std::vector<double> *pos);
+
+/* Вариант для int16 I/Q, масштаб 1/2048 (12 бит АЦП) */
+size_t qpsk_demod_process_iq16(struct qpsk_demod *d, const int16_t *iq, size_t n,
+                               std::vector<cf_t> &syms, std::vector<double> *pos);
+
+/*
+ * Мягкие решения для декодера (fec.h): I -> soft[2k], Q -> soft[2k + 1],
+ * round(x * scale) с ограничением до +-127. Символ 2*b - 1, как в 1.py.
+ * LLR с масштабом по шуму - demapper.h.
+ */
+void qpsk_soft_bits(const cf_t *syms, size_t n, float scale, int8_t *soft);
+
+#endif // QPSK_DEMOD_H
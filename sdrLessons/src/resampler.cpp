@@ -0,0 +1,166 @@
+#include "resampler.h"
+#include "simd_ops.h"
+
+#include <math.h>
+#include <string.h>
+#include <errno.h>
+
+static unsigned gcd_u(unsigned a, unsigned b)
+{
+    while (b) {
+        unsigned t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static double bessel_i0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12)
+            break;
+    }
+    return sum;
+}
+
+/*
+ * Прототип длиной nphases * ntaps на частоте nphases * fs_in,
+ * cutoff - частота среза в долях этой частоты. Коэффициенты раскладываются
+ * по фазам в обратном порядке: bank_p[m] = h[p + (ntaps - 1 - m) * nphases].
+ */
+static void design_bank(struct resampler *r, unsigned nphases, double cutoff)
+{
+    const size_t N = (size_t)nphases * r->ntaps;
+    const double beta = 8.0;        // окно Кайзера, ~80 дБ
+    const double c = (N - 1) / 2.0;
+    std::vector<double> h(N);
+
+    for (size_t q = 0; q < N; q++) {
+        double t = (double)q - c;
+        double sinc = t == 0.0 ? 2.0 * cutoff : sin(2.0 * M_PI * cutoff * t) / (M_PI * t);
+        double w = t / c;
+        double win = bessel_i0(beta * sqrt(fmax(0.0, 1.0 - w * w))) / bessel_i0(beta);
+        h[q] = sinc * win * nphases;
+    }
+
+    r->stride = (2 * r->ntaps + 7) & ~(size_t)7;
+    r->bank.assign((size_t)nphases * r->stride, 0.0f);
+    for (unsigned p = 0; p < nphases; p++) {
+        float *b = &r->bank[(size_t)p * r->stride];
+        for (unsigned m = 0; m < r->ntaps; m++) {
+            float v = (float)h[p + (size_t)(r->ntaps - 1 - m) * nphases];
+            b[2 * m] = v;
+            b[2 * m + 1] = v;
+        }
+    }
+}
+
+int resampler_init_rational(struct resampler *r, unsigned L, unsigned M, unsigned taps_per_phase)
+{
+    if (L == 0 || M == 0 || taps_per_phase == 0)
+        return -EINVAL;
+
+    unsigned g = gcd_u(L, M);
+    r->fractional = false;
+    r->L = L / g;
+    r->M = M / g;
+    r->step = (double)r->M / r->L;
+    r->ntaps = taps_per_phase;
+
+    unsigned mx = r->L > r->M ? r->L : r->M;
+    design_bank(r, r->L, 0.45 / mx);
+    resampler_reset(r);
+    return 0;
+}
+
+int resampler_init_fractional(struct resampler *r, double ratio, unsigned taps_per_phase,
+                              unsigned nphases)
+{
+    if (ratio <= 0.0 || taps_per_phase == 0 || nphases < 2)
+        return -EINVAL;
+
+    r->fractional = true;
+    r->L = nphases;
+    r->M = 0;
+    r->step = 1.0 / ratio;
+    r->ntaps = taps_per_phase;
+
+    double bw = ratio < 1.0 ? ratio : 1.0;
+    design_bank(r, nphases, 0.45 * bw / nphases);
+    resampler_reset(r);
+    return 0;
+}
+
+void resampler_reset(struct resampler *r)
+{
+    /* ntaps - 1 нулей истории */
+    r->buf.assign(2 * (r->ntaps - 1), 0.0f);
+    r->pos = r->ntaps - 1;
+    r->phase = 0;
+    r->t = (double)(r->ntaps - 1);
+}
+
+double resampler_delay(const struct resampler *r)
+{
+    return ((double)r->L * r->ntaps - 1.0) / (2.0 * r->L);
+}
+
+static inline cf_t bank_dot(const struct resampler *r, unsigned phase, size_t newest)
+{
+    float re, im;
+    const float *x = &r->buf[2 * (newest + 1 - r->ntaps)];
+    simd_dot_cf_rf2(x, &r->bank[(size_t)phase * r->stride], 2 * r->ntaps, &re, &im);
+    return cf_t(re, im);
+}
+
+size_t resampler_process(struct resampler *r, const cf_t *x, size_t n, std::vector<cf_t> &out)
+{
+    const size_t old = r->buf.size();
+    r->buf.resize(old + 2 * n);
+    memcpy(&r->buf[old], x, n * sizeof(cf_t));
+    const size_t avail = r->buf.size() / 2;
+    size_t produced = 0;
+    size_t drop;
+
+    if (!r->fractional) {
+        while (r->pos < avail) {
+            out.push_back(bank_dot(r, r->phase, r->pos));
+            produced++;
+            r->phase += r->M;
+            r->pos += r->phase / r->L;
+            r->phase %= r->L;
+        }
+        // всё левее окна следующего выхода больше не нужно
+        drop = r->pos + 1 - r->ntaps;
+        if (drop > avail)
+            drop = avail;
+        r->pos -= drop;
+    } else {
+        const double P = r->L;
+        for (;;) {
+            size_t i = (size_t)r->t;
+            if (i + 1 >= avail)
+                break;
+            double ph = (r->t - (double)i) * P;
+            unsigned p0 = (unsigned)ph;
+            float a = (float)(ph - p0);
+            cf_t y0 = bank_dot(r, p0, i);
+            // фаза P - это фаза 0 на следующем входном отсчёте
+            cf_t y1 = p0 + 1 < r->L ? bank_dot(r, p0 + 1, i) : bank_dot(r, 0, i + 1);
+            out.push_back(y0 + (y1 - y0) * a);
+            produced++;
+            r->t += r->step;
+        }
+        drop = (size_t)r->t + 1 - r->ntaps;
+        if (drop > avail)
+            drop = avail;
+        r->t -= (double)drop;
+    }
+
+    r->buf.erase(r->buf.begin(), r->buf.begin() + 2 * drop);
+    return produced;
+}
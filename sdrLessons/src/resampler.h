@@ -0,0 +1,47 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <stddef.h>
+#include <vector>
+
+#include "dsp_types.h"
+
+/*
+ * Полифазный ресэмплер с сохранением состояния между блоками.
+ *
+ * Рациональный режим: fs_out = fs_in * L / M (L, M сокращаются на НОД).
+ * Дробный режим: произвольное отношение fs_out / fs_in, банк из nphases
+ * фаз с линейной интерполяцией между соседними фазами.
+ *
+ * Прототип - sinc с окном Кайзера, срез по min(fs_in, fs_out) / 2.
+ * Свёртка - simd_dot_cf_rf2 (AVX/SSE2/NEON).
+ *
+ * Пример: радио на 10 MS/s, DSP на 4 sps при 1 Msym/s -> L = 2, M = 5.
+ */
+
+struct resampler {
+    bool fractional;
+    unsigned L, M;              // рациональный режим; в дробном L = nphases
+    double step;                // дробный режим: шаг по входу на выходной сэмпл
+    unsigned ntaps;             // коэффициентов на фазу
+    size_t stride;              // float на фазу в bank (кратно 8)
+    std::vector<float> bank;    // фазы, коэффициенты продублированы для I/Q, в обратном порядке
+
+    std::vector<float> buf;     // входная история, interleaved I/Q
+    size_t pos;                 // индекс новейшего отсчёта окна (рациональный режим)
+    unsigned phase;
+    double t;                   // дробный режим: позиция в buf
+};
+
+int resampler_init_rational(struct resampler *r, unsigned L, unsigned M, unsigned taps_per_phase);
+int resampler_init_fractional(struct resampler *r, double ratio, unsigned taps_per_phase,
+                              unsigned nphases);
+void resampler_reset(struct resampler *r);
+
+/* Выходные сэмплы добавляются в out. Возвращает их число */
+size_t resampler_process(struct resampler *r, const cf_t *x, size_t n, std::vector<cf_t> &out);
+
+/* Задержка в входных сэмплах */
+double resampler_delay(const struct resampler *r);
+
+#endif // RESAMPLER_H
@@ -0,0 +1,223 @@
+#include "rt_thread.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+
+#include <atomic>
+
+#ifdef HAVE_LIBNUMA
+#include <numa.h>
+#endif
+
+static int shutdown_efd = -1;
+static std::atomic<bool> shutdown_flag(false);
+
+int rt_thread_apply(const struct rt_thread_cfg *cfg)
+{
+    pthread_t self = pthread_self();
+    int ret;
+
+    if (cfg->name)
+        pthread_setname_np(self, cfg->name);
+
+    if (cfg->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cfg->cpu, &set);
+        ret = pthread_setaffinity_np(self, sizeof(set), &set);
+        if (ret) {
+            fprintf(stderr, "* Unable to pin thread %s to CPU %d: %s\n",
+                    cfg->name ? cfg->name : "", cfg->cpu, strerror(ret));
+            return -ret;
+        }
+    }
+
+    if (cfg->priority > 0) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = cfg->priority;
+        ret = pthread_setschedparam(self, SCHED_FIFO, &param);
+        if (ret == EPERM) {
+            // без CAP_SYS_NICE / rtprio в limits.conf работаем как есть
+            fprintf(stderr, "* SCHED_FIFO not permitted for thread %s, using SCHED_OTHER\n",
+                    cfg->name ? cfg->name : "");
+        } else if (ret) {
+            return -ret;
+        }
+    }
+    return 0;
+}
+
+static int parse_cpu_list(const char *str, std::vector<int> &cpus)
+{
+    const char *p = str;
+    while (*p && *p != '\n') {
+        char *end;
+        long a = strtol(p, &end, 10);
+        if (end == p)
+            return -EINVAL;
+        long b = a;
+        if (*end == '-') {
+            p = end + 1;
+            b = strtol(p, &end, 10);
+            if (end == p)
+                return -EINVAL;
+        }
+        for (long c = a; c <= b; c++)
+            cpus.push_back((int)c);
+        p = end;
+        if (*p == ',')
+            p++;
+    }
+    return 0;
+}
+
+int rt_isolated_cpus(std::vector<int> &cpus)
+{
+    char line[256] = {0};
+    cpus.clear();
+
+    FILE *f = fopen("/sys/devices/system/cpu/isolated", "r");
+    if (!f)
+        return -errno;
+    if (!fgets(line, sizeof(line), f))
+        line[0] = '\0';
+    fclose(f);
+    return parse_cpu_list(line, cpus);
+}
+
+int rt_other_cpus(const std::vector<int> &exclude, std::vector<int> &cpus)
+{
+    cpu_set_t set;
+    cpus.clear();
+    if (sched_getaffinity(0, sizeof(set), &set) < 0)
+        return -errno;
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (!CPU_ISSET(c, &set))
+            continue;
+        bool skip = false;
+        for (size_t k = 0; k < exclude.size(); k++)
+            skip |= exclude[k] == c;
+        if (!skip)
+            cpus.push_back(c);
+    }
+    return 0;
+}
+
+void *rt_alloc_locked(size_t len, int cpu)
+{
+    void *ptr = NULL;
+
+#ifdef HAVE_LIBNUMA
+    if (numa_available() >= 0) {
+        int node = cpu >= 0 ? numa_node_of_cpu(cpu) : numa_preferred();
+        ptr = numa_alloc_onnode(len, node < 0 ? 0 : node);
+    }
+#else
+    (void)cpu;
+#endif
+    if (!ptr) {
+        // без libnuma: страницы попадут на узел того потока, что первым их тронет
+        ptr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED)
+            return NULL;
+    }
+
+    memset(ptr, 0, len);
+    if (mlock(ptr, len) < 0)
+        fprintf(stderr, "* mlock(%zu) failed: %s\n", len, strerror(errno));
+    return ptr;
+}
+
+void rt_free_locked(void *ptr, size_t len)
+{
+    if (!ptr)
+        return;
+    munlock(ptr, len);
+#ifdef HAVE_LIBNUMA
+    if (numa_available() >= 0) {
+        numa_free(ptr, len);
+        return;
+    }
+#endif
+    munmap(ptr, len);
+}
+
+int rt_lock_all_memory(void)
+{
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0) {
+        fprintf(stderr, "* mlockall failed: %s\n", strerror(errno));
+        return -errno;
+    }
+    return 0;
+}
+
+static void shutdown_signal_handler(int sig_no)
+{
+    (void)sig_no;
+    rt_shutdown_request();
+}
+
+int rt_shutdown_init(void)
+{
+    if (shutdown_efd < 0) {
+        shutdown_efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (shutdown_efd < 0)
+            return -errno;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = &shutdown_signal_handler;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    return 0;
+}
+
+int rt_shutdown_fd(void)
+{
+    return shutdown_efd;
+}
+
+bool rt_shutdown_requested(void)
+{
+    return shutdown_flag.load(std::memory_order_acquire);
+}
+
+void rt_shutdown_request(void)
+{
+    /* только async-signal-safe вызовы */
+    shutdown_flag.store(true, std::memory_order_release);
+    if (shutdown_efd >= 0) {
+        uint64_t one = 1;
+        ssize_t ret = write(shutdown_efd, &one, sizeof(one));
+        (void)ret;
+    }
+}
+
+int rt_shutdown_wait(int timeout_ms)
+{
+    if (rt_shutdown_requested())
+        return 1;
+    if (shutdown_efd < 0)
+        return -EBADF;
+
+    struct pollfd pfd;
+    pfd.fd = shutdown_efd;
+    pfd.events = POLLIN;
+    int ret = poll(&pfd, 1, timeout_ms);
+    if (ret < 0)
+        return errno == EINTR ? (int)rt_shutdown_requested() : -errno;
+    return rt_shutdown_requested() ? 1 : 0;
+}
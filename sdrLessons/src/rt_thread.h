@@ -0,0 +1,48 @@
+#ifndef RT_THREAD_H
+#define RT_THREAD_H
+
+#include <stddef.h>
+#include <vector>
+
+/*
+ * Настройка потоков реального времени для RX/TX/DSP.
+ *
+ * RX/TX потоки IIO сажаются на изолированные ядра (isolcpus=...) с
+ * SCHED_FIFO, их буферы фиксируются в памяти (mlock) и выделяются на
+ * NUMA узле своего ядра. DSP потоки - на оставшихся ядрах с обычным
+ * планировщиком.
+ *
+ * Остановка: обработчик SIGINT/SIGTERM только пишет в eventfd, весь
+ * teardown делается в обычном контексте тем, кто ждёт rt_shutdown_fd().
+ */
+
+struct rt_thread_cfg {
+    const char *name;       // имя потока (до 15 символов), NULL - не менять
+    int cpu;                // ядро, -1 - не привязывать
+    int priority;           // приоритет SCHED_FIFO 1..99, 0 - SCHED_OTHER
+};
+
+/* Применить настройки к вызывающему потоку. Ошибки прав (EPERM) не фатальны: печатается предупреждение */
+int rt_thread_apply(const struct rt_thread_cfg *cfg);
+
+/* Ядра из /sys/devices/system/cpu/isolated; пустой список, если изоляции нет */
+int rt_isolated_cpus(std::vector<int> &cpus);
+
+/* Все ядра, кроме перечисленных в exclude - для DSP потоков */
+int rt_other_cpus(const std::vector<int> &exclude, std::vector<int> &cpus);
+
+/* Выделить память на NUMA узле ядра cpu и зафиксировать её (mlock). cpu < 0 - текущий узел */
+void *rt_alloc_locked(size_t len, int cpu);
+void rt_free_locked(void *ptr, size_t len);
+
+/* mlockall(MCL_CURRENT | MCL_FUTURE) */
+int rt_lock_all_memory(void);
+
+/* Кооперативная остановка через eventfd */
+int rt_shutdown_init(void);             // eventfd + обработчики SIGINT/SIGTERM
+int rt_shutdown_fd(void);               // для poll(): читаемо после запроса остановки
+bool rt_shutdown_requested(void);
+void rt_shutdown_request(void);         // можно звать из любого потока и из обработчика сигнала
+int rt_shutdown_wait(int timeout_ms);   // 1 - остановка запрошена, 0 - таймаут
+
+#endif // RT_THREAD_H
@@ -0,0 +1,262 @@
+#include "sdr_autotune.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+
+#define MARKER_LEN      64          // сэмплов в метке
+#define MARKER_SLOTS    64
+#define POLL_MS         50
+
+void sdr_autotune_default_cfg(struct sdr_autotune_cfg *cfg)
+{
+    cfg->min_block = 1 << 10;
+    cfg->max_block = 1 << 16;
+    cfg->min_count = 2;
+    cfg->max_count = 8;
+    cfg->seconds = 1.0;
+    cfg->warmup_s = 0.2;
+    cfg->max_cpu_pct = 50.0;
+    cfg->marker_amp = 8192;
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static double cpu_s(void)
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1e-6;
+}
+
+/* TX: метка MARKER_LEN сэмплов в начале каждого периода, время заполнения - в fill_ns */
+struct marker_tx {
+    long long period;
+    int16_t amp;
+    std::atomic<int64_t> fill_ns[MARKER_SLOTS];
+};
+
+static void marker_fill_cb(int16_t *iq, size_t n, long long index, void *user)
+{
+    struct marker_tx *m = static_cast<struct marker_tx *>(user);
+    memset(iq, 0, n * 2 * sizeof(int16_t));
+    long long first = (index + m->period - 1) / m->period * m->period;
+    // хвост метки из прошлого блока
+    long long prev = index / m->period * m->period;
+    for (long long k = index; k < prev + MARKER_LEN && k < index + (long long)n; k++) {
+        iq[2 * (k - index)] = m->amp;
+        iq[2 * (k - index) + 1] = m->amp;
+    }
+    for (long long start = first; start < index + (long long)n; start += m->period) {
+        m->fill_ns[(start / m->period) % MARKER_SLOTS].store(now_ns(), std::memory_order_relaxed);
+        for (long long k = start; k < start + MARKER_LEN && k < index + (long long)n; k++) {
+            iq[2 * (k - index)] = m->amp;
+            iq[2 * (k - index) + 1] = m->amp;
+        }
+    }
+}
+
+/* RX: фронт метки по порогу над средним шумом */
+struct marker_rx {
+    double noise;
+    bool in_marker;
+    size_t quiet;
+};
+
+static bool marker_detect(struct marker_rx *d, const int16_t *iq, size_t n)
+{
+    bool found = false;
+    for (size_t k = 0; k < n; k++) {
+        double a = abs(iq[2 * k]) + abs(iq[2 * k + 1]);
+        if (!d->in_marker) {
+            if (a > 10.0 * d->noise + 64.0) {
+                d->in_marker = true;
+                d->quiet = 0;
+                found = true;
+            } else {
+                d->noise += 1e-3 * (a - d->noise);
+            }
+        } else if (a < 3.0 * d->noise + 32.0) {
+            if (++d->quiet > 2 * MARKER_LEN)
+                d->in_marker = false;
+        } else {
+            d->quiet = 0;
+        }
+    }
+    return found;
+}
+
+static int run_point(const struct sdr_stream_cfg *base, const struct sdr_autotune_cfg *acfg,
+                     struct sdr_autotune_point *pt)
+{
+    struct sdr_stream_cfg cfg = *base;
+    cfg.geometry_profile = NULL;
+    cfg.block_size = pt->block_size;
+    cfg.block_count = pt->block_count;
+
+    const double fs = (double)cfg.rx.fs_hz;
+    struct marker_tx *mtx = new marker_tx;
+    mtx->period = (long long)(fs / 4);
+    mtx->amp = acfg->marker_amp;
+    for (int k = 0; k < MARKER_SLOTS; k++)
+        mtx->fill_ns[k].store(0);
+
+    struct sdr_stream s;
+    int ret = sdr_stream_open(&s, &cfg);
+    if (ret < 0) {
+        delete mtx;
+        return ret;
+    }
+    ret = sdr_stream_start(&s, marker_fill_cb, mtx);
+    if (ret < 0) {
+        sdr_stream_stop(&s);
+        sdr_stream_close(&s);
+        delete mtx;
+        return ret;
+    }
+
+    struct marker_rx det = {0.0, false, 0};
+    std::vector<double> lat;
+    const int64_t t0 = now_ns();
+    const int64_t t_warm = t0 + (int64_t)(acfg->warmup_s * 1e9);
+    const int64_t t_end = t_warm + (int64_t)(acfg->seconds * 1e9);
+    int64_t t_poll = t_warm;
+    bool counting = false;
+    double cpu0 = 0.0;
+    uint64_t drops0 = 0;
+    long long err0 = 0;
+
+    for (;;) {
+        int64_t t = now_ns();
+        if (t >= t_end || rt_shutdown_requested())
+            break;
+        if (!counting && t >= t_warm) {
+            // с этого момента всё считается: сбросить липкие флаги разгона
+            bool ro, tu;
+            sdr_stream_dma_status(&s, &ro, &tu);
+            cpu0 = cpu_s();
+            drops0 = s.ring.overflows.load();
+            err0 = s.rx_errors.load() + s.tx_errors.load();
+            counting = true;
+        }
+        if (counting && t >= t_poll) {
+            bool ro, tu;
+            if (sdr_stream_dma_status(&s, &ro, &tu) == 0) {
+                pt->rx_overflows += ro;
+                pt->tx_underflows += tu;
+            }
+            t_poll = t + POLL_MS * 1000000LL;
+        }
+
+        if (sdr_stream_rx_wait(&s, POLL_MS) <= 0)
+            continue;
+        const struct iq_block_info *info;
+        const int16_t *iq;
+        while ((iq = iq_ring_read_begin(&s.ring, &info)) != NULL) {
+            if (marker_detect(&det, iq, info->n) && counting) {
+                // последняя метка, заполненная раньше прихода блока, не старше периода
+                int64_t best = -1;
+                for (int k = 0; k < MARKER_SLOTS; k++) {
+                    int64_t f = mtx->fill_ns[k].load(std::memory_order_relaxed);
+                    if (f > 0 && f <= info->host_ns && (best < 0 || f > best))
+                        best = f;
+                }
+                if (best > 0 && info->host_ns - best < (int64_t)(mtx->period / fs * 1e9))
+                    lat.push_back((info->host_ns - best) * 1e-6);
+            }
+            iq_ring_read_release(&s.ring);
+        }
+    }
+
+    double wall = (now_ns() - t_warm) * 1e-9;
+    pt->cpu_pct = counting && wall > 0.0 ? 100.0 * (cpu_s() - cpu0) / wall : 0.0;
+    pt->ring_drops = counting ? (long long)(s.ring.overflows.load() - drops0) : 0;
+    pt->errors = counting ? s.rx_errors.load() + s.tx_errors.load() - err0 : 0;
+    sdr_stream_stop(&s);
+    sdr_stream_close(&s);
+    delete mtx;
+
+    pt->queue_ms = 2.0 * pt->block_count * pt->block_size / fs * 1e3;
+    if (!lat.empty()) {
+        std::nth_element(lat.begin(), lat.begin() + lat.size() / 2, lat.end());
+        pt->latency_ms = lat[lat.size() / 2];
+    }
+    pt->ok = pt->rx_overflows == 0 && pt->tx_underflows == 0 && pt->ring_drops == 0 && pt->errors == 0 &&
+             pt->cpu_pct <= acfg->max_cpu_pct;
+    return 0;
+}
+
+static double point_latency(const struct sdr_autotune_point *p)
+{
+    return p->latency_ms >= 0.0 ? p->latency_ms : p->queue_ms;
+}
+
+static long long point_losses(const struct sdr_autotune_point *p)
+{
+    return p->rx_overflows + p->tx_underflows + p->ring_drops + p->errors;
+}
+
+int sdr_autotune_run(const struct sdr_stream_cfg *base, const struct sdr_autotune_cfg *acfg,
+                     std::vector<struct sdr_autotune_point> &points, struct stream_geometry *best)
+{
+    if (acfg->min_block == 0 || acfg->min_block > acfg->max_block || acfg->min_count < 2 ||
+        acfg->min_count > acfg->max_count)
+        return -EINVAL;
+
+    points.clear();
+    for (size_t bs = acfg->min_block; bs <= acfg->max_block && !rt_shutdown_requested(); bs <<= 1) {
+        for (size_t bc = acfg->min_count; bc <= acfg->max_count && !rt_shutdown_requested(); bc++) {
+            struct sdr_autotune_point pt;
+            memset(&pt, 0, sizeof(pt));
+            pt.block_size = bs;
+            pt.block_count = bc;
+            pt.latency_ms = -1.0;
+            int ret = run_point(base, acfg, &pt);
+            if (ret < 0) {
+                fprintf(stderr, "Unable to run block %zu x %zu: %s\n", bs, bc, strerror(-ret));
+                return ret;
+            }
+            printf("* block %6zu x %zu: ovf %lld, unf %lld, drops %lld, err %lld, cpu %5.1f%%, "
+                   "latency %.2f ms (queues %.2f ms)%s\n",
+                   bs, bc, pt.rx_overflows, pt.tx_underflows, pt.ring_drops, pt.errors, pt.cpu_pct,
+                   pt.latency_ms, pt.queue_ms, pt.ok ? "" : " - rejected");
+            points.push_back(pt);
+        }
+    }
+    if (points.empty())
+        return -EINVAL;
+
+    // без потерь - минимальная задержка, при равной - меньше CPU; иначе - минимум потерь
+    size_t b = 0;
+    for (size_t k = 1; k < points.size(); k++) {
+        const struct sdr_autotune_point *p = &points[k], *q = &points[b];
+        bool better;
+        if (p->ok != q->ok)
+            better = p->ok;
+        else if (!p->ok && point_losses(p) != point_losses(q))
+            better = point_losses(p) < point_losses(q);
+        else if (point_latency(p) != point_latency(q))
+            better = point_latency(p) < point_latency(q);
+        else
+            better = p->cpu_pct < q->cpu_pct;
+        if (better)
+            b = k;
+    }
+    best->fs_hz = base->rx.fs_hz;
+    best->block_size = points[b].block_size;
+    best->block_count = points[b].block_count;
+    best->latency_ms = point_latency(&points[b]);
+    best->cpu_pct = points[b].cpu_pct;
+    return points[b].ok ? 0 : -EAGAIN;
+}
@@ -0,0 +1,58 @@
+#ifndef SDR_AUTOTUNE_H
+#define SDR_AUTOTUNE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "sdr_stream.h"
+#include "stream_geometry.h"
+
+/*
+ * Подбор геометрии буферов движка: для каждой пары (размер блока, число
+ * блоков) поток запускается на seconds секунд и меряются:
+ *  - переполнения RX / опустошения TX по флагам DMA AD9361, потери в
+ *    кольце RX -> DSP, ошибки iio_stream;
+ *  - загрузка CPU процесса (getrusage);
+ *  - задержка TX -> RX: TX раз в 1/4 секунды шлёт метку, время её
+ *    заполнения сравнивается с временем прихода RX блока с ней (нужна
+ *    петля TX -> RX кабелем или антеннами, как в single_adalm_rxtx_costas.cpp).
+ *    Без петли - расчётная задержка очередей 2 * count * size / fs.
+ *
+ * Лучшая точка - без потерь, с CPU не выше max_cpu_pct и минимальной
+ * задержкой; её можно сохранить в профиль (stream_geometry_save), и
+ * sdr_stream_open() дальше подхватывает её сам.
+ */
+
+struct sdr_autotune_cfg {
+    size_t min_block, max_block;    // степени двойки
+    size_t min_count, max_count;
+    double seconds;                 // на одну точку
+    double warmup_s;                // начало точки не считается (разгон TX)
+    double max_cpu_pct;             // процент одного ядра
+    int16_t marker_amp;
+};
+
+void sdr_autotune_default_cfg(struct sdr_autotune_cfg *cfg);
+
+struct sdr_autotune_point {
+    size_t block_size, block_count;
+    long long rx_overflows;         // опросов (раз в 50 мс) с флагом DMA
+    long long tx_underflows;
+    long long ring_drops;
+    long long errors;
+    double cpu_pct;
+    double latency_ms;              // медиана измеренной TX -> RX, < 0 - меток не было
+    double queue_ms;                // расчётная
+    bool ok;
+};
+
+/*
+ * Прогнать сетку поверх base (uri, частоты, потоки). Все точки - в points,
+ * лучшая - в best (fs_hz = base->rx.fs_hz). 0, -EAGAIN если ни одна точка
+ * не прошла без потерь (best - с наименьшими потерями), или ошибка открытия.
+ */
+int sdr_autotune_run(const struct sdr_stream_cfg *base, const struct sdr_autotune_cfg *acfg,
+                     std::vector<struct sdr_autotune_point> &points, struct stream_geometry *best);
+
+#endif // SDR_AUTOTUNE_H
@@ -0,0 +1,372 @@
+#include "sdr_ctrl.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "sdr_stream.h"
+
+enum attr_type { ATTR_LL, ATTR_DBL, ATTR_STR };
+
+struct attr_desc {
+    const char *chn;        // NULL - атрибут устройства
+    bool output;
+    const char *name;
+    int type;
+    bool trigger;           // команда, а не состояние: пишется всегда
+};
+
+/* Порядок - как в enum sdr_ctrl_attr */
+static const struct attr_desc attr_descs[CTRL_ATTR_COUNT] = {
+    { "voltage0",    false, "rf_port_select",     ATTR_STR, false },
+    { "voltage0",    false, "rf_bandwidth",       ATTR_LL,  false },
+    { "voltage0",    false, "sampling_frequency", ATTR_LL,  false },
+    { "voltage0",    false, "gain_control_mode",  ATTR_STR, false },
+    { "voltage0",    false, "hardwaregain",       ATTR_DBL, false },
+    { "voltage0",    true,  "rf_port_select",     ATTR_STR, false },
+    { "voltage0",    true,  "rf_bandwidth",       ATTR_LL,  false },
+    { "voltage0",    true,  "sampling_frequency", ATTR_LL,  false },
+    { "voltage0",    true,  "hardwaregain",       ATTR_DBL, false },
+    { "altvoltage0", true,  "frequency",          ATTR_LL,  false },
+    { "altvoltage0", true,  "fastlock_store",     ATTR_LL,  true  },
+    { "altvoltage0", true,  "fastlock_recall",    ATTR_LL,  true  },
+    { "altvoltage0", true,  "fastlock_save",      ATTR_LL,  true  },
+    { "altvoltage0", true,  "fastlock_load",      ATTR_STR, true  },
+    { "altvoltage1", true,  "frequency",          ATTR_LL,  false },
+    { "altvoltage1", true,  "fastlock_store",     ATTR_LL,  true  },
+    { "altvoltage1", true,  "fastlock_recall",    ATTR_LL,  true  },
+    { "altvoltage1", true,  "fastlock_save",      ATTR_LL,  true  },
+    { "altvoltage1", true,  "fastlock_load",      ATTR_STR, true  },
+    { NULL,          false, "ensm_mode",          ATTR_STR, false },
+};
+
+/* Смещения fastlock-атрибутов от LO */
+#define FL_STORE    1
+#define FL_RECALL   2
+#define FL_SAVE     3
+#define FL_LOAD     4
+
+static int64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static inline int lo_attr(bool tx)
+{
+    return tx ? CTRL_TX_LO : CTRL_RX_LO;
+}
+
+int sdr_ctrl_init(struct sdr_ctrl *c, struct iio_device *phy)
+{
+    c->phy = phy;
+    c->queued = 0;
+    memset(&c->stats, 0, sizeof(c->stats));
+    sdr_ctrl_invalidate(c);
+    if (!phy)
+        return -ENODEV;
+
+    int found = 0;
+    for (int a = 0; a < CTRL_ATTR_COUNT; a++) {
+        const struct attr_desc *d = &attr_descs[a];
+        c->attr[a] = NULL;
+        if (d->chn) {
+            struct iio_channel *chn = iio_device_find_channel(phy, d->chn, d->output);
+            if (chn)
+                c->attr[a] = iio_channel_find_attr(chn, d->name);
+        } else {
+            c->attr[a] = iio_device_find_attr(phy, d->name);
+        }
+        found += c->attr[a] != NULL;
+    }
+    return found > 0 ? 0 : -ENODEV;
+}
+
+void sdr_ctrl_invalidate(struct sdr_ctrl *c)
+{
+    for (int a = 0; a < CTRL_ATTR_COUNT; a++)
+        c->known[a] = false;
+}
+
+static struct sdr_ctrl_write *enqueue(struct sdr_ctrl *c, int attr)
+{
+    if (attr < 0 || attr >= CTRL_ATTR_COUNT)
+        return NULL;
+    // повтор атрибута - новое значение на прежнем месте в очереди
+    for (size_t k = 0; k < c->queued; k++)
+        if (c->queue[k].attr == attr)
+            return &c->queue[k];
+    if (c->queued == SDR_CTRL_QUEUE)
+        return NULL;
+    struct sdr_ctrl_write *w = &c->queue[c->queued++];
+    w->attr = attr;
+    return w;
+}
+
+int sdr_ctrl_set(struct sdr_ctrl *c, int attr, long long val)
+{
+    struct sdr_ctrl_write *w = enqueue(c, attr);
+    if (!w || attr_descs[attr].type != ATTR_LL)
+        return -EINVAL;
+    w->ll = val;
+    return 0;
+}
+
+int sdr_ctrl_set_double(struct sdr_ctrl *c, int attr, double val)
+{
+    struct sdr_ctrl_write *w = enqueue(c, attr);
+    if (!w || attr_descs[attr].type != ATTR_DBL)
+        return -EINVAL;
+    w->d = val;
+    return 0;
+}
+
+int sdr_ctrl_set_str(struct sdr_ctrl *c, int attr, const char *val)
+{
+    struct sdr_ctrl_write *w = enqueue(c, attr);
+    if (!w || attr_descs[attr].type != ATTR_STR || !val)
+        return -EINVAL;
+    w->s = val;
+    return 0;
+}
+
+static bool unchanged(const struct sdr_ctrl *c, const struct sdr_ctrl_write *w)
+{
+    const struct attr_desc *d = &attr_descs[w->attr];
+    if (d->trigger || !c->known[w->attr])
+        return false;
+    switch (d->type) {
+    case ATTR_LL:  return c->ll[w->attr] == w->ll;
+    case ATTR_DBL: return c->d[w->attr] == w->d;
+    default:       return c->s[w->attr] == w->s;
+    }
+}
+
+static int write_one(struct sdr_ctrl *c, const struct sdr_ctrl_write *w)
+{
+    const struct attr_desc *d = &attr_descs[w->attr];
+    const struct iio_attr *attr = c->attr[w->attr];
+    if (!attr) {
+        fprintf(stderr, "* Attribute %s not found\n", d->name);
+        return -ENOENT;
+    }
+    if (unchanged(c, w)) {
+        c->stats.skipped++;
+        return 0;
+    }
+
+    int ret;
+    switch (d->type) {
+    case ATTR_LL:  ret = iio_attr_write_longlong(attr, w->ll); break;
+    case ATTR_DBL: ret = iio_attr_write_double(attr, w->d); break;
+    default:       ret = iio_attr_write_string(attr, w->s.c_str()); break;
+    }
+    c->stats.writes++;
+    if (ret < 0) {
+        // драйвер мог округлить или частично применить - значение неизвестно
+        c->known[w->attr] = false;
+        fprintf(stderr, "Unable to write %s: %s\n", d->name, strerror(-ret));
+        return ret;
+    }
+    c->known[w->attr] = !d->trigger;
+    c->ll[w->attr] = w->ll;
+    c->d[w->attr] = w->d;
+    if (d->type == ATTR_STR)
+        c->s[w->attr] = w->s;
+    return 0;
+}
+
+int sdr_ctrl_commit(struct sdr_ctrl *c)
+{
+    int ret = 0;
+    for (size_t k = 0; k < c->queued; k++) {
+        int r = write_one(c, &c->queue[k]);
+        if (r < 0 && ret == 0)
+            ret = r;
+    }
+    c->queued = 0;
+    return ret;
+}
+
+int sdr_ctrl_configure(struct sdr_ctrl *c, const struct stream_cfg *rx, const struct stream_cfg *tx)
+{
+    if (tx) {
+        printf("* Настройка параметров %s канала AD9361 \n", "TX");
+        sdr_ctrl_set_str(c, CTRL_TX_PORT, tx->rfport);
+        sdr_ctrl_set(c, CTRL_TX_BW, tx->bw_hz);
+        sdr_ctrl_set(c, CTRL_TX_FS, tx->fs_hz);
+        sdr_ctrl_set(c, CTRL_TX_LO, tx->lo_hz);
+    }
+    if (rx) {
+        printf("* Настройка параметров %s канала AD9361 \n", "RX");
+        sdr_ctrl_set_str(c, CTRL_RX_PORT, rx->rfport);
+        sdr_ctrl_set(c, CTRL_RX_BW, rx->bw_hz);
+        sdr_ctrl_set(c, CTRL_RX_FS, rx->fs_hz);
+        sdr_ctrl_set(c, CTRL_RX_LO, rx->lo_hz);
+    }
+    return sdr_ctrl_commit(c) < 0 ? -EIO : 0;
+}
+
+static void account_retune(struct sdr_ctrl *c, int64_t t0, bool recall)
+{
+    int64_t dt = monotonic_ns() - t0;
+    c->stats.retunes++;
+    c->stats.recalls += recall;
+    c->stats.retune_ns_last = dt;
+    c->stats.retune_ns_sum += dt;
+    if (dt > c->stats.retune_ns_max)
+        c->stats.retune_ns_max = dt;
+}
+
+int sdr_ctrl_retune(struct sdr_ctrl *c, bool tx, long long hz)
+{
+    int64_t t0 = monotonic_ns();
+    struct sdr_ctrl_write w;
+    w.attr = lo_attr(tx);
+    w.ll = hz;
+    int ret = write_one(c, &w);
+    if (ret == 0)
+        account_retune(c, t0, false);
+    return ret;
+}
+
+int sdr_ctrl_fastlock_store(struct sdr_ctrl *c, bool tx, unsigned slot, long long hz)
+{
+    if (slot >= SDR_FASTLOCK_SLOTS)
+        return -EINVAL;
+    struct sdr_ctrl_write w;
+    w.attr = lo_attr(tx);
+    w.ll = hz;
+    int ret = write_one(c, &w);
+    if (ret < 0)
+        return ret;
+    w.attr = lo_attr(tx) + FL_STORE;
+    w.ll = slot;
+    return write_one(c, &w);
+}
+
+static int recall_slot(struct sdr_ctrl *c, bool tx, unsigned slot, long long hz)
+{
+    struct sdr_ctrl_write w;
+    w.attr = lo_attr(tx) + FL_RECALL;
+    w.ll = slot;
+    int ret = write_one(c, &w);
+    if (ret < 0)
+        return ret;
+    // frequency теперь равна частоте слота, повторная запись её не нужна
+    c->known[lo_attr(tx)] = true;
+    c->ll[lo_attr(tx)] = hz;
+    return 0;
+}
+
+int sdr_ctrl_fastlock_recall(struct sdr_ctrl *c, bool tx, unsigned slot, long long hz)
+{
+    if (slot >= SDR_FASTLOCK_SLOTS)
+        return -EINVAL;
+    int64_t t0 = monotonic_ns();
+    int ret = recall_slot(c, tx, slot, hz);
+    if (ret == 0)
+        account_retune(c, t0, true);
+    return ret;
+}
+
+int sdr_ctrl_fastlock_save(struct sdr_ctrl *c, bool tx, unsigned slot, std::string &profile)
+{
+    if (slot >= SDR_FASTLOCK_SLOTS)
+        return -EINVAL;
+    struct sdr_ctrl_write w;
+    w.attr = lo_attr(tx) + FL_SAVE;
+    w.ll = slot;
+    int ret = write_one(c, &w);
+    if (ret < 0)
+        return ret;
+
+    // "slot v0,v1,...,v15"
+    char buf[256];
+    ssize_t n = iio_attr_read_raw(c->attr[w.attr], buf, sizeof(buf));
+    if (n < 0)
+        return (int)n;
+    buf[sizeof(buf) - 1] = '\0';
+    char *end;
+    unsigned long got = strtoul(buf, &end, 10);
+    if (end == buf || *end != ' ' || got != slot)
+        return -EIO;
+    profile = end + 1;
+    while (!profile.empty() && (profile.back() == '\n' || profile.back() == ' '))
+        profile.pop_back();
+    return profile.empty() ? -EIO : 0;
+}
+
+int sdr_ctrl_fastlock_load(struct sdr_ctrl *c, bool tx, unsigned slot, const std::string &profile)
+{
+    if (slot >= SDR_FASTLOCK_SLOTS)
+        return -EINVAL;
+    struct sdr_ctrl_write w;
+    w.attr = lo_attr(tx) + FL_LOAD;
+    w.s = std::to_string(slot) + " " + profile;
+    return write_one(c, &w);
+}
+
+int sdr_lo_table_build(struct sdr_ctrl *c, struct sdr_lo_table *t, bool tx, const long long *freq_hz, size_t n)
+{
+    t->tx = tx;
+    t->freq_hz.assign(freq_hz, freq_hz + n);
+    t->profile.assign(n, std::string());
+    t->tick = 0;
+    for (int k = 0; k < SDR_FASTLOCK_SLOTS; k++) {
+        t->slot_of[k] = -1;
+        t->slot_used[k] = 0;
+    }
+
+    // калибровка через слот 0, профили - на хост
+    for (size_t k = 0; k < n; k++) {
+        int ret = sdr_ctrl_fastlock_store(c, tx, 0, freq_hz[k]);
+        if (ret == 0)
+            ret = sdr_ctrl_fastlock_save(c, tx, 0, t->profile[k]);
+        if (ret < 0) {
+            fprintf(stderr, "Unable to profile LO at %lld Hz: %s\n", freq_hz[k], strerror(-ret));
+            return ret;
+        }
+    }
+    // в слоте 0 осталась последняя частота
+    if (n > 0) {
+        t->slot_of[0] = (int)(n - 1);
+        t->slot_used[0] = ++t->tick;
+    }
+    return 0;
+}
+
+int sdr_lo_table_hop(struct sdr_ctrl *c, struct sdr_lo_table *t, size_t idx)
+{
+    if (idx >= t->freq_hz.size())
+        return -EINVAL;
+    int64_t t0 = monotonic_ns();
+
+    int slot = -1, lru = 0;
+    for (int k = 0; k < SDR_FASTLOCK_SLOTS; k++) {
+        if (t->slot_of[k] == (int)idx)
+            slot = k;
+        if (t->slot_used[k] < t->slot_used[lru])
+            lru = k;
+    }
+    int ret;
+    if (slot < 0) {
+        slot = lru;
+        t->slot_of[slot] = -1;
+        ret = sdr_ctrl_fastlock_load(c, t->tx, slot, t->profile[idx]);
+        if (ret < 0)
+            return ret;
+        t->slot_of[slot] = (int)idx;
+        c->stats.loads++;
+    }
+    t->slot_used[slot] = ++t->tick;
+
+    // в статистике - весь прыжок, вместе с подгрузкой
+    ret = recall_slot(c, t->tx, slot, t->freq_hz[idx]);
+    if (ret == 0)
+        account_retune(c, t0, true);
+    return ret;
+}
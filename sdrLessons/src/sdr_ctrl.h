@@ -0,0 +1,141 @@
+#ifndef SDR_CTRL_H
+#define SDR_CTRL_H
+
+#include <iio/iio.h>
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+/*
+ * Плоскость управления ad9361-phy для быстрой перестройки.
+ *
+ * Все атрибуты (docs/iio_info.txt) ищутся один раз в sdr_ctrl_init(), дальше
+ * запись - только iio_attr_write_* по готовому указателю, без
+ * iio_device_find_channel / iio_channel_find_attr на каждый вызов.
+ *
+ * Пакет: sdr_ctrl_set*() только ставят запись в очередь (повтор того же
+ * атрибута заменяет значение), sdr_ctrl_commit() пишет очередь по порядку
+ * постановки и пропускает значения, уже записанные раньше, - по сети
+ * уходят только реально изменившиеся атрибуты.
+ *
+ * Fastlock AD9361: 8 профилей синтезатора в самом чипе на RX и TX LO.
+ * fastlock_recall переключает LO за одну запись без калибровки VCO.
+ * Для прыжков по большему числу частот таблица профилей хранится на хосте
+ * (fastlock_save) и подгружается в свободный слот (fastlock_load) по LRU.
+ */
+
+struct stream_cfg;
+
+enum sdr_ctrl_attr {
+    CTRL_RX_PORT = 0,
+    CTRL_RX_BW,
+    CTRL_RX_FS,
+    CTRL_RX_GAIN_MODE,
+    CTRL_RX_GAIN,
+    CTRL_TX_PORT,
+    CTRL_TX_BW,
+    CTRL_TX_FS,
+    CTRL_TX_GAIN,
+    CTRL_RX_LO,
+    CTRL_RX_FL_STORE,
+    CTRL_RX_FL_RECALL,
+    CTRL_RX_FL_SAVE,
+    CTRL_RX_FL_LOAD,
+    CTRL_TX_LO,
+    CTRL_TX_FL_STORE,
+    CTRL_TX_FL_RECALL,
+    CTRL_TX_FL_SAVE,
+    CTRL_TX_FL_LOAD,
+    CTRL_ENSM_MODE,
+    CTRL_ATTR_COUNT
+};
+
+#define SDR_FASTLOCK_SLOTS  8
+#define SDR_CTRL_QUEUE      CTRL_ATTR_COUNT
+
+struct sdr_ctrl_write {
+    int attr;
+    long long ll;
+    double d;
+    std::string s;
+};
+
+/* Таблица LO на хосте: профиль fastlock на каждую частоту */
+struct sdr_lo_table {
+    bool tx;
+    std::vector<long long> freq_hz;
+    std::vector<std::string> profile;   // значения fastlock_save без номера слота
+    int slot_of[SDR_FASTLOCK_SLOTS];    // какая запись таблицы лежит в слоте, -1 - никакая
+    unsigned long long slot_used[SDR_FASTLOCK_SLOTS];
+    unsigned long long tick;
+};
+
+struct sdr_ctrl_stats {
+    unsigned long long writes;      // реальных записей атрибутов
+    unsigned long long skipped;     // пропущено: значение не изменилось
+    unsigned long long retunes;
+    unsigned long long recalls;     // из них через fastlock_recall
+    unsigned long long loads;       // подгрузок профиля в слот
+    int64_t retune_ns_last, retune_ns_max, retune_ns_sum;
+};
+
+struct sdr_ctrl {
+    struct iio_device *phy;
+    const struct iio_attr *attr[CTRL_ATTR_COUNT];
+
+    /* последнее записанное значение */
+    bool known[CTRL_ATTR_COUNT];
+    long long ll[CTRL_ATTR_COUNT];
+    double d[CTRL_ATTR_COUNT];
+    std::string s[CTRL_ATTR_COUNT];
+
+    struct sdr_ctrl_write queue[SDR_CTRL_QUEUE];
+    size_t queued;
+
+    struct sdr_ctrl_stats stats;
+};
+
+/* Найти все атрибуты ad9361-phy; отсутствующие - NULL (запись вернёт -ENOENT) */
+int sdr_ctrl_init(struct sdr_ctrl *c, struct iio_device *phy);
+
+/* В очередь */
+int sdr_ctrl_set(struct sdr_ctrl *c, int attr, long long val);
+int sdr_ctrl_set_double(struct sdr_ctrl *c, int attr, double val);
+int sdr_ctrl_set_str(struct sdr_ctrl *c, int attr, const char *val);
+
+/* Записать очередь. 0 или первая ошибка (остальные записи всё равно делаются) */
+int sdr_ctrl_commit(struct sdr_ctrl *c);
+
+/* Забыть записанные значения (после внешней перенастройки чипа) */
+void sdr_ctrl_invalidate(struct sdr_ctrl *c);
+
+/* Порт, полоса, частота дискретизации и LO одним пакетом (rx/tx могут быть NULL) */
+int sdr_ctrl_configure(struct sdr_ctrl *c, const struct stream_cfg *rx, const struct stream_cfg *tx);
+
+/*
+ * Перестройка LO (RX или TX): запись frequency по готовому атрибуту.
+ * Время записи - в stats. 0 или ошибка.
+ */
+int sdr_ctrl_retune(struct sdr_ctrl *c, bool tx, long long hz);
+
+/* Fastlock: настроить LO на hz и запомнить в слот чипа */
+int sdr_ctrl_fastlock_store(struct sdr_ctrl *c, bool tx, unsigned slot, long long hz);
+/* Переключиться на слот (одна запись), hz - частота слота для кэша и статистики */
+int sdr_ctrl_fastlock_recall(struct sdr_ctrl *c, bool tx, unsigned slot, long long hz);
+/* Профиль слота чипа -> строка "v0,v1,..." и обратно */
+int sdr_ctrl_fastlock_save(struct sdr_ctrl *c, bool tx, unsigned slot, std::string &profile);
+int sdr_ctrl_fastlock_load(struct sdr_ctrl *c, bool tx, unsigned slot, const std::string &profile);
+
+/*
+ * Таблица LO: для каждой частоты чип калибруется один раз (store + save),
+ * профили остаются на хосте. Медленно - вызывать до прыжков.
+ */
+int sdr_lo_table_build(struct sdr_ctrl *c, struct sdr_lo_table *t, bool tx, const long long *freq_hz, size_t n);
+
+/* Прыжок на запись idx таблицы: recall, если профиль уже в слоте, иначе load + recall */
+int sdr_lo_table_hop(struct sdr_ctrl *c, struct sdr_lo_table *t, size_t idx);
+
+#endif // SDR_CTRL_H
@@ -0,0 +1,509 @@
+#include "sdr_stream.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "stream_geometry.h"
+
+#define DMA_STATUS_REG      0x80000088
+#define DMA_RX_OVERFLOW     (1u << 2)
+#define DMA_TX_UNDERFLOW    (1u << 0)
+
+#define MAX_ERRORS_IN_ROW   100         // ~12 с пауз, дальше поток останавливается
+
+static int64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void sdr_stream_default_cfg(struct sdr_stream_cfg *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->uri = "ip:192.168.2.1";
+
+    cfg->rx.bw_hz = MHZ(10);
+    cfg->rx.fs_hz = MHZ(10);
+    cfg->rx.lo_hz = MHZ(1000);
+    cfg->rx.rfport = "A_BALANCED";
+
+    cfg->tx.bw_hz = MHZ(10);
+    cfg->tx.fs_hz = MHZ(10);
+    cfg->tx.lo_hz = MHZ(1000);
+    cfg->tx.rfport = "A";
+
+    cfg->enable_rx = true;
+    cfg->enable_tx = true;
+    cfg->block_size = 1 << 13;
+    cfg->block_count = 4;
+    cfg->ring_slots = 64;
+    cfg->bus_slots = 64;
+    cfg->clock_model = true;
+    cfg->lock_memory = true;
+    cfg->geometry_profile = stream_geometry_default_path();
+
+    // RX и TX - на изолированные ядра, если они есть
+    std::vector<int> iso;
+    rt_isolated_cpus(iso);
+    cfg->rx_thread.name = "sdr-rx";
+    cfg->rx_thread.cpu = iso.size() > 0 ? iso[0] : -1;
+    cfg->rx_thread.priority = 80;
+    cfg->tx_thread.name = "sdr-tx";
+    cfg->tx_thread.cpu = iso.size() > 1 ? iso[1] : cfg->rx_thread.cpu;
+    cfg->tx_thread.priority = 80;
+}
+
+int sdr_phy_configure(struct iio_device *phy_dev, const struct stream_cfg *rxcfg,
+                      const struct stream_cfg *txcfg)
+{
+    struct sdr_ctrl ctrl;
+    if (sdr_ctrl_init(&ctrl, phy_dev) < 0)
+        return -ENODEV;
+    return sdr_ctrl_configure(&ctrl, rxcfg, txcfg);
+}
+
+int sdr_stream_open(struct sdr_stream *s, const struct sdr_stream_cfg *cfg)
+{
+    int ret;
+
+    s->cfg = *cfg;
+    struct stream_geometry geo;
+    if (cfg->geometry_profile && stream_geometry_load(cfg->geometry_profile, cfg->rx.fs_hz, &geo) == 0) {
+        printf("* Geometry from %s: block %zu x %zu\n", cfg->geometry_profile, geo.block_size, geo.block_count);
+        s->cfg.block_size = geo.block_size;
+        s->cfg.block_count = geo.block_count;
+    }
+    cfg = &s->cfg;
+    s->ctx = NULL;
+    s->rxmask = s->txmask = NULL;
+    s->rxbuf = s->txbuf = NULL;
+    s->rxstream = s->txstream = NULL;
+    s->ring.info = NULL;
+    s->ring.efd = -1;
+    s->bus.map = NULL;
+    s->rx_running = s->tx_running = false;
+    s->stop.store(false);
+    s->tx_cb = NULL;
+    s->tx_user = NULL;
+    pthread_mutex_init(&s->tx_cyclic_lock, NULL);
+    s->tx_cyclic_block = NULL;
+    s->tx_cyclic_len = 0;
+    s->tx_cyclic_swaps = 0;
+    s->rx_samples.store(0);
+    s->tx_samples.store(0);
+    s->rx_errors.store(0);
+    s->tx_errors.store(0);
+    s->failed.store(0);
+
+    // модели есть всегда - sdr_stream_rx_time() и т.п. безопасны и без cfg.clock_model
+    struct clock_model_cfg ccfg;
+    clock_model_default_cfg(&ccfg, (double)cfg->rx.fs_hz);
+    clock_model_init(&s->rx_clock, &ccfg);
+    clock_model_default_cfg(&ccfg, (double)cfg->tx.fs_hz);
+    clock_model_init(&s->tx_clock, &ccfg);
+
+    s->ctx = iio_create_context(NULL, cfg->uri);
+    if (!s->ctx) {
+        fprintf(stderr, "Unable to create IIO context addr: %s\n", cfg->uri);
+        return -ENODEV;
+    }
+
+    s->tx_dev = iio_context_find_device(s->ctx, "cf-ad9361-dds-core-lpc");
+    s->rx_dev = iio_context_find_device(s->ctx, "cf-ad9361-lpc");
+    s->phy_dev = iio_context_find_device(s->ctx, "ad9361-phy");
+    if (!s->tx_dev || !s->rx_dev || !s->phy_dev) {
+        fprintf(stderr, "Unable to find AD9361 devices\n");
+        sdr_stream_close(s);
+        return -ENODEV;
+    }
+
+    // атрибуты ищутся один раз, дальше перестройка - через s->ctrl
+    ret = sdr_ctrl_init(&s->ctrl, s->phy_dev);
+    if (ret == 0)
+        ret = sdr_ctrl_configure(&s->ctrl, cfg->enable_rx ? &cfg->rx : NULL,
+                                 cfg->enable_tx ? &cfg->tx : NULL);
+    if (ret < 0) {
+        sdr_stream_close(s);
+        return ret;
+    }
+
+    s->tx0_i = iio_device_find_channel(s->tx_dev, "voltage0", true);
+    s->tx0_q = iio_device_find_channel(s->tx_dev, "voltage1", true);
+    s->rx0_i = iio_device_find_channel(s->rx_dev, "voltage0", false);
+    s->rx0_q = iio_device_find_channel(s->rx_dev, "voltage1", false);
+
+    if (cfg->enable_rx) {
+        s->rxmask = iio_create_channels_mask(iio_device_get_channels_count(s->rx_dev));
+        if (!s->rxmask) {
+            fprintf(stderr, "Unable to alloc RX channels mask\n");
+            sdr_stream_close(s);
+            return -ENOMEM;
+        }
+        iio_channel_enable(s->rx0_i, s->rxmask);
+        iio_channel_enable(s->rx0_q, s->rxmask);
+        s->rx_sample_sz = iio_device_get_sample_size(s->rx_dev, s->rxmask);
+
+        s->rxbuf = iio_device_create_buffer(s->rx_dev, 0, s->rxmask);
+        ret = iio_err(s->rxbuf);
+        if (ret) {
+            s->rxbuf = NULL;
+            fprintf(stderr, "Unable to create RX buffer: %s\n", strerror(-ret));
+            sdr_stream_close(s);
+            return ret;
+        }
+
+        // кольцо для DSP - на NUMA узле RX потока
+        ret = iq_ring_init(&s->ring, cfg->ring_slots, cfg->block_size, cfg->rx_thread.cpu);
+        if (ret < 0) {
+            sdr_stream_close(s);
+            return ret;
+        }
+        if (cfg->bus_name) {
+            ret = iq_bus_create(&s->bus, cfg->bus_name, cfg->bus_slots, cfg->block_size, (double)cfg->rx.fs_hz);
+            if (ret < 0) {
+                sdr_stream_close(s);
+                return ret;
+            }
+            printf("* IQ bus %s: %zu slots\n", cfg->bus_name, cfg->bus_slots);
+        }
+        if (cfg->rx_correct) {
+            struct iq_correct_cfg ccfg;
+            iq_correct_default_cfg(&ccfg);
+            iq_correct_init(&s->rx_corr, &ccfg);
+            s->rx_fix.assign(2 * cfg->block_size, 0);
+        }
+    }
+
+    if (cfg->enable_tx) {
+        s->txmask = iio_create_channels_mask(iio_device_get_channels_count(s->tx_dev));
+        if (!s->txmask) {
+            fprintf(stderr, "Unable to alloc TX channels mask\n");
+            sdr_stream_close(s);
+            return -ENOMEM;
+        }
+        iio_channel_enable(s->tx0_i, s->txmask);
+        iio_channel_enable(s->tx0_q, s->txmask);
+        s->tx_sample_sz = iio_device_get_sample_size(s->tx_dev, s->txmask);
+
+        s->txbuf = iio_device_create_buffer(s->tx_dev, 0, s->txmask);
+        ret = iio_err(s->txbuf);
+        if (ret) {
+            s->txbuf = NULL;
+            fprintf(stderr, "Unable to create TX buffer: %s\n", strerror(-ret));
+            sdr_stream_close(s);
+            return ret;
+        }
+    }
+
+    printf("* Streaming engine: %s, block %zu x %zu, fs = %lld\n", cfg->uri,
+           cfg->block_size, cfg->block_count, cfg->rx.fs_hz);
+    return 0;
+}
+
+/*
+ * Ошибка IIO в потоке RX/TX: SCHED_FIFO поток без паузы занял бы ядро
+ * целиком, поэтому пауза растёт 2 мс .. 128 мс; MAX_ERRORS_IN_ROW подряд -
+ * поток останавливает движок. true - выходить из цикла.
+ */
+static bool stream_error(struct sdr_stream *s, const char *dir, int err, unsigned *in_row)
+{
+    if (s->stop.load() || err == -EBADF)
+        return true;
+    if (++*in_row >= MAX_ERRORS_IN_ROW) {
+        fprintf(stderr, "%s stream: %u errors in a row, last: %s; stopping\n", dir, *in_row, strerror(-err));
+        s->failed.store(err);
+        s->stop.store(true);
+        rt_shutdown_request();
+        return true;
+    }
+    usleep(1000u << (*in_row < 7 ? *in_row : 7));
+    return false;
+}
+
+static void *rx_thread_fn(void *arg)
+{
+    struct sdr_stream *s = static_cast<struct sdr_stream *>(arg);
+    long long index = 0;
+    unsigned in_row = 0;
+
+    rt_thread_apply(&s->cfg.rx_thread);
+
+    while (!s->stop.load(std::memory_order_relaxed) && !rt_shutdown_requested()) {
+        const struct iio_block *rxblock = iio_stream_get_next_block(s->rxstream);
+        int err = iio_err(rxblock);
+        if (err) {
+            s->rx_errors.fetch_add(1);
+            if (stream_error(s, "RX", err, &in_row))
+                break;
+            continue;
+        }
+        in_row = 0;
+
+        int16_t *p_dat = static_cast<int16_t *>(iio_block_first(rxblock, s->rx0_i));
+        int16_t *p_end = static_cast<int16_t *>(iio_block_end(rxblock));
+        size_t n = (p_end - p_dat) / (s->rx_sample_sz / sizeof(*p_dat));
+
+        // переполнение кольца считается внутри iq_ring_push
+        int64_t host_ns = monotonic_ns(), sample_ns = 0;
+        if (s->cfg.clock_model) {
+            clock_model_update(&s->rx_clock, index + (long long)n, host_ns);
+            sample_ns = clock_model_host_ns(&s->rx_clock, index);
+        }
+        if (s->cfg.rx_correct) {
+            if (n > s->cfg.block_size)
+                n = s->cfg.block_size;
+            iq_correct_process_iq16(&s->rx_corr, p_dat, s->rx_fix.data(), n);
+            p_dat = s->rx_fix.data();
+        }
+        iq_ring_push(&s->ring, p_dat, n, index, host_ns, sample_ns);
+        if (s->bus.map)
+            iq_bus_publish(&s->bus, p_dat, n, index, host_ns, sample_ns);
+        index += n;
+        s->rx_samples.store(index, std::memory_order_relaxed);
+    }
+    return NULL;
+}
+
+static void *tx_thread_fn(void *arg)
+{
+    struct sdr_stream *s = static_cast<struct sdr_stream *>(arg);
+    long long index = 0;
+    unsigned in_row = 0;
+
+    rt_thread_apply(&s->cfg.tx_thread);
+
+    while (!s->stop.load(std::memory_order_relaxed) && !rt_shutdown_requested()) {
+        const struct iio_block *txblock = iio_stream_get_next_block(s->txstream);
+        int err = iio_err(txblock);
+        if (err) {
+            s->tx_errors.fetch_add(1);
+            if (stream_error(s, "TX", err, &in_row))
+                break;
+            continue;
+        }
+        in_row = 0;
+
+        int16_t *p_dat = static_cast<int16_t *>(iio_block_first(txblock, s->tx0_i));
+        int16_t *p_end = static_cast<int16_t *>(iio_block_end(txblock));
+        size_t n = (p_end - p_dat) / (s->tx_sample_sz / sizeof(*p_dat));
+
+        // первые block_count блоков свободны сразу; дальше блок освобождается,
+        // когда DMA доиграл его прошлое содержимое - сейчас уходит сэмпл
+        // index - (block_count - 1) * n
+        long long depth = (long long)(s->cfg.block_count - 1) * (long long)n;
+        if (s->cfg.clock_model && index >= depth + (long long)n)
+            clock_model_update(&s->tx_clock, index - depth, monotonic_ns());
+
+        if (s->tx_cb)
+            s->tx_cb(p_dat, n, index, s->tx_user);
+        else
+            memset(p_dat, 0, n * s->tx_sample_sz);
+        index += n;
+        s->tx_samples.store(index, std::memory_order_relaxed);
+    }
+    return NULL;
+}
+
+int sdr_stream_start(struct sdr_stream *s, sdr_tx_fill_cb tx_cb, void *tx_user)
+{
+    int ret;
+
+    s->tx_cb = tx_cb;
+    s->tx_user = tx_user;
+    s->stop.store(false);
+    s->failed.store(0);
+    // блоки IIO (создаются ниже), стеки и кольцо - без page fault в RT потоках
+    if (s->cfg.lock_memory)
+        rt_lock_all_memory();
+    // номера сэмплов в потоках начинаются с нуля
+    clock_model_reset(&s->rx_clock);
+    clock_model_reset(&s->tx_clock);
+
+    if (s->rxbuf) {
+        s->rxstream = iio_buffer_create_stream(s->rxbuf, s->cfg.block_count, s->cfg.block_size);
+        ret = iio_err(s->rxstream);
+        if (ret) {
+            s->rxstream = NULL;
+            fprintf(stderr, "Unable to create RX stream: %s\n", strerror(-ret));
+            return ret;
+        }
+        ret = pthread_create(&s->rx_tid, NULL, rx_thread_fn, s);
+        if (ret) {
+            sdr_stream_stop(s);
+            return -ret;
+        }
+        s->rx_running = true;
+    }
+
+    if (s->txbuf && !s->tx_cyclic_block) {
+        s->txstream = iio_buffer_create_stream(s->txbuf, s->cfg.block_count, s->cfg.block_size);
+        ret = iio_err(s->txstream);
+        if (ret) {
+            s->txstream = NULL;
+            fprintf(stderr, "Unable to create TX stream: %s\n", strerror(-ret));
+            sdr_stream_stop(s);
+            return ret;
+        }
+        ret = pthread_create(&s->tx_tid, NULL, tx_thread_fn, s);
+        if (ret) {
+            sdr_stream_stop(s);
+            return -ret;
+        }
+        s->tx_running = true;
+    }
+    return 0;
+}
+
+int sdr_stream_dma_status(struct sdr_stream *s, bool *rx_overflow, bool *tx_underflow)
+{
+    uint32_t val;
+    int ret;
+
+    *rx_overflow = *tx_underflow = false;
+    if (s->rxbuf) {
+        ret = iio_device_reg_read(s->rx_dev, DMA_STATUS_REG, &val);
+        if (ret < 0)
+            return ret;
+        *rx_overflow = (val & DMA_RX_OVERFLOW) != 0;
+        iio_device_reg_write(s->rx_dev, DMA_STATUS_REG, val);     // сброс записью единиц
+    }
+    if (s->txbuf) {
+        ret = iio_device_reg_read(s->tx_dev, DMA_STATUS_REG, &val);
+        if (ret < 0)
+            return ret;
+        *tx_underflow = (val & DMA_TX_UNDERFLOW) != 0;
+        iio_device_reg_write(s->tx_dev, DMA_STATUS_REG, val);
+    }
+    return 0;
+}
+
+static void print_clock(const char *name, const struct clock_model *cm)
+{
+    if (cm->valid.load())
+        printf("* %s clock: %+.2f ppm, jitter %.1f us, %zu/%zu points, %llu/%llu fits rejected\n", name,
+               cm->ppm, cm->jitter_ns * 1e-3, cm->inliers, cm->count,
+               (unsigned long long)cm->rejected, (unsigned long long)cm->fits);
+}
+
+void sdr_stream_stop(struct sdr_stream *s)
+{
+    s->stop.store(true);
+
+    // разбудить потоки, висящие в iio_stream_get_next_block()
+    if (s->rxbuf && s->rx_running)
+        iio_buffer_cancel(s->rxbuf);
+    if (s->txbuf && s->tx_running)
+        iio_buffer_cancel(s->txbuf);
+
+    if (s->rx_running) {
+        pthread_join(s->rx_tid, NULL);
+        s->rx_running = false;
+    }
+    if (s->tx_running) {
+        pthread_join(s->tx_tid, NULL);
+        s->tx_running = false;
+    }
+
+    // потоки IIO - на один запуск: повторный sdr_stream_start() создаёт новые,
+    // циклический TX снова доступен
+    if (s->rxstream) {
+        iio_stream_destroy(s->rxstream);
+        s->rxstream = NULL;
+    }
+    if (s->txstream) {
+        iio_stream_destroy(s->txstream);
+        s->txstream = NULL;
+    }
+
+    printf("* Stream stopped: rx = %lld, tx = %lld samples, overflows = %llu\n",
+           s->rx_samples.load(), s->tx_samples.load(),
+           (unsigned long long)(s->ring.info ? s->ring.overflows.load() : 0));
+    if (s->cfg.rx_correct && s->rx_corr.primed)
+        printf("* RX correction: DC %.1f / %.1f, I/Q %.2f dB, %.2f deg%s\n", s->rx_corr.dc_i, s->rx_corr.dc_q,
+               s->rx_corr.gain_db, s->rx_corr.phase_deg, s->rx_corr.iq_valid ? "" : " (not applied)");
+    if (s->cfg.clock_model) {
+        print_clock("RX", &s->rx_clock);
+        print_clock("TX", &s->tx_clock);
+    }
+}
+
+int sdr_stream_tx_cyclic(struct sdr_stream *s, const int16_t *iq, size_t n)
+{
+    int ret;
+
+    if (!s->txbuf)
+        return -ENODEV;
+    if (s->tx_running || s->txstream)
+        return -EBUSY;
+    if (n == 0)
+        return -EINVAL;
+
+    // новый блок заполняем, пока старый ещё крутится
+    struct iio_block *block = iio_buffer_create_block(s->txbuf, n * s->tx_sample_sz);
+    ret = iio_err(block);
+    if (ret) {
+        fprintf(stderr, "Unable to create cyclic TX block: %s\n", strerror(-ret));
+        return ret;
+    }
+    int16_t *p_dat = static_cast<int16_t *>(iio_block_first(block, s->tx0_i));
+    memcpy(p_dat, iq, n * 2 * sizeof(int16_t));     // I/Q подряд: tx_sample_sz = 4
+
+    pthread_mutex_lock(&s->tx_cyclic_lock);
+    if (s->tx_cyclic_block) {
+        iio_buffer_disable(s->txbuf);
+        iio_block_destroy(s->tx_cyclic_block);
+        s->tx_cyclic_block = NULL;
+        s->tx_cyclic_swaps++;
+    }
+    ret = iio_block_enqueue(block, 0, true);
+    if (!ret)
+        ret = iio_buffer_enable(s->txbuf);
+    if (ret) {
+        fprintf(stderr, "Unable to start cyclic TX: %s\n", strerror(-ret));
+        iio_buffer_disable(s->txbuf);
+        iio_block_destroy(block);
+    } else {
+        s->tx_cyclic_block = block;
+        s->tx_cyclic_len = n;
+    }
+    pthread_mutex_unlock(&s->tx_cyclic_lock);
+
+    if (!ret)
+        printf("* Cyclic TX: %zu samples (swap %u)\n", n, s->tx_cyclic_swaps);
+    return ret;
+}
+
+/* cleanup */
+void sdr_stream_close(struct sdr_stream *s)
+{
+    if (s->tx_cyclic_block) {
+        iio_buffer_disable(s->txbuf);
+        iio_block_destroy(s->tx_cyclic_block);
+        s->tx_cyclic_block = NULL;
+    }
+
+	printf("* Destroying buffers\n");
+	if (s->rxbuf) { iio_buffer_destroy(s->rxbuf); }
+	if (s->txbuf) { iio_buffer_destroy(s->txbuf); }
+
+	printf("* Destroying channel masks\n");
+	if (s->rxmask) { iio_channels_mask_destroy(s->rxmask); }
+	if (s->txmask) { iio_channels_mask_destroy(s->txmask); }
+
+	printf("* Destroying context\n");
+	if (s->ctx) { iio_context_destroy(s->ctx); }
+
+    if (s->ring.info)
+        iq_ring_destroy(&s->ring);
+    iq_bus_close(&s->bus);
+
+    s->rxbuf = s->txbuf = NULL;
+    s->rxmask = s->txmask = NULL;
+    s->ctx = NULL;
+}
@@ -0,0 +1,189 @@
+#ifndef SDR_STREAM_H
+#define SDR_STREAM_H
+
+#include <iio/iio.h>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include <atomic>
+#include <vector>
+
+#include "rt_thread.h"
+#include "iq_ring.h"
+#include "iq_bus.h"
+#include "iq_correct.h"
+#include "clock_model.h"
+#include "sdr_ctrl.h"
+
+/* helper macros */
+#define MHZ(x) ((long long)(x*1000000.0 + .5))
+#define GHZ(x) ((long long)(x*1000000000.0 + .5))
+
+/* common RX and TX streaming params */
+struct stream_cfg {
+	long long bw_hz; // Analog banwidth in Hz
+	long long fs_hz; // Baseband sample rate in Hz
+	long long lo_hz; // Local oscillator frequency in Hz
+	const char* rfport; // Port name
+};
+
+/*
+ * Потоковый движок AD9361 (Pluto): то же, что делают примеры в tests/,
+ * но RX и TX крутятся в отдельных потоках реального времени.
+ *
+ *  RX поток: iio_stream_get_next_block() -> копия в iq_ring (mlock, NUMA) -> DSP
+ *  TX поток: tx_cb заполняет блок -> iio_stream_get_next_block()
+ *
+ * DSP читает кольцо из своего потока (sdr_stream_rx_wait / iq_ring_read_*).
+ * rx_correct - RX поток снимает DC и разбаланс I/Q (iq_correct.h) до кольца,
+ * DSP и шина получают уже исправленные блоки. Если задан bus_name, RX поток ещё публикует блоки в шину общей памяти
+ * (iq_bus.h) для других процессов - запись, спектр, второй демодулятор.
+ * clock_model - RX и TX потоки ведут модели "номер сэмпла -> CLOCK_MONOTONIC"
+ * (clock_model.h): у RX блоков есть info->sample_ns, TX планируется через
+ * sdr_stream_tx_index_at(). Без меток времени Soapy, одна подгонка на 50 мс.
+ * Остановка кооперативная: rt_shutdown_request() (например, из SIGINT)
+ * или sdr_stream_stop() из обычного контекста. Ошибки IIO потоки
+ * пережидают с растущей паузой; если они не проходят, движок
+ * останавливается сам (failed, rt_shutdown_request()).
+ *
+ * Циклический TX (маяки, тестовые тоны): sdr_stream_tx_cyclic() один раз
+ * загружает сигнал в циклический блок, дальше его повторяет DMA на Pluto -
+ * TX потока нет, по сети ничего не идёт. Повторный вызов меняет сигнал.
+ */
+
+/* Заполнить TX блок: n сэмплов interleaved I/Q, index - номер первого сэмпла */
+typedef void (*sdr_tx_fill_cb)(int16_t *iq, size_t n, long long index, void *user);
+
+struct sdr_stream_cfg {
+    const char *uri;            // "ip:192.168.2.1", "usb:" ...
+    struct stream_cfg rx;
+    struct stream_cfg tx;
+    bool enable_rx;
+    bool enable_tx;
+
+    size_t block_size;          // сэмплов в блоке IIO
+    size_t block_count;         // блоков в очереди IIO
+    size_t ring_slots;          // блоков в кольце RX -> DSP (степень двойки)
+    bool rx_correct;            // коррекция DC/разбаланса в RX потоке
+    bool clock_model;           // модели времени сэмплов RX/TX
+    bool lock_memory;           // mlockall при start: блоки IIO и всё остальное без page fault
+    /* профиль stream_geometry.h: если есть запись для rx.fs_hz, она заменяет
+       block_size/block_count при открытии. NULL - не читать */
+    const char *geometry_profile;
+    /* шина для локальных процессов (iq_bus.h), NULL - без неё */
+    const char *bus_name;
+    size_t bus_slots;           // степень двойки
+
+    struct rt_thread_cfg rx_thread;
+    struct rt_thread_cfg tx_thread;
+};
+
+/*
+ * Значения по умолчанию: как в single_adalm_rxtx_costas.cpp, потоки RX/TX на
+ * изолированных ядрах, геометрия буферов - из профиля по умолчанию, если он есть
+ */
+void sdr_stream_default_cfg(struct sdr_stream_cfg *cfg);
+
+struct sdr_stream {
+    struct sdr_stream_cfg cfg;
+
+    struct iio_context *ctx;
+    struct iio_device *phy_dev, *rx_dev, *tx_dev;
+    struct iio_channel *rx0_i, *rx0_q, *tx0_i, *tx0_q;
+    struct iio_channels_mask *rxmask, *txmask;
+    struct iio_buffer *rxbuf, *txbuf;
+    struct iio_stream *rxstream, *txstream;
+    size_t rx_sample_sz, tx_sample_sz;
+
+    /* управление ad9361-phy: перестройка LO, fastlock (sdr_ctrl.h) */
+    struct sdr_ctrl ctrl;
+
+    struct iq_ring ring;
+    struct iq_bus bus;          // bus.map == NULL - шины нет
+
+    /* коррекция RX (cfg.rx_correct): состояние и блок после неё */
+    struct iq_correct rx_corr;
+    std::vector<int16_t> rx_fix;
+
+    /* модели времени сэмплов (cfg.clock_model); latency_ns - калибровка */
+    struct clock_model rx_clock, tx_clock;
+
+    pthread_t rx_tid, tx_tid;
+    bool rx_running, tx_running;
+    std::atomic<bool> stop;
+
+    sdr_tx_fill_cb tx_cb;
+    void *tx_user;
+
+    /* циклический TX */
+    pthread_mutex_t tx_cyclic_lock;
+    struct iio_block *tx_cyclic_block;
+    size_t tx_cyclic_len;               // сэмплов в блоке
+    unsigned tx_cyclic_swaps;
+
+    /* статистика */
+    std::atomic<long long> rx_samples;
+    std::atomic<long long> tx_samples;
+    std::atomic<long long> rx_errors;
+    std::atomic<long long> tx_errors;
+    std::atomic<int> failed;            // 0 или ошибка IIO, остановившая движок
+};
+
+int sdr_stream_open(struct sdr_stream *s, const struct sdr_stream_cfg *cfg);
+
+/*
+ * Запустить RX/TX потоки. tx_cb может быть NULL - тогда TX шлёт нули.
+ * Если уже загружен циклический TX, TX поток не создаётся.
+ */
+int sdr_stream_start(struct sdr_stream *s, sdr_tx_fill_cb tx_cb, void *tx_user);
+
+/*
+ * Циклический TX: iq - n сэмплов interleaved I/Q (целое число периодов).
+ * Новый блок заполняется заранее, затем буфер останавливается, старый блок
+ * заменяется новым и буфер запускается снова - разрыв на время
+ * disable/enqueue/enable, без мусора в эфире. Потокобезопасно.
+ * Нельзя вместе с потоковым TX: -EBUSY, если запущен TX поток.
+ */
+int sdr_stream_tx_cyclic(struct sdr_stream *s, const int16_t *iq, size_t n);
+
+/*
+ * Флаги DMA AD9361 (регистр статуса 0x80000088 ядер cf-ad9361, как в
+ * iio_rwdev): переполнение RX / опустошение TX с прошлого вызова.
+ * Флаги сбрасываются. 0 или ошибка чтения регистра.
+ */
+int sdr_stream_dma_status(struct sdr_stream *s, bool *rx_overflow, bool *tx_underflow);
+
+/* Остановить потоки и освободить потоки IIO (не из обработчика сигнала); можно снова start */
+void sdr_stream_stop(struct sdr_stream *s);
+
+/* Освободить буферы и контекст IIO; сначала sdr_stream_stop() */
+void sdr_stream_close(struct sdr_stream *s);
+
+/*
+ * Настройка ad9361-phy по rx/tx конфигам (порт, полоса, частота дискретизации, LO).
+ * Разовая: атрибуты ищутся на каждый вызов, для перестройки на ходу - sdr_ctrl.
+ */
+int sdr_phy_configure(struct iio_device *phy_dev, const struct stream_cfg *rxcfg,
+                      const struct stream_cfg *txcfg);
+
+/* Ждать RX блок для DSP: 1 - есть, 0 - таймаут или остановка */
+static inline int sdr_stream_rx_wait(struct sdr_stream *s, int timeout_ms)
+{
+    return iq_ring_wait(&s->ring, timeout_ms);
+}
+
+/* CLOCK_MONOTONIC RX сэмпла index (событие в потоке); 0 - модели ещё нет */
+static inline int64_t sdr_stream_rx_time(const struct sdr_stream *s, long long index)
+{
+    return clock_model_host_ns(&s->rx_clock, index);
+}
+
+/* Номер TX сэмпла, который уйдёт в эфир в host_ns (начало пачки); -1 - модели ещё нет */
+static inline long long sdr_stream_tx_index_at(const struct sdr_stream *s, int64_t host_ns)
+{
+    return clock_model_index(&s->tx_clock, host_ns);
+}
+
+#endif // SDR_STREAM_H
@@ -0,0 +1,172 @@
+#include "sdr_sweep.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+
+#define WAIT_MS     100
+
+void sdr_sweep_default_cfg(struct sdr_sweep_cfg *cfg)
+{
+    cfg->start_hz = MHZ(2400);
+    cfg->stop_hz = MHZ(2500);
+    cfg->usable = 0.75;
+    cfg->settle_us = 200.0;
+    cfg->dwell_frames = 16;
+    psd_default_cfg(&cfg->psd);
+    cfg->fastlock = false;
+    cfg->fix_dc = true;
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+int sdr_sweep_init(struct sdr_sweep *sw, struct sdr_stream *s, const struct sdr_sweep_cfg *cfg)
+{
+    if (!s->ring.info || cfg->stop_hz <= cfg->start_hz || cfg->usable <= 0.0 || cfg->usable > 1.0 ||
+        cfg->dwell_frames == 0)
+        return -EINVAL;
+
+    sw->s = s;
+    sw->cfg = *cfg;
+    sw->fs = (double)s->cfg.rx.fs_hz;
+    const size_t nfft = cfg->psd.nfft;
+    sw->bin_hz = sw->fs / nfft;
+    sw->keep = (size_t)(cfg->usable * nfft) & ~(size_t)1;
+    if (sw->keep < 2)
+        sw->keep = 2;
+    sw->dwell_samples = nfft + (cfg->dwell_frames - 1) * (nfft - cfg->psd.overlap);
+    sw->queue_ns = (int64_t)(s->cfg.block_count * s->cfg.block_size / sw->fs * 1e9);
+
+    // середина шага k - бин keep / 2, тогда бин панорамы i ровно start + i * bin
+    const double step_hz = sw->keep * sw->bin_hz;
+    size_t nsteps = (size_t)ceil((cfg->stop_hz - cfg->start_hz) / step_hz);
+    sw->centers.resize(nsteps);
+    for (size_t k = 0; k < nsteps; k++)
+        sw->centers[k] = cfg->start_hz + (long long)llround((k + 0.5) * step_hz);
+    sw->panorama.assign(nsteps * sw->keep, -200.0f);
+
+    for (int b = 0; b < 2; b++) {
+        int ret = psd_init(&sw->psd[b], &cfg->psd);
+        if (ret < 0)
+            return ret;
+        sw->dwell[b].reserve(sw->dwell_samples);
+        sw->spec[b].resize(nfft);
+    }
+    memset(&sw->stats, 0, sizeof(sw->stats));
+    work_pool_init(&sw->pool, 1);
+
+    printf("* Sweep %.3f .. %.3f MHz: %zu steps of %.3f MHz, bin %.1f kHz, dwell %zu samples\n",
+           cfg->start_hz / 1e6, cfg->stop_hz / 1e6, nsteps, step_hz / 1e6, sw->bin_hz / 1e3, sw->dwell_samples);
+
+    if (cfg->fastlock) {
+        printf("* Profiling %zu LO steps for fastlock\n", nsteps);
+        int ret = sdr_lo_table_build(&s->ctrl, &sw->table, false, sw->centers.data(), nsteps);
+        if (ret < 0) {
+            work_pool_destroy(&sw->pool);
+            return ret;
+        }
+    }
+    return 0;
+}
+
+void sdr_sweep_destroy(struct sdr_sweep *sw)
+{
+    work_pool_destroy(&sw->pool);
+}
+
+static int tune(struct sdr_sweep *sw, size_t k, int64_t *t_done)
+{
+    int64_t t0 = now_ns();
+    int ret = sw->cfg.fastlock ? sdr_lo_table_hop(&sw->s->ctrl, &sw->table, k)
+                               : sdr_ctrl_retune(&sw->s->ctrl, false, sw->centers[k]);
+    *t_done = now_ns();
+    sw->stats.retune_s += (*t_done - t0) * 1e-9;
+    return ret;
+}
+
+/* Собрать dwell из кольца, сэмплы раньше t_min отбросить */
+static int collect(struct sdr_sweep *sw, int64_t t_min, std::vector<cf_t> &buf)
+{
+    struct sdr_stream *s = sw->s;
+    buf.clear();
+    while (buf.size() < sw->dwell_samples) {
+        if (rt_shutdown_requested() || s->stop.load(std::memory_order_relaxed))
+            return -EINTR;
+        if (sdr_stream_rx_wait(s, WAIT_MS) <= 0)
+            continue;
+        const struct iq_block_info *info;
+        const int16_t *iq;
+        while (buf.size() < sw->dwell_samples && (iq = iq_ring_read_begin(&s->ring, &info)) != NULL) {
+            // сэмпл j снят около sample_ns + j / fs (модель часов), без неё - самая ранняя
+            // оценка host_ns - queue_ns - (n - j) / fs: блоки до перестройки ещё лежат в очереди IIO
+            double late_s = info->sample_ns ? (info->sample_ns - t_min) * 1e-9 + info->n / sw->fs
+                                            : (info->host_ns - sw->queue_ns - t_min) * 1e-9;
+            size_t j0 = info->n;
+            if (late_s > 0.0) {
+                double first = info->n - late_s * sw->fs;
+                j0 = first <= 0.0 ? 0 : (size_t)ceil(first);
+                if (j0 > info->n)
+                    j0 = info->n;
+            }
+            sw->stats.settle_dropped += j0;
+            size_t take = info->n - j0;
+            if (take > sw->dwell_samples - buf.size())
+                take = sw->dwell_samples - buf.size();
+            for (size_t j = j0; j < j0 + take; j++)
+                buf.push_back(cf_t(iq[2 * j] / 2048.0f, iq[2 * j + 1] / 2048.0f));
+            iq_ring_read_release(&s->ring);
+        }
+    }
+    return 0;
+}
+
+/* Спектр dwell шага k -> его кусок панорамы (в потоке пула) */
+static void spectrum_job(struct sdr_sweep *sw, int b, size_t k)
+{
+    struct psd *p = &sw->psd[b];
+    float *spec = sw->spec[b].data();
+    const size_t nfft = sw->cfg.psd.nfft;
+
+    psd_reset(p);
+    psd_process(p, sw->dwell[b].data(), sw->dwell[b].size());
+    psd_result_db(p, spec);
+    if (sw->cfg.fix_dc)
+        spec[nfft / 2] = 0.5f * (spec[nfft / 2 - 1] + spec[nfft / 2 + 1]);
+    memcpy(&sw->panorama[k * sw->keep], &spec[nfft / 2 - sw->keep / 2], sw->keep * sizeof(float));
+}
+
+int sdr_sweep_run(struct sdr_sweep *sw)
+{
+    const size_t nsteps = sw->centers.size();
+    const int64_t settle_ns = (int64_t)(sw->cfg.settle_us * 1e3);
+    const int64_t t_start = now_ns();
+    const uint64_t ovf0 = sw->s->ring.overflows.load();
+    sw->stats.retune_s = 0.0;
+    sw->stats.settle_dropped = 0;
+
+    int64_t t_done;
+    int ret = tune(sw, 0, &t_done);
+    for (size_t k = 0; k < nsteps && ret == 0; k++) {
+        const int b = k & 1;
+        ret = collect(sw, t_done + settle_ns, sw->dwell[b]);
+        if (ret < 0)
+            break;
+        // задача k - 1 читает другой буфер; дождаться её, чтобы пул не рос
+        work_pool_wait(&sw->pool);
+        work_pool_submit(&sw->pool, [sw, b, k]() { spectrum_job(sw, b, k); });
+        if (k + 1 < nsteps)
+            ret = tune(sw, k + 1, &t_done);
+    }
+    work_pool_wait(&sw->pool);
+
+    sw->stats.sweep_s = (now_ns() - t_start) * 1e-9;
+    sw->stats.ring_overflows = (long long)(sw->s->ring.overflows.load() - ovf0);
+    return ret;
+}
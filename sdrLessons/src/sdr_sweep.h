@@ -0,0 +1,84 @@
+#ifndef SDR_SWEEP_H
+#define SDR_SWEEP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "sdr_stream.h"
+#include "sdr_ctrl.h"
+#include "psd.h"
+#include "work_pool.h"
+
+/*
+ * Панорама шире полосы АЦП: RX LO шагает от start_hz до stop_hz через
+ * s->ctrl (sdr_ctrl_retune или прыжки fastlock по таблице sdr_lo_table),
+ * на каждом шаге копится dwell, спектр - psd, и из каждого шага в панораму
+ * берётся только середина usable * fs (края - спад фильтров AD9361).
+ *
+ * После перестройки сэмплы, снятые раньше retune + settle_us, выбрасываются
+ * (время сэмпла - по sample_ns блока из кольца движка, без модели часов -
+ * по host_ns минус вся очередь IIO: блок мог пролежать в ней до
+ * block_count * block_size / fs, так что граница сдвигается с запасом).
+ *
+ * Конвейер: как только dwell шага k собран, его БПФ уходит в поток
+ * work_pool, а этот поток сразу перестраивает LO на шаг k + 1 и ждёт
+ * установления. Хост не добавляет времени к шагу, пока БПФ dwell
+ * короче retune + settle + dwell.
+ */
+
+struct sdr_sweep_cfg {
+    long long start_hz, stop_hz;
+    double usable;              // доля fs, которая идёт в панораму
+    double settle_us;           // после перестройки
+    size_t dwell_frames;        // кадров psd на шаг
+    struct psd_cfg psd;
+    bool fastlock;              // таблица профилей LO вместо записи frequency
+    bool fix_dc;                // бин LO заменить средним соседей (утечка LO)
+};
+
+void sdr_sweep_default_cfg(struct sdr_sweep_cfg *cfg);
+
+struct sdr_sweep_stats {
+    double sweep_s;             // последний проход
+    double retune_s;            // из них в записи LO
+    long long settle_dropped;   // сэмплов выброшено на установление
+    long long ring_overflows;   // потери кольца за проход
+};
+
+struct sdr_sweep {
+    struct sdr_stream *s;
+    struct sdr_sweep_cfg cfg;
+    double fs, bin_hz;
+    size_t keep;                        // бинов с шага
+    size_t dwell_samples;
+    int64_t queue_ns;                   // глубина очереди IIO, для оценки без sample_ns
+    std::vector<long long> centers;
+    struct sdr_lo_table table;
+
+    /* двойной буфер: dwell собирается в один, БПФ идёт по другому */
+    std::vector<cf_t> dwell[2];
+    struct psd psd[2];
+    std::vector<float> spec[2];
+    struct work_pool pool;
+
+    std::vector<float> panorama;        // dB, бин k - start_hz + k * bin_hz
+    struct sdr_sweep_stats stats;
+};
+
+/*
+ * Поток s открыт с RX и запущен. Частоты шагов - по fs = s->cfg.rx.fs_hz.
+ * При fastlock профили всех шагов снимаются здесь (один раз, медленно).
+ */
+int sdr_sweep_init(struct sdr_sweep *sw, struct sdr_stream *s, const struct sdr_sweep_cfg *cfg);
+void sdr_sweep_destroy(struct sdr_sweep *sw);
+
+/* Один проход; результат в sw->panorama. 0, -EINTR по остановке или ошибка перестройки */
+int sdr_sweep_run(struct sdr_sweep *sw);
+
+static inline double sdr_sweep_bin_freq(const struct sdr_sweep *sw, size_t k)
+{
+    return (double)sw->cfg.start_hz + k * sw->bin_hz;
+}
+
+#endif // SDR_SWEEP_H
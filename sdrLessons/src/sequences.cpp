@@ -0,0 +1,48 @@
+#include "sequences.h"
+
+#include <errno.h>
+
+const int8_t barker7[7] = {1, -1, 1, 1, 1, -1, 1};
+
+const uint8_t training_seq[4][26] = {
+    {0,0,1,0,0,1,0,1,1,1,0,0,0,0,1,0,0,0,1,0,0,1,0,1,1,1},
+    {0,0,1,0,1,1,0,1,1,1,0,1,1,1,1,0,0,0,1,0,1,1,0,1,1,1},
+    {1,0,1,0,0,1,1,1,1,1,0,1,1,0,0,0,1,0,1,0,0,1,1,1,1,1},
+    {1,1,1,0,1,1,1,1,0,0,0,1,0,0,1,0,1,1,1,0,1,1,1,1,0,0},
+};
+
+/* отводы как в scipy (_mls_taps) */
+static const uint8_t mls_taps[][4] = {
+    {0}, {0}, {1}, {2}, {3}, {3}, {5}, {6}, {7, 6, 1}, {5}, {7},
+    {9}, {11, 10, 4}, {12, 11, 8}, {13, 12, 2}, {14}, {15, 13, 4},
+};
+static const uint8_t mls_ntaps[] = {0, 0, 1, 1, 1, 1, 1, 1, 3, 1, 1, 1, 3, 3, 3, 1, 3};
+
+int max_len_seq(unsigned nbits, std::vector<uint8_t> &bits)
+{
+    if (nbits < 2 || nbits > 16)
+        return -EINVAL;
+
+    const size_t len = ((size_t)1 << nbits) - 1;
+    std::vector<uint8_t> state(nbits, 1);
+    size_t idx = 0;
+
+    bits.resize(len);
+    for (size_t i = 0; i < len; i++) {
+        uint8_t feedback = state[idx];
+        bits[i] = feedback;
+        for (unsigned t = 0; t < mls_ntaps[nbits]; t++)
+            feedback ^= state[(mls_taps[nbits][t] + idx) % nbits];
+        state[idx] = feedback;
+        idx = (idx + 1) % nbits;
+    }
+    return 0;
+}
+
+std::vector<float> sequence_to_bpsk(const uint8_t *bits, size_t len)
+{
+    std::vector<float> out(len);
+    for (size_t k = 0; k < len; k++)
+        out[k] = bits[k] ? 1.0f : -1.0f;
+    return out;
+}
@@ -0,0 +1,22 @@
+#ifndef SEQUENCES_H
+#define SEQUENCES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+/*
+ * Опорные последовательности для синхронизации (см. pyhon_qpsk/1.py).
+ * Биты 0/1; для BPSK символов использовать sequence_to_bpsk().
+ */
+
+/* M-последовательность длины 2^nbits - 1, совпадает со scipy.signal.max_len_seq */
+int max_len_seq(unsigned nbits, std::vector<uint8_t> &bits);
+
+extern const int8_t barker7[7];         // уже в виде +-1
+extern const uint8_t training_seq[4][26];   // ts1..ts4
+
+/* 0/1 -> -1/+1 (2*b - 1) */
+std::vector<float> sequence_to_bpsk(const uint8_t *bits, size_t len);
+
+#endif // SEQUENCES_H
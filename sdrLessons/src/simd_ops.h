@@ -0,0 +1,456 @@
+#ifndef SIMD_OPS_H
+#define SIMD_OPS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*
+ * Векторные ядра DSP. Путь выбирается при компиляции: AVX, SSE2, NEON или скаляр.
+ */
+
+/*
+ * Ядро FIR: x - interleaved I/Q (float), h2 - вещественные
+ * коэффициенты, продублированные для I и Q ({h0, h0, h1, h1, ...}).
+ * n2 - длина в float (2 * число отсчётов). Выравнивание не требуется.
+ */
+static inline void simd_dot_cf_rf2(const float *x, const float *h2, size_t n2,
+                                   float *out_re, float *out_im)
+{
+    size_t k = 0;
+    float re = 0.0f, im = 0.0f;
+
+#if defined(__AVX__)
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; k + 16 <= n2; k += 16) {
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(x + k), _mm256_loadu_ps(h2 + k)));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(x + k + 8), _mm256_loadu_ps(h2 + k + 8)));
+    }
+    for (; k + 8 <= n2; k += 8)
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(x + k), _mm256_loadu_ps(h2 + k)));
+    acc0 = _mm256_add_ps(acc0, acc1);
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+    float lanes[4];
+    _mm_storeu_ps(lanes, s);
+    re = lanes[0] + lanes[2];
+    im = lanes[1] + lanes[3];
+#elif defined(__SSE2__)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; k + 8 <= n2; k += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(x + k), _mm_loadu_ps(h2 + k)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(x + k + 4), _mm_loadu_ps(h2 + k + 4)));
+    }
+    for (; k + 4 <= n2; k += 4)
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(x + k), _mm_loadu_ps(h2 + k)));
+    acc0 = _mm_add_ps(acc0, acc1);
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc0);
+    re = lanes[0] + lanes[2];
+    im = lanes[1] + lanes[3];
+#elif defined(__ARM_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    for (; k + 4 <= n2; k += 4)
+        acc0 = vmlaq_f32(acc0, vld1q_f32(x + k), vld1q_f32(h2 + k));
+    float lanes[4];
+    vst1q_f32(lanes, acc0);
+    re = lanes[0] + lanes[2];
+    im = lanes[1] + lanes[3];
+#endif
+
+    for (; k + 2 <= n2; k += 2) {
+        re += x[k] * h2[k];
+        im += x[k + 1] * h2[k + 1];
+    }
+    *out_re = re;
+    *out_im = im;
+}
+
+/*
+ * Комплексное скалярное произведение sum x[k] * w[k] (без сопряжения),
+ * x, w - interleaved I/Q, n - число комплексных отсчётов.
+ * a = x * w по дорожкам даёт {xr wr, xi wi}, b = x * swap(w) - {xr wi, xi wr}:
+ * re = sum (a0 - a1), im = sum (b0 + b1).
+ */
+static inline void simd_dot_cf_cf(const float *x, const float *w, size_t n,
+                                  float *out_re, float *out_im)
+{
+    const size_t n2 = 2 * n;
+    size_t k = 0;
+    float re = 0.0f, im = 0.0f;
+
+#if defined(__AVX__)
+    __m256 a = _mm256_setzero_ps();
+    __m256 b = _mm256_setzero_ps();
+    for (; k + 8 <= n2; k += 8) {
+        __m256 vx = _mm256_loadu_ps(x + k);
+        __m256 vw = _mm256_loadu_ps(w + k);
+        a = _mm256_add_ps(a, _mm256_mul_ps(vx, vw));
+        b = _mm256_add_ps(b, _mm256_mul_ps(vx, _mm256_permute_ps(vw, 0xB1)));
+    }
+    float la[8], lb[8];
+    _mm256_storeu_ps(la, a);
+    _mm256_storeu_ps(lb, b);
+    for (int j = 0; j < 8; j += 2) {
+        re += la[j] - la[j + 1];
+        im += lb[j] + lb[j + 1];
+    }
+#elif defined(__SSE2__)
+    __m128 a = _mm_setzero_ps();
+    __m128 b = _mm_setzero_ps();
+    for (; k + 4 <= n2; k += 4) {
+        __m128 vx = _mm_loadu_ps(x + k);
+        __m128 vw = _mm_loadu_ps(w + k);
+        a = _mm_add_ps(a, _mm_mul_ps(vx, vw));
+        b = _mm_add_ps(b, _mm_mul_ps(vx, _mm_shuffle_ps(vw, vw, 0xB1)));
+    }
+    float la[4], lb[4];
+    _mm_storeu_ps(la, a);
+    _mm_storeu_ps(lb, b);
+    re = la[0] - la[1] + la[2] - la[3];
+    im = lb[0] + lb[1] + lb[2] + lb[3];
+#elif defined(__ARM_NEON)
+    float32x4_t a = vdupq_n_f32(0.0f);
+    float32x4_t b = vdupq_n_f32(0.0f);
+    for (; k + 4 <= n2; k += 4) {
+        float32x4_t vx = vld1q_f32(x + k);
+        float32x4_t vw = vld1q_f32(w + k);
+        a = vmlaq_f32(a, vx, vw);
+        b = vmlaq_f32(b, vx, vrev64q_f32(vw));
+    }
+    float la[4], lb[4];
+    vst1q_f32(la, a);
+    vst1q_f32(lb, b);
+    re = la[0] - la[1] + la[2] - la[3];
+    im = lb[0] + lb[1] + lb[2] + lb[3];
+#endif
+
+    for (; k < n2; k += 2) {
+        re += x[k] * w[k] - x[k + 1] * w[k + 1];
+        im += x[k] * w[k + 1] + x[k + 1] * w[k];
+    }
+    *out_re = re;
+    *out_im = im;
+}
+
+/*
+ * Обновление коэффициентов LMS: w[k] += c * conj(x[k]), n - число
+ * комплексных отсчётов. c * conj(x) = {cr xr + ci xi, ci xr - cr xi}
+ * = x * {cr, -cr} + swap(x) * {ci, ci}.
+ */
+static inline void simd_axpy_conj_cf(float *w, const float *x, size_t n, float c_re, float c_im)
+{
+    const size_t n2 = 2 * n;
+    size_t k = 0;
+
+#if defined(__AVX__)
+    const __m256 vr = _mm256_setr_ps(c_re, -c_re, c_re, -c_re, c_re, -c_re, c_re, -c_re);
+    const __m256 vi = _mm256_set1_ps(c_im);
+    for (; k + 8 <= n2; k += 8) {
+        __m256 vx = _mm256_loadu_ps(x + k);
+        __m256 d = _mm256_add_ps(_mm256_mul_ps(vx, vr), _mm256_mul_ps(_mm256_permute_ps(vx, 0xB1), vi));
+        _mm256_storeu_ps(w + k, _mm256_add_ps(_mm256_loadu_ps(w + k), d));
+    }
+#elif defined(__SSE2__)
+    const __m128 vr = _mm_setr_ps(c_re, -c_re, c_re, -c_re);
+    const __m128 vi = _mm_set1_ps(c_im);
+    for (; k + 4 <= n2; k += 4) {
+        __m128 vx = _mm_loadu_ps(x + k);
+        __m128 d = _mm_add_ps(_mm_mul_ps(vx, vr), _mm_mul_ps(_mm_shuffle_ps(vx, vx, 0xB1), vi));
+        _mm_storeu_ps(w + k, _mm_add_ps(_mm_loadu_ps(w + k), d));
+    }
+#elif defined(__ARM_NEON)
+    const float vr_init[4] = {c_re, -c_re, c_re, -c_re};
+    const float32x4_t vr = vld1q_f32(vr_init);
+    const float32x4_t vi = vdupq_n_f32(c_im);
+    for (; k + 4 <= n2; k += 4) {
+        float32x4_t vx = vld1q_f32(x + k);
+        float32x4_t acc = vmlaq_f32(vld1q_f32(w + k), vx, vr);
+        vst1q_f32(w + k, vmlaq_f32(acc, vrev64q_f32(vx), vi));
+    }
+#endif
+
+    for (; k < n2; k += 2) {
+        w[k] += c_re * x[k] + c_im * x[k + 1];
+        w[k + 1] += c_im * x[k] - c_re * x[k + 1];
+    }
+}
+
+/* acc[k] += a[k] * b[k], n - длина в float (полифазная свёртка канализатора) */
+static inline void simd_mac_f32(float *acc, const float *a, const float *b, size_t n)
+{
+    size_t k = 0;
+
+#if defined(__AVX__)
+    for (; k + 8 <= n; k += 8) {
+        __m256 p = _mm256_mul_ps(_mm256_loadu_ps(a + k), _mm256_loadu_ps(b + k));
+        _mm256_storeu_ps(acc + k, _mm256_add_ps(_mm256_loadu_ps(acc + k), p));
+    }
+#elif defined(__SSE2__)
+    for (; k + 4 <= n; k += 4) {
+        __m128 p = _mm_mul_ps(_mm_loadu_ps(a + k), _mm_loadu_ps(b + k));
+        _mm_storeu_ps(acc + k, _mm_add_ps(_mm_loadu_ps(acc + k), p));
+    }
+#elif defined(__ARM_NEON)
+    for (; k + 4 <= n; k += 4)
+        vst1q_f32(acc + k, vmlaq_f32(vld1q_f32(acc + k), vld1q_f32(a + k), vld1q_f32(b + k)));
+#endif
+
+    for (; k < n; k++)
+        acc[k] += a[k] * b[k];
+}
+
+/*
+ * Моменты I/Q для статистики созвездия, x - interleaved I/Q, n2 - длина в float.
+ * К m[0..6] прибавляются: sum I, sum Q, sum I^2, sum Q^2, sum I*Q,
+ * sum (|I| + |Q|), sum (I^2 + Q^2)^2.
+ * Накопление во float - вызывающий режет вход на блоки в несколько тысяч сэмплов.
+ */
+static inline void simd_iq_moments(const float *x, size_t n2, float m[7])
+{
+    size_t k = 0;
+    float s[7] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+#if defined(__AVX__)
+    const __m256 absmask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 a_sum = _mm256_setzero_ps(), a_sq = _mm256_setzero_ps();
+    __m256 a_iq = _mm256_setzero_ps(), a_abs = _mm256_setzero_ps(), a_p2 = _mm256_setzero_ps();
+    for (; k + 8 <= n2; k += 8) {
+        __m256 v = _mm256_loadu_ps(x + k);
+        __m256 sq = _mm256_mul_ps(v, v);
+        __m256 p = _mm256_add_ps(sq, _mm256_permute_ps(sq, 0xB1));     // I^2 + Q^2 в обеих дорожках
+        a_sum = _mm256_add_ps(a_sum, v);
+        a_sq = _mm256_add_ps(a_sq, sq);
+        a_iq = _mm256_add_ps(a_iq, _mm256_mul_ps(v, _mm256_permute_ps(v, 0xB1)));
+        a_abs = _mm256_add_ps(a_abs, _mm256_and_ps(v, absmask));
+        a_p2 = _mm256_add_ps(a_p2, _mm256_mul_ps(p, p));
+    }
+    float l[5][8];
+    _mm256_storeu_ps(l[0], a_sum);
+    _mm256_storeu_ps(l[1], a_sq);
+    _mm256_storeu_ps(l[2], a_iq);
+    _mm256_storeu_ps(l[3], a_abs);
+    _mm256_storeu_ps(l[4], a_p2);
+    for (int j = 0; j < 8; j += 2) {
+        s[0] += l[0][j];
+        s[1] += l[0][j + 1];
+        s[2] += l[1][j];
+        s[3] += l[1][j + 1];
+        s[4] += l[2][j];                // в чётной и нечётной дорожке одно и то же
+        s[5] += l[3][j] + l[3][j + 1];
+        s[6] += l[4][j];
+    }
+#elif defined(__SSE2__)
+    const __m128 absmask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 a_sum = _mm_setzero_ps(), a_sq = _mm_setzero_ps();
+    __m128 a_iq = _mm_setzero_ps(), a_abs = _mm_setzero_ps(), a_p2 = _mm_setzero_ps();
+    for (; k + 4 <= n2; k += 4) {
+        __m128 v = _mm_loadu_ps(x + k);
+        __m128 sq = _mm_mul_ps(v, v);
+        __m128 p = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, 0xB1));
+        a_sum = _mm_add_ps(a_sum, v);
+        a_sq = _mm_add_ps(a_sq, sq);
+        a_iq = _mm_add_ps(a_iq, _mm_mul_ps(v, _mm_shuffle_ps(v, v, 0xB1)));
+        a_abs = _mm_add_ps(a_abs, _mm_and_ps(v, absmask));
+        a_p2 = _mm_add_ps(a_p2, _mm_mul_ps(p, p));
+    }
+    float l[5][4];
+    _mm_storeu_ps(l[0], a_sum);
+    _mm_storeu_ps(l[1], a_sq);
+    _mm_storeu_ps(l[2], a_iq);
+    _mm_storeu_ps(l[3], a_abs);
+    _mm_storeu_ps(l[4], a_p2);
+    for (int j = 0; j < 4; j += 2) {
+        s[0] += l[0][j];
+        s[1] += l[0][j + 1];
+        s[2] += l[1][j];
+        s[3] += l[1][j + 1];
+        s[4] += l[2][j];
+        s[5] += l[3][j] + l[3][j + 1];
+        s[6] += l[4][j];
+    }
+#elif defined(__ARM_NEON)
+    float32x4_t a_sum = vdupq_n_f32(0.0f), a_sq = vdupq_n_f32(0.0f);
+    float32x4_t a_iq = vdupq_n_f32(0.0f), a_abs = vdupq_n_f32(0.0f), a_p2 = vdupq_n_f32(0.0f);
+    for (; k + 4 <= n2; k += 4) {
+        float32x4_t v = vld1q_f32(x + k);
+        float32x4_t sq = vmulq_f32(v, v);
+        float32x4_t p = vaddq_f32(sq, vrev64q_f32(sq));
+        a_sum = vaddq_f32(a_sum, v);
+        a_sq = vaddq_f32(a_sq, sq);
+        a_iq = vmlaq_f32(a_iq, v, vrev64q_f32(v));
+        a_abs = vaddq_f32(a_abs, vabsq_f32(v));
+        a_p2 = vmlaq_f32(a_p2, p, p);
+    }
+    float l[5][4];
+    vst1q_f32(l[0], a_sum);
+    vst1q_f32(l[1], a_sq);
+    vst1q_f32(l[2], a_iq);
+    vst1q_f32(l[3], a_abs);
+    vst1q_f32(l[4], a_p2);
+    for (int j = 0; j < 4; j += 2) {
+        s[0] += l[0][j];
+        s[1] += l[0][j + 1];
+        s[2] += l[1][j];
+        s[3] += l[1][j + 1];
+        s[4] += l[2][j];
+        s[5] += l[3][j] + l[3][j + 1];
+        s[6] += l[4][j];
+    }
+#endif
+
+    for (; k + 2 <= n2; k += 2) {
+        float i = x[k], q = x[k + 1];
+        float p = i * i + q * q;
+        s[0] += i;
+        s[1] += q;
+        s[2] += i * i;
+        s[3] += q * q;
+        s[4] += i * q;
+        s[5] += fabsf(i) + fabsf(q);
+        s[6] += p * p;
+    }
+    for (int j = 0; j < 7; j++)
+        m[j] += s[j];
+}
+
+/*
+ * Мягкие решения: out[k] = round(x[k] * scale), ограничение до +-127
+ * (симметрично - 0 остаётся стиранием, см. fec.h).
+ */
+static inline void simd_f32_to_i8_sat(const float *x, size_t n, float scale, int8_t *out)
+{
+    size_t k = 0;
+
+#if defined(__SSE2__)
+    const __m128 vs = _mm_set1_ps(scale);
+    const __m128 hi = _mm_set1_ps(127.0f), lo = _mm_set1_ps(-127.0f);
+    for (; k + 16 <= n; k += 16) {
+        __m128i r[4];
+        for (int j = 0; j < 4; j++) {
+            __m128 v = _mm_mul_ps(_mm_loadu_ps(x + k + 4 * j), vs);
+            r[j] = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(v, hi), lo));
+        }
+        __m128i w = _mm_packs_epi16(_mm_packs_epi32(r[0], r[1]), _mm_packs_epi32(r[2], r[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + k), w);
+    }
+#elif defined(__ARM_NEON)
+    const float32x4_t hi = vdupq_n_f32(127.0f), lo = vdupq_n_f32(-127.0f);
+    for (; k + 8 <= n; k += 8) {
+        float32x4_t v0 = vmaxq_f32(vminq_f32(vmulq_n_f32(vld1q_f32(x + k), scale), hi), lo);
+        float32x4_t v1 = vmaxq_f32(vminq_f32(vmulq_n_f32(vld1q_f32(x + k + 4), scale), hi), lo);
+        // округление к ближайшему: +-0.5 и отбрасывание дробной части
+        v0 = vaddq_f32(v0, vbslq_f32(vcltq_f32(v0, vdupq_n_f32(0.0f)), vdupq_n_f32(-0.5f), vdupq_n_f32(0.5f)));
+        v1 = vaddq_f32(v1, vbslq_f32(vcltq_f32(v1, vdupq_n_f32(0.0f)), vdupq_n_f32(-0.5f), vdupq_n_f32(0.5f)));
+        int16x8_t w = vcombine_s16(vqmovn_s32(vcvtq_s32_f32(v0)), vqmovn_s32(vcvtq_s32_f32(v1)));
+        vst1_s8(out + k, vqmovn_s16(w));
+    }
+#endif
+
+    for (; k < n; k++) {
+        float v = x[k] * scale;
+        v = v > 127.0f ? 127.0f : (v < -127.0f ? -127.0f : v);
+        out[k] = (int8_t)lrintf(v);
+    }
+}
+
+/*
+ * Аффинное преобразование I/Q (коррекция DC и разбаланса, iq_correct.h):
+ *   I' = c0 I + c1 Q + c2,  Q' = c3 I + c4 Q + c5
+ * x - interleaved I/Q, n - сэмплов, на месте.
+ */
+static inline void simd_iq_affine(float *x, size_t n, const float c[6])
+{
+    size_t k = 0;
+
+#if defined(__AVX__)
+    const __m256 a = _mm256_setr_ps(c[0], c[4], c[0], c[4], c[0], c[4], c[0], c[4]);
+    const __m256 b = _mm256_setr_ps(c[1], c[3], c[1], c[3], c[1], c[3], c[1], c[3]);
+    const __m256 o = _mm256_setr_ps(c[2], c[5], c[2], c[5], c[2], c[5], c[2], c[5]);
+    for (; k + 4 <= n; k += 4) {
+        __m256 v = _mm256_loadu_ps(x + 2 * k);
+        __m256 r = _mm256_add_ps(_mm256_mul_ps(v, a), _mm256_mul_ps(_mm256_permute_ps(v, 0xB1), b));
+        _mm256_storeu_ps(x + 2 * k, _mm256_add_ps(r, o));
+    }
+#elif defined(__SSE2__)
+    const __m128 a = _mm_setr_ps(c[0], c[4], c[0], c[4]);
+    const __m128 b = _mm_setr_ps(c[1], c[3], c[1], c[3]);
+    const __m128 o = _mm_setr_ps(c[2], c[5], c[2], c[5]);
+    for (; k + 2 <= n; k += 2) {
+        __m128 v = _mm_loadu_ps(x + 2 * k);
+        __m128 r = _mm_add_ps(_mm_mul_ps(v, a), _mm_mul_ps(_mm_shuffle_ps(v, v, 0xB1), b));
+        _mm_storeu_ps(x + 2 * k, _mm_add_ps(r, o));
+    }
+#elif defined(__ARM_NEON)
+    const float32x4_t a = {c[0], c[4], c[0], c[4]};
+    const float32x4_t b = {c[1], c[3], c[1], c[3]};
+    const float32x4_t o = {c[2], c[5], c[2], c[5]};
+    for (; k + 2 <= n; k += 2) {
+        float32x4_t v = vld1q_f32(x + 2 * k);
+        vst1q_f32(x + 2 * k, vmlaq_f32(vmlaq_f32(o, v, a), vrev64q_f32(v), b));
+    }
+#endif
+
+    for (; k < n; k++) {
+        float i = x[2 * k], q = x[2 * k + 1];
+        x[2 * k] = c[0] * i + c[1] * q + c[2];
+        x[2 * k + 1] = c[3] * i + c[4] * q + c[5];
+    }
+}
+
+/* То же для int16 I/Q с округлением и насыщением; in == out допускается */
+static inline void simd_iq_affine_i16(const int16_t *in, int16_t *out, size_t n, const float c[6])
+{
+    size_t k = 0;
+
+#if defined(__SSE2__)
+    const __m128 a = _mm_setr_ps(c[0], c[4], c[0], c[4]);
+    const __m128 b = _mm_setr_ps(c[1], c[3], c[1], c[3]);
+    const __m128 o = _mm_setr_ps(c[2], c[5], c[2], c[5]);
+    for (; k + 4 <= n; k += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 2 * k));
+        __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+        __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+        lo = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lo, a), _mm_mul_ps(_mm_shuffle_ps(lo, lo, 0xB1), b)), o);
+        hi = _mm_add_ps(_mm_add_ps(_mm_mul_ps(hi, a), _mm_mul_ps(_mm_shuffle_ps(hi, hi, 0xB1), b)), o);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * k),
+                         _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi)));
+    }
+#elif defined(__ARM_NEON)
+    const float32x4_t a = {c[0], c[4], c[0], c[4]};
+    const float32x4_t b = {c[1], c[3], c[1], c[3]};
+    const float32x4_t o = {c[2], c[5], c[2], c[5]};
+    const float32x4_t half = vdupq_n_f32(0.5f), mhalf = vdupq_n_f32(-0.5f), zero = vdupq_n_f32(0.0f);
+    for (; k + 4 <= n; k += 4) {
+        int16x8_t v = vld1q_s16(in + 2 * k);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+        lo = vmlaq_f32(vmlaq_f32(o, lo, a), vrev64q_f32(lo), b);
+        hi = vmlaq_f32(vmlaq_f32(o, hi, a), vrev64q_f32(hi), b);
+        lo = vaddq_f32(lo, vbslq_f32(vcltq_f32(lo, zero), mhalf, half));
+        hi = vaddq_f32(hi, vbslq_f32(vcltq_f32(hi, zero), mhalf, half));
+        vst1q_s16(out + 2 * k, vcombine_s16(vqmovn_s32(vcvtq_s32_f32(lo)), vqmovn_s32(vcvtq_s32_f32(hi))));
+    }
+#endif
+
+    for (; k < n; k++) {
+        float i = in[2 * k], q = in[2 * k + 1];
+        float ri = c[0] * i + c[1] * q + c[2];
+        float rq = c[3] * i + c[4] * q + c[5];
+        ri = ri > 32767.0f ? 32767.0f : (ri < -32768.0f ? -32768.0f : ri);
+        rq = rq > 32767.0f ? 32767.0f : (rq < -32768.0f ? -32768.0f : rq);
+        out[2 * k] = (int16_t)lrintf(ri);
+        out[2 * k + 1] = (int16_t)lrintf(rq);
+    }
+}
+
+#endif // SIMD_OPS_H
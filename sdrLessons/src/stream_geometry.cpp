@@ -0,0 +1,91 @@
+#include "stream_geometry.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <string>
+#include <vector>
+
+const char *stream_geometry_default_path(void)
+{
+    static std::string path;
+    if (path.empty()) {
+        const char *env = getenv("SDR_GEOMETRY_PROFILE");
+        const char *home = getenv("HOME");
+        if (env && *env)
+            path = env;
+        else
+            path = std::string(home ? home : ".") + "/.sdr_geometry";
+    }
+    return path.c_str();
+}
+
+static bool parse_line(const char *line, struct stream_geometry *g)
+{
+    while (*line == ' ' || *line == '\t')
+        line++;
+    if (*line == '#' || *line == '\n' || *line == '\0')
+        return false;
+    g->latency_ms = 0.0;
+    g->cpu_pct = 0.0;
+    return sscanf(line, "%lld %zu %zu %lf %lf", &g->fs_hz, &g->block_size, &g->block_count,
+                  &g->latency_ms, &g->cpu_pct) >= 3 && g->block_size > 0 && g->block_count > 0;
+}
+
+int stream_geometry_load(const char *path, long long fs_hz, struct stream_geometry *g)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return -ENOENT;
+
+    char line[256];
+    int ret = -ENOENT;
+    struct stream_geometry cur;
+    while (fgets(line, sizeof(line), f)) {
+        if (parse_line(line, &cur) && cur.fs_hz == fs_hz) {
+            *g = cur;
+            ret = 0;        // последняя запись побеждает
+        }
+    }
+    fclose(f);
+    return ret;
+}
+
+int stream_geometry_save(const char *path, const struct stream_geometry *g)
+{
+    // остальные строки (другие частоты, комментарии) сохраняются как есть
+    std::vector<std::string> lines;
+    FILE *f = fopen(path, "r");
+    if (f) {
+        char line[256];
+        struct stream_geometry cur;
+        while (fgets(line, sizeof(line), f)) {
+            if (parse_line(line, &cur) && cur.fs_hz == g->fs_hz)
+                continue;
+            lines.push_back(line);
+        }
+        fclose(f);
+    } else {
+        lines.push_back("# fs_hz block_size block_count latency_ms cpu_pct (stream_autotune)\n");
+    }
+
+    std::string tmp = std::string(path) + ".tmp";
+    f = fopen(tmp.c_str(), "w");
+    if (!f) {
+        int err = errno;
+        fprintf(stderr, "Unable to write %s: %s\n", tmp.c_str(), strerror(err));
+        return -err;
+    }
+    for (size_t k = 0; k < lines.size(); k++)
+        fputs(lines[k].c_str(), f);
+    fprintf(f, "%lld %zu %zu %.3f %.1f\n", g->fs_hz, g->block_size, g->block_count, g->latency_ms, g->cpu_pct);
+    if (fclose(f) != 0 || rename(tmp.c_str(), path) != 0) {
+        int err = errno;
+        fprintf(stderr, "Unable to write %s: %s\n", path, strerror(err));
+        remove(tmp.c_str());
+        return -err;
+    }
+    return 0;
+}
@@ -0,0 +1,33 @@
+#ifndef STREAM_GEOMETRY_H
+#define STREAM_GEOMETRY_H
+
+#include <stddef.h>
+
+/*
+ * Геометрия буферов IIO (размер блока x число блоков) по частоте
+ * дискретизации - результат sdr_autotune, чтобы не подбирать её руками
+ * (4 x 2^14 в main.cpp, 4 x 2^13 в single_adalm_rxtx_costas.cpp).
+ *
+ * Профиль - текстовый файл, строка на частоту:
+ *   fs_hz block_size block_count latency_ms cpu_pct
+ * '#' - комментарий. Путь: $SDR_GEOMETRY_PROFILE или ~/.sdr_geometry.
+ */
+
+struct stream_geometry {
+    long long fs_hz;
+    size_t block_size;
+    size_t block_count;
+    double latency_ms;      // измеренная задержка TX -> RX, для справки
+    double cpu_pct;
+};
+
+/* Путь профиля по умолчанию (статическая строка) */
+const char *stream_geometry_default_path(void);
+
+/* Найти запись для fs_hz: 0, -ENOENT (нет файла или записи) */
+int stream_geometry_load(const char *path, long long fs_hz, struct stream_geometry *g);
+
+/* Записать/заменить запись для g->fs_hz (через временный файл и rename) */
+int stream_geometry_save(const char *path, const struct stream_geometry *g);
+
+#endif // STREAM_GEOMETRY_H
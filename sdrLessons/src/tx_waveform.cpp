@@ -0,0 +1,152 @@
+#include "tx_waveform.h"
+
+#include <stdlib.h>
+#include <math.h>
+#include <errno.h>
+
+/* Выделить память под период и развёртку, iq[0 .. 2*len) заполняет вызывающий */
+static int wf_alloc(struct tx_waveform *wf, size_t len, size_t block_size)
+{
+    wf->iq = NULL;
+    wf->len = 0;
+    wf->block_size = 0;
+    if (len == 0 || block_size == 0)
+        return -EINVAL;
+
+    void *p = NULL;
+    size_t bytes = (len + block_size) * 2 * sizeof(int16_t);
+    if (posix_memalign(&p, 64, (bytes + 63) & ~(size_t)63) != 0)
+        return -ENOMEM;
+    wf->iq = static_cast<int16_t *>(p);
+    wf->len = len;
+    wf->block_size = block_size;
+    return 0;
+}
+
+/* Продолжить период на block_size сэмплов (период может быть короче блока) */
+static void wf_unroll(struct tx_waveform *wf)
+{
+    for (size_t k = wf->len; k < wf->len + wf->block_size; k++) {
+        wf->iq[2 * k] = wf->iq[2 * (k - wf->len)];
+        wf->iq[2 * k + 1] = wf->iq[2 * (k - wf->len) + 1];
+    }
+}
+
+int tx_waveform_init(struct tx_waveform *wf, const int16_t *iq, size_t len, size_t block_size)
+{
+    int ret = wf_alloc(wf, len, block_size);
+    if (ret < 0)
+        return ret;
+    memcpy(wf->iq, iq, len * 2 * sizeof(int16_t));
+    wf_unroll(wf);
+    return 0;
+}
+
+int tx_waveform_from_iq(struct tx_waveform *wf, const int16_t *i, const int16_t *q, size_t len,
+                        unsigned shift, size_t block_size)
+{
+    int ret = wf_alloc(wf, len, block_size);
+    if (ret < 0)
+        return ret;
+    for (size_t k = 0; k < len; k++) {
+        // деление, а не >>: округление к нулю, как tx_i[k] / pow(2, 9) раньше
+        wf->iq[2 * k] = (int16_t)(i[k] / (1 << shift));
+        wf->iq[2 * k + 1] = (int16_t)(q[k] / (1 << shift));
+    }
+    wf_unroll(wf);
+    return 0;
+}
+
+static inline int16_t sat16(float v)
+{
+    long r = lrintf(v);
+    if (r > 32767) r = 32767;
+    if (r < -32768) r = -32768;
+    return (int16_t)r;
+}
+
+int tx_waveform_from_symbols(struct tx_waveform *wf, const cf_t *syms, size_t n, unsigned sps,
+                             float amplitude, size_t block_size)
+{
+    if (sps == 0)
+        return -EINVAL;
+    int ret = wf_alloc(wf, n * sps, block_size);
+    if (ret < 0)
+        return ret;
+    int16_t *p = wf->iq;
+    for (size_t s = 0; s < n; s++) {
+        int16_t vi = sat16(syms[s].real() * amplitude);
+        int16_t vq = sat16(syms[s].imag() * amplitude);
+        for (unsigned k = 0; k < sps; k++) {
+            *p++ = vi;
+            *p++ = vq;
+        }
+    }
+    wf_unroll(wf);
+    return 0;
+}
+
+int tx_waveform_block_pattern(struct tx_waveform *wf, size_t block_size, size_t period_blocks,
+                              const size_t *marks, size_t n_marks,
+                              int16_t mark_i, int16_t mark_q, int16_t idle_i, int16_t idle_q)
+{
+    int ret = wf_alloc(wf, block_size * period_blocks, block_size);
+    if (ret < 0)
+        return ret;
+    for (size_t b = 0; b < period_blocks; b++) {
+        bool mark = false;
+        for (size_t m = 0; m < n_marks; m++)
+            mark |= marks[m] % period_blocks == b;
+        int16_t *p = wf->iq + 2 * b * block_size;
+        for (size_t k = 0; k < block_size; k++) {
+            p[2 * k] = mark ? mark_i : idle_i;
+            p[2 * k + 1] = mark ? mark_q : idle_q;
+        }
+    }
+    wf_unroll(wf);
+    return 0;
+}
+
+void tx_waveform_free(struct tx_waveform *wf)
+{
+    free(wf->iq);
+    wf->iq = NULL;
+    wf->len = 0;
+}
+
+void tx_waveform_fill_cb(int16_t *iq, size_t n, long long index, void *user)
+{
+    tx_waveform_fill(static_cast<const struct tx_waveform *>(user), iq, n, index);
+}
+
+int tx_cache_add(struct tx_waveform_cache *c, const char *name, struct tx_waveform *wf)
+{
+    int id = tx_cache_find(c, name);
+    if (id >= 0) {
+        tx_waveform_free(&c->items[id]);
+        c->items[id] = *wf;
+    } else {
+        id = (int)c->items.size();
+        c->names.push_back(name);
+        c->items.push_back(*wf);
+    }
+    wf->iq = NULL;      // теперь принадлежит кэшу
+    wf->len = 0;
+    return id;
+}
+
+int tx_cache_find(const struct tx_waveform_cache *c, const char *name)
+{
+    for (size_t k = 0; k < c->names.size(); k++)
+        if (c->names[k] == name)
+            return (int)k;
+    return -ENOENT;
+}
+
+void tx_cache_free(struct tx_waveform_cache *c)
+{
+    for (size_t k = 0; k < c->items.size(); k++)
+        tx_waveform_free(&c->items[k]);
+    c->items.clear();
+    c->names.clear();
+}
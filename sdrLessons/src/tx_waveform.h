@@ -0,0 +1,89 @@
+#ifndef TX_WAVEFORM_H
+#define TX_WAVEFORM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "dsp_types.h"
+
+/*
+ * Кэш TX сигналов: модуляция считается один раз, дальше TX блок
+ * заполняется одним memcpy.
+ *
+ * Сигнал периодический (период len сэмплов), хранится в формате блока
+ * IIO (int16, I/Q чередуются), выровнен на 64 байта и "развёрнут": за
+ * периодом лежат ещё block_size его сэмплов, так что любые block_size
+ * сэмплов с любой позиции периода лежат в памяти подряд.
+ */
+
+struct tx_waveform {
+    int16_t *iq;            // len + block_size сэмплов
+    size_t len;             // период в сэмплах
+    size_t block_size;      // максимум сэмплов за один непрерывный memcpy
+};
+
+/* Из готовых interleaved I/Q (len пар) */
+int tx_waveform_init(struct tx_waveform *wf, const int16_t *iq, size_t len, size_t block_size);
+
+/* Из раздельных I и Q, как tx_i/tx_q в примерах; отсчёты делятся на 2^shift (к нулю) */
+int tx_waveform_from_iq(struct tx_waveform *wf, const int16_t *i, const int16_t *q, size_t len,
+                        unsigned shift, size_t block_size);
+
+/* Символы с прямоугольным импульсом по sps сэмплов, |1| -> amplitude */
+int tx_waveform_from_symbols(struct tx_waveform *wf, const cf_t *syms, size_t n, unsigned sps,
+                             float amplitude, size_t block_size);
+
+/*
+ * Кадры по блокам: period_blocks блоков, блоки из списка marks заполнены
+ * (mark_i, mark_q), остальные (idle_i, idle_q). Как counter % 10 в chat_test.
+ */
+int tx_waveform_block_pattern(struct tx_waveform *wf, size_t block_size, size_t period_blocks,
+                              const size_t *marks, size_t n_marks,
+                              int16_t mark_i, int16_t mark_q, int16_t idle_i, int16_t idle_q);
+
+void tx_waveform_free(struct tx_waveform *wf);
+
+/* Указатель на сэмплы с позиции index (по модулю периода); подряд лежат block_size */
+static inline const int16_t *tx_waveform_at(const struct tx_waveform *wf, long long index)
+{
+    return wf->iq + 2 * (size_t)(index % (long long)wf->len);
+}
+
+/* Заполнить n сэмплов, начиная с позиции index потока */
+static inline void tx_waveform_fill(const struct tx_waveform *wf, int16_t *iq, size_t n, long long index)
+{
+    while (n > 0) {
+        size_t chunk = n < wf->block_size ? n : wf->block_size;
+        memcpy(iq, tx_waveform_at(wf, index), chunk * 2 * sizeof(int16_t));
+        iq += 2 * chunk;
+        index += chunk;
+        n -= chunk;
+    }
+}
+
+/* sdr_tx_fill_cb для sdr_stream_start: user - const struct tx_waveform * */
+void tx_waveform_fill_cb(int16_t *iq, size_t n, long long index, void *user);
+
+/* Набор заранее посчитанных сигналов по именам (преамбулы, idle, кадры) */
+struct tx_waveform_cache {
+    std::vector<std::string> names;
+    std::vector<struct tx_waveform> items;
+};
+
+/* Забирает wf во владение кэша, возвращает номер; имя уже есть - заменяет */
+int tx_cache_add(struct tx_waveform_cache *c, const char *name, struct tx_waveform *wf);
+/* Номер по имени или -ENOENT */
+int tx_cache_find(const struct tx_waveform_cache *c, const char *name);
+
+static inline const struct tx_waveform *tx_cache_get(const struct tx_waveform_cache *c, int id)
+{
+    return &c->items[id];
+}
+
+void tx_cache_free(struct tx_waveform_cache *c);
+
+#endif // TX_WAVEFORM_H
@@ -0,0 +1,130 @@
+#include "work_pool.h"
+
+static thread_local int pool_thread_index = -1;
+static thread_local struct work_pool *pool_thread_owner = NULL;
+
+int work_pool_thread_index(void)
+{
+    return pool_thread_index;
+}
+
+size_t work_pool_size(const struct work_pool *pool)
+{
+    return pool->threads.size();
+}
+
+/* Своя очередь с хвоста, потом чужие с головы */
+static bool take_task(struct work_pool *pool, size_t self, work_fn &fn)
+{
+    const size_t n = pool->queues.size();
+    {
+        struct work_queue *q = pool->queues[self];
+        std::lock_guard<std::mutex> guard(q->lock);
+        if (!q->tasks.empty()) {
+            fn = std::move(q->tasks.back());
+            q->tasks.pop_back();
+            pool->queued.fetch_sub(1);
+            return true;
+        }
+    }
+    for (size_t k = 1; k < n; k++) {
+        struct work_queue *q = pool->queues[(self + k) % n];
+        std::lock_guard<std::mutex> guard(q->lock);
+        if (!q->tasks.empty()) {
+            fn = std::move(q->tasks.front());
+            q->tasks.pop_front();
+            pool->queued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void finish_task(struct work_pool *pool)
+{
+    if (pool->pending.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> guard(pool->idle_lock);
+        pool->done_cv.notify_all();
+    }
+}
+
+static void worker_fn(struct work_pool *pool, size_t self)
+{
+    pool_thread_index = (int)self;
+    pool_thread_owner = pool;
+
+    work_fn fn;
+    while (!pool->stop.load()) {
+        if (take_task(pool, self, fn)) {
+            fn();
+            fn = nullptr;
+            finish_task(pool);
+            continue;
+        }
+
+        // ждать именно невзятых задач: pending считает и выполняющиеся,
+        // на нём простаивающие потоки крутились бы всё время работы задачи
+        std::unique_lock<std::mutex> guard(pool->idle_lock);
+        pool->idle_cv.wait_for(guard, std::chrono::milliseconds(10), [pool] {
+            return pool->stop.load() || pool->queued.load() > 0;
+        });
+    }
+}
+
+int work_pool_init(struct work_pool *pool, size_t nthreads)
+{
+    if (nthreads == 0)
+        nthreads = std::thread::hardware_concurrency();
+    if (nthreads == 0)
+        nthreads = 1;
+
+    pool->next_queue.store(0);
+    pool->pending.store(0);
+    pool->queued.store(0);
+    pool->stop.store(false);
+    for (size_t k = 0; k < nthreads; k++)
+        pool->queues.push_back(new work_queue);
+    for (size_t k = 0; k < nthreads; k++)
+        pool->threads.emplace_back(worker_fn, pool, k);
+    return 0;
+}
+
+void work_pool_destroy(struct work_pool *pool)
+{
+    work_pool_wait(pool);
+    pool->stop.store(true);
+    {
+        std::lock_guard<std::mutex> guard(pool->idle_lock);
+        pool->idle_cv.notify_all();
+    }
+    for (size_t k = 0; k < pool->threads.size(); k++)
+        pool->threads[k].join();
+    for (size_t k = 0; k < pool->queues.size(); k++)
+        delete pool->queues[k];
+    pool->threads.clear();
+    pool->queues.clear();
+}
+
+void work_pool_submit(struct work_pool *pool, work_fn fn)
+{
+    size_t q;
+    if (pool_thread_owner == pool && pool_thread_index >= 0)
+        q = (size_t)pool_thread_index;
+    else
+        q = pool->next_queue.fetch_add(1) % pool->queues.size();
+
+    pool->pending.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> guard(pool->queues[q]->lock);
+        pool->queues[q]->tasks.push_back(std::move(fn));
+        pool->queued.fetch_add(1);
+    }
+    std::lock_guard<std::mutex> guard(pool->idle_lock);
+    pool->idle_cv.notify_one();
+}
+
+void work_pool_wait(struct work_pool *pool)
+{
+    std::unique_lock<std::mutex> guard(pool->idle_lock);
+    pool->done_cv.wait(guard, [pool] { return pool->pending.load() == 0; });
+}
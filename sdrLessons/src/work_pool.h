@@ -0,0 +1,57 @@
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+#include <stddef.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Пул потоков с кражей задач (work stealing).
+ *
+ * У каждого потока своя очередь: владелец берёт задачи с хвоста (LIFO,
+ * тёплый кэш), простаивающие потоки крадут с головы чужих очередей.
+ * Задачи, поставленные извне пула, раздаются по очередям по кругу.
+ */
+
+typedef std::function<void()> work_fn;
+
+struct work_queue {
+    std::mutex lock;
+    std::deque<work_fn> tasks;
+};
+
+struct work_pool {
+    std::vector<std::thread> threads;
+    std::vector<work_queue *> queues;
+    std::atomic<size_t> next_queue;
+    std::atomic<size_t> pending;        // поставлено и ещё не выполнено
+    std::atomic<size_t> queued;         // лежит в очередях, ещё не взято
+    std::atomic<bool> stop;
+
+    std::mutex idle_lock;
+    std::condition_variable idle_cv;    // есть работа
+    std::condition_variable done_cv;    // pending == 0
+};
+
+/* nthreads == 0 - по числу ядер */
+int work_pool_init(struct work_pool *pool, size_t nthreads);
+void work_pool_destroy(struct work_pool *pool);
+
+size_t work_pool_size(const struct work_pool *pool);
+
+/* Поставить задачу; из потока пула - в его собственную очередь */
+void work_pool_submit(struct work_pool *pool, work_fn fn);
+
+/* Ждать выполнения всех поставленных задач */
+void work_pool_wait(struct work_pool *pool);
+
+/* Номер текущего потока пула или -1 вне пула */
+int work_pool_thread_index(void);
+
+#endif // WORK_POOL_H
@@ -0,0 +1,127 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <iostream>
+#include <vector>
+
+#include "sdr_stream.h"
+#include "rt_thread.h"
+#include "qpsk_demod.h"
+#include "bert.h"
+
+/*
+ * BERT на одном Pluto: вместо кадра из max_len_seq(8) (pyhon_qpsk/1.py) -
+ * бесконечный PRBS поток QPSK, BER по всем битам на полной символьной
+ * скорости:
+ *
+ *   bert_example [uri=ip:192.168.3.1] [prbs=31] [sps=8] [log.csv]
+ *
+ * TX: bert_tx_fill_cb прямо из TX потока движка, без заготовленного
+ * периода. RX: блоки из кольца -> qpsk_demod -> bert_rx. Раз в секунду -
+ * BER за секунду и накопленный, состояние захвата; log.csv - то же для
+ * графика BER во времени. Остановка по CTRL-C.
+ */
+
+#define TX_AMPLITUDE 8192
+
+int main(int argc, char **argv){
+    std::cout << "Hello, world!" << std::endl;
+    rt_shutdown_init();
+
+    struct sdr_stream_cfg cfg;
+    sdr_stream_default_cfg(&cfg);
+    cfg.uri = argc > 1 ? argv[1] : "ip:192.168.3.1";
+    unsigned order = argc > 2 ? (unsigned)atoi(argv[2]) : 31;
+    unsigned sps = argc > 3 ? (unsigned)atoi(argv[3]) : 8;
+    const char *log_path = argc > 4 ? argv[4] : NULL;
+
+    struct bert_tx tx;
+    struct bert_rx_cfg rcfg;
+    struct bert_rx rx;
+    bert_rx_default_cfg(&rcfg, order);
+    if (bert_tx_init(&tx, order, sps, TX_AMPLITUDE) < 0 || bert_rx_init(&rx, &rcfg) < 0) {
+        fprintf(stderr, "Bad BERT parameters (prbs 7/15/23/31, sps > 0)\n");
+        return 1;
+    }
+    struct qpsk_demod_cfg dcfg;
+    qpsk_demod_default_cfg(&dcfg, sps);
+    struct qpsk_demod dm;
+    if (qpsk_demod_init(&dm, &dcfg) < 0) {
+        fprintf(stderr, "Bad demod parameters\n");
+        return 1;
+    }
+    printf("* PRBS-%u, QPSK sps %u, %.2f Mbit/s at %.1f MS/s\n", order, sps,
+           2.0 * cfg.rx.fs_hz / sps / 1e6, cfg.rx.fs_hz / 1e6);
+
+    FILE *log = NULL;
+    if (log_path) {
+        log = fopen(log_path, "w");
+        if (!log) {
+            fprintf(stderr, "Unable to create %s\n", log_path);
+            return 1;
+        }
+        fprintf(log, "t_s,bits,errors,ber,total_bits,total_errors,total_ber,lock,losses\n");
+    }
+
+    struct sdr_stream stream;
+    if (sdr_stream_open(&stream, &cfg) < 0) {
+        if (log)
+            fclose(log);
+        return 1;
+    }
+    if (sdr_stream_start(&stream, bert_tx_fill_cb, &tx) < 0) {
+        sdr_stream_close(&stream);
+        if (log)
+            fclose(log);
+        return 1;
+    }
+
+    std::vector<cf_t> syms;
+    struct timespec t_start, t_last, now;
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+    t_last = t_start;
+    while (!rt_shutdown_requested()) {
+        if (sdr_stream_rx_wait(&stream, 500) > 0) {
+            const struct iq_block_info *info;
+            const int16_t *iq;
+            while ((iq = iq_ring_read_begin(&stream.ring, &info)) != NULL) {
+                qpsk_demod_process_iq16(&dm, iq, info->n, syms, NULL);
+                iq_ring_read_release(&stream.ring);
+                bert_rx_process(&rx, syms.data(), syms.size());
+                syms.clear();
+            }
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        double dt = (now.tv_sec - t_last.tv_sec) + (now.tv_nsec - t_last.tv_nsec) * 1e-9;
+        if (dt < 1.0)
+            continue;
+        double t = (now.tv_sec - t_start.tv_sec) + (now.tv_nsec - t_start.tv_nsec) * 1e-9;
+        uint64_t bits, errors;
+        bert_rx_interval(&rx, &bits, &errors);
+        double ber = bits ? (double)errors / bits : 0.0;
+        double total_ber = rx.bits ? (double)rx.errors / rx.bits : 0.0;
+        printf("%s rot %u deg, %.2f Mbit/s, BER %.2e, total %.2e (%llu / %llu bits), locks %llu, losses %llu\n",
+               rx.state == BERT_LOCK ? "LOCK" : "HUNT", rx.rot * 90, bits / dt / 1e6, ber, total_ber,
+               (unsigned long long)rx.errors, (unsigned long long)rx.bits,
+               (unsigned long long)rx.locks, (unsigned long long)rx.losses);
+        if (log) {
+            fprintf(log, "%.3f,%llu,%llu,%.3e,%llu,%llu,%.3e,%d,%llu\n", t,
+                    (unsigned long long)bits, (unsigned long long)errors, ber,
+                    (unsigned long long)rx.bits, (unsigned long long)rx.errors, total_ber,
+                    rx.state == BERT_LOCK, (unsigned long long)rx.losses);
+            fflush(log);
+        }
+        t_last = now;
+    }
+
+    printf("CTRL-C pressed\n");
+    sdr_stream_stop(&stream);
+    sdr_stream_close(&stream);
+    printf("* total BER %.3e over %llu bits\n", rx.bits ? (double)rx.errors / rx.bits : 0.0,
+           (unsigned long long)rx.bits);
+    if (log)
+        fclose(log);
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <iostream>
+#include <vector>
+
+#include "sdr_stream.h"
+#include "rt_thread.h"
+#include "work_pool.h"
+#include "channelizer.h"
+#include "qpsk_demod.h"
+#include "iq_analytics.h"
+
+/*
+ * Много узких QPSK каналов с одного Pluto вместо Pluto на каждого
+ * (rxtx_1_example / rxtx_2_example на 900 и 1000 МГц):
+ *
+ *   channelizer_rx_example [uri=ip:192.168.2.1] [lo_mhz=1000] [nchan=16] [sps=10] [chan ...]
+ *
+ * RX 10 MS/s -> channelizer на nchan каналов (шаг 10 / nchan МГц, выход
+ * 2 * 10 / nchan MS/s) -> на каждый выбранный канал свой qpsk_demod в
+ * потоке work_pool. Без списка каналов - все. Раз в секунду по каналу:
+ * мощность, символы, EVM.
+ */
+
+struct chan_state {
+    struct qpsk_demod dm;
+    std::vector<cf_t> syms;
+    struct iq_stats sig, sym;
+};
+
+static void demod_channel(unsigned c, const cf_t *y, size_t n, void *user)
+{
+    struct chan_state *st = &static_cast<struct chan_state *>(user)[c];
+    iq_stats_add(&st->sig, y, n);
+    size_t base = st->syms.size();
+    qpsk_demod_process(&st->dm, y, n, st->syms, NULL);
+    iq_stats_add(&st->sym, &st->syms[base], st->syms.size() - base);
+    st->syms.clear();
+}
+
+int main(int argc, char **argv){
+    std::cout << "Hello, world!" << std::endl;
+    rt_shutdown_init();
+
+    struct sdr_stream_cfg cfg;
+    sdr_stream_default_cfg(&cfg);
+    cfg.uri = argc > 1 ? argv[1] : "ip:192.168.2.1";
+    if (argc > 2)
+        cfg.rx.lo_hz = MHZ(atof(argv[2]));
+    unsigned nchan = argc > 3 ? (unsigned)atoi(argv[3]) : 16;
+    unsigned sps = argc > 4 ? (unsigned)atoi(argv[4]) : 10;
+    cfg.enable_tx = false;
+
+    struct channelizer_cfg ccfg;
+    channelizer_default_cfg(&ccfg, nchan);
+    struct channelizer ch;
+    if (channelizer_init(&ch, &ccfg) < 0) {
+        fprintf(stderr, "Unable to create channelizer for %u channels\n", nchan);
+        return 1;
+    }
+    std::vector<unsigned> chans;
+    std::vector<bool> used(nchan, false);
+    for (int k = 5; k < argc; k++) {
+        unsigned c = (unsigned)atoi(argv[k]) % nchan;
+        if (!used[c])       // у канала одно состояние - один поток
+            chans.push_back(c);
+        used[c] = true;
+    }
+    if (chans.empty())
+        for (unsigned c = 0; c < nchan; c++)
+            chans.push_back(c);
+
+    const double fs = (double)cfg.rx.fs_hz;
+    const double fs_chan = fs / ch.decim;
+    printf("* %u channels, %.1f kHz apart, %.3f MS/s each, %.1f ksym/s at %u sps\n", nchan, fs / nchan * 1e-3,
+           fs_chan * 1e-6, fs_chan / sps * 1e-3, sps);
+
+    struct qpsk_demod_cfg dcfg;
+    qpsk_demod_default_cfg(&dcfg, sps);
+    std::vector<struct chan_state> st(nchan);
+    for (unsigned c = 0; c < nchan; c++) {
+        qpsk_demod_init(&st[c].dm, &dcfg);
+        iq_stats_reset(&st[c].sig);
+        iq_stats_reset(&st[c].sym);
+    }
+
+    // DSP и пул - на не изолированных ядрах
+    std::vector<int> rt_cpus, dsp_cpus;
+    if (cfg.rx_thread.cpu >= 0)
+        rt_cpus.push_back(cfg.rx_thread.cpu);
+    rt_other_cpus(rt_cpus, dsp_cpus);
+    struct work_pool pool;
+    work_pool_init(&pool, dsp_cpus.empty() ? 0 : dsp_cpus.size());
+
+    struct sdr_stream stream;
+    if (sdr_stream_open(&stream, &cfg) < 0) {
+        work_pool_destroy(&pool);
+        return 1;
+    }
+    if (sdr_stream_start(&stream, NULL, NULL) < 0) {
+        sdr_stream_stop(&stream);
+        sdr_stream_close(&stream);
+        work_pool_destroy(&pool);
+        return 1;
+    }
+
+    std::vector<std::vector<cf_t>> out(nchan);
+    time_t last = time(NULL);
+    while (!rt_shutdown_requested()) {
+        if (sdr_stream_rx_wait(&stream, 500) <= 0)
+            continue;
+
+        const struct iq_block_info *info;
+        const int16_t *iq;
+        while ((iq = iq_ring_read_begin(&stream.ring, &info)) != NULL) {
+            for (unsigned c = 0; c < nchan; c++)
+                out[c].clear();
+            channelizer_process_iq16(&ch, iq, info->n, out.data());
+            iq_ring_read_release(&stream.ring);
+            channelizer_dispatch(&pool, out.data(), chans.data(), chans.size(), demod_channel, st.data());
+        }
+
+        if (time(NULL) != last) {
+            last = time(NULL);
+            for (size_t k = 0; k < chans.size(); k++) {
+                struct chan_state *s = &st[chans[k]];
+                struct iq_report sig, sym;
+                iq_stats_report(&s->sig, &sig);
+                iq_stats_report(&s->sym, &sym);
+                printf("ch %2u %+8.1f kHz: %6.1f dB, %8zu syms, EVM %5.1f%%\n", chans[k],
+                       channelizer_chan_offset(&ch, chans[k], fs) * 1e-3, 10.0 * log10(sig.power + 1e-20),
+                       s->sym.n, 100.0 * sym.evm_rms);
+                iq_stats_reset(&s->sig);
+                iq_stats_reset(&s->sym);
+            }
+            printf("* ring overflows %llu\n", (unsigned long long)stream.ring.overflows.load());
+        }
+    }
+
+    printf("CTRL-C pressed\n");
+    sdr_stream_stop(&stream);
+    sdr_stream_close(&stream);
+    work_pool_destroy(&pool);
+    return 0;
+}
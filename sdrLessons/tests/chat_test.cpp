@@ -12,6 +12,8 @@
 #include <iostream>
 #include <fstream>
 
+#include "tx_waveform.h"
+
 /* helper macros */
 #define MHZ(x) ((long long)(x*1000000.0 + .5))
 #define GHZ(x) ((long long)(x*1000000000.0 + .5))
@@ -158,6 +160,17 @@ int main(){
 
     struct iio_block *txblock, *rxblock;
 
+    // TX: каждый 10-й блок (10000, 10000), остальные (10, 10) - период из 10 блоков
+    // считается один раз, в цикле только memcpy
+    size_t tx_block_samples = txcfg.buffer_size / tx_sample_sz;
+    const size_t tx_marks[] = {0};
+    struct tx_waveform tx_wf;
+    if (tx_waveform_block_pattern(&tx_wf, tx_block_samples, 10, tx_marks, 1,
+                                  10000, 10000, 10, 10) < 0) {
+        fprintf(stderr, "Unable to alloc TX waveform\n");
+        return 1;
+    }
+
     int32_t counter = 0;
     // Открываем файл для записи данных
     std::ofstream outfile("rx_signal.txt", std::ios::out);
@@ -193,17 +206,10 @@ int main(){
         txblock = iio_buffer_create_block(txbuf, txcfg.buffer_size);
         /* WRITE: Get pointers to TX buf and write IQ to TX buf port 0 */
         p_inc = tx_sample_sz;
+        p_dat = static_cast<int16_t *>(iio_block_first(txblock, tx0_i));
         p_end = static_cast<int16_t *>(iio_block_end(txblock));
-        for (p_dat = static_cast<int16_t *>(iio_block_first(txblock, tx0_i)); p_dat < p_end;
-            p_dat += p_inc / sizeof(*p_dat)) {
-            if(counter % 10 == 0){
-                p_dat[0] = 10000; /* Real (I) */
-                p_dat[1] = 10000; /* Imag (Q) */
-            } else {
-                p_dat[0] = 10; /* Real (I) */
-                p_dat[1] = 10; /* Imag (Q) */
-            }
-        }
+        tx_waveform_fill(&tx_wf, p_dat, (p_end - p_dat) / (p_inc / sizeof(*p_dat)),
+                         (long long)counter * tx_block_samples);
 
         iio_block_enqueue(txblock, 0, false);
         iio_buffer_enable(txbuf);
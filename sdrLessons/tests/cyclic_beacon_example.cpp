@@ -0,0 +1,80 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+
+#include "sdr_stream.h"
+#include "rt_thread.h"
+#include "tx_waveform.h"
+
+/*
+ * Маяк на циклическом TX буфере: сигнал из main.cpp (постоянные 330 по I и Q)
+ * загружается в Pluto один раз и дальше крутится DMA самого Pluto.
+ * Хост и сеть свободны, поэтому один хост держит сколько угодно маяков:
+ *
+ *   ./cyclic_beacon_example ip:192.168.2.1 ip:192.168.3.1 ...
+ *
+ * Каждые 5 секунд сигнал на лету меняется на (10000, 10000) и обратно -
+ * пример горячей замены. Остановка по CTRL-C.
+ */
+
+#define BEACON_SAMPLES 4096
+
+int main(int argc, char **argv){
+    std::cout << "Hello, world!" << std::endl;
+    rt_shutdown_init();
+
+    std::vector<const char *> uris;
+    for (int k = 1; k < argc; k++)
+        uris.push_back(argv[k]);
+    if (uris.empty())
+        uris.push_back("ip:192.168.3.1");
+
+    // два сигнала для замены: блок целиком из одного значения
+    const size_t mark = 0;
+    struct tx_waveform low, high;
+    if (tx_waveform_block_pattern(&low, BEACON_SAMPLES, 1, NULL, 0, 0, 0, 330, 330) < 0 ||
+        tx_waveform_block_pattern(&high, BEACON_SAMPLES, 1, &mark, 1, 10000, 10000, 0, 0) < 0) {
+        fprintf(stderr, "Unable to alloc TX waveform\n");
+        return 1;
+    }
+
+    std::vector<struct sdr_stream *> radios;
+    for (size_t k = 0; k < uris.size(); k++) {
+        struct sdr_stream_cfg cfg;
+        sdr_stream_default_cfg(&cfg);
+        cfg.uri = uris[k];
+        cfg.enable_rx = false;
+
+        struct sdr_stream *s = new sdr_stream;
+        if (sdr_stream_open(s, &cfg) < 0 || sdr_stream_tx_cyclic(s, low.iq, low.len) < 0) {
+            fprintf(stderr, "* %s skipped\n", uris[k]);
+            sdr_stream_close(s);
+            delete s;
+            continue;
+        }
+        radios.push_back(s);
+    }
+    printf("* %zu beacons running\n", radios.size());
+
+    bool use_high = false;
+    while (!radios.empty() && !rt_shutdown_requested()) {
+        // ничего не делаем: eventfd остановки или таймаут 5 с
+        if (rt_shutdown_wait(5000))
+            break;
+        use_high = !use_high;
+        const struct tx_waveform *wf = use_high ? &high : &low;
+        for (size_t k = 0; k < radios.size(); k++)
+            sdr_stream_tx_cyclic(radios[k], wf->iq, wf->len);
+    }
+
+    printf("CTRL-C pressed\n");
+    for (size_t k = 0; k < radios.size(); k++) {
+        sdr_stream_close(radios[k]);
+        delete radios[k];
+    }
+    tx_waveform_free(&low);
+    tx_waveform_free(&high);
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <iostream>
+#include <vector>
+
+#include <iio/iio.h>
+
+#include "sdr_ctrl.h"
+#include "sdr_stream.h"
+#include "rt_thread.h"
+
+/*
+ * Задержка перестройки RX LO тремя способами:
+ *
+ *   retune_bench [uri=ip:192.168.2.1] [f0_mhz=2400] [step_mhz=5] [n=16] [hops=200]
+ *
+ *  naive    - как в примерах: find_channel + find_attr + запись frequency
+ *  cached   - sdr_ctrl_retune(): запись по найденному заранее атрибуту
+ *  fastlock - sdr_lo_table_hop(): профили n частот на хосте, recall из
+ *             слота чипа (load + recall, если профиля в слоте нет)
+ *
+ * Прыжки - по псевдослучайной последовательности из n частот f0 + k * step.
+ * При n <= 8 все профили помещаются в слоты, и прыжок - одна запись.
+ */
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void report(const char *name, std::vector<int64_t> &ns)
+{
+    if (ns.empty())
+        return;
+    double sum = 0.0;
+    int64_t mx = 0;
+    for (size_t k = 0; k < ns.size(); k++) {
+        sum += ns[k];
+        if (ns[k] > mx)
+            mx = ns[k];
+    }
+    printf("* %-8s: %zu hops, mean %8.1f us, max %8.1f us\n", name, ns.size(), sum / ns.size() * 1e-3, mx * 1e-3);
+}
+
+int main(int argc, char **argv){
+    std::cout << "Hello, world!" << std::endl;
+    rt_shutdown_init();
+
+    const char *uri = argc > 1 ? argv[1] : "ip:192.168.2.1";
+    double f0_mhz = argc > 2 ? atof(argv[2]) : 2400.0;
+    double step_mhz = argc > 3 ? atof(argv[3]) : 5.0;
+    size_t n = argc > 4 ? (size_t)atoi(argv[4]) : 16;
+    size_t hops = argc > 5 ? (size_t)atoi(argv[5]) : 200;
+    if (n < 2)
+        n = 2;
+
+    struct iio_context *ctx = iio_create_context(NULL, uri);
+    if (!ctx) {
+        fprintf(stderr, "Unable to create IIO context addr: %s\n", uri);
+        return 1;
+    }
+    struct iio_device *phy = iio_context_find_device(ctx, "ad9361-phy");
+    struct sdr_ctrl ctrl;
+    if (!phy || sdr_ctrl_init(&ctrl, phy) < 0) {
+        fprintf(stderr, "Unable to find ad9361-phy\n");
+        iio_context_destroy(ctx);
+        return 1;
+    }
+
+    std::vector<long long> freq(n);
+    for (size_t k = 0; k < n; k++)
+        freq[k] = MHZ(f0_mhz + k * step_mhz);
+    // одна и та же последовательность для всех способов, без повторов подряд
+    std::vector<size_t> seq(hops);
+    uint32_t lcg = 12345;
+    for (size_t h = 0; h < hops; h++) {
+        do {
+            lcg = lcg * 1664525u + 1013904223u;
+            seq[h] = (lcg >> 8) % n;
+        } while (h > 0 && seq[h] == seq[h - 1]);
+    }
+
+    std::vector<int64_t> t_naive, t_cached, t_fast;
+    for (size_t h = 0; h < hops && !rt_shutdown_requested(); h++) {
+        int64_t t0 = now_ns();
+        struct iio_channel *chn = iio_device_find_channel(phy, "altvoltage0", true);
+        const struct iio_attr *attr = chn ? iio_channel_find_attr(chn, "frequency") : NULL;
+        if (!attr || iio_attr_write_longlong(attr, freq[seq[h]]) < 0) {
+            fprintf(stderr, "Unable to write RX LO\n");
+            break;
+        }
+        t_naive.push_back(now_ns() - t0);
+    }
+
+    sdr_ctrl_invalidate(&ctrl);
+    for (size_t h = 0; h < hops && !rt_shutdown_requested(); h++) {
+        if (sdr_ctrl_retune(&ctrl, false, freq[seq[h]]) < 0)
+            break;
+        t_cached.push_back(ctrl.stats.retune_ns_last);
+    }
+
+    printf("* Profiling %zu LO frequencies from %.3f MHz\n", n, f0_mhz);
+    struct sdr_lo_table table;
+    if (sdr_lo_table_build(&ctrl, &table, false, freq.data(), n) == 0) {
+        unsigned long long loads0 = ctrl.stats.loads;
+        for (size_t h = 0; h < hops && !rt_shutdown_requested(); h++) {
+            if (sdr_lo_table_hop(&ctrl, &table, seq[h]) < 0)
+                break;
+            t_fast.push_back(ctrl.stats.retune_ns_last);
+        }
+        printf("* Fastlock slot loads: %llu of %zu hops\n", ctrl.stats.loads - loads0, t_fast.size());
+    }
+
+    report("naive", t_naive);
+    report("cached", t_cached);
+    report("fastlock", t_fast);
+    printf("* Attribute writes %llu, skipped %llu\n", ctrl.stats.writes, ctrl.stats.skipped);
+
+    iio_context_destroy(ctx);
+    return 0;
+}
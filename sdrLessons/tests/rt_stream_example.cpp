@@ -0,0 +1,149 @@
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <iostream>
+#include <fstream>
+#include <vector>
+
+#include "sdr_stream.h"
+#include "rt_thread.h"
+#include "burst_detector.h"
+#include "tx_waveform.h"
+#include "iq_server.h"
+#include "capture_file.h"
+
+/*
+ * Тот же сценарий, что в single_adalm_rxtx_costas.cpp, но на потоковом движке:
+ * RX/TX потоки на изолированных ядрах с SCHED_FIFO, DSP (детектор пакетов и
+ * запись) - в главном потоке на остальных ядрах. Остановка по CTRL-C.
+ *
+ *   rt_stream_example [full.iqz]
+ *
+ * С аргументом весь RX поток ещё и пишется без потерь в .iqz (capture_writer:
+ * сжатие на двух потоках пула, DSP поток только копирует блок).
+ */
+
+/*
+ * TX: пачка +-A каждые 10 сэмплов в чётных блоках, тишина в нечётных.
+ * Период - два блока, считается один раз; TX поток только копирует.
+ */
+static int make_tx_waveform(struct tx_waveform *wf, size_t block_size)
+{
+    std::vector<int16_t> iq(2 * 2 * block_size, 0);
+    for (size_t k = 0; k < block_size; k++) {
+        int16_t v = ((k / 10) & 1) ? -32 : 32;
+        iq[2 * k] = v;      /* Real (I) */
+        iq[2 * k + 1] = v;  /* Imag (Q) */
+    }
+    return tx_waveform_init(wf, iq.data(), 2 * block_size, block_size);
+}
+
+int main(int argc, char **argv){
+    std::cout << "Hello, world!" << std::endl;
+    rt_shutdown_init();
+
+    struct sdr_stream_cfg cfg;
+    sdr_stream_default_cfg(&cfg);
+    cfg.uri = "ip:192.168.3.1";
+
+    // DSP - на любом не изолированном ядре
+    std::vector<int> rt_cpus, dsp_cpus;
+    if (cfg.rx_thread.cpu >= 0)
+        rt_cpus.push_back(cfg.rx_thread.cpu);
+    if (cfg.tx_thread.cpu >= 0)
+        rt_cpus.push_back(cfg.tx_thread.cpu);
+    rt_other_cpus(rt_cpus, dsp_cpus);
+    struct rt_thread_cfg dsp_thread = {"sdr-dsp", dsp_cpus.empty() ? -1 : dsp_cpus[0], 0};
+    rt_thread_apply(&dsp_thread);
+    printf("* RX cpu %d, TX cpu %d, DSP cpu %d\n", cfg.rx_thread.cpu, cfg.tx_thread.cpu, dsp_thread.cpu);
+
+    struct sdr_stream stream;
+    if (sdr_stream_open(&stream, &cfg) < 0)
+        return 1;
+
+    struct burst_detector_cfg det_cfg = {};
+    det_cfg.window = 64;
+    det_cfg.on_db = 10;
+    det_cfg.off_db = 6;
+    det_cfg.hangover = 256;
+    det_cfg.noise_alpha = 0.001f;
+    struct burst_detector det;
+    if (burst_detector_init(&det, &det_cfg) < 0) {
+        fprintf(stderr, "Unable to init burst detector\n");
+        sdr_stream_close(&stream);
+        return 1;
+    }
+
+    // Открываем файл для записи данных (int16 I/Q, как читает plot_pcm.py)
+    std::ofstream outfile("rt_stream_rx.pcm", std::ios::out | std::ios::binary);
+    std::vector<int16_t> active_iq;
+    std::vector<struct burst_segment> bursts;
+
+    // сырые RX блоки - ещё и подписчикам по сети (tools/iq_client)
+    struct iq_server_cfg srv_cfg;
+    iq_server_default_cfg(&srv_cfg);
+    srv_cfg.block_samples = stream.cfg.block_size;    // с учётом профиля геометрии
+    struct iq_server srv;
+    bool srv_ok = iq_server_start(&srv, &srv_cfg) == 0;
+
+    struct capture_writer rec;
+    bool rec_ok = false;
+    if (argc > 1) {
+        struct capture_writer_cfg rec_cfg;
+        capture_writer_default_cfg(&rec_cfg);
+        rec_cfg.fs_hz = (double)cfg.rx.fs_hz;
+        rec_cfg.threads = 2;
+        rec_ok = capture_writer_open(&rec, argv[1], &rec_cfg) == 0;
+    }
+
+    struct tx_waveform tx_wf;
+    if (make_tx_waveform(&tx_wf, stream.cfg.block_size) < 0 ||
+        sdr_stream_start(&stream, tx_waveform_fill_cb, &tx_wf) < 0) {
+        sdr_stream_close(&stream);
+        tx_waveform_free(&tx_wf);
+        if (srv_ok)
+            iq_server_stop(&srv);
+        if (rec_ok)
+            capture_writer_close(&rec);
+        return 1;
+    }
+
+    while (!rt_shutdown_requested()) {
+        if (sdr_stream_rx_wait(&stream, 500) <= 0)
+            continue;
+
+        const struct iq_block_info *info;
+        const int16_t *iq;
+        while ((iq = iq_ring_read_begin(&stream.ring, &info)) != NULL) {
+            active_iq.clear();
+            bursts.clear();
+            burst_detector_process(&det, iq, info->n, &active_iq, &bursts);
+            if (srv_ok)
+                iq_server_publish(&srv, iq, info->n, info->index, info->host_ns);
+            if (rec_ok && capture_writer_write(&rec, iq, info->n) < 0) {
+                fprintf(stderr, "Unable to record RX, recording stopped\n");
+                capture_writer_close(&rec);
+                rec_ok = false;
+            }
+            iq_ring_read_release(&stream.ring);
+
+            for (size_t b = 0; b < bursts.size(); b++)
+                printf("burst [%lld, %lld) peak = %.1f dB, t = %.6f s\n", bursts[b].start, bursts[b].end,
+                       bursts[b].peak_db, sdr_stream_rx_time(&stream, bursts[b].start) * 1e-9);
+            outfile.write(reinterpret_cast<const char *>(active_iq.data()),
+                          active_iq.size() * sizeof(int16_t));
+        }
+    }
+
+    printf("CTRL-C pressed\n");
+    sdr_stream_stop(&stream);
+    sdr_stream_close(&stream);
+    tx_waveform_free(&tx_wf);
+    if (srv_ok)
+        iq_server_stop(&srv);
+    if (rec_ok && capture_writer_close(&rec) == 0)
+        printf("* recorded %s: %llu -> %llu bytes\n", argv[1], (unsigned long long)rec.raw_bytes,
+               (unsigned long long)rec.hdr.index_offset);
+    return 0;
+}
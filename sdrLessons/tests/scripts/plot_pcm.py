@@ -5,6 +5,12 @@ import numpy as np
 import matplotlib.pyplot as plt
 from scipy.signal import convolve, firwin
 
+# Нативные ядра (python/sdrpy.cpp, cmake -DSDR_PYTHON=ON), если собраны
+try:
+    import sdrpy
+except ImportError:
+    sdrpy = None
+
 def read_iq_data(filename: str, start_sample: int, end_sample: int) -> np.ndarray:
     """Читает I/Q данные из бинарного файла (формат int16, чередующиеся I/Q).
 
@@ -27,6 +33,14 @@ def read_iq_data(filename: str, start_sample: int, end_sample: int) -> np.ndarra
     if start_sample < 0 or end_sample <= start_sample:
         raise ValueError("Некорректные значения start_sample или end_sample (должно быть: 0 <= start_sample < end_sample).")
 
+    if sdrpy is not None:
+        try:
+            # .pcm и .iqz, срез - вид на mmap без копии
+            iq = sdrpy.Capture(filename).iq[start_sample // 2:end_sample // 2]
+        except ValueError:
+            raise FileNotFoundError(f"Файл не найден: {filename}") from None
+        return iq[:, 0].astype(np.float64) + 1j * iq[:, 1].astype(np.float64)
+
     try:
         with open(filename, "rb") as file:
             file.seek(start_sample * 2)  # int16 (это 2 байта)
@@ -189,6 +203,81 @@ def plot_constellation(signal: np.ndarray, title: str = "Диаграмма со
     ax.set_aspect('equal', 'box')
 
 
+def load_analytics(prefix: str) -> dict:
+    """Загружает результаты tools/iq_analyze (гистограммы .npy и статистику).
+
+    Args:
+        prefix: Префикс выходных файлов iq_analyze.
+
+    Returns:
+        Словарь: "stats" - числа из prefix_stats.txt, "extent" - границы осей,
+        "samples", "eye", "symbols" - гистограммы (symbols может отсутствовать).
+    """
+    stats, extent = {}, {}
+    with open(prefix + "_stats.txt") as f:
+        for line in f:
+            key, *values = line.split()
+            if key.endswith("_extent"):
+                extent[key[:-len("_extent")]] = [float(v) for v in values]
+            else:
+                stats[key] = float(values[0])
+
+    result = {"stats": stats, "extent": extent}
+    for name in ("samples", "eye", "symbols"):
+        try:
+            result[name] = np.load(f"{prefix}_{name}.npy")
+        except FileNotFoundError:
+            pass
+    return result
+
+
+def plot_density(hist: np.ndarray, extent: list, title: str, ax: plt.Axes = None, log: bool = True):
+    """Рисует готовую гистограмму плотности (созвездие или глаз) одной картинкой.
+
+    Args:
+        hist: Массив (строки по Y, столбцы по X), строка 0 - нижняя граница.
+        extent: [x0, x1, y0, y1].
+        title: Заголовок графика.
+        ax: Объект Matplotlib Axes (необязательно).
+        log: Логарифмическая шкала яркости.
+    """
+    if ax is None:
+        fig, ax = plt.subplots()
+
+    image = np.log1p(hist) if log else hist
+    ax.imshow(image, origin='lower', extent=extent, aspect='auto', cmap='inferno')
+    ax.set_title(title)
+    ax.grid(False)
+
+
+def plot_analytics(prefix: str):
+    """Отображает результаты tools/iq_analyze без обработки сэмплов в Python."""
+    data = load_analytics(prefix)
+    stats = data["stats"]
+    names = [n for n in ("samples", "eye", "symbols") if n in data]
+
+    fig, axes = plt.subplots(1, len(names), figsize=(6 * len(names), 5))
+    axes = np.atleast_1d(axes)
+    titles = {
+        "samples": "Плотность сэмплов",
+        "eye": "Глазковая диаграмма (I)",
+        "symbols": "Созвездие символов",
+    }
+    for ax, name in zip(axes, names):
+        plot_density(data[name], data["extent"][name], titles[name], ax)
+    axes[0].set_xlabel("I")
+    axes[0].set_ylabel("Q")
+
+    if "symbols_mer_db" in stats:
+        axes[-1].set_title(f"{titles['symbols']}: EVM {100 * stats['symbols_evm_rms']:.2f} %, "
+                           f"MER {stats['symbols_mer_db']:.1f} дБ")
+    print(f"IQ разбаланс: {stats['samples_gain_imb_db']:.3f} дБ, {stats['samples_phase_imb_deg']:.2f} град, "
+          f"SNR (M2M4) {stats['samples_snr_m2m4_db']:.1f} дБ")
+
+    plt.tight_layout()
+    plt.show()
+
+
 def create_raised_cosine_filter(sps: int, filter_length: int, rolloff: float = 0.2) -> np.ndarray:
     """Создает фильтр RC.
 
@@ -221,8 +310,14 @@ def main():
         "algorithm": 3,  # 3: Gardner, 4: Gardner (уст. к сдвигу), 5: M&M
         "filter_length": 11, # Должна быть нечётной для firwin с pass_zero=True
         "rolloff": 0.2, # Коэффициент сглаживания для RC фильтра.
+        # Префикс результатов tools/iq_analyze; если задан - рисуем готовые гистограммы
+        "analytics_prefix": None,
     }
 
+    if config["analytics_prefix"]:
+        plot_analytics(config["analytics_prefix"])
+        return
+
     try:
         iq_data = read_iq_data(config["filename"], config["start_sample"], config["end_sample"])
     except (FileNotFoundError, ValueError) as e:
@@ -233,7 +328,10 @@ def main():
 
     # --- Согласованная фильтрация ---
     matched_filter = create_raised_cosine_filter(config["sps"], config["filter_length"], config["rolloff"])
-    filtered_iq_data = convolve(iq_data, matched_filter, mode='full')[:len(iq_data)]
+    if sdrpy is not None:
+        filtered_iq_data = sdrpy.Fir(matched_filter).process(iq_data.astype(np.complex64)).astype(np.complex128)
+    else:
+        filtered_iq_data = convolve(iq_data, matched_filter, mode='full')[:len(iq_data)]
 
     # --- Выделение символов (до и после синхронизации) ---
     raw_symbols = iq_data[::config["sps"]]
@@ -11,6 +11,12 @@
 #include <math.h>
 #include <iostream>
 #include <fstream>
+#include <vector>
+
+#include "burst_detector.h"
+#include "rt_thread.h"
+#include "tx_waveform.h"
+#include "stream_geometry.h"
 
 /* helper macros */
 #define MHZ(x) ((long long)(x*1000000.0 + .5))
@@ -51,16 +57,6 @@ static void shutdown(void)
 	if (ctx) { iio_context_destroy(ctx); }
 }
 
-struct sigaction old_action;
-
-void sigint_handler(int sig_no)
-{
-    printf("CTRL-C pressed\n");
-    sigaction(SIGINT, &old_action, NULL);
-    shutdown();
-    exit(0);
-}
-
 /* common RX and TX streaming params */
 struct stream_cfg {
 	long long bw_hz; // Analog banwidth in Hz
@@ -71,10 +67,8 @@ struct stream_cfg {
 
 int main(){
     std::cout << "Hello, world!" << std::endl;
-    struct sigaction action;
-    memset(&action, 0, sizeof(action));
-    action.sa_handler = &sigint_handler;
-    sigaction(SIGINT, &action, &old_action);
+    // CTRL-C только выставляет флаг (eventfd), shutdown() зовётся после цикла
+    rt_shutdown_init();
 
     // Конфиг. параметры "потоков"
 	struct stream_cfg rxcfg;
@@ -178,8 +172,16 @@ int main(){
 	rxbuf = iio_device_create_buffer(rx_dev, 0, rxmask);
     txbuf = iio_device_create_buffer(tx_dev, 0, txmask);
 
-    rxstream = iio_buffer_create_stream(rxbuf, 4, pow(2, 13));
-    txstream = iio_buffer_create_stream(txbuf, 4, pow(2, 13));
+    // геометрия буферов - из профиля stream_autotune, если он есть
+    size_t block_size = pow(2, 13), block_count = 4;
+    struct stream_geometry geo;
+    if (stream_geometry_load(stream_geometry_default_path(), rxcfg.fs_hz, &geo) == 0) {
+        block_size = geo.block_size;
+        block_count = geo.block_count;
+    }
+    printf("* Blocks %zu x %zu\n", block_size, block_count);
+    rxstream = iio_buffer_create_stream(rxbuf, block_count, block_size);
+    txstream = iio_buffer_create_stream(txbuf, block_count, block_size);
     // RX and TX sample size
 	size_t rx_sample_sz, tx_sample_sz;
     rx_sample_sz = iio_device_get_sample_size(rx_dev, rxmask);
@@ -202,9 +204,40 @@ int main(){
     memset (tx_file_i, 0, 1000000);
     memset (tx_file_q, 0, 1000000);
 
+    // TX сигнал считается один раз (/ 2^9, к нулю) в формате блока IIO,
+    // дальше блок заполняется memcpy
+    struct tx_waveform tx_wf;
+    if (tx_waveform_from_iq(&tx_wf, tx_i, tx_q, 330, 9, block_size) < 0) {
+        fprintf(stderr, "Unable to alloc TX waveform\n");
+        shutdown();
+        return 1;
+    }
+
+    // Детектор пакетов: дальше (в файл) идут только сэмплы внутри пакетов.
+    // TX шлёт 330-сэмпловую последовательность, она же преамбула для squelch.
+    const int16_t *preamble = tx_wf.iq;
+    struct burst_detector_cfg det_cfg = {};
+    det_cfg.window = 64;
+    det_cfg.on_db = 10;
+    det_cfg.off_db = 6;
+    det_cfg.hangover = 256;
+    det_cfg.noise_alpha = 0.001f;
+    det_cfg.preamble = preamble;
+    det_cfg.preamble_len = 330;
+    det_cfg.preamble_thresh = 0.5f;
+    struct burst_detector det;
+    if (burst_detector_init(&det, &det_cfg) < 0) {
+        fprintf(stderr, "Unable to init burst detector\n");
+        tx_waveform_free(&tx_wf);
+        shutdown();
+        return 1;
+    }
+    std::vector<int16_t> active_iq;
+    std::vector<struct burst_segment> bursts;
+
     int32_t counter = 0;
     int32_t i = 0, j= 0;
-    while (counter < 30)
+    while (counter < 30 && !rt_shutdown_requested())
     {
         int16_t *p_dat, *p_end;
 		ptrdiff_t p_inc;
@@ -215,21 +248,13 @@ int main(){
 
         /* WRITE: Get pointers to TX buf and write IQ to TX buf port 0 */
         if(counter % 2 == 0){
+            // I/Q лежат подряд (tx_sample_sz = 4), каждый блок с начала последовательности
             p_inc = tx_sample_sz;
+            p_dat = static_cast<int16_t *>(iio_block_first(txblock, tx0_i));
             p_end = static_cast<int16_t *>(iio_block_end(txblock));
-            int counter_i = 0;
-            for (p_dat = static_cast<int16_t *>(iio_block_first(txblock, tx0_i)); p_dat < p_end;
-                p_dat += p_inc / sizeof(*p_dat))
-            {
-                if(counter_i < 330){
-                    p_dat[0] = (tx_i[counter_i]) / pow(2, 9);               // pow(2, 12); /* Real (I) */
-                    p_dat[1] = (tx_q[counter_i]) / pow(2, 9); 
-                } else {
-                    counter_i = 0;
-                }
-                counter_i++;
-                j++ ;
-            }
+            size_t tx_cnt = (p_end - p_dat) / (p_inc / sizeof(*p_dat));
+            tx_waveform_fill(&tx_wf, p_dat, tx_cnt, 0);
+            j += tx_cnt;
         } 
         // else 
         // {
@@ -251,25 +276,34 @@ int main(){
 		p_inc = rx_sample_sz;
 		p_end = static_cast<int16_t *>(iio_block_end(rxblock));
         printf("iio_block_first = %d, iio_block_end = %d, p_inc = %d\n", iio_block_first(rxblock, rx0_i), p_end, p_inc);
-		for (p_dat = static_cast<int16_t *> (iio_block_first(rxblock, rx0_i)); p_dat < p_end;
-		     p_dat += p_inc / sizeof(*p_dat)) {
-			/* Example: swap I and Q */
-			// int16_t i = p_dat[0];
-			// int16_t q = p_dat[1];
-            rx_i[i] = p_dat[0];
-            rx_q[i] = p_dat[1];
-            samples_cnt++;
+        // Один RX канал: I/Q лежат подряд (p_inc = 2 * sizeof(int16_t))
+        p_dat = static_cast<int16_t *> (iio_block_first(rxblock, rx0_i));
+        samples_cnt = (p_end - p_dat) / (p_inc / sizeof(*p_dat));
+        active_iq.clear();
+        bursts.clear();
+        burst_detector_process(&det, p_dat, samples_cnt, &active_iq, &bursts);
+        for (size_t b = 0; b < bursts.size(); b++) {
+            printf("burst [%lld, %lld) peak = %.1f dB corr = %.2f\n",
+                   bursts[b].start, bursts[b].end, bursts[b].peak_db, bursts[b].corr);
+        }
+        for (size_t k = 0; k + 1 < active_iq.size() && i < 1000000; k += 2) {
+            rx_i[i] = active_iq[k];
+            rx_q[i] = active_iq[k + 1];
             i++;
         }
-        printf("samples_cnt = %d\n", samples_cnt);
+        printf("samples_cnt = %d, active = %d\n", samples_cnt, (int)(active_iq.size() / 2));
         printf("i = %d\n", i);
 
 
         printf("counter = %d\n", counter);
         counter++;
     }
+    if (rt_shutdown_requested()) {
+        printf("CTRL-C pressed\n");
+    }
     shutdown();
-    for (int j = 0; j < 1000000; j++){
+    tx_waveform_free(&tx_wf);
+    for (int j = 0; j < i; j++){
         // printf("rx_i[i] = %d\n", rx_i[j]);
         // printf("rx_q[i] = %d\n", rx_q[j]);
         outfile << rx_i[j] << ", " << rx_q[j] << std::endl;
@@ -0,0 +1,62 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <iostream>
+#include <vector>
+
+#include "sdr_stream.h"
+#include "sdr_autotune.h"
+#include "stream_geometry.h"
+#include "rt_thread.h"
+
+/*
+ * Подбор геометрии буферов движка для частоты дискретизации:
+ *
+ *   stream_autotune [uri=ip:192.168.3.1] [fs_mhz=10] [seconds=1] [profile]
+ *
+ * Блоки 2^10 .. 2^16 x 2 .. 8, на каждую точку seconds секунд. TX
+ * соединить с RX (кабель через аттенюатор или антенны рядом) - тогда
+ * задержка меряется, иначе берётся расчётная. Лучшая точка пишется в
+ * профиль (по умолчанию $SDR_GEOMETRY_PROFILE или ~/.sdr_geometry), и
+ * sdr_stream_open() / single_adalm_rxtx_costas дальше берут её сами.
+ */
+
+int main(int argc, char **argv){
+    std::cout << "Hello, world!" << std::endl;
+    rt_shutdown_init();
+
+    struct sdr_stream_cfg cfg;
+    sdr_stream_default_cfg(&cfg);
+    cfg.uri = argc > 1 ? argv[1] : "ip:192.168.3.1";
+    if (argc > 2) {
+        double fs_mhz = atof(argv[2]);
+        cfg.rx.fs_hz = cfg.tx.fs_hz = MHZ(fs_mhz);
+        cfg.rx.bw_hz = cfg.tx.bw_hz = MHZ(fs_mhz);
+    }
+    struct sdr_autotune_cfg acfg;
+    sdr_autotune_default_cfg(&acfg);
+    if (argc > 3)
+        acfg.seconds = atof(argv[3]);
+    const char *profile = argc > 4 ? argv[4] : stream_geometry_default_path();
+
+    printf("* Autotune %s at %.3f MS/s, %.1f s per point\n", cfg.uri, cfg.rx.fs_hz / 1e6, acfg.seconds);
+    std::vector<struct sdr_autotune_point> points;
+    struct stream_geometry best;
+    int ret = sdr_autotune_run(&cfg, &acfg, points, &best);
+    if (ret < 0 && ret != -EAGAIN)
+        return 1;
+    if (rt_shutdown_requested()) {
+        printf("CTRL-C pressed, profile not written\n");
+        return 1;
+    }
+    if (ret == -EAGAIN)
+        printf("* No loss-free geometry, using the one with fewest losses\n");
+
+    printf("* Best: block %zu x %zu, latency %.2f ms, cpu %.1f%%\n", best.block_size, best.block_count,
+           best.latency_ms, best.cpu_pct);
+    if (stream_geometry_save(profile, &best) < 0)
+        return 1;
+    printf("* Saved to %s\n", profile);
+    return ret == 0 ? 0 : 2;
+}
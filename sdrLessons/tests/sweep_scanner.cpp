@@ -0,0 +1,102 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <iostream>
+#include <vector>
+
+#include "sdr_stream.h"
+#include "sdr_sweep.h"
+#include "rt_thread.h"
+
+/*
+ * Обзор диапазона шире полосы Pluto одним запуском:
+ *
+ *   sweep_scanner [uri=ip:192.168.2.1] [start_mhz=2400] [stop_mhz=2500] [fs_mhz=20]
+ *                 [passes=1] [out=sweep.txt] [fastlock=0]
+ *
+ * RX LO шагает по диапазону (sdr_sweep.h), после каждого прохода панорама
+ * пишется в out строками "freq_hz, dB" (как "I, Q" в rx_signal.txt).
+ * passes = 0 - до CTRL-C, файл переписывается после каждого прохода.
+ * fastlock = 1 - профили LO снимаются один раз, прыжки через fastlock_recall.
+ */
+
+static int save_panorama(const struct sdr_sweep *sw, const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Unable to open %s\n", path);
+        return -1;
+    }
+    for (size_t k = 0; k < sw->panorama.size(); k++)
+        fprintf(f, "%.0f, %.2f\n", sdr_sweep_bin_freq(sw, k), sw->panorama[k]);
+    fclose(f);
+    return 0;
+}
+
+int main(int argc, char **argv){
+    std::cout << "Hello, world!" << std::endl;
+    rt_shutdown_init();
+
+    struct sdr_sweep_cfg scfg;
+    sdr_sweep_default_cfg(&scfg);
+    struct sdr_stream_cfg cfg;
+    sdr_stream_default_cfg(&cfg);
+    cfg.uri = argc > 1 ? argv[1] : "ip:192.168.2.1";
+    if (argc > 2)
+        scfg.start_hz = MHZ(atof(argv[2]));
+    if (argc > 3)
+        scfg.stop_hz = MHZ(atof(argv[3]));
+    double fs_mhz = argc > 4 ? atof(argv[4]) : 20.0;
+    long passes = argc > 5 ? atol(argv[5]) : 1;
+    const char *out = argc > 6 ? argv[6] : "sweep.txt";
+    scfg.fastlock = argc > 7 && atoi(argv[7]) != 0;
+
+    cfg.rx.fs_hz = MHZ(fs_mhz);
+    cfg.rx.bw_hz = MHZ(fs_mhz);
+    cfg.rx.lo_hz = scfg.start_hz;
+    cfg.enable_tx = false;
+
+    struct sdr_stream stream;
+    if (sdr_stream_open(&stream, &cfg) < 0)
+        return 1;
+    // усиление не должно меняться между шагами
+    sdr_ctrl_set_str(&stream.ctrl, CTRL_RX_GAIN_MODE, "manual");
+    sdr_ctrl_set_double(&stream.ctrl, CTRL_RX_GAIN, 40.0);
+    sdr_ctrl_commit(&stream.ctrl);
+
+    if (sdr_stream_start(&stream, NULL, NULL) < 0) {
+        sdr_stream_stop(&stream);
+        sdr_stream_close(&stream);
+        return 1;
+    }
+
+    struct sdr_sweep sw;
+    int ret = sdr_sweep_init(&sw, &stream, &scfg);
+    if (ret < 0) {
+        fprintf(stderr, "Unable to start sweep\n");
+        sdr_stream_stop(&stream);
+        sdr_stream_close(&stream);
+        return 1;
+    }
+
+    for (long p = 0; (passes == 0 || p < passes) && !rt_shutdown_requested(); p++) {
+        ret = sdr_sweep_run(&sw);
+        if (ret < 0)
+            break;
+        printf("* Pass %ld: %zu steps in %.1f ms (retune %.1f ms), %.1f steps/s, settle drop %lld, ring drops %lld\n",
+               p, sw.centers.size(), sw.stats.sweep_s * 1e3, sw.stats.retune_s * 1e3,
+               sw.centers.size() / sw.stats.sweep_s, sw.stats.settle_dropped, sw.stats.ring_overflows);
+        save_panorama(&sw, out);
+    }
+    if (rt_shutdown_requested())
+        printf("CTRL-C pressed\n");
+
+    printf("* LO retunes %llu, mean %.1f us, max %.1f us\n", stream.ctrl.stats.retunes,
+           stream.ctrl.stats.retunes ? stream.ctrl.stats.retune_ns_sum * 1e-3 / stream.ctrl.stats.retunes : 0.0,
+           stream.ctrl.stats.retune_ns_max * 1e-3);
+    sdr_sweep_destroy(&sw);
+    sdr_stream_stop(&stream);
+    sdr_stream_close(&stream);
+    return ret < 0 && ret != -EINTR ? 1 : 0;
+}
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <vector>
+
+#include "capture_file.h"
+#include "fft_correlator.h"
+#include "sequences.h"
+
+/*
+ * Поиск преамбул в записи через fft_correlator и замер его темпа на
+ * одном ядре против частоты дискретизации.
+ *
+ *   corr_search <capture.pcm|.iqz> [sps=10] [seq=all] [min_corr=0.6] [fs_msps=10] [fft_len=0]
+ *
+ * seq: mls8 (max_len_seq(8)), barker7, ts1..ts4 или all - все за один
+ * проход. Запись подаётся блоками по 8192 сэмпла, как RX блоки движка.
+ * fs_msps - для .iqz берётся из заголовка, если там есть. fft_len = 0 -
+ * степень двойки не меньше 4 длин самого длинного шаблона.
+ */
+
+#define BLOCK_SAMPLES   8192
+#define PRINT_PEAKS     20
+
+static double elapsed_s(const struct timespec *a, const struct timespec *b)
+{
+    return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) * 1e-9;
+}
+
+static int add_seq(struct fft_correlator *fc, const char *name, unsigned sps)
+{
+    std::vector<float> sym;
+    if (strcmp(name, "mls8") == 0) {
+        std::vector<uint8_t> bits;
+        max_len_seq(8, bits);
+        sym = sequence_to_bpsk(bits.data(), bits.size());
+    } else if (strcmp(name, "barker7") == 0) {
+        sym.assign(barker7, barker7 + 7);
+    } else if (strncmp(name, "ts", 2) == 0 && name[2] >= '1' && name[2] <= '4' && name[3] == 0) {
+        sym = sequence_to_bpsk(training_seq[name[2] - '1'], 26);
+    } else {
+        return -1;
+    }
+    return fft_correlator_add_bpsk_template(fc, sym.data(), sym.size(), sps);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <capture.pcm|.iqz> [sps=10] [seq=all] [min_corr=0.6] [fs_msps=10] [fft_len=0]\n",
+                argv[0]);
+        return 1;
+    }
+    unsigned sps = argc > 2 ? atoi(argv[2]) : 10;
+    const char *seq = argc > 3 ? argv[3] : "all";
+    float min_corr = argc > 4 ? atof(argv[4]) : 0.6f;
+    double fs = (argc > 5 ? atof(argv[5]) : 10.0) * 1e6;
+    size_t fft_len = argc > 6 ? strtoull(argv[6], NULL, 0) : 0;
+
+    static const char *const all[] = {"mls8", "barker7", "ts1", "ts2", "ts3", "ts4"};
+    std::vector<const char *> names;
+    if (strcmp(seq, "all") == 0)
+        names.assign(all, all + 6);
+    else
+        names.push_back(seq);
+
+    // шаблоны добавляются до первого process: длина известна заранее
+    size_t max_len = 0;
+    for (size_t k = 0; k < names.size(); k++) {
+        size_t len = strcmp(names[k], "mls8") == 0 ? 255 : strcmp(names[k], "barker7") == 0 ? 7 : 26;
+        if (len * sps > max_len)
+            max_len = len * sps;
+    }
+    if (fft_len == 0)
+        fft_len = fft_next_pow2(4 * max_len > 4096 ? 4 * max_len : 4096);
+
+    struct fft_correlator_cfg cfg;
+    cfg.fft_len = fft_len;
+    cfg.min_corr = min_corr;
+    cfg.cfar_factor = 10.0f;
+    cfg.cfar_guard = sps;
+    cfg.cfar_train = 8 * sps;
+    struct fft_correlator fc;
+    if (sps == 0 || fft_correlator_init(&fc, &cfg) < 0) {
+        fprintf(stderr, "Bad fft_len = %zu\n", fft_len);
+        return 1;
+    }
+    for (size_t k = 0; k < names.size(); k++) {
+        if (add_seq(&fc, names[k], sps) < 0) {
+            fprintf(stderr, "Unable to add template %s (fft_len %zu)\n", names[k], fft_len);
+            return 1;
+        }
+    }
+
+    struct capture_file cf;
+    if (capture_open(&cf, argv[1]) < 0)
+        return 1;
+    if (cf.compressed && cf.hdr.fs_hz > 0.0)
+        fs = cf.hdr.fs_hz;
+
+    std::vector<struct corr_peak> peaks;
+    std::vector<size_t> per_tmpl(names.size(), 0);
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (size_t pos = 0; pos < cf.n_samples; pos += BLOCK_SAMPLES) {
+        size_t n = cf.n_samples - pos < BLOCK_SAMPLES ? cf.n_samples - pos : BLOCK_SAMPLES;
+        fft_correlator_process_iq16(&fc, capture_samples(&cf, pos), n, &peaks);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    for (size_t k = 0; k < peaks.size(); k++) {
+        per_tmpl[peaks[k].tmpl]++;
+        if (k < PRINT_PEAKS)
+            printf("%-8s %12.2f  corr %.3f  phase %+6.1f deg  cfar %.1f\n", names[peaks[k].tmpl],
+                   peaks[k].frac_index, peaks[k].corr, peaks[k].phase * 57.29578f, peaks[k].cfar_ratio);
+    }
+    if (peaks.size() > PRINT_PEAKS)
+        printf("... %zu more\n", peaks.size() - PRINT_PEAKS);
+    for (size_t k = 0; k < names.size(); k++)
+        printf("* %s: %zu peaks\n", names[k], per_tmpl[k]);
+
+    double t = elapsed_s(&t0, &t1);
+    double rate = cf.n_samples / t;
+    printf("* %zu templates, fft_len %zu: %.1f MS/s on one core, %.2fx of fs %.1f MS/s%s\n", names.size(),
+           fft_len, rate / 1e6, rate / fs, fs / 1e6, rate < fs ? " - NOT real time" : "");
+
+    capture_close(&cf);
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <vector>
+
+#include "capture_file.h"
+#include "ddc.h"
+
+/*
+ * Вырезать узкий сигнал из широкой записи (вместо np.exp(-1j*2*pi*f*t) по
+ * всему массиву в plot_data.py без децимации):
+ *
+ *   ddc_extract capture.{pcm,iqz} out.pcm freq_hz [decim=32] [fs=10e6]
+ *
+ * freq_hz - сдвиг сигнала от LO. decim = R * 2^k: до двух полуполосных
+ * ступеней, остальное - CIC. Выход - int16 I/Q на fs / decim (как
+ * читает plot_pcm.py), масштаб тот же 2048.
+ */
+
+static double elapsed_s(const struct timespec *a, const struct timespec *b)
+{
+    return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 4) {
+        fprintf(stderr, "usage: %s capture.{pcm,iqz} out.pcm freq_hz [decim=32] [fs=10e6]\n", argv[0]);
+        return 1;
+    }
+    unsigned decim = argc > 4 ? (unsigned)atoi(argv[4]) : 32;
+    struct capture_file cf;
+    if (capture_open(&cf, argv[1]) < 0)
+        return 1;
+    double fs = argc > 5 ? atof(argv[5]) : (cf.compressed && cf.hdr.fs_hz > 0.0 ? cf.hdr.fs_hz : 10e6);
+
+    struct ddc_cfg cfg;
+    ddc_default_cfg(&cfg, fs);
+    cfg.freq = atof(argv[3]);
+    cfg.hb_stages = 0;
+    while (cfg.hb_stages < 2 && decim % (2u << cfg.hb_stages) == 0)
+        cfg.hb_stages++;
+    cfg.cic_decim = decim >> cfg.hb_stages;
+    if (cfg.cic_decim == 1)
+        cfg.cfir_taps = 0;      // без CIC нечего компенсировать
+    struct ddc d;
+    if (decim == 0 || ddc_init(&d, &cfg) < 0) {
+        fprintf(stderr, "Unable to build DDC for decimation %u\n", decim);
+        capture_close(&cf);
+        return 1;
+    }
+
+    FILE *out = fopen(argv[2], "wb");
+    if (!out) {
+        fprintf(stderr, "Unable to open %s\n", argv[2]);
+        capture_close(&cf);
+        return 1;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    const size_t chunk = 65536;
+    std::vector<cf_t> y;
+    std::vector<int16_t> iq;
+    size_t produced = 0;
+    for (size_t pos = 0; pos < cf.n_samples; pos += chunk) {
+        size_t n = cf.n_samples - pos < chunk ? cf.n_samples - pos : chunk;
+        y.clear();
+        ddc_process_iq16(&d, capture_samples(&cf, pos), n, y);
+        iq.resize(2 * y.size());
+        for (size_t k = 0; k < y.size(); k++) {
+            float re = y[k].real() * 2048.0f, im = y[k].imag() * 2048.0f;
+            iq[2 * k] = (int16_t)lrintf(fminf(fmaxf(re, -32768.0f), 32767.0f));
+            iq[2 * k + 1] = (int16_t)lrintf(fminf(fmaxf(im, -32768.0f), 32767.0f));
+        }
+        fwrite(iq.data(), sizeof(int16_t), iq.size(), out);
+        produced += y.size();
+    }
+    fclose(out);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    double dt = elapsed_s(&t0, &t1);
+    printf("* %zu -> %zu samples (CIC %u x HB %u, %.1f kS/s), %.1f MS/s\n", cf.n_samples, produced,
+           cfg.cic_decim, 1u << cfg.hb_stages, fs / decim * 1e-3, dt > 0.0 ? cf.n_samples / dt * 1e-6 : 0.0);
+    capture_close(&cf);
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include <random>
+#include <vector>
+
+#include "demapper.h"
+#include "fec.h"
+
+/*
+ * Проверка FEC без радио: пакеты через AWGN, BER/PER без кода (жёсткие
+ * решения) и с кодом K = 7 (LLR демаппера -> Витерби), скорость демаппера
+ * и декодера. Шум для LLR демаппер оценивает сам по EVM принятых символов.
+ * Те же данные (packet_bits / 8 байт) идут и кадром fec_packet_encode:
+ * доля доставленных кадров и кадров с ошибкой, пропущенной CRC.
+ *
+ *   fec_ber [mod=qpsk] [ebn0_from=0] [ebn0_to=7] [packet_bits=1024] [packets=300]
+ *
+ * mod: bpsk, qpsk, 8psk, 16qam. Eb/N0 - на информационный бит.
+ */
+
+static double elapsed_s(const struct timespec *a, const struct timespec *b)
+{
+    return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) * 1e-9;
+}
+
+/* Биты -> символы (хвост дополняется нулями до целого символа) + шум N0 */
+static void modulate_awgn(const struct demapper *d, std::vector<uint8_t> &bits, size_t nbits, float n0,
+                          std::mt19937 &rng, std::vector<cf_t> &syms)
+{
+    size_t nsym = (nbits + d->bps - 1) / d->bps;
+    bits.resize(nsym * d->bps, 0);
+    syms.resize(nsym);
+    demapper_map(d, bits.data(), nsym * d->bps, syms.data());
+    std::normal_distribution<float> noise(0.0f, sqrtf(n0 / 2.0f));
+    for (size_t k = 0; k < nsym; k++)
+        syms[k] += cf_t(noise(rng), noise(rng));
+}
+
+int main(int argc, char **argv)
+{
+    int mod = demap_mod_parse(argc > 1 ? argv[1] : "qpsk");
+    double from = argc > 2 ? atof(argv[2]) : 0.0;
+    double to = argc > 3 ? atof(argv[3]) : 7.0;
+    size_t nbits = argc > 4 ? strtoull(argv[4], NULL, 0) : 1024;
+    size_t packets = argc > 5 ? strtoull(argv[5], NULL, 0) : 300;
+    struct demapper dm;
+    if (mod < 0 || demapper_init(&dm, mod) < 0 || nbits == 0 || packets == 0) {
+        fprintf(stderr, "usage: %s [bpsk|qpsk|8psk|16qam] [ebn0_from=0] [ebn0_to=7] [packet_bits=1024] [packets=300]\n",
+                argv[0]);
+        return 1;
+    }
+
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> coin(0, 1);
+    const size_t ncoded = fec_conv_coded_len(nbits);
+    std::vector<uint8_t> bits(nbits), tx, coded(ncoded), out(nbits + dm.bps);
+    std::vector<int8_t> soft(ncoded + dm.bps);
+    std::vector<cf_t> syms;
+    const size_t frame_len = nbits / 8 < FEC_PACKET_MAX ? nbits / 8 : FEC_PACKET_MAX;
+    const size_t frame_coded = fec_packet_coded_len(frame_len);
+    std::vector<uint8_t> frame(frame_len), frame_out(frame_len), frame_bits(frame_coded);
+    std::vector<int8_t> frame_soft(frame_coded + dm.bps);
+
+    struct fec_viterbi vit;
+    fec_viterbi_init(&vit);
+    double dec_s = 0.0, demap_s = 0.0;
+    size_t dec_bits = 0, demap_syms = 0;
+
+    printf("Eb/N0 dB   BER uncoded  PER uncoded   BER coded   PER coded   EVM est          frames ok  undetected\n");
+    for (double ebn0 = from; ebn0 <= to + 1e-9; ebn0 += 1.0) {
+        double ebn0_lin = pow(10.0, ebn0 / 10.0);
+        // Es = 1: N0 = 1 / (bps * R * Eb/N0)
+        float n0_raw = (float)(1.0 / (dm.bps * ebn0_lin));
+        float n0_fec = (float)(1.0 / (dm.bps * ebn0_lin * nbits / ncoded));
+        float n0_frame = (float)(1.0 / (dm.bps * ebn0_lin * 8.0 * (frame_len ? frame_len : 1) / frame_coded));
+        size_t err_raw = 0, err_fec = 0, pkt_raw = 0, pkt_fec = 0, frame_ok = 0, frame_bad = 0;
+        double evm = 0.0;
+
+        for (size_t p = 0; p < packets; p++) {
+            for (size_t k = 0; k < nbits; k++)
+                bits[k] = (uint8_t)coin(rng);
+
+            // без кода
+            tx.assign(bits.begin(), bits.end());
+            modulate_awgn(&dm, tx, nbits, n0_raw, rng, syms);
+            demapper_estimate(&dm, syms.data(), syms.size());
+            demap_hard(&dm, syms.data(), syms.size(), out.data());
+            size_t e = 0;
+            for (size_t k = 0; k < nbits; k++)
+                e += out[k] != bits[k];
+            err_raw += e;
+            pkt_raw += e > 0;
+
+            // K = 7, R = 1/2
+            fec_conv_encode(bits.data(), nbits, coded.data());
+            tx.assign(coded.begin(), coded.end());
+            modulate_awgn(&dm, tx, ncoded, n0_fec, rng, syms);
+            struct timespec t0, t1, t2;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            evm += demapper_estimate(&dm, syms.data(), syms.size());
+            demap_soft(&dm, syms.data(), syms.size(), soft.data());
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            fec_viterbi_decode(&vit, soft.data(), nbits, out.data());
+            clock_gettime(CLOCK_MONOTONIC, &t2);
+            demap_s += elapsed_s(&t0, &t1);
+            dec_s += elapsed_s(&t1, &t2);
+            demap_syms += syms.size();
+            dec_bits += nbits;
+            e = 0;
+            for (size_t k = 0; k < nbits; k++)
+                e += out[k] != bits[k];
+            err_fec += e;
+            pkt_fec += e > 0;
+
+            // кадр чата/TUN: заголовок с длиной + данные с CRC-32
+            for (size_t k = 0; k < frame_len; k++)
+                frame[k] = (uint8_t)(rng() & 0xff);
+            fec_packet_encode(frame.data(), frame_len, frame_bits.data());
+            tx.assign(frame_bits.begin(), frame_bits.end());
+            modulate_awgn(&dm, tx, frame_coded, n0_frame, rng, syms);
+            demapper_estimate(&dm, syms.data(), syms.size());
+            demap_soft(&dm, syms.data(), syms.size(), frame_soft.data());
+            int len = fec_packet_decode_hdr(&vit, frame_soft.data());
+            if (len == (int)frame_len &&
+                fec_packet_decode_body(&vit, frame_soft.data() + FEC_PACKET_HDR_SOFT, len, frame_out.data()) == 0) {
+                if (frame_out == frame)
+                    frame_ok++;
+                else
+                    frame_bad++;
+            } else if (len >= 0 && len != (int)frame_len) {
+                frame_bad++;       // заголовок прошёл CRC-8 с неверной длиной
+            }
+        }
+
+        double total = (double)packets * nbits;
+        printf("%7.1f   %11.3e  %11.3f   %9.3e   %9.3f   %5.1f%% (%.1f%%)   %9.3f  %10zu\n", ebn0, err_raw / total,
+               (double)pkt_raw / packets, err_fec / total, (double)pkt_fec / packets,
+               100.0 * evm / packets, 100.0 * sqrt(n0_fec), (double)frame_ok / packets, frame_bad);
+    }
+    printf("* demapper (EVM estimate + LLR): %.2f Msym/s, Viterbi: %.1f Mbit/s decoded on one core\n",
+           demap_syms / demap_s / 1e6, dec_bits / dec_s / 1e6);
+    return 0;
+}
@@ -0,0 +1,266 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+
+#include "capture_file.h"
+#include "iq_analytics.h"
+#include "work_pool.h"
+
+/*
+ * Аналитика записи для plot_pcm.py: вместо scatter/plot на каждый сэмпл
+ * считаем гистограммы плотности и статистику параллельно по кускам.
+ *
+ * Вход: запись int16 I/Q и (необязательно) символы complex64 после
+ * offline_demod. Выход (prefix = out_prefix):
+ *   prefix_samples.npy  - плотность сырых сэмплов на плоскости I/Q
+ *   prefix_eye.npy      - глаз по I, два символа
+ *   prefix_symbols.npy  - плотность символов (если дан symbols.c64)
+ *   prefix_stats.txt    - "ключ значение": оценки и границы осей гистограмм
+ *
+ * Каждый поток пула копит свои гистограммы, в конце они складываются.
+ */
+
+#define HIST_BINS       256
+#define EYE_COLS_PER_SAMPLE 16
+#define CHUNK_SAMPLES   ((size_t)1 << 20)
+
+struct acc {
+    struct iq_stats stats;
+    struct density_hist iq;
+    struct density_hist eye;
+};
+
+static double elapsed_s(const struct timespec *a, const struct timespec *b)
+{
+    return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) * 1e-9;
+}
+
+static void iq16_to_cf(const int16_t *iq, size_t n, cf_t *out)
+{
+    for (size_t k = 0; k < n; k++)
+        out[k] = cf_t(iq[2 * k] / 2048.0f, iq[2 * k + 1] / 2048.0f);
+}
+
+/* Кусок записи [from, to): to включительно для последнего отрезка глаза */
+static void samples_chunk(const struct capture_file *cf, size_t from, size_t to,
+                          unsigned sps, bool hist, struct acc *a)
+{
+    cf_t tmp[4097];
+    for (size_t s = from; s < to; s += 4096) {
+        size_t n = to - s < 4096 ? to - s : 4096;
+        size_t m = n + (s + n < cf->n_samples ? 1 : 0);     // +1 сэмпл на стыке для глаза
+        iq16_to_cf(capture_samples(cf, s), m, tmp);
+        if (!hist) {
+            iq_stats_add(&a->stats, tmp, n);
+            continue;
+        }
+        density_hist_add_iq(&a->iq, tmp, n);
+        density_hist_add_eye(&a->eye, tmp, m, sps, (long long)s);
+    }
+}
+
+static void symbols_chunk(const cf_t *syms, size_t n, bool hist, struct acc *a)
+{
+    if (hist)
+        density_hist_add_iq(&a->iq, syms, n);
+    else
+        iq_stats_add(&a->stats, syms, n);
+}
+
+/* Разослать куски [0, total) пулу; fn(from, to, acc потока) */
+template <typename F>
+static void run_chunks(struct work_pool *pool, size_t total, std::vector<struct acc> &accs, F fn)
+{
+    for (size_t from = 0; from < total; from += CHUNK_SAMPLES) {
+        size_t to = from + CHUNK_SAMPLES < total ? from + CHUNK_SAMPLES : total;
+        work_pool_submit(pool, [&accs, fn, from, to] {
+            fn(from, to, &accs[work_pool_thread_index()]);
+        });
+    }
+    work_pool_wait(pool);
+}
+
+static void reduce(std::vector<struct acc> &accs, bool hist, struct acc *out)
+{
+    for (size_t k = 1; k < accs.size(); k++) {
+        if (hist) {
+            density_hist_merge(&accs[0].iq, &accs[k].iq);
+            density_hist_merge(&accs[0].eye, &accs[k].eye);
+        } else {
+            iq_stats_merge(&accs[0].stats, &accs[k].stats);
+        }
+    }
+    *out = accs[0];
+}
+
+static void reset_accs(std::vector<struct acc> &accs, const struct density_hist *iq,
+                       const struct density_hist *eye)
+{
+    for (size_t k = 0; k < accs.size(); k++) {
+        iq_stats_reset(&accs[k].stats);
+        accs[k].iq = *iq;
+        accs[k].eye = *eye;
+    }
+}
+
+static void print_report(FILE *f, const char *name, const struct iq_stats *s)
+{
+    struct iq_report r;
+    iq_stats_report(s, &r);
+    fprintf(f, "%s_count %zu\n", name, s->n);
+    fprintf(f, "%s_power %.6g\n", name, r.power);
+    fprintf(f, "%s_dc_i %.6g\n%s_dc_q %.6g\n", name, r.dc_i, name, r.dc_q);
+    fprintf(f, "%s_evm_rms %.6g\n%s_mer_db %.3f\n", name, r.evm_rms, name, r.mer_db);
+    fprintf(f, "%s_snr_m2m4_db %.3f\n", name, r.snr_m2m4_db);
+    fprintf(f, "%s_gain_imb_db %.4f\n%s_phase_imb_deg %.4f\n", name, r.gain_imb_db, name, r.phase_imb_deg);
+}
+
+static void print_extent(FILE *f, const char *name, const struct density_hist *d)
+{
+    fprintf(f, "%s_extent %g %g %g %g\n", name, d->x0, d->x1, d->y0, d->y1);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <capture.pcm> <out_prefix> [sps=10] [threads=0] [symbols.c64]\n", argv[0]);
+        return 1;
+    }
+    const char *in_name = argv[1];
+    std::string prefix = argv[2];
+    unsigned sps = argc > 3 ? atoi(argv[3]) : 10;
+    size_t threads = argc > 4 ? atoi(argv[4]) : 0;
+    const char *sym_name = argc > 5 ? argv[5] : NULL;
+    if (sps == 0) {
+        fprintf(stderr, "Bad sps = %u\n", sps);
+        return 1;
+    }
+
+    struct capture_file cf;
+    if (capture_open(&cf, in_name) < 0)
+        return 1;
+
+    struct work_pool pool;
+    work_pool_init(&pool, threads);
+    std::vector<struct acc> accs(work_pool_size(&pool));
+    struct density_hist empty;
+    density_hist_init(&empty, 1, 1, 0.0f, 1.0f, 0.0f, 1.0f);
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    /* 1: моменты сырых сэмплов - из них же границы гистограмм */
+    struct acc samples;
+    reset_accs(accs, &empty, &empty);
+    run_chunks(&pool, cf.n_samples, accs, [&cf, sps](size_t from, size_t to, struct acc *a) {
+        samples_chunk(&cf, from, to, sps, false, a);
+    });
+    reduce(accs, false, &samples);
+    struct iq_report rs;
+    iq_stats_report(&samples.stats, &rs);
+    float lim = (float)(1.5 * sqrt(rs.power) + fmax(fabs(rs.dc_i), fabs(rs.dc_q)));
+    if (!(lim > 0.0f))
+        lim = 1.0f;
+
+    /* 2: плотность на плоскости I/Q и глаз */
+    struct density_hist iq0, eye0;
+    density_hist_init(&iq0, HIST_BINS, HIST_BINS, -lim, lim, -lim, lim);
+    density_hist_init(&eye0, 2 * sps * EYE_COLS_PER_SAMPLE, HIST_BINS, 0.0f, 2.0f * sps, -lim, lim);
+    reset_accs(accs, &iq0, &eye0);
+    run_chunks(&pool, cf.n_samples, accs, [&cf, sps](size_t from, size_t to, struct acc *a) {
+        samples_chunk(&cf, from, to, sps, true, a);
+    });
+    struct acc hists;
+    reduce(accs, true, &hists);
+
+    /* 3: символы */
+    struct acc symbols;
+    bool have_syms = false;
+    if (sym_name) {
+        int fd = open(sym_name, O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(cf_t)) {
+            fprintf(stderr, "Unable to open %s\n", sym_name);
+        } else {
+            size_t n = st.st_size / sizeof(cf_t);
+            void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map == MAP_FAILED) {
+                perror("mmap");
+            } else {
+                const cf_t *syms = (const cf_t *)map;
+                reset_accs(accs, &empty, &empty);
+                run_chunks(&pool, n, accs, [syms](size_t from, size_t to, struct acc *a) {
+                    symbols_chunk(syms + from, to - from, false, a);
+                });
+                reduce(accs, false, &symbols);
+
+                // точки QPSK в (+-a, +-a), поле +-2a
+                float a = (float)(symbols.stats.m[5] / (2.0 * symbols.stats.n));
+                float sl = a > 0.0f ? 2.0f * a : 1.0f;
+                struct density_hist s0;
+                density_hist_init(&s0, HIST_BINS, HIST_BINS, -sl, sl, -sl, sl);
+                reset_accs(accs, &s0, &empty);
+                run_chunks(&pool, n, accs, [syms](size_t from, size_t to, struct acc *a) {
+                    symbols_chunk(syms + from, to - from, true, a);
+                });
+                struct acc sh;
+                reduce(accs, true, &sh);
+                symbols.iq = sh.iq;
+                have_syms = true;
+                munmap(map, st.st_size);
+            }
+        }
+        if (fd >= 0)
+            close(fd);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    work_pool_destroy(&pool);
+
+    /* выход */
+    int ret = 0;
+    ret |= density_hist_save_npy(&hists.iq, (prefix + "_samples.npy").c_str());
+    ret |= density_hist_save_npy(&hists.eye, (prefix + "_eye.npy").c_str());
+    if (have_syms)
+        ret |= density_hist_save_npy(&symbols.iq, (prefix + "_symbols.npy").c_str());
+
+    std::string stats_name = prefix + "_stats.txt";
+    FILE *f = fopen(stats_name.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "Unable to open %s for writing\n", stats_name.c_str());
+        capture_close(&cf);
+        return 1;
+    }
+    fprintf(f, "sps %u\n", sps);
+    print_report(f, "samples", &samples.stats);
+    print_extent(f, "samples", &hists.iq);
+    print_extent(f, "eye", &hists.eye);
+    if (have_syms) {
+        print_report(f, "symbols", &symbols.stats);
+        print_extent(f, "symbols", &symbols.iq);
+    }
+    fclose(f);
+
+    double td = elapsed_s(&t0, &t1);
+    printf("* %s: %zu samples in %.3f s (%.1f MS/s) -> %s_*\n",
+           in_name, cf.n_samples, td, cf.n_samples / td / 1e6, prefix.c_str());
+    if (have_syms) {
+        struct iq_report r;
+        iq_stats_report(&symbols.stats, &r);
+        printf("* symbols: %zu, EVM %.2f %%, MER %.1f dB, SNR(M2M4) %.1f dB\n",
+               symbols.stats.n, 100.0 * r.evm_rms, r.mer_db, r.snr_m2m4_db);
+    }
+    printf("* samples: DC %.4f/%.4f, IQ gain %.3f dB, phase %.2f deg\n",
+           rs.dc_i, rs.dc_q, rs.gain_imb_db, rs.phase_imb_deg);
+
+    capture_close(&cf);
+    return ret ? 1 : 0;
+}
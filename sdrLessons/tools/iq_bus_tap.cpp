@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "capture_file.h"
+#include "iq_bus.h"
+#include "rt_thread.h"
+
+/*
+ * Читатель шины iq_bus.h: ещё один процесс на тех же RX блоках, без
+ * второго подключения к IIO.
+ *
+ *   iq_bus_tap [bus=/sdr_iq_bus] [out.iqz|-] [delay_us=0]
+ *
+ * Раз в секунду - темп, мощность, потерянные блоки (отставание и
+ * перезапись во время чтения) и пометка slow от писателя. out.iqz -
+ * запись потока через capture_writer. delay_us - искусственная задержка
+ * на блок, чтобы посмотреть на медленного читателя.
+ */
+
+int main(int argc, char **argv)
+{
+    const char *name = argc > 1 ? argv[1] : IQ_BUS_DEFAULT_NAME;
+    const char *out = argc > 2 && strcmp(argv[2], "-") != 0 ? argv[2] : NULL;
+    unsigned delay_us = argc > 3 ? (unsigned)atoi(argv[3]) : 0;
+    rt_shutdown_init();
+
+    struct iq_bus bus;
+    if (iq_bus_attach(&bus, name) < 0)
+        return 1;
+    const struct iq_bus_reader_rec *rec = &bus.hdr->readers[bus.reader];
+    printf("* %s: %u slots x %llu samples, fs %.0f Hz, reader %d\n", name, bus.hdr->slots,
+           (unsigned long long)bus.hdr->slot_samples, bus.hdr->fs_hz, bus.reader);
+
+    struct capture_writer w;
+    if (out) {
+        struct capture_writer_cfg cfg;
+        capture_writer_default_cfg(&cfg);
+        cfg.fs_hz = bus.hdr->fs_hz;
+        if (capture_writer_open(&w, out, &cfg) < 0) {
+            iq_bus_close(&bus);
+            return 1;
+        }
+    }
+
+    // блок копируется до проверки штампа: в запись идёт только целый
+    std::vector<int16_t> copy(2 * bus.hdr->slot_samples);
+    unsigned long long blocks = 0, samples = 0, stale = 0, gaps = 0, total = 0;
+    long long next_index = -1;
+    double power = 0.0;
+    time_t last = time(NULL);
+    int ret;
+    while ((ret = iq_bus_wait(&bus, 500)) >= 0 && !rt_shutdown_requested()) {
+        const struct iq_block_info *info;
+        const int16_t *iq;
+        while ((iq = iq_bus_read_begin(&bus, &info)) != NULL) {
+            long long index = info->index;
+            size_t n = info->n < bus.hdr->slot_samples ? info->n : bus.hdr->slot_samples;
+            memcpy(copy.data(), iq, n * 2 * sizeof(int16_t));
+            if (delay_us)
+                usleep(delay_us);
+            if (iq_bus_read_end(&bus) < 0) {
+                stale++;        // блок уже чужой, копия не в счёт
+                continue;
+            }
+            double acc = 0.0;
+            for (size_t k = 0; k < 2 * n; k++)
+                acc += (double)copy[k] * copy[k];
+            if (out)
+                capture_writer_write(&w, copy.data(), n);
+            if (next_index >= 0 && index != next_index)
+                gaps++;
+            next_index = index + (long long)n;
+            power += acc;
+            samples += n;
+            total += n;
+            blocks++;
+            if (time(NULL) != last)
+                break;          // отставший читатель тоже отчитывается
+        }
+
+        if (time(NULL) != last) {
+            last = time(NULL);
+            printf("* %llu blocks, %.2f MS/s, %.1f dBFS, lost %llu (stale %llu, gaps %llu), %s%llu slow events\n",
+                   blocks, samples * 1e-6, 10.0 * log10(power / (2.0 * samples + 1e-20) / (2048.0 * 2048.0) + 1e-20),
+                   (unsigned long long)rec->lost.load(), stale, gaps, rec->slow.load() ? "SLOW, " : "",
+                   (unsigned long long)rec->slow_events.load());
+            blocks = samples = 0;
+            power = 0.0;
+        }
+    }
+    if (ret == -EPIPE)
+        printf("* writer closed the bus\n");
+
+    if (out && capture_writer_close(&w) < 0)
+        fprintf(stderr, "Unable to finish %s\n", out);
+    printf("* %llu samples total\n", total);
+    iq_bus_close(&bus);
+    return 0;
+}
@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <vector>
+
+#include "iq_server.h"
+#include "rt_thread.h"
+
+/*
+ * Подписчик iq_server: принимает блоки и пишет их в .pcm (int16 I/Q, как
+ * читает plot_pcm.py), печатает скорость и пропуски по index.
+ *
+ *   iq_client tcp:127.0.0.1:5555 out.pcm [decim=1] [seconds=0]
+ *   iq_client udp:127.0.0.1:5556 out.pcm 10
+ *   iq_client unix:/tmp/sdr_iq.sock -
+ *
+ * "-" вместо имени файла - только статистика.
+ */
+
+static int64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int connect_to(const char *uri, bool *udp, struct sockaddr_storage *peer, socklen_t *peer_len)
+{
+    *udp = strncmp(uri, "udp:", 4) == 0;
+    if (strncmp(uri, "unix:", 5) == 0) {
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, uri + 5, sizeof(addr.sun_path) - 1);
+        if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0) {
+            close(fd);
+            return -errno;
+        }
+        return fd;
+    }
+    if (strncmp(uri, "tcp:", 4) != 0 && !*udp)
+        return -EINVAL;
+
+    char host[256];
+    strncpy(host, uri + 4, sizeof(host) - 1);
+    host[sizeof(host) - 1] = 0;
+    char *port = strrchr(host, ':');
+    if (!port)
+        return -EINVAL;
+    *port++ = 0;
+
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_socktype = *udp ? SOCK_DGRAM : SOCK_STREAM;
+    if (getaddrinfo(host, port, &hints, &res) != 0)
+        return -EHOSTUNREACH;
+    int fd = socket(res->ai_family, res->ai_socktype | SOCK_CLOEXEC, 0);
+    int ret = fd < 0 ? -errno : 0;
+    if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) < 0) {
+        ret = -errno;
+        close(fd);
+    }
+    memcpy(peer, res->ai_addr, res->ai_addrlen);
+    *peer_len = res->ai_addrlen;
+    freeaddrinfo(res);
+    if (ret < 0)
+        return ret;
+
+    if (*udp) {
+        int rcvbuf = 4 << 20;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    }
+    return fd;
+}
+
+static bool read_full(int fd, void *buf, size_t len)
+{
+    char *p = static_cast<char *>(buf);
+    while (len > 0) {
+        ssize_t r = recv(fd, p, len, 0);
+        if (r < 0 && (errno == EINTR || errno == EAGAIN) && !rt_shutdown_requested())
+            continue;
+        if (r <= 0)
+            return false;
+        p += r;
+        len -= r;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <tcp:host:port|udp:host:port|unix:path> <out.pcm|-> [decim=1] [seconds=0]\n", argv[0]);
+        return 1;
+    }
+    unsigned decim = argc > 3 ? atoi(argv[3]) : 1;
+    double seconds = argc > 4 ? atof(argv[4]) : 0.0;
+    rt_shutdown_init();
+
+    bool udp;
+    struct sockaddr_storage peer;
+    socklen_t peer_len = 0;
+    int fd = connect_to(argv[1], &udp, &peer, &peer_len);
+    if (fd < 0) {
+        fprintf(stderr, "Unable to connect to %s: %s\n", argv[1], strerror(-fd));
+        return 1;
+    }
+    FILE *out = strcmp(argv[2], "-") == 0 ? NULL : fopen(argv[2], "wb");
+
+    char req[32];
+    int req_len = snprintf(req, sizeof(req), udp ? "SUB %u" : "SUB %u\n", decim);
+    if (send(fd, req, req_len, 0) < 0) {
+        perror("send");
+        return 1;
+    }
+    struct timeval tv = {0, 200000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    std::vector<char> buf(sizeof(struct iq_net_hdr) + 65536 * 4);
+    long long expect = -1, samples = 0, blocks = 0, gaps = 0, lost = 0;
+    const int64_t t0 = monotonic_ns();
+    int64_t last_sub = t0, last_print = t0;
+
+    while (!rt_shutdown_requested()) {
+        int64_t now = monotonic_ns();
+        if (seconds > 0.0 && now - t0 > (int64_t)(seconds * 1e9))
+            break;
+        if (udp && now - last_sub > IQ_UDP_TIMEOUT_S * 1000000000LL / 3) {
+            send(fd, req, req_len, 0);      // продление подписки
+            last_sub = now;
+        }
+        if (now - last_print > 1000000000LL) {
+            printf("* %lld blocks, %lld samples, %.2f MS/s, gaps %lld (%lld samples lost)\n",
+                   blocks, samples, samples / ((now - t0) * 1e-9) / 1e6, gaps, lost);
+            last_print = now;
+        }
+
+        struct iq_net_hdr *hdr = reinterpret_cast<struct iq_net_hdr *>(buf.data());
+        int16_t *iq = reinterpret_cast<int16_t *>(buf.data() + sizeof(*hdr));
+        if (udp) {
+            ssize_t r = recv(fd, buf.data(), buf.size(), 0);
+            if (r < (ssize_t)sizeof(*hdr))
+                continue;
+            if (hdr->magic != IQ_NET_MAGIC || r != (ssize_t)(sizeof(*hdr) + hdr->n * 4))
+                continue;
+        } else {
+            ssize_t r = recv(fd, buf.data(), sizeof(*hdr), MSG_PEEK);
+            if (r < 0 && (errno == EAGAIN || errno == EINTR))
+                continue;
+            if (r <= 0 || !read_full(fd, hdr, sizeof(*hdr)))
+                break;
+            if (hdr->magic != IQ_NET_MAGIC || hdr->n > 65536) {
+                fprintf(stderr, "Bad block header\n");
+                break;
+            }
+            if (!read_full(fd, iq, hdr->n * 4))
+                break;
+        }
+
+        if (expect >= 0 && hdr->index != expect) {
+            gaps++;
+            lost += (hdr->index - expect) / (long long)hdr->decim;
+        }
+        expect = hdr->index + (long long)hdr->n * hdr->decim;
+        blocks++;
+        samples += hdr->n;
+        if (out)
+            fwrite(iq, 4, hdr->n, out);
+    }
+
+    if (udp)
+        send(fd, "UNSUB", 5, 0);
+    double dt = (monotonic_ns() - t0) * 1e-9;
+    printf("* done: %lld blocks, %lld samples in %.1f s, gaps %lld (%lld samples lost)\n",
+           blocks, samples, dt, gaps, lost);
+    if (out)
+        fclose(out);
+    close(fd);
+    return 0;
+}
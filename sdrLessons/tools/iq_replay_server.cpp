@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "capture_file.h"
+#include "iq_server.h"
+#include "iq_bus.h"
+#include "rt_thread.h"
+
+/*
+ * Проверка iq_server без Pluto: запись (int16 I/Q) публикуется блоками
+ * с темпом fs, как её отдавал бы RX поток движка. Запись крутится по кругу.
+ *
+ *   iq_replay_server capture.pcm [fs_msps=10] [block=8192] [bus=/sdr_iq_bus]
+ *   iq_client tcp:127.0.0.1:5555 rx.pcm
+ *   iq_bus_tap /sdr_iq_bus             - то же через общую память (iq_bus.h)
+ */
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <capture.pcm> [fs_msps=10] [block=8192] [bus=/sdr_iq_bus]\n", argv[0]);
+        return 1;
+    }
+    double fs = (argc > 2 ? atof(argv[2]) : 10.0) * 1e6;
+    size_t block = argc > 3 ? strtoull(argv[3], NULL, 0) : 8192;
+    rt_shutdown_init();
+
+    struct capture_file cf;
+    if (capture_open(&cf, argv[1]) < 0)
+        return 1;
+    if (cf.n_samples < block) {
+        fprintf(stderr, "%s: less than one block\n", argv[1]);
+        capture_close(&cf);
+        return 1;
+    }
+
+    struct iq_server_cfg cfg;
+    iq_server_default_cfg(&cfg);
+    cfg.block_samples = block;
+    struct iq_server srv;
+    if (iq_server_start(&srv, &cfg) < 0) {
+        capture_close(&cf);
+        return 1;
+    }
+    struct iq_bus bus;
+    bus.map = NULL;
+    if (argc > 4 && iq_bus_create(&bus, argv[4], 64, block, fs) < 0) {
+        iq_server_stop(&srv);
+        capture_close(&cf);
+        return 1;
+    }
+
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    const long long period_ns = (long long)(block / fs * 1e9);
+    long long index = 0, drops = 0;
+    size_t pos = 0;
+
+    while (!rt_shutdown_requested()) {
+        if (pos + block > cf.n_samples)
+            pos = 0;
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t host_ns = (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+        if (iq_server_publish(&srv, capture_samples(&cf, pos), block, index, host_ns) < 0)
+            drops++;
+        if (bus.map)
+            iq_bus_publish(&bus, capture_samples(&cf, pos), block, index, host_ns, 0);
+        pos += block;
+        index += block;
+
+        if (index % (long long)(fs / block * block) < (long long)block)
+            printf("* %.1f s, clients %zu, bus readers %zu, pool drops %lld\n", index / fs, iq_server_clients(&srv),
+                   bus.map ? iq_bus_readers(&bus) : 0, drops);
+
+        next.tv_nsec += period_ns;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+
+    iq_bus_close(&bus);
+    iq_server_stop(&srv);
+    capture_close(&cf);
+    return 0;
+}
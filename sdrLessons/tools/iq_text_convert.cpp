@@ -0,0 +1,295 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <vector>
+
+#include "capture_file.h"
+#include "work_pool.h"
+
+/*
+ * Перевод старых текстовых записей "I, Q\n" (rx_signal.txt из main.cpp,
+ * 1_rx_signal.txt / 2_rx_signal.txt из rxtx_*_example, single_adalm_rx.txt)
+ * в бинарный формат, который читают capture_open(), offline_demod и plot_pcm.py:
+ *
+ *   iq_text_convert rx_signal.txt out.{iqz,pcm} [fs=0] [threads=0] [level=1]
+ *
+ * Файл отображается в память и идёт окнами по 64 МБ; окно режется по
+ * границам строк на куски по числу потоков, куски разбираются параллельно
+ * и пишутся по порядку. .iqz сжимает capture_writer на том же пуле.
+ *
+ * Числа разбираются SWAR: 8 байт строки - одно uint64, маска цифр и
+ * свёртка 8 -> 4 -> 2 -> 1 тремя умножениями, без ветвления по цифрам.
+ * Строки с дробными числами (1.5e3) - через strtod, значения вне int16
+ * ограничиваются, пустые и нечитаемые строки пропускаются (считаются).
+ */
+
+#define WINDOW_BYTES    (64u << 20)
+
+static double elapsed_s(const struct timespec *a, const struct timespec *b)
+{
+    return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) * 1e-9;
+}
+
+struct chunk {
+    const char *p, *end;
+    std::vector<int16_t> iq;
+    size_t bad;                 // нечитаемые строки
+    size_t clipped;
+};
+
+/* Число цифр подряд в начале v (0..8) и их значение */
+static inline unsigned swar_digits(uint64_t v, uint32_t *out)
+{
+    // байт - цифра, если старшая тетрада 3 и после +6 тоже 3
+    uint64_t t = (v & 0xF0F0F0F0F0F0F0F0ull) | (((v + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4);
+    uint64_t nd = t ^ 0x3333333333333333ull;
+    unsigned len = nd ? (unsigned)__builtin_ctzll(nd) / 8 : 8;
+    if (len == 0)
+        return 0;
+    // цифры к старшим байтам, младшие - ведущие нули
+    uint64_t d = (v - 0x3030303030303030ull) << (8 * (8 - len));
+    d = (d * 10 + (d >> 8)) & 0x00FF00FF00FF00FFull;
+    d = (d * 100 + (d >> 16)) & 0x0000FFFF0000FFFFull;
+    d = (d * 10000 + (d >> 32)) & 0xFFFFFFFFull;
+    *out = (uint32_t)d;
+    return len;
+}
+
+static inline int16_t clip16(long v, size_t *clipped)
+{
+    if (v > 32767 || v < -32768) {
+        (*clipped)++;
+        return v > 0 ? 32767 : -32768;
+    }
+    return (int16_t)v;
+}
+
+/* Медленный путь: дробные числа и хвост окна ближе 8 байт к концу */
+static bool parse_line_slow(const char *p, const char *eol, int16_t *iq, size_t *clipped)
+{
+    char buf[128];
+    size_t len = (size_t)(eol - p);
+    if (len >= sizeof(buf))
+        return false;
+    memcpy(buf, p, len);
+    buf[len] = 0;
+    char *s = buf, *e;
+    for (int k = 0; k < 2; k++) {
+        double v = strtod(s, &e);
+        if (e == s)
+            return false;
+        iq[k] = clip16(lrint(v), clipped);
+        s = e;
+        while (*s == ' ' || *s == '\t')
+            s++;
+        if (k == 0 && *s++ != ',')
+            return false;
+    }
+    while (*s == ' ' || *s == '\t' || *s == '\r')
+        s++;
+    return *s == 0;
+}
+
+/* Целое со знаком, p не ближе 8 байт к концу буфера; false - не целое */
+static inline bool parse_int_fast(const char **pp, long *v)
+{
+    const char *p = *pp;
+    while (*p == ' ' || *p == '\t')
+        p++;
+    bool neg = *p == '-';
+    p += neg || *p == '+';
+    uint64_t w;
+    memcpy(&w, p, 8);
+    uint32_t d;
+    unsigned len = swar_digits(w, &d);
+    if (len == 0 || len == 8)
+        return false;
+    p += len;
+    *v = neg ? -(long)d : (long)d;
+    *pp = p;
+    return true;
+}
+
+static bool parse_line_fast(const char *p, const char *eol, int16_t *iq, size_t *clipped)
+{
+    long i, q;
+    if (!parse_int_fast(&p, &i))
+        return false;
+    while (*p == ' ' || *p == '\t')
+        p++;
+    if (*p++ != ',')
+        return false;
+    if (!parse_int_fast(&p, &q))
+        return false;
+    while (p < eol && (*p == ' ' || *p == '\t' || *p == '\r'))
+        p++;
+    if (p != eol)
+        return false;
+    iq[0] = clip16(i, clipped);
+    iq[1] = clip16(q, clipped);
+    return true;
+}
+
+static void parse_chunk(struct chunk *c, const char *buf_end)
+{
+    c->iq.clear();
+    c->iq.reserve(2 * (size_t)(c->end - c->p) / 8);
+    c->bad = c->clipped = 0;
+    const char *p = c->p;
+    while (p < c->end) {
+        const char *eol = (const char *)memchr(p, '\n', (size_t)(c->end - p));
+        if (!eol)
+            eol = c->end;
+        int16_t iq[2];
+        // после второго числа читается до 8 байт вперёд
+        bool ok = eol + 8 <= buf_end && parse_line_fast(p, eol, iq, &c->clipped);
+        if (!ok)
+            ok = parse_line_slow(p, eol, iq, &c->clipped);
+        if (ok) {
+            c->iq.push_back(iq[0]);
+            c->iq.push_back(iq[1]);
+        } else if (eol > p && !(eol == p + 1 && *p == '\r')) {
+            c->bad++;
+        }
+        p = eol + 1;
+    }
+}
+
+/* Конец строки не раньше pos */
+static const char *line_end(const char *pos, const char *end)
+{
+    if (pos >= end)
+        return end;
+    const char *nl = (const char *)memchr(pos, '\n', (size_t)(end - pos));
+    return nl ? nl + 1 : end;
+}
+
+struct out_file {
+    bool compressed;
+    FILE *raw;
+    struct capture_writer w;
+};
+
+static int out_write(struct out_file *o, const int16_t *iq, size_t n)
+{
+    if (o->compressed)
+        return capture_writer_write(&o->w, iq, n);
+    return fwrite(iq, 4, n, o->raw) == n ? 0 : -EIO;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s rx_signal.txt out.{iqz,pcm} [fs=0] [threads=0] [level=1]\n", argv[0]);
+        return 1;
+    }
+    double fs = argc > 3 ? atof(argv[3]) : 0.0;
+    size_t threads = argc > 4 ? strtoull(argv[4], NULL, 0) : 0;
+    int level = argc > 5 ? atoi(argv[5]) : 1;
+
+    int fd = open(argv[1], O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        fprintf(stderr, "Unable to open %s\n", argv[1]);
+        if (fd >= 0)
+            close(fd);
+        return 1;
+    }
+    size_t len = (size_t)st.st_size;
+    const char *text = NULL;
+    if (len > 0) {
+        void *p = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            fprintf(stderr, "Unable to map %s: %s\n", argv[1], strerror(errno));
+            close(fd);
+            return 1;
+        }
+        madvise(p, len, MADV_SEQUENTIAL);
+        text = (const char *)p;
+    }
+    const char *end = text + len;
+
+    struct work_pool pool;
+    work_pool_init(&pool, threads);
+
+    struct out_file o;
+    size_t out_len = strlen(argv[2]);
+    o.compressed = !(out_len > 4 && strcmp(argv[2] + out_len - 4, ".pcm") == 0);
+    int ret = 0;
+    if (o.compressed) {
+        struct capture_writer_cfg cfg;
+        capture_writer_default_cfg(&cfg);
+        cfg.level = level;
+        cfg.fs_hz = fs;
+        cfg.pool = &pool;
+        ret = capture_writer_open(&o.w, argv[2], &cfg);
+    } else {
+        o.raw = fopen(argv[2], "wb");
+        ret = o.raw ? 0 : -errno;
+    }
+    if (ret < 0) {
+        fprintf(stderr, "Unable to create %s: %s\n", argv[2], strerror(-ret));
+        work_pool_destroy(&pool);
+        if (text)
+            munmap((void *)text, len);
+        close(fd);
+        return 1;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    std::vector<struct chunk> chunks(work_pool_size(&pool));
+    size_t samples = 0, bad = 0, clipped = 0;
+    for (const char *win = text; win < end && ret == 0;) {
+        const char *win_end = line_end(win + (end - win < WINDOW_BYTES ? end - win : WINDOW_BYTES) - 1, end);
+        size_t step = ((size_t)(win_end - win) + chunks.size() - 1) / chunks.size();
+
+        const char *p = win;
+        for (size_t k = 0; k < chunks.size(); k++) {
+            chunks[k].p = p;
+            chunks[k].end = p = line_end(p + step - 1 < win_end ? p + step - 1 : win_end, win_end);
+            struct chunk *c = &chunks[k];
+            work_pool_submit(&pool, [c, end] { parse_chunk(c, end); });
+        }
+        work_pool_wait(&pool);
+
+        for (size_t k = 0; k < chunks.size() && ret == 0; k++) {
+            ret = out_write(&o, chunks[k].iq.data(), chunks[k].iq.size() / 2);
+            samples += chunks[k].iq.size() / 2;
+            bad += chunks[k].bad;
+            clipped += chunks[k].clipped;
+        }
+        // уже разобранные страницы больше не нужны
+        madvise((void *)((uintptr_t)win & ~(uintptr_t)4095), (size_t)(win_end - win), MADV_DONTNEED);
+        win = win_end;
+    }
+
+    int close_ret = o.compressed ? capture_writer_close(&o.w) : (fclose(o.raw) == 0 ? 0 : -EIO);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    work_pool_destroy(&pool);
+    if (text)
+        munmap((void *)text, len);
+    close(fd);
+    if (ret == 0)
+        ret = close_ret;
+    if (ret < 0) {
+        fprintf(stderr, "Unable to write %s: %s\n", argv[2], strerror(-ret));
+        return 1;
+    }
+
+    double dt = elapsed_s(&t0, &t1);
+    printf("* %zu samples from %zu bytes, %.1f MB/s, %.1f MS/s\n", samples, len,
+           dt > 0.0 ? len / dt * 1e-6 : 0.0, dt > 0.0 ? samples / dt * 1e-6 : 0.0);
+    if (bad || clipped)
+        printf("* skipped %zu unreadable lines, clipped %zu values to int16\n", bad, clipped);
+    return 0;
+}
@@ -0,0 +1,377 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <utility>
+#include <vector>
+
+#include "capture_file.h"
+#include "equalizer.h"
+#include "qpsk_demod.h"
+#include "work_pool.h"
+
+/*
+ * Параллельная демодуляция большой записи (int16 I/Q, см. plot_pcm.py).
+ *
+ * Файл режется на куски по chunk сэмплов, каждый кусок демодулируется
+ * с нахлёстом overlap сэмплов слева (разгон фильтра, AGC, Гарднера и
+ * Костаса). Куски раздаются пулу с кражей задач, затем символы сшиваются:
+ *  - шов проверяется на сошедшейся половине нахлёста: символы соседних
+ *    кусков совпадают по числу и позициям (до sps/4), корреляция близка
+ *    к 1 (шум у них общий) и жёсткие решения одинаковы все. По корреляции
+ *    же снимается неоднозначность фазы QPSK (k * 90 градусов);
+ *  - не прошедшие куски пересчитываются тем же пулом с нахлёстом x4, x16
+ *    и, наконец, с начала предыдущего куска (тогда нахлёст совпадает с ним
+ *    бит в бит); пересчёт куска заново проверяет и следующий шов. Поворот
+ *    через непроверенный шов не переносится;
+ *  - из каждого куска берутся символы с позициями в [start, end),
+ *    дубликаты на шве (ближе sps/2 к предыдущему) отбрасываются.
+ *
+ * Выход: complex64 символы (np.fromfile(name, dtype=np.complex64)).
+ *
+ * verify=1 - ещё и демодуляция всей записи одним куском и сравнение
+ * решений с результатом по кускам (регрессия сшивки); код возврата 2,
+ * если разошлось число символов или решение не у самой границы.
+ *
+ * eq_taps > 0 - после демодулятора дробный эквалайзер T/2 (equalizer.h) на
+ * eq_taps отводов; нахлёст тогда покрывает и его захват.
+ */
+
+struct chunk_result {
+    size_t start, end;          // границы куска без нахлёста
+    size_t from;                // начало демодуляции (start - нахлёст)
+    std::vector<cf_t> syms;
+    std::vector<double> pos;
+};
+
+static double elapsed_s(const struct timespec *a, const struct timespec *b)
+{
+    return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) * 1e-9;
+}
+
+static void demod_chunk(const struct capture_file *cf, const struct qpsk_demod_cfg *cfg,
+                        const struct equalizer_cfg *eq_cfg, struct chunk_result *res)
+{
+    struct qpsk_demod d;
+    qpsk_demod_init(&d, cfg);
+    struct equalizer eq;
+    std::vector<cf_t> half;
+    size_t eq_delay = 0;
+    if (eq_cfg) {
+        equalizer_init(&eq, eq_cfg);
+        eq_delay = equalizer_delay(&eq);
+        d.half = &half;
+    }
+
+    // справа тоже небольшой запас: символ с позицией перед end стробируется
+    // только через задержку фильтра (и эквалайзера)
+    size_t from = res->from;
+    size_t to = res->end + d.taps.size() + (2 + eq_delay) * cfg->sps;
+    if (to > cf->n_samples)
+        to = cf->n_samples;
+    qpsk_demod_reset(&d, (long long)from);
+    res->syms.clear();
+    res->pos.clear();
+    res->syms.reserve((to - from) / cfg->sps + 16);
+    res->pos.reserve((to - from) / cfg->sps + 16);
+    qpsk_demod_process_iq16(&d, capture_samples(cf, from), to - from, res->syms, &res->pos);
+    if (!eq_cfg)
+        return;
+
+    // выход эквалайзера k - символ k - eq_delay
+    res->syms.clear();
+    equalizer_process(&eq, half.data(), half.size(), res->syms);
+    size_t n = res->syms.size() > eq_delay ? res->syms.size() - eq_delay : 0;
+    res->syms.erase(res->syms.begin(), res->syms.begin() + (res->syms.size() - n));
+    res->pos.resize(n);
+}
+
+static const cf_t quarter_rot[4] = {cf_t(1, 0), cf_t(0, 1), cf_t(-1, 0), cf_t(0, -1)};
+
+static inline uint8_t decision(cf_t s)
+{
+    return (uint8_t)((s.real() > 0.0f) << 1 | (s.imag() > 0.0f));
+}
+
+/*
+ * Шов на [from, to): поворот куска cur к опоре (0..3, * 90 градусов)
+ * или -1, если символы не совпали по числу/позициям, корреляция слабая
+ * или после поворота разошлось хоть одно жёсткое решение
+ */
+static int check_seam(const struct chunk_result *ref, const struct chunk_result *cur,
+                      double from, double to, double sps)
+{
+    size_t n_ref = 0, n_cur = 0;
+    for (size_t k = 0; k < ref->pos.size() && ref->pos[k] < to; k++)
+        n_ref += ref->pos[k] >= from;
+
+    std::vector<std::pair<size_t, size_t> > pairs;     // (ref, cur)
+    cf_t acc(0.0f, 0.0f);
+    double norm = 0.0;
+    size_t r = 0;
+    for (size_t k = 0; k < cur->pos.size() && cur->pos[k] < to; k++) {
+        if (cur->pos[k] < from)
+            continue;
+        n_cur++;
+        while (r + 1 < ref->pos.size() && ref->pos[r] < cur->pos[k] - sps / 2)
+            r++;
+        if (r < ref->pos.size() && fabs(ref->pos[r] - cur->pos[k]) < sps / 4) {
+            pairs.push_back(std::make_pair(r, k));
+            acc += ref->syms[r] * std::conj(cur->syms[k]);
+            norm += std::abs(ref->syms[r]) * std::abs(cur->syms[k]);
+        }
+    }
+    // по одному символу на краях окна может выпасть
+    size_t matched = pairs.size();
+    if (matched == 0 || n_ref > matched + 1 || n_cur > matched + 1 || std::abs(acc) < 0.9 * norm)
+        return -1;
+
+    int quarter = (int)lround(std::arg(acc) / (M_PI / 2.0)) & 3;
+    for (size_t k = 0; k < matched; k++) {
+        cf_t c = cur->syms[pairs[k].second] * quarter_rot[quarter];
+        if (decision(ref->syms[pairs[k].first]) != decision(c))
+            return -1;
+    }
+    return quarter;
+}
+
+static void rotate_chunk(struct chunk_result *cur, int quarter)
+{
+    if (quarter <= 0)
+        return;
+    for (size_t k = 0; k < cur->syms.size(); k++)
+        cur->syms[k] *= quarter_rot[quarter];
+}
+
+/* Начало пересчёта куска: level 1 - нахлёст x4, 2 - x16, 3 - с начала предыдущего */
+static size_t retry_from(const struct chunk_result *prev, const struct chunk_result *r,
+                         unsigned level, size_t overlap)
+{
+    size_t mult = level == 1 ? 4 : 16;
+    if (level >= 3 || r->start <= prev->from + mult * overlap)
+        return prev->from;
+    return r->start - mult * overlap;
+}
+
+/* Символы из [start, end) после last_pos (дубликаты шва); last - весь хвост */
+static void chunk_range(const struct chunk_result *r, double last_pos, double sps, bool last,
+                        size_t *first, size_t *count)
+{
+    size_t a = 0;
+    while (a < r->pos.size() && (r->pos[a] < (double)r->start || r->pos[a] < last_pos + sps / 2.0))
+        a++;
+    size_t b = a;
+    while (b < r->pos.size() && r->pos[b] < (double)r->end)
+        b++;
+    if (last)
+        b = r->pos.size() > a ? r->pos.size() : a;
+    *first = a;
+    *count = b - a;
+}
+
+/*
+ * Сравнение с демодуляцией одним куском: разошедшиеся решения; marginal -
+ * из них те, где обе стороны у самой границы (ближе margin по разошедшейся
+ * оси). Эквалайзер T/2 не забывает начальные отводы (дрейф вне полосы
+ * сигнала), поэтому такие перевороты после шва возможны и без ошибки сшивки.
+ */
+static size_t compare_decisions(const cf_t *ref, const cf_t *got, size_t n, size_t *marginal)
+{
+    double pwr = 0.0;
+    for (size_t k = 0; k < n; k++)
+        pwr += std::norm(ref[k]);
+    float margin = n ? 0.1f * (float)sqrt(pwr / n) : 0.0f;
+
+    size_t diff = 0;
+    *marginal = 0;
+    for (size_t k = 0; k < n; k++) {
+        uint8_t x = decision(ref[k]) ^ decision(got[k]);
+        if (!x)
+            continue;
+        diff++;
+        bool near_i = !(x & 2) || (fabsf(ref[k].real()) < margin && fabsf(got[k].real()) < margin);
+        bool near_q = !(x & 1) || (fabsf(ref[k].imag()) < margin && fabsf(got[k].imag()) < margin);
+        *marginal += near_i && near_q;
+    }
+    return diff;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <capture.pcm> <symbols.c64> [sps=10] [threads=0] [chunk=4194304] [eq_taps=0] "
+                "[verify=0]\n", argv[0]);
+        return 1;
+    }
+    const char *in_name = argv[1];
+    const char *out_name = argv[2];
+    unsigned sps = argc > 3 ? atoi(argv[3]) : 10;
+    size_t threads = argc > 4 ? atoi(argv[4]) : 0;
+    size_t chunk = argc > 5 ? strtoull(argv[5], NULL, 0) : ((size_t)1 << 22);
+    unsigned eq_taps = argc > 6 ? atoi(argv[6]) : 0;
+    bool verify = argc > 7 && atoi(argv[7]) != 0;
+
+    struct capture_file cf;
+    if (capture_open(&cf, in_name) < 0)
+        return 1;
+
+    struct qpsk_demod_cfg cfg;
+    qpsk_demod_default_cfg(&cfg, sps);
+    struct qpsk_demod probe;
+    if (qpsk_demod_init(&probe, &cfg) < 0) {
+        fprintf(stderr, "Bad sps = %u\n", sps);
+        return 1;
+    }
+
+    struct equalizer_cfg eq_cfg;
+    equalizer_default_cfg(&eq_cfg, 2);
+    if (eq_taps)
+        eq_cfg.ntaps = eq_taps;
+
+    // разгон: фильтр + ~10 постоянных времени самой медленной петли
+    size_t warmup_syms = (size_t)(10.0f / (cfg.timing_bw < cfg.costas_bw ? cfg.timing_bw : cfg.costas_bw));
+    if (eq_taps) {
+        // CMA сходится за ~10 / mu символов
+        size_t eq_syms = (size_t)(10.0f / eq_cfg.mu_cma);
+        if (warmup_syms < eq_syms)
+            warmup_syms = eq_syms;
+    }
+    size_t overlap = probe.taps.size() + warmup_syms * sps;
+    if (chunk < 4 * overlap)
+        chunk = 4 * overlap;
+
+    size_t n_chunks = (cf.n_samples + chunk - 1) / chunk;
+    std::vector<struct chunk_result> res(n_chunks);
+    for (size_t k = 0; k < n_chunks; k++) {
+        res[k].start = k * chunk;
+        res[k].end = (k + 1) * chunk < cf.n_samples ? (k + 1) * chunk : cf.n_samples;
+        res[k].from = res[k].start > overlap ? res[k].start - overlap : 0;
+    }
+    const struct equalizer_cfg *ec = eq_taps ? &eq_cfg : NULL;
+
+    struct work_pool pool;
+    work_pool_init(&pool, threads);
+    printf("* %s: %zu samples, %zu chunks of %zu (+%zu overlap), %zu threads\n",
+           in_name, cf.n_samples, n_chunks, chunk, overlap, work_pool_size(&pool));
+    if (eq_taps)
+        printf("* equalizer: T/2, %u taps\n", eq_cfg.ntaps);
+
+    struct timespec t0, t1, t2, t3;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (size_t k = 0; k < n_chunks; k++) {
+        struct chunk_result *r = &res[k];
+        work_pool_submit(&pool, [&cf, &cfg, ec, r] { demod_chunk(&cf, &cfg, ec, r); });
+    }
+    work_pool_wait(&pool);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    /* проверка швов по кругам: пересчёт куска k - заново швы k и k + 1 */
+    std::vector<unsigned> level(n_chunks, 0);
+    std::vector<bool> dirty(n_chunks, true);
+    size_t reruns = 0;
+    for (;;) {
+        std::vector<size_t> rerun;
+        for (size_t k = 1; k < n_chunks; k++) {
+            if (!dirty[k])
+                continue;
+            dirty[k] = false;
+            const struct chunk_result *prev = &res[k - 1];
+            struct chunk_result *r = &res[k];
+            if (check_seam(prev, r, (double)r->start - overlap / 2.0, (double)r->start, sps) >= 0)
+                continue;
+            size_t from = r->from;
+            while (from >= r->from && level[k] < 3)
+                from = retry_from(prev, r, ++level[k], overlap);
+            if (level[k] == 3)
+                from = prev->from;
+            if (from >= r->from)
+                continue;       // раньше начинать некуда
+            r->from = from;
+            rerun.push_back(k);
+        }
+        if (rerun.empty())
+            break;
+        for (size_t j = 0; j < rerun.size(); j++) {
+            struct chunk_result *r = &res[rerun[j]];
+            work_pool_submit(&pool, [&cf, &cfg, ec, r] { demod_chunk(&cf, &cfg, ec, r); });
+            dirty[rerun[j]] = true;
+            if (rerun[j] + 1 < n_chunks)
+                dirty[rerun[j] + 1] = true;
+        }
+        work_pool_wait(&pool);
+        reruns += rerun.size();
+    }
+    work_pool_destroy(&pool);
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+
+    /* сшивка */
+    FILE *out = fopen(out_name, "wb");
+    if (!out) {
+        fprintf(stderr, "Unable to open %s for writing\n", out_name);
+        capture_close(&cf);
+        return 1;
+    }
+    size_t total = 0, unverified = 0;
+    double last_pos = -1e300;
+    std::vector<cf_t> got;         // для verify
+    for (size_t k = 0; k < n_chunks; k++) {
+        struct chunk_result *r = &res[k];
+        if (k > 0) {
+            // сравниваем только уже сошедшуюся вторую половину нахлёста
+            const struct chunk_result *prev = &res[k - 1];
+            double from = (double)r->start - overlap / 2.0;
+            int quarter = check_seam(prev, r, from, (double)r->start, sps);
+            if (quarter < 0) {
+                fprintf(stderr, "Seam at %zu not verified, phase of the rest is unknown\n", r->start);
+                unverified++;
+            }
+            rotate_chunk(r, quarter);
+        }
+
+        size_t first, count;
+        chunk_range(r, last_pos, sps, k + 1 == n_chunks, &first, &count);
+        if (count) {
+            fwrite(&r->syms[first], sizeof(cf_t), count, out);
+            if (verify)
+                got.insert(got.end(), r->syms.begin() + first, r->syms.begin() + first + count);
+            last_pos = r->pos[first + count - 1];
+            total += count;
+        }
+        // символы k-1 больше не нужны как опора
+        if (k > 0) {
+            std::vector<cf_t>().swap(res[k - 1].syms);
+            std::vector<double>().swap(res[k - 1].pos);
+        }
+    }
+    fclose(out);
+    clock_gettime(CLOCK_MONOTONIC, &t3);
+
+    double td = elapsed_s(&t0, &t1);
+    printf("* demod %.3f s (%.1f MS/s), seams %.3f s (%zu chunks re-run), stitch %.3f s (%zu unverified), "
+           "%zu symbols -> %s\n", td, cf.n_samples / td / 1e6, elapsed_s(&t1, &t2), reruns,
+           elapsed_s(&t2, &t3), unverified, total, out_name);
+
+    int ret = 0;
+    if (verify) {
+        // тот же поток одним куском: число символов и решения должны совпасть
+        struct chunk_result whole;
+        whole.start = whole.from = 0;
+        whole.end = cf.n_samples;
+        demod_chunk(&cf, &cfg, ec, &whole);
+        size_t first, count, marginal;
+        chunk_range(&whole, -1e300, sps, true, &first, &count);
+        size_t n = count < got.size() ? count : got.size();
+        size_t diff = compare_decisions(&whole.syms[first], got.data(), n, &marginal);
+        printf("* verify: %zu symbols in one chunk, %zu chunked, %zu decisions differ (%zu at the boundary)\n",
+               count, got.size(), diff, marginal);
+        if (count != got.size() || diff > marginal) {
+            fprintf(stderr, "Chunked output differs from single-chunk output\n");
+            ret = 2;
+        }
+    }
+
+    capture_close(&cf);
+    return ret;
+}